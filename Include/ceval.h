@@ -70,10 +70,26 @@ PyAPI_FUNC(PyObject *) PyEval_EvalFrame_slp(struct _frame *f, int exc, PyObject
 PyAPI_FUNC(PyObject *) PyEval_EvalFrameEx_slp(struct _frame *f, int exc, PyObject *retval);
 #endif
 
+/* Runtime opcode profile, see sys.setopcodeprofile() */
+#define PyEval_PROFILE_OPCODES  1
+#define PyEval_PROFILE_LINES    2
+#define PyEval_PROFILE_PAIRS    4
+
+PyAPI_FUNC(int) _PyEval_SetOpcodeProfile(int flags);
+PyAPI_FUNC(int) _PyEval_GetOpcodeProfile(void);
+PyAPI_FUNC(PyObject *) _PyEval_GetOpcodeStats(void);
+PyAPI_FUNC(void) _PyEval_ClearOpcodeStats(void);
+
 /* this used to be handled on a per-thread basis - now just two globals */
 PyAPI_DATA(volatile int) _Py_Ticker;
 PyAPI_DATA(int) _Py_CheckInterval;
 
+#ifdef WITH_THREAD
+/* the GIL switch interval, in microseconds */
+PyAPI_FUNC(void) _PyEval_SetSwitchInterval(unsigned long microseconds);
+PyAPI_FUNC(unsigned long) _PyEval_GetSwitchInterval(void);
+#endif
+
 /* Interface for threads.
 
    A module that plans to do a blocking system call (or something else
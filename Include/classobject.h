@@ -19,6 +19,8 @@ typedef struct {
     PyObject	*cl_setattr;
     PyObject	*cl_delattr;
     PyObject    *cl_weakreflist; /* List of weak references */
+    /* Table shared by the __dict__s of the instances, or NULL */
+    struct _dictkeysobject *cl_cached_keys;
 } PyClassObject;
 
 typedef struct {
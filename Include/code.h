@@ -6,8 +6,54 @@
 extern "C" {
 #endif
 
-/* Bytecode object */
+/* Inline cache for one LOAD_GLOBAL or LOAD_ATTR instruction.  A
+   LOAD_GLOBAL entry is valid while the globals and builtins dicts still
+   have the recorded versions; a LOAD_ATTR entry is valid while the type
+   of the owner is the recorded one and its tp_version_tag is unchanged.
+   All object pointers are borrowed, the versions guarantee that they
+   are still alive whenever an entry matches. */
+typedef struct {
+    Py_dictversion_t globals_ver;
+    Py_dictversion_t builtins_ver;
+    PyObject *ptr;
+} _PyOpcache_LoadGlobal;
+
 typedef struct {
+    PyTypeObject *type;
+    unsigned int tp_version;
+    PyObject *descr;            /* result of _PyType_Lookup, may be NULL */
+} _PyOpcache_LoadAttr;
+
+typedef struct {
+    union {
+        _PyOpcache_LoadGlobal lg;
+        _PyOpcache_LoadAttr la;
+    } u;
+} _PyOpcache;
+
+/* Runtime opcode profile of one code object, see sys.setopcodeprofile().
+   All profiles are chained together so that they can be reported and
+   cleared; a dying code object unlinks its own. */
+#ifdef HAVE_LONG_LONG
+typedef PY_LONG_LONG _Py_profcount_t;
+#define _Py_profcount_AsObject(c) \
+    ((c) <= LONG_MAX ? PyInt_FromLong((long)(c)) : PyLong_FromLongLong(c))
+#else
+typedef long _Py_profcount_t;
+#define _Py_profcount_AsObject(c) PyInt_FromLong(c)
+#endif
+
+typedef struct _codeprofile {
+    struct _codeprofile *next;
+    struct _codeprofile *prev;
+    struct PyCodeObject *code;  /* borrowed */
+    _Py_profcount_t opcounts[256];
+    _Py_profcount_t *instrcounts;  /* per bytecode offset, if lines are
+                                      profiled, else NULL */
+} _PyCodeProfile;
+
+/* Bytecode object */
+typedef struct PyCodeObject {
     PyObject_HEAD
     int co_argcount;		/* #arguments, except *args */
     int co_nlocals;		/* #local variables */
@@ -27,6 +73,15 @@ typedef struct {
 				   Objects/lnotab_notes.txt for details. */
     void *co_zombieframe;     /* for optimization only (see frameobject.c) */
     PyObject *co_weakreflist;   /* to support weakrefs to code objects */
+    /* Inline caches, built once the code object has run
+       _PyCode_OPCACHE_MIN_RUNS times.  co_opcache_map maps the offset of
+       each cached instruction to its index in co_opcache plus one.  They
+       are an optimization only and never compared, marshalled or pickled. */
+    unsigned char *co_opcache_map;
+    _PyOpcache *co_opcache;
+    int co_opcache_flag;        /* runs so far, up to _PyCode_OPCACHE_MIN_RUNS */
+    int co_opcache_size;        /* number of entries in co_opcache */
+    _PyCodeProfile *co_profile; /* NULL unless the opcode profile ran */
 } PyCodeObject;
 
 /* Masks for co_flags above */
@@ -67,6 +122,19 @@ PyAPI_DATA(PyTypeObject) PyCode_Type;
 #define PyCode_Check(op) (Py_TYPE(op) == &PyCode_Type)
 #define PyCode_GetNumFree(op) (PyTuple_GET_SIZE((op)->co_freevars))
 
+/* Inline caches, see above */
+#define _PyCode_OPCACHE_MIN_RUNS 1024
+/* co_opcache_map entries are bytes, this many instructions get a cache */
+#define _PyCode_OPCACHE_MAX_SIZE 255
+
+PyAPI_FUNC(int) _PyCode_InitOpcache(PyCodeObject *);
+PyAPI_FUNC(void) _PyCode_ClearOpcache(PyCodeObject *);
+
+/* Opcode profile storage, used by ceval.c */
+PyAPI_FUNC(_PyCodeProfile *) _PyCode_GetProfile(PyCodeObject *, int lines);
+PyAPI_FUNC(PyObject *) _PyCode_GetProfiles(void);
+PyAPI_FUNC(void) _PyCode_ClearProfiles(void);
+
 /* Public interface */
 PyAPI_FUNC(PyCodeObject *) PyCode_New(
 	int, int, int, int, PyObject *, PyObject *, PyObject *, PyObject *,
@@ -100,6 +168,7 @@ PyAPI_FUNC(int) _PyCode_CheckLineNumber(PyCodeObject* co,
 
 PyAPI_FUNC(PyObject*) PyCode_Optimize(PyObject *code, PyObject* consts,
                                       PyObject *names, PyObject *lineno_obj);
+PyAPI_FUNC(PyObject *) _PyCode_UnfuseCode(PyObject *code);
 
 #ifdef __cplusplus
 }
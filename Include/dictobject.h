@@ -14,78 +14,75 @@ extern "C" {
 */
 
 /*
-There are three kinds of slots in the table:
-
-1. Unused.  me_key == me_value == NULL
-   Does not hold an active (key, value) pair now and never did.  Unused can
-   transition to Active upon key insertion.  This is the only case in which
-   me_key is NULL, and is each slot's initial state.
-
-2. Active.  me_key != NULL and me_key != dummy and me_value != NULL
-   Holds an active (key, value) pair.  Active can transition to Dummy upon
-   key deletion.  This is the only case in which me_value != NULL.
-
-3. Dummy.  me_key == dummy and me_value == NULL
-   Previously held an active (key, value) pair, but that was deleted and an
-   active pair has not yet overwritten the slot.  Dummy can transition to
-   Active upon key insertion.  Dummy slots cannot be made Unused again
-   (cannot have me_key set to NULL), else the probe sequence in case of
-   collision would have no way to know they were once active.
-
-Note: .popitem() abuses the me_hash field of an Unused or Dummy slot to
-hold a search finger.  The me_hash field of Unused or Dummy slots has no
-meaning otherwise.
+A dict keeps its items in a dense array of entries, in insertion order,
+and finds them through a separate hash table of small integer indices
+into that array; see Objects/dictobject.c.  An entry is either
+
+1. Active.  me_key != NULL and me_value != NULL
+   Holds an active (key, value) pair.
+
+2. Deleted.  me_key == me_value == NULL
+   Previously held an active (key, value) pair.  The hash table marks
+   its index as a dummy, so probe sequences going through it go on;
+   deleted entries are only dropped when the table is rebuilt.
+
+In a split table (see below) the values live outside the entries, and an
+entry is Active for a dict when that dict has a non-NULL value for it.
 */
 
-/* PyDict_MINSIZE is the minimum size of a dictionary.  This many slots are
- * allocated directly in the dict object (in the ma_smalltable member).
- * It must be a power of 2, and at least 4.  8 allows dicts with no more
- * than 5 active entries to live in ma_smalltable (and so avoid an
- * additional malloc); instrumentation suggested this suffices for the
- * majority of dicts (consisting mostly of usually-small instance dicts and
- * usually-small dicts created to pass keyword arguments).
+/* PyDict_MINSIZE is the minimum size of a dictionary table.  It must be
+ * a power of 2, and at least 8.  8 allows dicts with no more than 5
+ * active entries to live in the smallest table; instrumentation
+ * suggested this suffices for the majority of dicts (consisting mostly
+ * of usually-small instance dicts and usually-small dicts created to
+ * pass keyword arguments).  Tables of this size are recycled through a
+ * free list.
  */
 #define PyDict_MINSIZE 8
 
 typedef struct {
-    /* Cached hash code of me_key.  Note that hash codes are C longs.
-     * We have to use Py_ssize_t instead because dict_popitem() abuses
-     * me_hash to hold a search finger.
+    /* Cached hash code of me_key.  Note that hash codes are C longs;
+     * Py_ssize_t is kept for binary compatibility.
      */
     Py_ssize_t me_hash;
     PyObject *me_key;
     PyObject *me_value;
 } PyDictEntry;
 
+/* The hash table and entries, see Objects/dictobject.c */
+typedef struct _dictkeysobject PyDictKeysObject;
+
+/* Wide enough that the version counter never wraps in practice */
+#ifdef HAVE_UINT64_T
+typedef PY_UINT64_T Py_dictversion_t;
+#else
+typedef size_t Py_dictversion_t;
+#endif
+
 /*
-To ensure the lookup algorithm terminates, there must be at least one Unused
-slot (NULL key) in the table.
-The value ma_fill is the number of non-NULL keys (sum of Active and Dummy);
-ma_used is the number of non-NULL, non-dummy keys (== the number of non-NULL
-values == the number of Active items).
-To avoid slowing down lookups on a near-full table, we resize the table when
-it's two-thirds full.
+A dict is either combined or split.  A combined dict owns its table,
+which holds both its keys and its values, and ma_values is NULL.  A
+split dict shares its table (keys and hashes only, all keys strings)
+with other dicts, normally the __dict__s of the instances of one class,
+and keeps its own values in ma_values, indexed like the table's entries.
+A split dict becomes combined as soon as it cannot use the shared table
+any more.
 */
 typedef struct _dictobject PyDictObject;
 struct _dictobject {
     PyObject_HEAD
-    Py_ssize_t ma_fill;  /* # Active + # Dummy */
     Py_ssize_t ma_used;  /* # Active */
 
-    /* The table contains ma_mask + 1 slots, and that's a power of 2.
-     * We store the mask instead of the size because the mask is more
-     * frequently needed.
+    /* ma_version changes whenever a key is added, removed or rebound.
+     * Versions are drawn from one global counter, so two dicts never
+     * share a nonzero version; a dict that was never modified is empty
+     * and has version 0.  The eval loop's inline caches rely on this.
      */
-    Py_ssize_t ma_mask;
+    Py_dictversion_t ma_version;
 
-    /* ma_table points to ma_smalltable for small tables, else to
-     * additional malloc'ed memory.  ma_table is never NULL!  This rule
-     * saves repeated runtime null-tests in the workhorse getitem and
-     * setitem calls.
-     */
-    PyDictEntry *ma_table;
-    PyDictEntry *(*ma_lookup)(PyDictObject *mp, PyObject *key, long hash);
-    PyDictEntry ma_smalltable[PyDict_MINSIZE];
+    /* ma_keys is never NULL; empty dicts share a static empty table */
+    PyDictKeysObject *ma_keys;
+    PyObject **ma_values;  /* NULL for a combined dict */
 };
 
 PyAPI_DATA(PyTypeObject) PyDict_Type;
@@ -99,6 +96,7 @@ PyAPI_DATA(PyTypeObject) PyDictValues_Type;
 #define PyDict_Check(op) \
                  PyType_FastSubclass(Py_TYPE(op), Py_TPFLAGS_DICT_SUBCLASS)
 #define PyDict_CheckExact(op) (Py_TYPE(op) == &PyDict_Type)
+#define _PyDict_VERSION(op) (((PyDictObject *)(op))->ma_version)
 #define PyDictKeys_Check(op) (Py_TYPE(op) == &PyDictKeys_Type)
 #define PyDictItems_Check(op) (Py_TYPE(op) == &PyDictItems_Type)
 #define PyDictValues_Check(op) (Py_TYPE(op) == &PyDictValues_Type)
@@ -125,6 +123,24 @@ PyAPI_FUNC(int) _PyDict_Contains(PyObject *mp, PyObject *key, long hash);
 PyAPI_FUNC(PyObject *) _PyDict_NewPresized(Py_ssize_t minused);
 PyAPI_FUNC(void) _PyDict_MaybeUntrack(PyObject *mp);
 
+/* Lookup of a name in globals, then builtins, both exact dicts.  Returns
+   a borrowed reference, or NULL with or without an exception set. */
+PyAPI_FUNC(PyObject *) _PyDict_LoadGlobal(PyDictObject *globals,
+                                          PyDictObject *builtins,
+                                          PyObject *key);
+
+/* Key sharing for instance dicts.  A class keeps the shared table of its
+   instances in *cachedp (NULL when sharing was given up). */
+#define _PyType_CACHED_KEYS(tp) \
+    (PyType_HasFeature((tp), Py_TPFLAGS_HEAPTYPE) ? \
+     &((PyHeapTypeObject *)(tp))->ht_cached_keys : NULL)
+PyAPI_FUNC(PyDictKeysObject *) _PyDict_NewKeysForClass(void);
+PyAPI_FUNC(void) _PyDictKeys_DecRef(PyDictKeysObject *keys);
+PyAPI_FUNC(PyObject *) _PyObjectDict_New(PyDictKeysObject **cachedp);
+PyAPI_FUNC(int) _PyObjectDict_SetItem(PyDictKeysObject **cachedp,
+                                      PyObject **dictptr,
+                                      PyObject *key, PyObject *value);
+
 /* PyDict_Update(mp, other) is equivalent to PyDict_Merge(mp, other, 1). */
 PyAPI_FUNC(int) PyDict_Update(PyObject *mp, PyObject *other);
 
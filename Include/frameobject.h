@@ -91,6 +91,8 @@ PyAPI_FUNC(void) PyFrame_LocalsToFast(PyFrameObject *, int);
 PyAPI_FUNC(void) PyFrame_FastToLocals(PyFrameObject *);
 
 PyAPI_FUNC(int) PyFrame_ClearFreeList(void);
+PyAPI_FUNC(int) _PyFrame_TrimFreeList(void);
+PyAPI_FUNC(PyObject *) _PyFrame_GetStats(void);
 
 /* Return the line of code the frame is currently executing. */
 PyAPI_FUNC(int) PyFrame_GetLineNumber(PyFrameObject *);
@@ -19,6 +19,9 @@ typedef PyObject *(*PyCFunction)(PyObject *, PyObject *);
 typedef PyObject *(*PyCFunctionWithKeywords)(PyObject *, PyObject *,
 					     PyObject *);
 typedef PyObject *(*PyNoArgsFunction)(PyObject *);
+typedef PyObject *(*_PyCFunctionFast)(PyObject *, PyObject **, Py_ssize_t);
+typedef PyObject *(*_PyCFunctionFastWithKeywords)(PyObject *, PyObject **,
+                                                  Py_ssize_t, PyObject *);
 
 PyAPI_FUNC(PyCFunction) PyCFunction_GetFunction(PyObject *);
 PyAPI_FUNC(PyObject *) PyCFunction_GetSelf(PyObject *);
@@ -70,6 +73,13 @@ PyAPI_FUNC(PyObject *) PyCFunction_NewEx(PyMethodDef *, PyObject *,
 
 #define METH_COEXIST   0x0040
 
+/* METH_FASTCALL passes the positional arguments as a C array and their
+   number instead of a tuple, so the interpreter can call the function
+   directly from its value stack.  It may be combined with METH_KEYWORDS,
+   then the keywords follow as a dict or NULL.  See _PyCFunctionFast. */
+
+#define METH_FASTCALL  0x0100
+
 #ifdef STACKLESS
 #define METH_STACKLESS 0x0080
 #else
@@ -93,6 +103,11 @@ typedef struct {
 
 PyAPI_FUNC(int) PyCFunction_ClearFreeList(void);
 
+/* Call a METH_FASTCALL method without a bound method object */
+PyAPI_FUNC(PyObject *) _PyMethodDef_FastCall(PyMethodDef *, PyObject *,
+                                             PyObject **, Py_ssize_t,
+                                             PyObject *);
+
 #ifdef __cplusplus
 }
 #endif
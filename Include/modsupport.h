@@ -15,6 +15,9 @@ extern "C" {
 #define PyArg_Parse			_PyArg_Parse_SizeT
 #define PyArg_ParseTuple		_PyArg_ParseTuple_SizeT
 #define PyArg_ParseTupleAndKeywords	_PyArg_ParseTupleAndKeywords_SizeT
+#define _PyArg_ParseStack		_PyArg_ParseStack_SizeT
+#define _PyArg_ParseTupleAndKeywordsFast	_PyArg_ParseTupleAndKeywordsFast_SizeT
+#define _PyArg_ParseStackAndKeywords	_PyArg_ParseStackAndKeywords_SizeT
 #define PyArg_VaParse			_PyArg_VaParse_SizeT
 #define PyArg_VaParseTupleAndKeywords	_PyArg_VaParseTupleAndKeywords_SizeT
 #define Py_BuildValue			_Py_BuildValue_SizeT
@@ -31,6 +34,33 @@ PyAPI_FUNC(int) PyArg_UnpackTuple(PyObject *, const char *, Py_ssize_t, Py_ssize
 PyAPI_FUNC(PyObject *) Py_BuildValue(const char *, ...);
 PyAPI_FUNC(PyObject *) _Py_BuildValue_SizeT(const char *, ...);
 PyAPI_FUNC(int) _PyArg_NoKeywords(const char *funcname, PyObject *kw);
+PyAPI_FUNC(int) _PyArg_ParseStack(PyObject **, Py_ssize_t, const char *, ...);
+PyAPI_FUNC(int) _PyArg_UnpackStack(PyObject **, Py_ssize_t, const char *,
+                                   Py_ssize_t, Py_ssize_t, ...);
+
+/* A precompiled keyword argument parser.  Declare it static next to the
+   function that uses it; the format is checked against the keyword list
+   and the keyword names are interned on first use, so later calls only
+   pay for the conversions:
+
+       static const char * const _keywords[] = {"retval", NULL};
+       static _PyArg_Parser _parser = {"|O:schedule", _keywords};
+*/
+typedef struct _PyArg_Parser {
+    const char *format;
+    const char * const *keywords;
+    const char *fname;
+    const char *custom_msg;
+    int min;                    /* minimal number of arguments */
+    int max;                    /* maximal number of arguments */
+    PyObject *kwtuple;          /* tuple of interned keyword names */
+    struct _PyArg_Parser *next;
+} _PyArg_Parser;
+
+PyAPI_FUNC(int) _PyArg_ParseTupleAndKeywordsFast(PyObject *, PyObject *,
+                                                 _PyArg_Parser *, ...);
+PyAPI_FUNC(int) _PyArg_ParseStackAndKeywords(PyObject **, Py_ssize_t,
+                                             PyObject *, _PyArg_Parser *, ...);
 
 PyAPI_FUNC(int) PyArg_VaParse(PyObject *, const char *, va_list);
 PyAPI_FUNC(int) PyArg_VaParseTupleAndKeywords(PyObject *, PyObject *,
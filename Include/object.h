@@ -424,6 +424,8 @@ typedef struct _typeobject {
     PyBufferProcs as_buffer;
     PyObject *ht_name, *ht_slots;
     slp_methodflags slpflags;
+    /* the table shared by the __dict__s of the instances, or NULL */
+    struct _dictkeysobject *ht_cached_keys;
 #endif
 } PyTypeObject;
 
@@ -451,6 +453,8 @@ typedef struct _heaptypeobject {
                                       see add_operators() in typeobject.c . */
     PyBufferProcs as_buffer;
     PyObject *ht_name, *ht_slots;
+    /* the table shared by the __dict__s of the instances, or NULL */
+    struct _dictkeysobject *ht_cached_keys;
     /* here are optional user slots, followed by the members. */
 } PyHeapTypeObject;
 
@@ -723,7 +727,6 @@ environment the global variable trick is not safe.)
 PyAPI_DATA(Py_ssize_t) _Py_RefTotal;
 PyAPI_FUNC(void) _Py_NegativeRefcount(const char *fname,
                                             int lineno, PyObject *op);
-PyAPI_FUNC(PyObject *) _PyDict_Dummy(void);
 PyAPI_FUNC(PyObject *) _PySet_Dummy(void);
 PyAPI_FUNC(Py_ssize_t) _Py_GetRefTotal(void);
 #define _Py_INC_REFTOTAL        _Py_RefTotal++
@@ -780,6 +783,33 @@ PyAPI_FUNC(void) _Py_AddToAllObjects(PyObject *, int force);
     (*Py_TYPE(op)->tp_dealloc)((PyObject *)(op)))
 #endif /* !Py_TRACE_REFS */
 
+#ifdef Py_IMMORTAL_OBJECTS
+/* An object whose reference count was set to _Py_IMMORTAL_REFCNT, see
+ * gc.freeze(), is never freed, and Py_INCREF() and Py_DECREF() do not
+ * write to it any more, so its memory page stays shared after a fork.
+ * This costs a test in every reference count operation, and the macros
+ * evaluate their argument more than once.
+ */
+#define _Py_IMMORTAL_REFCNT     (PY_SSIZE_T_MAX / 2)
+#define _Py_IsImmortal(op)      \
+    (((PyObject*)(op))->ob_refcnt >= _Py_IMMORTAL_REFCNT)
+
+#define Py_INCREF(op) (                         \
+    _Py_IsImmortal(op) ? (void)0 : (void)(      \
+    _Py_INC_REFTOTAL  _Py_REF_DEBUG_COMMA       \
+    ((PyObject*)(op))->ob_refcnt++))
+
+#define Py_DECREF(op)                                   \
+    do {                                                \
+        if (_Py_IsImmortal(op))                         \
+            ;                                           \
+        else if (_Py_DEC_REFTOTAL  _Py_REF_DEBUG_COMMA  \
+        --((PyObject*)(op))->ob_refcnt != 0)            \
+            _Py_CHECK_REFCNT(op)                        \
+        else                                            \
+        _Py_Dealloc((PyObject *)(op));                  \
+    } while (0)
+#else
 #define Py_INCREF(op) (                         \
     _Py_INC_REFTOTAL  _Py_REF_DEBUG_COMMA       \
     ((PyObject*)(op))->ob_refcnt++)
@@ -792,6 +822,7 @@ PyAPI_FUNC(void) _Py_AddToAllObjects(PyObject *, int force);
         else                                            \
         _Py_Dealloc((PyObject *)(op));                  \
     } while (0)
+#endif /* Py_IMMORTAL_OBJECTS */
 
 /* Safely decref `op` and set `op` to NULL, especially useful in tp_clear
  * and tp_dealloc implementatons.
@@ -98,6 +98,52 @@ PyAPI_FUNC(void *) PyObject_Malloc(size_t);
 PyAPI_FUNC(void *) PyObject_Realloc(void *, size_t);
 PyAPI_FUNC(void) PyObject_Free(void *);
 
+#ifdef WITH_PYMALLOC
+/* Statistics of the object allocator, for sys.getmallocstats(). */
+#define PyMalloc_MAX_CLASSES 64
+
+typedef struct {
+    size_t size;                /* block size of the class */
+    size_t pools;               /* pools in use */
+    size_t blocks;              /* allocated blocks */
+    size_t free_blocks;         /* free blocks in the pools in use */
+} _PyMallocClassStats;
+
+typedef struct {
+    size_t arena_size;
+    size_t pool_size;
+    int hugepages;
+    size_t arenas;              /* arenas allocated now */
+    size_t arenas_allocated;    /* arenas ever allocated */
+    size_t arenas_highwater;    /* most arenas allocated at once */
+    size_t free_pools;          /* pools in arenas not in use */
+    size_t sample_rate;
+    size_t samples_lost;        /* samples that found no room */
+    int nclasses;
+    _PyMallocClassStats classes[PyMalloc_MAX_CLASSES];
+} _PyMallocStats;
+
+PyAPI_FUNC(void) _PyObject_GetMallocStats(_PyMallocStats *stats);
+
+/* Sampling of the sites that allocate blocks, for sys.setmallocsampling()
+   and sys.getmallocsamples().  where() returns the key and the line of the
+   current site; hold(key, 1) keeps a key that a new site stores, and
+   hold(key, -1) lets it go when the samples are discarded. */
+typedef struct {
+    void *(*where)(int *lineno);
+    void (*hold)(void *key, int incr);
+} _PyMallocSampler;
+
+typedef int (*_PyMallocSampleVisit)(size_t size, void *key, int lineno,
+                                    size_t allocated, size_t live,
+                                    void *arg);
+
+PyAPI_FUNC(int) _PyObject_SetMallocSampling(Py_ssize_t rate,
+                                            const _PyMallocSampler *sampler);
+PyAPI_FUNC(int) _PyObject_VisitMallocSamples(_PyMallocSampleVisit visit,
+                                             void *arg);
+#endif
+
 
 /* Macros */
 #ifdef WITH_PYMALLOC
@@ -234,6 +280,33 @@ PyAPI_FUNC(PyVarObject *) _PyObject_NewVar(PyTypeObject *, Py_ssize_t);
 /* C equivalent of gc.collect(). */
 PyAPI_FUNC(Py_ssize_t) PyGC_Collect(void);
 
+/* C equivalent of gc.collect_step(step). */
+PyAPI_FUNC(Py_ssize_t) PyGC_CollectStep(Py_ssize_t step);
+
+/* Collection monitoring.  The hook is called with PyGC_START before each
+ * collection and with PyGC_STOP after it.  generation is the generation
+ * collected, or PyGC_INCREMENTAL for a step of an incremental pass, and
+ * start is the time the collection started, in seconds of a monotonic
+ * clock.  The other fields are only set for PyGC_STOP.  The hook runs in
+ * the middle of the collector: it must not call into Python, nor create
+ * or destroy objects.  Passing NULL removes it.
+ */
+typedef struct {
+    int generation;
+    double start;
+    double duration;           /* seconds */
+    Py_ssize_t examined;       /* objects looked at */
+    Py_ssize_t collected;      /* unreachable objects freed */
+    Py_ssize_t uncollectable;  /* unreachable objects put into gc.garbage */
+} PyGC_Info;
+
+#define PyGC_START              0
+#define PyGC_STOP               1
+#define PyGC_INCREMENTAL        3
+
+typedef void (*PyGC_Hook)(int event, PyGC_Info *info, void *arg);
+PyAPI_FUNC(void) PyGC_SetHook(PyGC_Hook hook, void *arg);
+
 /* Test if a type has a GC head */
 #define PyType_IS_GC(t) PyType_HasFeature((t), Py_TPFLAGS_HAVE_GC)
 
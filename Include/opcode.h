@@ -150,6 +150,14 @@ extern "C" {
 #define SET_ADD         146
 #define MAP_ADD         147
 
+/* Superinstructions, emitted by the peephole optimizer.  Each one
+   replaces the first of a pair of instructions and has its argument;
+   the second instruction follows unchanged. */
+#define LOAD_FAST__LOAD_FAST            148
+#define LOAD_FAST__LOAD_ATTR            149
+#define COMPARE_OP__POP_JUMP_IF_FALSE   150
+#define LOAD_CONST__RETURN_VALUE        151
+
 
 enum cmp_op {PyCmp_LT=Py_LT, PyCmp_LE=Py_LE, PyCmp_EQ=Py_EQ, PyCmp_NE=Py_NE, PyCmp_GT=Py_GT, PyCmp_GE=Py_GE,
 	     PyCmp_IN, PyCmp_NOT_IN, PyCmp_IS, PyCmp_IS_NOT, PyCmp_EXC_MATCH, PyCmp_BAD};
@@ -331,7 +331,7 @@ class Counter(dict):
     >>> c = Counter('abracadabra')      # count elements from a string
 
     >>> c.most_common(3)                # three most common elements
-    [('a', 5), ('r', 2), ('b', 2)]
+    [('a', 5), ('b', 2), ('r', 2)]
     >>> sorted(c)                       # list all unique elements
     ['a', 'b', 'c', 'd', 'r']
     >>> ''.join(sorted(c.elements()))   # list elements with repetitions
@@ -397,7 +397,7 @@ class Counter(dict):
         common to the least.  If n is None, then list all element counts.
 
         >>> Counter('abracadabra').most_common(3)
-        [('a', 5), ('r', 2), ('b', 2)]
+        [('a', 5), ('b', 2), ('r', 2)]
 
         '''
         # Emulate Bag.sortedByCount from Smalltalk
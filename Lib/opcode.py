@@ -189,4 +189,15 @@ EXTENDED_ARG = 145
 def_op('SET_ADD', 146)
 def_op('MAP_ADD', 147)
 
+# Superinstructions: the first instruction of a pair is replaced, the
+# second one follows unchanged.  The argument is the first one's.
+def_op('LOAD_FAST__LOAD_FAST', 148)
+haslocal.append(148)
+def_op('LOAD_FAST__LOAD_ATTR', 149)
+haslocal.append(149)
+def_op('COMPARE_OP__POP_JUMP_IF_FALSE', 150)
+hascompare.append(150)
+def_op('LOAD_CONST__RETURN_VALUE', 151)
+hasconst.append(151)
+
 del def_op, name_op, jrel_op, jabs_op
@@ -749,6 +749,48 @@ class CommonTest(unittest.TestCase):
         self.checkraises(TypeError, 'hello', 'replace', 42, 'h')
         self.checkraises(TypeError, 'hello', 'replace', 'h', 42)
 
+    def test_long_strings(self):
+        # strings longer than a few dozen characters are searched a
+        # vector of positions at a time; put the matches on either side
+        # of the vector boundaries
+        for n in (31, 32, 33, 63, 64, 65, 100, 129):
+            for pos in (0, 1, 15, 16, 17, 31, 32, n - 2, n - 1):
+                for sub in ('x', 'xy', 'xyz', 'x' + 'y' * 30 + 'z'):
+                    if pos + len(sub) > n:
+                        continue
+                    tail = 'b' * (n - pos - len(sub))
+                    s = 'a' * pos + sub + tail
+                    self.checkequal(pos, s, 'find', sub)
+                    self.checkequal(pos, s, 'rfind', sub)
+                    self.checkequal(1, s, 'count', sub)
+                    self.checkequal(-1, s, 'find', sub + 'a')
+                    self.checkequal(['a' * pos, tail], s, 'split', sub)
+                    self.checkequal(['a' * pos, tail], s, 'rsplit', sub)
+                    self.checkequal('a' * pos + '-' + tail, s, 'replace',
+                                    sub, '-')
+            s = 'ab' * n
+            self.checkequal(n, s, 'count', 'b')
+            self.checkequal(n, s, 'count', 'ab')
+            self.checkequal((2 * n + 1) // 4, s, 'count', 'aba')
+            self.checkequal(1, s, 'count', 'b', 2 * n - 1)
+            self.checkequal(2 * n - 1, s, 'rfind', 'b')
+            self.checkequal(2 * n - 2, s, 'rfind', 'ab')
+            self.checkequal([''] * (n + 1), s, 'split', 'ab')
+            self.checkequal(['a'] * n + [''], s, 'split', 'b')
+            self.checkequal([''] + ['b'] * n, s, 'rsplit', 'a')
+
+            words = ['w%d' % i + 'x' * (i * 7 % 40) for i in range(n // 8)]
+            seps = [' ', '\t\n', ' \r\x0b\x0c ', ' ' * 40]
+            s = '\n ' + words[0] + ''.join([seps[i % len(seps)] + word
+                                           for i, word in
+                                           enumerate(words[1:])]) + ' \t'
+            self.checkequal(words, s, 'split')
+            self.checkequal(words, s, 'rsplit')
+            self.assertEqual(self.fixtype(s).split(None, 2)[:2],
+                             self.fixtype(words[:2]))
+            self.assertEqual(self.fixtype(s).rsplit(None, 2)[-2:],
+                             self.fixtype(words[-2:]))
+
     def test_replace_overflow(self):
         # Check for overflow checking on 32 bit machines
         if sys.maxint != 2147483647 or struct.calcsize("P") > 4:
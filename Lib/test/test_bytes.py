@@ -283,6 +283,24 @@ class BaseBytesTest(unittest.TestCase):
         self.assertEqual(b.count(b'ss'), 2)
         self.assertEqual(b.count(b'w'), 0)
 
+    def test_long_search(self):
+        # long enough to be searched a vector of positions at a time
+        for data in (b'a' * 40 + b'xyz' + b'b' * 40,
+                     b'ab' * 50 + b'x',
+                     b'  arf\tbarf\n' * 10 + b'arfbarfarfbarf' * 5):
+            b = self.type2test(data)
+            for sub in (b'x', b'b', b'ab', b'aba', b'xyz', b'arf', b'barf' * 4):
+                self.assertEqual(b.find(sub), data.find(sub))
+                self.assertEqual(b.rfind(sub), data.rfind(sub))
+                self.assertEqual(b.count(sub), data.count(sub))
+                self.assertEqual(b.split(sub), data.split(sub))
+                self.assertEqual(b.rsplit(sub), data.rsplit(sub))
+                self.assertEqual(b.replace(sub, b'-'), data.replace(sub, b'-'))
+            self.assertEqual(b.split(), data.split())
+            self.assertEqual(b.rsplit(), data.rsplit())
+            self.assertEqual(b.split(None, 3), data.split(None, 3))
+            self.assertEqual(b.rsplit(None, 3), data.rsplit(None, 3))
+
     def test_startswith(self):
         b = self.type2test(b'hello')
         self.assertFalse(self.type2test().startswith(b"anything"))
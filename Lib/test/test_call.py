@@ -126,8 +126,77 @@ class CFunctionCalls(unittest.TestCase):
         self.assertRaises(TypeError, [].count, x=2, y=2)
 
 
+class FastCalls(unittest.TestCase):
+    # isinstance(), dict.get() and str.find() use METH_FASTCALL,
+    # min() and max() METH_FASTCALL | METH_KEYWORDS
+
+    def test_fastcall(self):
+        self.assertTrue(isinstance(1, int))
+        self.assertEqual({1: 2}.get(1), 2)
+        self.assertEqual({1: 2}.get(3, 4), 4)
+        self.assertEqual('abc'.find('c'), 2)
+        self.assertEqual('abcabc'.find('b', 2, None), 4)
+
+    def test_fastcall_errors(self):
+        self.assertRaises(TypeError, isinstance, 1)
+        self.assertRaises(TypeError, isinstance, 1, int, 2)
+        self.assertRaises(TypeError, {}.get)
+        self.assertRaises(TypeError, {}.get, 1, 2, 3)
+        self.assertRaises(TypeError, 'abc'.find)
+        self.assertRaises(TypeError, 'abc'.find, 'a', 'b')
+
+    def test_fastcall_ext(self):
+        self.assertTrue(isinstance(*(1, int)))
+        self.assertEqual({1: 2}.get(*(1,)), 2)
+        self.assertEqual(apply('abc'.find, ('b',)), 1)
+
+    def test_fastcall_kw(self):
+        self.assertRaises(TypeError, isinstance, 1, int, x=2)
+        self.assertRaises(TypeError, {}.get, 1, default=2)
+        self.assertRaises(TypeError, 'abc'.find, 'b', start=2)
+
+    def test_fastcall_descriptor(self):
+        self.assertEqual(dict.get({1: 2}, 1), 2)
+        self.assertEqual(str.find('abc', 'b'), 1)
+        self.assertEqual(str.strip(' a '), 'a')
+        self.assertRaises(TypeError, dict.get)
+        self.assertRaises(TypeError, dict.get, 1, 2)
+        self.assertRaises(TypeError, str.find, 'abc', 'b', start=2)
+        self.assertEqual(dict.get(*({1: 2}, 1)), 2)
+
+    def test_fastcall_keywords(self):
+        self.assertEqual(min(3, 1, 2), 1)
+        self.assertEqual(max([3, 1, 2]), 3)
+        self.assertEqual(min(3, 1, 2, key=lambda x: -x), 3)
+        self.assertEqual(max(*(3, 1, 2), **{'key': lambda x: -x}), 1)
+        self.assertRaises(TypeError, min)
+        self.assertRaises(TypeError, max, 1, 2, foo=3)
+        self.assertRaises(ValueError, min, [])
+
+    def test_profile(self):
+        import sys
+        events = []
+        def profiler(frame, event, arg):
+            if event.startswith('c_'):
+                events.append((event, arg.__name__))
+        sys.setprofile(profiler)
+        try:
+            isinstance(1, int)
+            try:
+                min()
+            except TypeError:
+                pass
+        finally:
+            sys.setprofile(None)
+        self.assertEqual(events, [('c_call', 'isinstance'),
+                                  ('c_return', 'isinstance'),
+                                  ('c_call', 'min'),
+                                  ('c_exception', 'min'),
+                                  ('c_call', 'setprofile')])
+
+
 def test_main():
-    test_support.run_unittest(CFunctionCalls)
+    test_support.run_unittest(CFunctionCalls, FastCalls)
 
 
 if __name__ == "__main__":
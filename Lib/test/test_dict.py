@@ -651,6 +651,251 @@ class DictTest(unittest.TestCase):
         self._tracked(MyDict())
 
 
+class SplitDictTest(unittest.TestCase):
+    # The __dict__s of the instances of a class share one table of keys
+
+    def _make(self, cls, n, names='abcde'):
+        objs = []
+        for i in range(n):
+            o = cls()
+            for name in names:
+                setattr(o, name, (name, i))
+            objs.append(o)
+        return objs
+
+    def _check(self, cls):
+        objs = self._make(cls, 10)
+        for i, o in enumerate(objs):
+            self.assertEqual(o.__dict__,
+                             dict((name, (name, i)) for name in 'abcde'))
+            self.assertEqual(sorted(o.__dict__.items()),
+                             [(name, (name, i)) for name in 'abcde'])
+        return objs
+
+    def test_newstyle(self):
+        class C(object):
+            pass
+        self._check(C)
+
+    def test_oldstyle(self):
+        class C:
+            pass
+        self._check(C)
+
+    @test_support.cpython_only
+    def test_sizeof(self):
+        import sys
+        class C(object):
+            pass
+        class D:
+            pass
+        for cls in C, D:
+            a, b = self._make(cls, 2)
+            plain = dict(a.__dict__)
+            self.assertLess(sys.getsizeof(b.__dict__), sys.getsizeof(plain))
+
+    def test_diverge(self):
+        class C(object):
+            pass
+        a, b = self._make(C, 2)
+        b.x = 1                         # a new key is fine
+        c = C()
+        c.e = 1                         # so is another order
+        c.a = 2
+        a.__dict__[1] = 'one'           # a non-string key is not
+        d = C()
+        for name in 'abcdefghijklmnopqrstuvwxyz':
+            setattr(d, name, name)      # neither is outgrowing the table
+        self.assertEqual(a.__dict__[1], 'one')
+        self.assertEqual(a.a, ('a', 0))
+        self.assertEqual(b.x, 1)
+        self.assertFalse(hasattr(a, 'x'))
+        self.assertEqual((c.a, c.e), (2, 1))
+        self.assertEqual(len(c.__dict__), 2)
+        self.assertEqual(d.z, 'z')
+        self.assertEqual(len(d.__dict__), 26)
+        e, = self._make(C, 1)
+        self.assertEqual(e.__dict__, dict((name, (name, 0)) for name in 'abcde'))
+
+    def test_delete(self):
+        class C(object):
+            pass
+        a, b = self._make(C, 2)
+        del a.c
+        self.assertFalse(hasattr(a, 'c'))
+        self.assertEqual(b.c, ('c', 1))
+        self.assertRaises(AttributeError, delattr, a, 'c')
+        self.assertEqual(len(a.__dict__), 4)
+        a.c = 3
+        self.assertEqual(a.c, 3)
+        self.assertEqual(len(a.__dict__), 5)
+        self.assertEqual(a.__dict__.pop('d'), ('d', 0))
+        self.assertRaises(KeyError, a.__dict__.pop, 'd')
+        self.assertEqual(sorted(a.__dict__), ['a', 'b', 'c', 'e'])
+
+    def test_dict_methods(self):
+        class C(object):
+            pass
+        a, b = self._make(C, 2)
+        c = a.__dict__.copy()
+        self.assertEqual(c, a.__dict__)
+        c['x'] = 1
+        self.assertNotIn('x', a.__dict__)
+        self.assertNotEqual(a.__dict__, b.__dict__)
+        items = []
+        while b.__dict__:
+            items.append(b.__dict__.popitem())
+        self.assertEqual(sorted(items), [(name, (name, 1)) for name in 'abcde'])
+        b.a = 1
+        self.assertEqual(b.__dict__, {'a': 1})
+        a.__dict__.clear()
+        self.assertEqual(a.__dict__, {})
+        a.a = 2
+        self.assertEqual(a.a, 2)
+        self.assertEqual(c.get('b'), ('b', 0))
+        self.assertEqual(c.setdefault('y', 5), 5)
+        c.update(a.__dict__)
+        self.assertEqual(c['a'], 2)
+        self.assertEqual(list(iter(a.__dict__)), ['a'])
+        self.assertEqual(list(a.__dict__.itervalues()), [2])
+
+    def test_iteration_mutation(self):
+        class C(object):
+            pass
+        a, = self._make(C, 1)
+        def mutate():
+            for k in a.__dict__:
+                a.z = 1
+        self.assertRaises(RuntimeError, mutate)
+
+    def test_copy_and_pickle(self):
+        import copy, pickle
+        # pickle needs a module level class
+        objs = self._make(Shared, 3)
+        for o in objs:
+            for proto in range(pickle.HIGHEST_PROTOCOL + 1):
+                o2 = pickle.loads(pickle.dumps(o, proto))
+                self.assertEqual(o2.__dict__, o.__dict__)
+            self.assertEqual(copy.deepcopy(o).__dict__, o.__dict__)
+
+    def test_gc(self):
+        class C(object):
+            pass
+        a, b = self._make(C, 2)
+        a.b = b
+        b.a = a
+        r = weakref.ref(a)
+        del a, b
+        gc.collect()
+        self.assertIs(r(), None)
+
+    def test_replaced_dict(self):
+        class C(object):
+            pass
+        a, = self._make(C, 1)
+        a.__dict__ = {'x': 1}
+        a.y = 2
+        self.assertEqual(a.__dict__, {'x': 1, 'y': 2})
+        b, = self._make(C, 1)
+        self.assertEqual(b.e, ('e', 0))
+
+class OrderTest(unittest.TestCase):
+    # Dicts keep their items in a dense array, in insertion order
+
+    def _keys(self, n):
+        # strings and ints that collide a lot in a small table
+        return ['k%d' % i for i in range(n)] + [i << 16 for i in range(n)]
+
+    def test_order(self):
+        keys = self._keys(10)
+        d = {}
+        for i, k in enumerate(keys):
+            d[k] = i
+        self.assertEqual(d.keys(), keys)
+        self.assertEqual(list(d), keys)
+        self.assertEqual(d.values(), range(len(keys)))
+        self.assertEqual(list(d.iteritems()), zip(keys, range(len(keys))))
+        self.assertEqual(list(d.viewkeys()), keys)
+        d[keys[3]] = 'x'                # rebinding keeps the position
+        self.assertEqual(d.keys(), keys)
+        self.assertEqual(d.keys(), dict(d).keys())
+        self.assertEqual(d.keys(), d.copy().keys())
+        self.assertEqual(dict.fromkeys(keys).keys(), keys)
+
+    def test_delete(self):
+        keys = self._keys(10)
+        d = dict.fromkeys(keys)
+        del d[keys[0]]
+        self.assertEqual(d.pop(keys[5]), None)
+        d[keys[0]] = 1                  # a reinserted key goes last
+        self.assertEqual(d.keys(), keys[1:5] + keys[6:] + keys[:1])
+        self.assertNotIn(keys[5], d)
+        for k in keys[1:5] + keys[6:]:
+            del d[k]
+        self.assertEqual(d.items(), [(keys[0], 1)])
+
+    def test_popitem(self):
+        keys = self._keys(10)
+        d = dict.fromkeys(keys)
+        del d[keys[-1]]
+        self.assertEqual(d.popitem(), (keys[-2], None))
+        d['x'] = 1
+        self.assertEqual(d.popitem(), ('x', 1))
+        popped = []
+        while d:
+            popped.append(d.popitem()[0])
+        self.assertEqual(popped, keys[-3::-1])
+
+    def test_resize(self):
+        # tables with 1, 2 and 4 byte indices
+        for n in (5, 100, 30000):
+            keys = range(n, 0, -1)
+            d = {}
+            for k in keys:
+                d[k] = k
+            self.assertEqual(d.keys(), keys)
+            for k in keys[::2]:
+                del d[k]
+            self.assertEqual(d.keys(), keys[1::2])
+            for k in keys[::2]:
+                d[k] = k
+            self.assertEqual(d.keys(), keys[1::2] + keys[::2])
+            self.assertEqual(len(d), n)
+            for k in keys:
+                self.assertEqual(d[k], k)
+
+    def test_many_deletions(self):
+        # the entries fill up with deleted ones and get compacted
+        d = {}
+        for i in range(1000):
+            d[i] = i
+            d['x'] = i
+            del d[i]
+        self.assertEqual(d, {'x': 999})
+
+    def test_split_order(self):
+        class C(object):
+            pass
+        a, b, c = C(), C(), C()
+        a.x, a.y, a.z = 1, 2, 3
+        b.x, b.y = 1, 2
+        c.y, c.x = 2, 1                 # not in the order of the class
+        self.assertEqual(vars(a).keys(), ['x', 'y', 'z'])
+        self.assertEqual(vars(b).keys(), ['x', 'y'])
+        self.assertEqual(vars(c).keys(), ['y', 'x'])
+        b.z = 3
+        b.w = 4
+        self.assertEqual(vars(b).keys(), ['x', 'y', 'z', 'w'])
+        del a.x
+        a.x = 1
+        self.assertEqual(vars(a).keys(), ['y', 'z', 'x'])
+        self.assertEqual(vars(C()).keys(), [])
+
+
+class Shared(object):
+    pass
+
+
 from test import mapping_tests
 
 class GeneralMappingTests(mapping_tests.BasicTestMappingProtocol):
@@ -668,6 +913,8 @@ def test_main():
          DeprecationWarning)):
         test_support.run_unittest(
             DictTest,
+            SplitDictTest,
+            OrderTest,
             GeneralMappingTests,
             SubclassMappingTests,
         )
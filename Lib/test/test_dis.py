@@ -16,7 +16,7 @@ dis_f = """\
               3 PRINT_ITEM
               4 PRINT_NEWLINE
 
- %-4d         5 LOAD_CONST               1 (1)
+ %-4d         5 LOAD_CONST__RETURN_VALUE     1 (1)
               8 RETURN_VALUE
 """%(_f.func_code.co_firstlineno + 1,
      _f.func_code.co_firstlineno + 2)
@@ -40,7 +40,7 @@ dis_bug708901 = """\
 
  %-4d        22 JUMP_ABSOLUTE           16
         >>   25 POP_BLOCK
-        >>   26 LOAD_CONST               0 (None)
+        >>   26 LOAD_CONST__RETURN_VALUE     0 (None)
              29 RETURN_VALUE
 """%(bug708901.func_code.co_firstlineno + 1,
      bug708901.func_code.co_firstlineno + 2,
@@ -69,7 +69,7 @@ dis_bug1333982 = """\
              34 BINARY_ADD
              35 RAISE_VARARGS            2
 
- %-4d   >>   38 LOAD_CONST               0 (None)
+ %-4d   >>   38 LOAD_CONST__RETURN_VALUE     0 (None)
              41 RETURN_VALUE
 """%(bug1333982.func_code.co_firstlineno + 1,
      bug1333982.func_code.co_firstlineno + 2,
@@ -78,7 +78,7 @@ dis_bug1333982 = """\
 _BIG_LINENO_FORMAT = """\
 %3d           0 LOAD_GLOBAL              0 (spam)
               3 POP_TOP
-              4 LOAD_CONST               0 (None)
+              4 LOAD_CONST__RETURN_VALUE     0 (None)
               7 RETURN_VALUE
 """
 
@@ -464,6 +464,32 @@ class ExceptionTests(unittest.TestCase):
             self.assertTrue(e is RuntimeError, e)
             self.assertIn("maximum recursion depth exceeded", str(v))
 
+    def test_bare_stopiteration(self):
+        # a bare "raise StopIteration" is normalized only when caught
+        try:
+            raise StopIteration
+        except StopIteration, e:
+            self.assertIsInstance(e, StopIteration)
+            self.assertEqual(e.args, ())
+            self.assertIs(sys.exc_info()[1], e)
+        def gen():
+            yield 1
+            raise StopIteration
+        self.assertEqual(list(gen()), [1])
+        self.assertEqual([x for x in gen()], [1])
+        g = gen()
+        next(g)
+        try:
+            next(g)
+        except StopIteration, e:
+            self.assertIsInstance(e, StopIteration)
+        else:
+            self.fail("StopIteration not raised")
+        def raiser():
+            raise StopIteration
+        it = iter(raiser, None)
+        self.assertEqual(list(it), [])
+
 
 
 # Helper class used by TestSameStrAndUnicodeMsg
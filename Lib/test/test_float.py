@@ -621,6 +621,49 @@ class ReprTestCase(unittest.TestCase):
             self.assertEqual(s, repr(float(s)))
             self.assertEqual(negs, repr(float(negs)))
 
+    @unittest.skipUnless(getattr(sys, 'float_repr_style', '') == 'short',
+                         "applies only when using short float repr style")
+    @requires_IEEE_754
+    def test_shortest_repr(self):
+        # repr() of a float is the shortest string that round-trips, and
+        # the closest such string when there is a choice.  The correctly
+        # rounded n-digit string '%.*e' % (n - 1, x) is the closest of its
+        # length, so the first one that round-trips gives the answer,
+        # except at powers of two, where a string of that length below the
+        # correctly rounded one may also round-trip.
+        def check(x):
+            r = repr(x)
+            self.assertEqual(float(r), x, r)
+            mantissa = r.lstrip('-').split('e')[0].replace('.', '')
+            ndigits = len(mantissa.strip('0') or '0')
+            for n in range(1, 18):
+                s = '%.*e' % (n - 1, x)
+                if float(s) == x:
+                    break
+            self.assertLessEqual(ndigits, n, r)
+            if ndigits == n:
+                self.assertEqual(mantissa.strip('0'),
+                                 s.lstrip('-').split('e')[0].replace('.', '')
+                                 .strip('0'), (r, s))
+
+        specials = [5e-324, 1e-323, 2.2250738585072014e-308,
+                    2.2250738585072009e-308, 1.7976931348623157e308,
+                    1e23, 9007199254740993.0, 0.1, 0.3, 1/3.0, 2**-1074,
+                    2.0**63, 2.0**-44, 123456789012345680.0]
+        for x in specials:
+            check(x)
+            check(-x)
+        for e in range(-1074, 1024):
+            x = ldexp(1.0, e)
+            check(x)
+            if e > -1022:
+                # the float just below the power of two
+                check(x * (1.0 - 2.0**-53))
+        for i in range(10000):
+            bits = random.randrange(2047 * 2**52)
+            check(struct.unpack('<d', struct.pack('<Q', bits))[0])
+            check(random.random())
+
 
 @requires_IEEE_754
 class RoundTestCase(unittest.TestCase):
@@ -1,6 +1,7 @@
 import unittest
 from test.test_support import verbose, run_unittest
 import sys
+import os
 import gc
 import weakref
 
@@ -446,6 +447,268 @@ class GCTests(unittest.TestCase):
         self.assertTrue(gc.is_tracked([]))
         self.assertTrue(gc.is_tracked(set()))
 
+    def test_freeze(self):
+        class A(object):
+            pass
+        a = A()
+        a.cycle = a
+        wr = weakref.ref(a)
+        gc.freeze()
+        try:
+            self.assertEqual(gc.get_count()[1:], (0, 0))
+            self.assertGreater(gc.get_freeze_count(), 0)
+            del a
+            # frozen garbage is not collected
+            gc.collect()
+            self.assertIsNot(wr(), None)
+        finally:
+            gc.unfreeze()
+        self.assertEqual(gc.get_freeze_count(), 0)
+        gc.collect()
+        self.assertIs(wr(), None)
+        self.assertRaises(TypeError, gc.freeze, 1, 2)
+
+    def _in_child(self, func):
+        # return func() as computed by a forked child
+        r, w = os.pipe()
+        pid = os.fork()
+        if pid == 0:
+            try:
+                try:
+                    result = (True, func())
+                except Exception:
+                    import traceback
+                    result = (False, traceback.format_exc())
+                os.write(w, repr(result))
+            finally:
+                os._exit(0)
+        os.close(w)
+        try:
+            chunks = []
+            while True:
+                chunk = os.read(r, 4096)
+                if not chunk:
+                    break
+                chunks.append(chunk)
+        finally:
+            os.close(r)
+            os.waitpid(pid, 0)
+        ok, result = eval("".join(chunks))
+        if not ok:
+            self.fail(result)
+        return result
+
+    def _copied_by(self, func):
+        # kB of memory the process copied from its parent while running func
+        def private_dirty():
+            total = 0
+            with open("/proc/self/smaps") as f:
+                for line in f:
+                    if line.startswith("Private_Dirty:"):
+                        total += int(line.split()[1])
+            return total
+        before = private_dirty()
+        func()
+        return private_dirty() - before
+
+    @unittest.skipUnless(hasattr(os, "fork") and
+                         os.path.exists("/proc/self/smaps"),
+                         "needs fork() and /proc/self/smaps")
+    def test_freeze_fork(self):
+        data = [[] for i in xrange(200000)]
+        gc.collect()
+        unfrozen = self._in_child(lambda: self._copied_by(gc.collect))
+        gc.freeze()
+        try:
+            frozen = self._in_child(lambda: self._copied_by(gc.collect))
+        finally:
+            gc.unfreeze()
+        # a collection in the child copies the pages of the objects it
+        # scans, the frozen ones stay shared
+        self.assertGreater(unfrozen, 4000)
+        self.assertLess(frozen * 4, unfrozen, (frozen, unfrozen))
+
+    @unittest.skipUnless(hasattr(os, "fork") and
+                         os.path.exists("/proc/self/smaps"),
+                         "needs fork() and /proc/self/smaps")
+    def test_immortal_fork(self):
+        data = [[] for i in xrange(200000)]
+        def touch():
+            for x in data:
+                len(x)
+        def immortal():
+            # runs in a child, so the objects of the tests stay mortal
+            try:
+                gc.freeze(True)
+            except ValueError:
+                return None
+            return self._in_child(lambda: self._copied_by(touch))
+        mortal = self._in_child(lambda: self._copied_by(touch))
+        self.assertGreater(mortal, 4000)
+        copied = self._in_child(immortal)
+        if copied is None:
+            self.skipTest("needs a Py_IMMORTAL_OBJECTS build")
+        # reference counting no longer writes to the shared pages
+        self.assertLess(copied * 4, mortal, (copied, mortal))
+
+    def _steps(self, alive, step=100, limit=1000):
+        # run incremental steps until alive() is false, return their number
+        for i in xrange(limit):
+            if not alive():
+                return i
+            gc.collect_step(step)
+        self.fail("garbage survived %d steps" % limit)
+
+    def test_incremental(self):
+        class A(object):
+            pass
+        self.assertRaises(ValueError, gc.set_incremental, -1)
+        self.assertRaises(ValueError, gc.collect_step, 0)
+        live = []
+        for i in xrange(1000):
+            a = A()
+            a.cycle = a
+            live.append(a)
+        garbage = [A() for i in xrange(1000)]
+        for a in garbage:
+            a.cycle = a
+        wrs = [weakref.ref(a) for a in garbage]
+        gc.collect()
+        del a, garbage
+        step = gc.get_incremental()
+        gc.set_incremental(100)
+        try:
+            self.assertEqual(gc.get_incremental(), 100)
+            # a step only looks at a part of the oldest generation
+            gc.collect_step()
+            self.assertTrue(any(wr() is not None for wr in wrs))
+            self._steps(lambda: any(wr() is not None for wr in wrs))
+            gc.set_incremental(0)
+            self.assertEqual(gc.get_incremental(), 0)
+            self.assertRaises(ValueError, gc.collect_step)
+        finally:
+            gc.set_incremental(step)
+        for a in live:
+            self.assertIs(a.cycle, a)
+        self.assertIn(live[0], gc.get_objects())
+
+    def test_incremental_cycle_in_step(self):
+        # the objects a step takes bring the cycles they are in along
+        class Node(object):
+            pass
+        nodes = [Node() for i in xrange(20)]
+        for i, node in enumerate(nodes):
+            node.next = nodes[(i + 1) % len(nodes)]
+        wr = weakref.ref(nodes[0])
+        gc.collect()
+        del node, nodes
+        self._steps(lambda: wr() is not None, 1000)
+
+    def test_incremental_large_cycle(self):
+        class Node(object):
+            pass
+        nodes = [Node() for i in xrange(500)]
+        for i, node in enumerate(nodes):
+            node.next = nodes[(i + 1) % len(nodes)]
+        wr = weakref.ref(nodes[0])
+        gc.collect()
+        del node, nodes
+        # a cycle larger than a step survives the steps...
+        for i in xrange(20):
+            gc.collect_step(10)
+        self.assertIsNot(wr(), None)
+        # ...but not a full collection
+        gc.collect()
+        self.assertIs(wr(), None)
+
+    def test_incremental_frozen(self):
+        class A(object):
+            pass
+        a = A()
+        a.cycle = a
+        wr = weakref.ref(a)
+        gc.freeze()
+        try:
+            del a
+            frozen = gc.get_freeze_count()
+            for i in xrange(10):
+                gc.collect_step(1000)
+            self.assertEqual(gc.get_freeze_count(), frozen)
+            self.assertIsNot(wr(), None)
+        finally:
+            gc.unfreeze()
+        self._steps(lambda: wr() is not None)
+
+    def test_pause_histogram(self):
+        gc.get_pause_histogram(True)
+        hists = gc.get_pause_histogram()
+        self.assertEqual(len(hists), 4)
+        for hist in hists:
+            self.assertEqual(set(hist), set([0]))
+        gc.collect(0)
+        gc.collect()
+        gc.collect()
+        gc.collect_step(10)
+        hists = gc.get_pause_histogram(True)
+        self.assertEqual([sum(hist) for hist in hists], [1, 0, 2, 1])
+        self.assertEqual(len(set(map(len, hists))), 1)
+        self.assertEqual(sum(map(sum, gc.get_pause_histogram())), 0)
+
+    def test_get_stats(self):
+        class A(object):
+            pass
+        class Uncollectable:
+            def __del__(self):
+                pass
+        keys = set(["collections", "examined", "collected", "uncollectable",
+                    "time", "max_pause", "last_pause"])
+        gc.get_stats(True)
+        stats = gc.get_stats()
+        self.assertEqual(len(stats), 4)
+        for st in stats[:3]:
+            self.assertEqual(set(st), keys)
+        self.assertEqual(set(stats[3]), keys | set(["passes",
+                         "last_pass_steps", "last_pass_time"]))
+        for st in stats:
+            self.assertEqual(set(st.values()), set([0]))
+
+        a = A()
+        a.cycle = a
+        u = Uncollectable()
+        u.cycle = u
+        del a, u
+        gc.collect(0)
+        gc.collect()
+        stats = gc.get_stats(True)
+        try:
+            self.assertEqual(stats[0]["collections"], 1)
+            self.assertEqual(stats[0]["collected"], 2)  # a and its __dict__
+            self.assertEqual(stats[0]["uncollectable"], 2)
+            self.assertEqual(stats[1]["collections"], 0)
+            self.assertEqual(stats[2]["collections"], 1)
+            self.assertGreater(stats[2]["examined"], stats[0]["examined"])
+            for st in stats[0], stats[2]:
+                self.assertGreaterEqual(st["max_pause"], st["last_pause"])
+                self.assertGreaterEqual(st["time"], st["max_pause"])
+                self.assertGreater(st["time"], 0)
+        finally:
+            for u in gc.garbage:
+                del u.cycle
+            del gc.garbage[:]
+
+        # a full pass over the oldest generation
+        gc.collect()
+        gc.get_stats(True)
+        for i in xrange(100000):
+            gc.collect_step(1000)
+            stats = gc.get_stats()[3]
+            if stats["passes"]:
+                break
+        self.assertEqual(stats["passes"], 1)
+        self.assertEqual(stats["last_pass_steps"], stats["collections"])
+        self.assertLessEqual(stats["last_pass_time"], stats["time"])
+        self.assertGreater(stats["examined"], 1000)
+
     def test_bug1055820b(self):
         # Corresponds to temp2b.py in the bug report.
 
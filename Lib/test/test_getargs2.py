@@ -1,6 +1,7 @@
 import unittest
 from test import test_support
-from _testcapi import getargs_keywords
+from _testcapi import getargs_keywords, getargs_keywords_fast, \
+     getargs_keywords_stack, getargs_keywords_bad
 import warnings
 
 """
@@ -273,41 +274,43 @@ class Tuple_TestCase(unittest.TestCase):
         self.assertRaises(TypeError, getargs_tuple, 1, seq())
 
 class Keywords_TestCase(unittest.TestCase):
+    getargs = staticmethod(getargs_keywords)
+
     def test_positional_args(self):
         # using all positional args
         self.assertEqual(
-            getargs_keywords((1,2), 3, (4,(5,6)), (7,8,9), 10),
+            self.getargs((1,2), 3, (4,(5,6)), (7,8,9), 10),
             (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)
             )
     def test_mixed_args(self):
         # positional and keyword args
         self.assertEqual(
-            getargs_keywords((1,2), 3, (4,(5,6)), arg4=(7,8,9), arg5=10),
+            self.getargs((1,2), 3, (4,(5,6)), arg4=(7,8,9), arg5=10),
             (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)
             )
     def test_keyword_args(self):
         # all keywords
         self.assertEqual(
-            getargs_keywords(arg1=(1,2), arg2=3, arg3=(4,(5,6)), arg4=(7,8,9), arg5=10),
+            self.getargs(arg1=(1,2), arg2=3, arg3=(4,(5,6)), arg4=(7,8,9), arg5=10),
             (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)
             )
     def test_optional_args(self):
         # missing optional keyword args, skipping tuples
         self.assertEqual(
-            getargs_keywords(arg1=(1,2), arg2=3, arg5=10),
+            self.getargs(arg1=(1,2), arg2=3, arg5=10),
             (1, 2, 3, -1, -1, -1, -1, -1, -1, 10)
             )
     def test_required_args(self):
         # required arg missing
         try:
-            getargs_keywords(arg1=(1,2))
+            self.getargs(arg1=(1,2))
         except TypeError, err:
             self.assertEqual(str(err), "Required argument 'arg2' (pos 2) not found")
         else:
             self.fail('TypeError should have been raised')
     def test_too_many_args(self):
         try:
-            getargs_keywords((1,2),3,(4,(5,6)),(7,8,9),10,111)
+            self.getargs((1,2),3,(4,(5,6)),(7,8,9),10,111)
         except TypeError, err:
             self.assertEqual(str(err), "function takes at most 5 arguments (6 given)")
         else:
@@ -315,14 +318,46 @@ class Keywords_TestCase(unittest.TestCase):
     def test_invalid_keyword(self):
         # extraneous keyword arg
         try:
-            getargs_keywords((1,2),3,arg5=10,arg666=666)
+            self.getargs((1,2),3,arg5=10,arg666=666)
         except TypeError, err:
             self.assertEqual(str(err), "'arg666' is an invalid keyword argument for this function")
         else:
             self.fail('TypeError should have been raised')
 
+class KeywordsFast_TestCase(Keywords_TestCase):
+    # the same checks with a precompiled _PyArg_Parser
+    getargs = staticmethod(getargs_keywords_fast)
+
+    def test_name_and_position(self):
+        try:
+            self.getargs((1,2), 3, arg2=3)
+        except TypeError, err:
+            self.assertEqual(str(err),
+                             "Argument given by name ('arg2') and position (2)")
+        else:
+            self.fail('TypeError should have been raised')
+
+    def test_keywords_not_strings(self):
+        self.assertRaises(TypeError, self.getargs, (1,2), 3, **{u'arg6': 1})
+
+    def test_bad_format(self):
+        # a parser that fails its check is not kept
+        for i in range(2):
+            try:
+                getargs_keywords_bad(1, 2, 3)
+            except RuntimeError, err:
+                self.assertEqual(str(err), "More keyword list entries (5) "
+                                 "than format specifiers (3)")
+            else:
+                self.fail('RuntimeError should have been raised')
+
+class KeywordsStack_TestCase(KeywordsFast_TestCase):
+    # and for a METH_FASTCALL function
+    getargs = staticmethod(getargs_keywords_stack)
+
 def test_main():
-    tests = [Signed_TestCase, Unsigned_TestCase, Tuple_TestCase, Keywords_TestCase]
+    tests = [Signed_TestCase, Unsigned_TestCase, Tuple_TestCase, Keywords_TestCase,
+             KeywordsFast_TestCase, KeywordsStack_TestCase]
     try:
         from _testcapi import getargs_L, getargs_K
     except ImportError:
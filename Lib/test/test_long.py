@@ -19,6 +19,8 @@ SHIFT = sys.long_info.bits_per_digit
 BASE = 2 ** SHIFT
 MASK = BASE - 1
 KARATSUBA_CUTOFF = 70   # from longobject.c
+TOOM3_CUTOFF = 300      # from longobject.c
+DIVIDE_CUTOFF = 100     # from longobject.c
 
 # Max number of base BASE digits to use in test cases.  Doubling
 # this will more than double the runtime.
@@ -194,6 +196,84 @@ class LongTest(unittest.TestCase):
                 self.assertEqual(x, y,
                     Frm("bad result for a*b: a=%r, b=%r, x=%r, y=%r", a, b, x, y))
 
+    def test_toom3(self):
+        digits = range(TOOM3_CUTOFF, TOOM3_CUTOFF + 4)
+        digits.extend([TOOM3_CUTOFF * 2 - 1, TOOM3_CUTOFF * 10])
+        bits = [digit * SHIFT for digit in digits]
+
+        # Products of long strings of 1 bits, as in test_karatsuba.
+        for abits in bits:
+            a = (1L << abits) - 1
+            for bbits in bits:
+                b = (1L << bbits) - 1
+                self.assertEqual(a * b, (1L << (abits + bbits)) -
+                                 (1L << abits) - (1L << bbits) + 1)
+
+        # Compare with products of pieces small enough for Karatsuba.
+        for lenx in digits:
+            x = self.getran(lenx)
+            for leny in digits:
+                if leny > lenx:
+                    continue
+                y = self.getran(leny)
+                lo = y & ((1L << (TOOM3_CUTOFF * SHIFT)) - 1)
+                hi = y >> (TOOM3_CUTOFF * SHIFT)
+                pieces = 0L
+                for i in xrange(0, lenx, TOOM3_CUTOFF):
+                    xi = abs(x) >> (i * SHIFT)
+                    xi &= (1L << (TOOM3_CUTOFF * SHIFT)) - 1
+                    pieces += ((xi * lo) << (i * SHIFT)) + \
+                        ((xi * hi) << ((i + TOOM3_CUTOFF) * SHIFT))
+                if x < 0:
+                    pieces = -pieces
+                self.assertEqual(x * y, pieces)
+                self.assertEqual(x * x, abs(x) * abs(x))
+
+    def test_large_division(self):
+        digits = [DIVIDE_CUTOFF, DIVIDE_CUTOFF + 1, DIVIDE_CUTOFF * 2 + 1,
+                  DIVIDE_CUTOFF * 7]
+        for lenx in digits:
+            for leny in digits:
+                x = self.getran(lenx + leny + DIVIDE_CUTOFF + 1)
+                y = self.getran(leny)
+                self.check_division(x, y)
+                # quotients with runs of BASE-1 digits, and remainders
+                # close to y, provoke the correction steps
+                q = self.getran(lenx + DIVIDE_CUTOFF + 1)
+                self.check_division(q * y - 1, y)
+                self.check_division(q * y + y - 1, y)
+                y = (1L << (leny * SHIFT)) - 1
+                self.check_division(y << (lenx * SHIFT + 1), y)
+                self.check_division(((y + 1) << (lenx * SHIFT + 2)) - 1,
+                                    y + 2)
+
+    def test_large_decimal(self):
+        # str() and long() split long numbers at powers of 10.
+        for n in (10, 500, 5000, 12345, 40000):
+            self.assertEqual(str(10L ** n), "1" + "0" * n)
+            self.assertEqual(str(10L ** n - 1), "9" * n)
+            self.assertEqual(str(-10L ** n - 1), "-1" + "0" * (n - 1) + "1")
+            self.assertEqual(long("9" * n), 10L ** n - 1)
+            self.assertEqual(long("1" + "0" * n), 10L ** n)
+            self.assertEqual(long("-" + "0" * n + "7"), -7L)
+            self.assertEqual(long("6" * n, 7), 7L ** n - 1)
+            self.assertEqual(long("1" + "0" * n, 36), 36L ** n)
+        for ndigits in (100, 1000, 3000, 10000):
+            x = self.getran(ndigits)
+            s = str(x)
+            self.assertEqual(long(s), x)
+            self.assertEqual(long(s + "L"), x)
+            self.assertEqual(repr(x), s + "L")
+            # the digits of x, converted piecewise, in groups of 1000
+            pieces = []
+            y = abs(x)
+            while y:
+                y, r = divmod(y, 10L ** 1000)
+                pieces.append(str(r).zfill(1000))
+            self.assertEqual(s.lstrip("-"), "".join(pieces[::-1]).lstrip("0"))
+            self.assertEqual(long("+" + s[::-1].rstrip("-") + "0"),
+                             long(s[::-1].rstrip("-")) * 10)
+
     def check_bitop_identities_1(self, x):
         eq = self.assertEqual
         eq(x & 0, 0, Frm("x & 0 != 0 for x=%r", x))
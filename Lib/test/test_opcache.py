@@ -0,0 +1,252 @@
+"""Tests for the inline caches of LOAD_GLOBAL and LOAD_ATTR.
+
+A code object gets its caches only after it has run a number of times,
+so every test first warms up the function under test and then changes
+the namespaces or types it depends on.
+"""
+
+import unittest
+from test import test_support
+import __builtin__
+import types
+
+WARMUP = 2000
+
+def warm(func, *args):
+    for i in xrange(WARMUP):
+        result = func(*args)
+    return result
+
+
+some_global = 1
+
+def get_global():
+    return some_global
+
+def get_len():
+    return len
+
+def get_missing():
+    return missing_global
+
+
+class LoadGlobalTests(unittest.TestCase):
+
+    def tearDown(self):
+        global some_global
+        some_global = 1
+        globals().pop('len', None)
+        globals().pop('missing_global', None)
+
+    def test_rebind(self):
+        global some_global
+        self.assertEqual(warm(get_global), 1)
+        some_global = 2
+        self.assertEqual(get_global(), 2)
+        self.assertEqual(warm(get_global), 2)
+
+    def test_delete(self):
+        global some_global
+        warm(get_global)
+        del some_global
+        self.assertRaises(NameError, get_global)
+        some_global = 3
+        self.assertEqual(get_global(), 3)
+
+    def test_missing(self):
+        for i in range(10):
+            self.assertRaises(NameError, get_missing)
+        globals()['missing_global'] = 5
+        self.assertEqual(warm(get_missing), 5)
+
+    def test_shadow_builtin(self):
+        self.assertTrue(warm(get_len) is len)
+        globals()['len'] = 42
+        self.assertEqual(get_len(), 42)
+        del globals()['len']
+        self.assertTrue(get_len() is __builtin__.len)
+
+    def test_modify_builtins(self):
+        saved = __builtin__.len
+        self.assertTrue(warm(get_len) is saved)
+        __builtin__.len = 'replaced'
+        try:
+            self.assertEqual(get_len(), 'replaced')
+        finally:
+            __builtin__.len = saved
+        self.assertTrue(get_len() is saved)
+
+    def test_other_globals(self):
+        # the same code object running with different globals
+        warm(get_global)
+        other = types.FunctionType(get_global.func_code,
+                                   {'some_global': 'other'})
+        self.assertEqual(other(), 'other')
+        self.assertEqual(warm(other), 'other')
+        self.assertEqual(get_global(), 1)
+        empty = types.FunctionType(get_global.func_code,
+                                   {'__builtins__': {}})
+        self.assertRaises(NameError, empty)
+
+    def test_exec(self):
+        code = compile('result = some_name', '<test>', 'exec')
+        for i in xrange(WARMUP):
+            ns = {'some_name': i}
+            exec code in ns
+            self.assertEqual(ns['result'], i)
+
+
+def get_attr(obj):
+    return obj.attr
+
+def call_method(obj):
+    return obj.method()
+
+
+class Plain(object):
+    attr = 'class'
+
+    def method(self):
+        return 'method'
+
+
+class LoadAttrTests(unittest.TestCase):
+
+    def test_instance_attribute(self):
+        obj = Plain()
+        obj.attr = 'instance'
+        self.assertEqual(warm(get_attr, obj), 'instance')
+        obj.attr = 'rebound'
+        self.assertEqual(get_attr(obj), 'rebound')
+        del obj.attr
+        self.assertEqual(get_attr(obj), 'class')
+
+    def test_class_attribute(self):
+        class C(object):
+            attr = 1
+        obj = C()
+        self.assertEqual(warm(get_attr, obj), 1)
+        C.attr = 2
+        self.assertEqual(get_attr(obj), 2)
+        del C.attr
+        self.assertRaises(AttributeError, get_attr, obj)
+
+    def test_base_class_modified(self):
+        class A(object):
+            attr = 'A'
+        class B(A):
+            pass
+        obj = B()
+        self.assertEqual(warm(get_attr, obj), 'A')
+        A.attr = 'changed'
+        self.assertEqual(get_attr(obj), 'changed')
+        B.attr = 'B'
+        self.assertEqual(get_attr(obj), 'B')
+
+    def test_method(self):
+        class C(object):
+            def method(self):
+                return 1
+        obj = C()
+        self.assertEqual(warm(call_method, obj), 1)
+        obj.method = lambda: 'instance'
+        self.assertEqual(call_method(obj), 'instance')
+        del obj.method
+        C.method = lambda self: 2
+        self.assertEqual(call_method(obj), 2)
+
+    def test_property_added(self):
+        class C(object):
+            pass
+        obj = C()
+        obj.attr = 'instance'
+        self.assertEqual(warm(get_attr, obj), 'instance')
+        # a data descriptor wins over the instance dict
+        C.attr = property(lambda self: 'property')
+        self.assertEqual(get_attr(obj), 'property')
+
+    def test_descriptor_becomes_data(self):
+        class Descr(object):
+            def __get__(self, obj, type):
+                return 'descr'
+        class C(object):
+            attr = Descr()
+        obj = C()
+        obj.__dict__['attr'] = 'instance'
+        self.assertEqual(warm(get_attr, obj), 'instance')
+        # only the descriptor's type changes, not the owner
+        Descr.__set__ = lambda self, obj, value: None
+        self.assertEqual(get_attr(obj), 'descr')
+
+    def test_getattr_added(self):
+        class C(object):
+            pass
+        obj = C()
+        self.assertRaises(AttributeError, get_attr, obj)
+        obj.attr = 1
+        warm(get_attr, obj)
+        del obj.attr
+        C.__getattr__ = lambda self, name: 'fallback'
+        self.assertEqual(get_attr(obj), 'fallback')
+        C.__getattribute__ = lambda self, name: 'always'
+        obj.attr = 1
+        self.assertEqual(get_attr(obj), 'always')
+
+    def test_class_reassigned(self):
+        class A(object):
+            attr = 'A'
+        class B(object):
+            attr = 'B'
+        obj = A()
+        self.assertEqual(warm(get_attr, obj), 'A')
+        obj.__class__ = B
+        self.assertEqual(get_attr(obj), 'B')
+
+    def test_slots(self):
+        class C(object):
+            __slots__ = ('attr',)
+        obj = C()
+        obj.attr = 'slot'
+        self.assertEqual(warm(get_attr, obj), 'slot')
+        del obj.attr
+        self.assertRaises(AttributeError, get_attr, obj)
+
+    def test_polymorphic(self):
+        class Old:
+            attr = 'old'
+        class WithGetattr(object):
+            def __getattr__(self, name):
+                return 'getattr'
+        objects = [Plain(), Old(), WithGetattr(), types, 'x']
+        types.attr = 'module'
+        try:
+            for i in xrange(WARMUP):
+                for obj in objects[:-1]:
+                    get_attr(obj)
+            self.assertEqual([get_attr(obj) for obj in objects[:-1]],
+                             ['class', 'old', 'getattr', 'module'])
+        finally:
+            del types.attr
+        self.assertRaises(AttributeError, get_attr, types)
+        self.assertRaises(AttributeError, get_attr, objects[-1])
+
+    def test_error_message(self):
+        class C(object):
+            pass
+        obj = C()
+        obj.attr = 1
+        warm(get_attr, obj)
+        del obj.attr
+        try:
+            get_attr(obj)
+        except AttributeError, e:
+            self.assertEqual(str(e), "'C' object has no attribute 'attr'")
+        else:
+            self.fail("no AttributeError")
+
+
+def test_main():
+    test_support.run_unittest(LoadGlobalTests, LoadAttrTests)
+
+if __name__ == "__main__":
+    test_main()
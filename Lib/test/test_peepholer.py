@@ -202,10 +202,118 @@ class TestTranforms(unittest.TestCase):
         self.assertEqual(asm.split().count('RETURN_VALUE'), 2)
 
 
+class TestSuperinstructions(unittest.TestCase):
+
+    def test_fused(self):
+        def f(a, b):
+            if a < b:
+                return a.real
+            return 1
+        asm = disassemble(f)
+        for elem in ('LOAD_FAST__LOAD_FAST', 'COMPARE_OP__POP_JUMP_IF_FALSE',
+                     'LOAD_FAST__LOAD_ATTR', 'LOAD_CONST__RETURN_VALUE'):
+            self.assertIn(elem, asm)
+        # the second instruction of each pair stays in place
+        self.assertEqual(asm.split().count('LOAD_ATTR'), 1)
+        self.assertEqual(asm.split().count('RETURN_VALUE'), 2)
+        self.assertEqual((f(1, 2), f(2, 1), f(1.5, 2), f('b', 'a')),
+                         (1, 1, 1.5, 1))
+
+    def test_jump_target(self):
+        # RETURN_VALUE is a jump target, the pair must not be fused
+        def f(x):
+            return x or 0
+        asm = disassemble(f)
+        self.assertNotIn('LOAD_CONST__RETURN_VALUE', asm)
+        self.assertEqual((f(0), f(5)), (0, 5))
+
+    def test_unbound_second(self):
+        def f(a, flag):
+            if flag:
+                b = 1
+            return a + b
+        self.assertIn('LOAD_FAST__LOAD_FAST', disassemble(f))
+        self.assertEqual(f(1, True), 2)
+        try:
+            f(1, False)
+        except UnboundLocalError, e:
+            self.assertIn("'b'", str(e))
+        else:
+            self.fail("no UnboundLocalError")
+
+    def test_attribute_error(self):
+        def f(a):
+            x = 1
+            return a.missing
+        self.assertIn('LOAD_FAST__LOAD_ATTR', disassemble(f))
+        try:
+            f(None)
+        except AttributeError:
+            tb = sys.exc_info()[2].tb_next
+            self.assertEqual(tb.tb_lineno, f.func_code.co_firstlineno + 2)
+        else:
+            self.fail("no AttributeError")
+
+    def test_rich_compare(self):
+        class Truth(object):
+            def __init__(self, value):
+                self.value = value
+            def __nonzero__(self):
+                if self.value is None:
+                    raise ValueError
+                return self.value
+        class C(object):
+            def __init__(self, result):
+                self.result = result
+            def __lt__(self, other):
+                return self.result
+        def f(a, b):
+            if a < b:
+                return 'yes'
+            return 'no'
+        self.assertIn('COMPARE_OP__POP_JUMP_IF_FALSE', disassemble(f))
+        self.assertEqual(f(C([1]), 0), 'yes')
+        self.assertEqual(f(C([]), 0), 'no')
+        self.assertEqual(f(C(Truth(True)), 0), 'yes')
+        self.assertEqual(f(C(Truth(False)), 0), 'no')
+        self.assertRaises(ValueError, f, C(Truth(None)), 0)
+        self.assertRaises(TypeError, f, 1j, 2j)
+        for op in ('<', '<=', '==', '!=', '>', '>=', 'is', 'is not',
+                   'in', 'not in'):
+            g = eval('lambda a, b: 1 if a %s b else 0' % op)
+            for a, b in ((1, 2), (2, 2), (3, 2), (1, [1]), (2, (1,))):
+                if op.endswith('in') and isinstance(b, int):
+                    continue
+                expected = eval('a %s b' % op)
+                self.assertEqual(g(a, b), expected, (a, op, b))
+
+    def test_tracing(self):
+        # while tracing, the second instruction runs on its own
+        def f(a, b):
+            if a < b:
+                return a.real
+            return 1
+        events = []
+        def tracer(frame, event, arg):
+            if frame.f_code is f.func_code:
+                events.append((event, frame.f_lineno))
+            return tracer
+        sys.settrace(tracer)
+        try:
+            result = f(1, 2)
+        finally:
+            sys.settrace(None)
+        self.assertEqual(result, 1)
+        first = f.func_code.co_firstlineno
+        self.assertEqual(events, [('call', first), ('line', first + 1),
+                                  ('line', first + 2),
+                                  ('return', first + 2)])
+
+
 def test_main(verbose=None):
     import sys
     from test import test_support
-    test_classes = (TestTranforms,)
+    test_classes = (TestTranforms, TestSuperinstructions)
 
     with test_support.check_py3k_warnings(
             ("backquote not supported", SyntaxWarning)):
@@ -213,6 +213,37 @@ class StrtodTests(unittest.TestCase):
                 s = '{}e{}'.format(digits, exponent)
                 self.check_strtod(s)
 
+    def test_short_inputs(self):
+        # inputs of at most 19 significant digits take the 128-bit
+        # product fast path in _Py_dg_strtod; exercise it across the whole
+        # exponent range, including near overflow and underflow where it
+        # has to defer to the bignum code
+        for ndigs in 1, 8, 15, 16, 17, 18, 19:
+            for i in xrange(10 * TEST_SIZE):
+                digits = random.randrange(10**(ndigs-1), 10**ndigs)
+                exponent = random.randrange(-345 - ndigs, 310 - ndigs)
+                s = '{}e{}'.format(digits, exponent)
+                self.check_strtod(s)
+        test_strings = [
+            '9007199254740993',
+            '9007199254740993e-1',
+            '9223372036854775807',
+            '9999999999999999999',
+            '1e23',
+            '8.5e-324',
+            '2.4703282292062328e-324',
+            '2.4703282292062327e-324',
+            '2.2250738585072011e-308',
+            '2.2250738585072012e-308',
+            '1.7976931348623157e308',
+            '1.7976931348623158e308',
+            '7.3177701707893310e+15',
+            '7.2057594037927933e+16',
+            '4.4501477170144023e-308',
+            ]
+        for s in test_strings:
+            self.check_strtod(s)
+
     def test_parsing(self):
         # make '0' more likely to be chosen than other digits
         digits = '000000123456789'
@@ -4,6 +4,11 @@ import sys, os, cStringIO
 import struct
 import operator
 
+try:
+    import threading
+except ImportError:
+    threading = None
+
 try:
     import stackless
     haveStackless = True
@@ -221,6 +226,158 @@ class SysModuleTest(unittest.TestCase):
             sys.setcheckinterval(n)
             self.assertEqual(sys.getcheckinterval(), n)
 
+    @unittest.skipUnless(threading, 'Threading required for this test.')
+    def test_switchinterval(self):
+        self.assertRaises(TypeError, sys.setswitchinterval)
+        self.assertRaises(TypeError, sys.setswitchinterval, "a")
+        self.assertRaises(ValueError, sys.setswitchinterval, -1.0)
+        self.assertRaises(ValueError, sys.setswitchinterval, 0.0)
+        orig = sys.getswitchinterval()
+        # sanity check
+        self.assertTrue(orig < 0.5, orig)
+        try:
+            for n in 0.00001, 0.05, 3.0, orig:
+                sys.setswitchinterval(n)
+                self.assertAlmostEqual(sys.getswitchinterval(), n)
+        finally:
+            sys.setswitchinterval(orig)
+
+    def test_opcodeprofile(self):
+        import dis
+        def f(n):
+            total = 0
+            for i in range(n):
+                total += i
+            return total
+        self.assertEqual(sys.getopcodeprofile(), 0)
+        self.assertRaises(ValueError, sys.setopcodeprofile, 8)
+        sys.clearopcodestats()
+        sys.setopcodeprofile(7)
+        try:
+            f(10)
+        finally:
+            sys.setopcodeprofile(0)
+        f(10)
+        codes, pairs = sys.getopcodestats()
+        stats = [(ops, lines) for co, ops, lines in codes if co is f.func_code]
+        self.assertEqual(len(stats), 1)
+        ops, lines = stats[0]
+        self.assertEqual(len(ops), 256)
+        self.assertEqual(ops[dis.opmap['INPLACE_ADD']], 10)
+        self.assertEqual(ops[dis.opmap['FOR_ITER']], 11)
+        # the pairs that PREDICT() normally joins are seen as well
+        self.assertEqual(ops[dis.opmap['STORE_FAST']], 11 + 10)
+        first = f.func_code.co_firstlineno
+        self.assertEqual(lines, {first + 1: 1, first + 2: 11,
+                                 first + 3: 10, first + 4: 1})
+        self.assertTrue(
+            pairs[dis.opmap['LOAD_FAST']][dis.opmap['INPLACE_ADD']] >= 10)
+        sys.clearopcodestats()
+        self.assertEqual(sys.getopcodestats(), ([], None))
+        # without lines and pairs
+        sys.setopcodeprofile(1)
+        try:
+            self.assertEqual(sys.getopcodeprofile(), 1)
+            f(3)
+        finally:
+            sys.setopcodeprofile(0)
+        codes, pairs = sys.getopcodestats()
+        stats = [(ops, lines) for co, ops, lines in codes if co is f.func_code]
+        self.assertEqual(stats[0][0][dis.opmap['INPLACE_ADD']], 3)
+        self.assertEqual(stats[0][1], None)
+        self.assertEqual(pairs, None)
+        sys.clearopcodestats()
+
+    def test_framestats(self):
+        import gc
+        def f(n):
+            return n and f(n - 1)
+        f(50)
+        before = sys.getframestats()
+        f(50)
+        after = sys.getframestats()
+        # one zombie frame, the others come from a free list
+        self.assertEqual(after['allocs'] - before['allocs'], 51)
+        self.assertEqual(after['zombie_hits'] - before['zombie_hits'], 1)
+        self.assertEqual(after['freelist_hits'] - before['freelist_hits'], 50)
+        self.assertEqual(after['deallocs'] - before['deallocs'], 51)
+        self.assertEqual(after['live'], before['live'])
+        self.assertEqual(after['live'], after['allocs'] - after['deallocs'])
+        self.assertEqual(after['cached'],
+                         sum(cached for slots, cached, limit in after['classes']))
+        for slots, cached, limit in after['classes']:
+            self.assertEqual(slots % 8, 0)
+            self.assertTrue(cached <= limit)
+        # a full collection gives half of the cached frames back
+        gc.collect()
+        self.assertTrue(sys.getframestats()['cached'] <= after['cached'] // 2 + 1)
+
+    @unittest.skipUnless(hasattr(sys, "getmallocstats"), "needs pymalloc")
+    def test_mallocstats(self):
+        stats = sys.getmallocstats()
+        self.assertTrue(stats['arenas'] > 0)
+        self.assertEqual(stats['arenas'],
+                         stats['arenas_allocated'] - stats['arenas_freed'])
+        self.assertTrue(stats['arenas_highwater'] >= stats['arenas'])
+        self.assertEqual(stats['arena_size'] % stats['pool_size'], 0)
+        self.assertTrue(0.0 <= stats['fragmentation'] < 1.0)
+        classes = stats['classes']
+        self.assertEqual(stats['pools'], sum(c[1] for c in classes))
+        self.assertEqual(stats['blocks'], sum(c[2] for c in classes))
+        self.assertEqual(stats['allocated_bytes'],
+                         sum(c[0] * c[2] for c in classes))
+        self.assertTrue(stats['pools'] + stats['free_pools'] <=
+                        stats['arenas'] * stats['arena_size'] //
+                        stats['pool_size'])
+        sizes = [c[0] for c in classes]
+        self.assertEqual(sizes, sorted(sizes))
+        for size, pools, blocks, free_blocks in classes:
+            self.assertTrue(blocks + free_blocks <=
+                            pools * (stats['pool_size'] // size))
+        # a class fills up with objects and empties again
+        class Slot(object):
+            __slots__ = ('x',)
+        before = [c[2] for c in sys.getmallocstats()['classes']]
+        l = [Slot() for i in xrange(10000)]
+        during = [c[2] for c in sys.getmallocstats()['classes']]
+        index = max(range(len(before)), key=lambda i: during[i] - before[i])
+        self.assertTrue(during[index] >= before[index] + 10000)
+        del l
+        after = sys.getmallocstats()['classes'][index][2]
+        self.assertTrue(after < before[index] + 100)
+
+    @unittest.skipUnless(hasattr(sys, "setmallocsampling"), "needs pymalloc")
+    def test_mallocsampling(self):
+        self.assertRaises(ValueError, sys.setmallocsampling, -1)
+        class Slot(object):
+            __slots__ = ('x',)
+        def allocate(n):
+            return [Slot() for i in xrange(n)]
+        def site(samples):
+            for size, code, line, allocated, live in samples:
+                if code is allocate.__code__ and allocated > 100:
+                    return line, allocated, live
+        sys.setmallocsampling(10)
+        try:
+            self.assertEqual(sys.getmallocstats()['sample_rate'], 10)
+            kept = allocate(5000)
+            freed = allocate(5000)
+            del freed
+            line, allocated, live = site(sys.getmallocsamples())
+            self.assertEqual(line, allocate.__code__.co_firstlineno + 1)
+            # 10000 objects, sampled one in ten
+            self.assertTrue(900 <= allocated <= 1100, allocated)
+            self.assertTrue(450 <= live <= 550, live)
+            del kept
+            self.assertEqual(site(sys.getmallocsamples())[2], 0)
+            # changing the rate keeps the samples
+            sys.setmallocsampling(1)
+            self.assertEqual(site(sys.getmallocsamples())[1], allocated)
+        finally:
+            sys.setmallocsampling(0)
+        self.assertEqual(sys.getmallocsamples(), [])
+        self.assertEqual(sys.getmallocstats()['sample_rate'], 0)
+
     def test_recursionlimit(self):
         self.assertRaises(TypeError, sys.getrecursionlimit, 42)
         oldlimit = sys.getrecursionlimit()
@@ -460,6 +617,29 @@ class SysModuleTest(unittest.TestCase):
         out = p.communicate()[0].strip()
         self.assertEqual(out, '?')
 
+    def test_arena_environment(self):
+        # The object allocator reads its arena settings at startup.
+        # Allocate and free objects of many sizes under each setting.
+        import subprocess
+        code = ("l = [' ' * (i % 300) for i in xrange(200000)]\n"
+                "del l[::2]\n"
+                "l += [(i,) * (i % 20) for i in xrange(100000)]\n"
+                "del l\n"
+                "print 'ok'\n")
+        for settings in ({"PYTHONARENASIZE": "1m"},
+                         {"PYTHONARENASIZE": "100000"},
+                         {"PYTHONARENASIZE": "1k"},
+                         {"PYTHONARENASIZE": "lots"},
+                         {"PYTHONHUGEPAGES": "1"},
+                         {"PYTHONHUGEPAGES": "1", "PYTHONARENASIZE": "8M"}):
+            env = dict(os.environ)
+            env.update(settings)
+            p = subprocess.Popen([sys.executable, "-c", code],
+                                 stdout = subprocess.PIPE, env=env)
+            out = p.communicate()[0].strip()
+            self.assertEqual(p.returncode, 0, settings)
+            self.assertEqual(out, 'ok')
+
     def test_call_tracing(self):
         self.assertEqual(sys.call_tracing(str, (2,)), "2")
         self.assertRaises(TypeError, sys.call_tracing, str, 2)
@@ -570,7 +750,7 @@ class SizeofTest(unittest.TestCase):
         class class_oldstyle():
             def method():
                 pass
-        check(class_oldstyle, size(h + '7P'))
+        check(class_oldstyle, size(h + '8P'))
         # instance (old-style class)
         check(class_oldstyle(), size(h + '3P'))
         # instancemethod (old-style class)
@@ -578,7 +758,7 @@ class SizeofTest(unittest.TestCase):
         # complex
         check(complex(0,1), size(h + '2d'))
         # code
-        check(get_cell().func_code, size(h + '4i8Pi3P'))
+        check(get_cell().func_code, size(h + '4i8Pi5P2iP'))
         # BaseException
         check(BaseException(), size(h + '3P'))
         # UnicodeEncodeError
@@ -606,9 +786,9 @@ class SizeofTest(unittest.TestCase):
         # method-wrapper (descriptor object)
         check({}.__iter__, size(h + '2P'))
         # dict
-        check({}, size(h + '3P2P' + 8*'P2P'))
+        check({}, size(h + 'PQ2P'))
         x = {1:1, 2:2, 3:3, 4:4, 5:5, 6:6, 7:7, 8:8}
-        check(x, size(h + '3P2P' + 8*'P2P') + 16*size('P2P'))
+        check(x, size(h + 'PQ2P') + size('5P' + 16*'b' + 11*'P2P'))
         # dictionary-keyiterator
         check({}.iterkeys(), size(h + 'P2PPP'))
         # dictionary-valueiterator
@@ -750,7 +930,7 @@ class SizeofTest(unittest.TestCase):
             stacklessSize = ' 83c'
         else:
             stacklessSize = ''
-        s = size(vh + 'P2P15Pl4PP9PP11PI') + size('41P 10P 3P 6P' + stacklessSize)
+        s = size(vh + 'P2P15Pl4PP9PP11PI') + size('41P 10P 3P 6P' + stacklessSize + ' P')
         class newstyleclass(object):
             pass
         check(newstyleclass, s)
@@ -386,6 +386,26 @@ class TraceTestCase(unittest.TestCase):
              (257, 'line'),
              (257, 'return')])
 
+    def test_17_raise_stopiteration(self):
+        # the 'exception' event gets an instance, also for a bare raise
+        def gen():
+            yield 1
+            raise StopIteration
+        values = []
+        def tracer(frame, event, arg):
+            if event == 'exception':
+                values.append(arg[1])
+            return tracer
+        sys.settrace(tracer)
+        try:
+            self.assertEqual(list(gen()), [1])
+        finally:
+            sys.settrace(None)
+        self.assertTrue(values)
+        for value in values:
+            self.assertIsInstance(value, StopIteration)
+            self.assertEqual(value.args, ())
+
 
 class RaisingTraceFuncTestCase(unittest.TestCase):
     def trace(self, frame, event, arg):
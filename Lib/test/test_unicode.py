@@ -822,6 +822,47 @@ class UnicodeTest(
         # Error handling (PyUnicode_EncodeDecimal())
         self.assertRaises(UnicodeError, int, u"\u0200")
 
+    def test_codecs_long_runs(self):
+        # The ASCII, Latin-1 and UTF-8 codecs convert runs of ASCII
+        # characters many at a time; end such a run at every position
+        # of the first few steps
+        base = u''.join(unichr(32 + i % 95) for i in xrange(70))
+        bbase = ''.join(chr(ord(c)) for c in base)
+        for i in xrange(len(base) + 1):
+            head, tail = base[:i], base[i:]
+            bhead, btail = bbase[:i], bbase[i:]
+            for c in (u'\x80', u'\xe9', u'\xff', u'\u20ac', u'\ud800',
+                      u'\U00010000'):
+                u = head + c + tail
+                b = u.encode('utf-8')
+                self.assertEqual(b, bhead + c.encode('utf-8') + btail)
+                self.assertEqual(b.decode('utf-8'), u)
+                self.assertEqual(u.encode('ascii', 'replace'),
+                                 bhead + '?' * len(c) + btail)
+                with self.assertRaises(UnicodeEncodeError) as cm:
+                    u.encode('ascii')
+                self.assertEqual(cm.exception.start, i)
+                if c < u'\u0100':
+                    self.assertEqual(u.encode('latin-1'),
+                                     bhead + chr(ord(c)) + btail)
+                else:
+                    self.assertEqual(u.encode('latin-1', 'replace'),
+                                     bhead + '?' * len(c) + btail)
+            b = bhead + '\xe9' + btail
+            self.assertEqual(b.decode('latin-1'), head + u'\xe9' + tail)
+            self.assertEqual(b.decode('ascii', 'replace'),
+                             head + u'\ufffd' + tail)
+            self.assertEqual(b.decode('utf-8', 'replace'),
+                             head + u'\ufffd' + tail)
+            for codec in ('ascii', 'utf-8'):
+                with self.assertRaises(UnicodeDecodeError) as cm:
+                    b.decode(codec)
+                self.assertEqual(cm.exception.start, i)
+            # an incomplete sequence after a run is left for later
+            self.assertEqual(codecs.utf_8_decode(bhead + '\xe2\x82',
+                                                 'strict', False),
+                             (head, i))
+
     def test_codecs(self):
         # Encoding
         self.assertEqual(u'hello'.encode('ascii'), 'hello')
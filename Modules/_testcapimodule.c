@@ -856,6 +856,57 @@ static PyObject *getargs_keywords(PyObject *self, PyObject *args, PyObject *kwar
         int_args[5], int_args[6], int_args[7], int_args[8], int_args[9]);
 }
 
+/* the same with a precompiled _PyArg_Parser */
+static const char * const getargs_keywords_names[] =
+    {"arg1","arg2","arg3","arg4","arg5", NULL};
+
+static PyObject *
+getargs_keywords_fast(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static _PyArg_Parser parser = {"(ii)i|(i(ii))(iii)i",
+                                   getargs_keywords_names};
+    int int_args[10]={-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwargs, &parser,
+        &int_args[0], &int_args[1], &int_args[2], &int_args[3], &int_args[4],
+        &int_args[5], &int_args[6], &int_args[7], &int_args[8], &int_args[9]))
+        return NULL;
+    return Py_BuildValue("iiiiiiiiii",
+        int_args[0], int_args[1], int_args[2], int_args[3], int_args[4],
+        int_args[5], int_args[6], int_args[7], int_args[8], int_args[9]);
+}
+
+/* and as a METH_FASTCALL function */
+static PyObject *
+getargs_keywords_stack(PyObject *self, PyObject **args, Py_ssize_t nargs,
+                       PyObject *kwargs)
+{
+    static _PyArg_Parser parser = {"(ii)i|(i(ii))(iii)i",
+                                   getargs_keywords_names};
+    int int_args[10]={-1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+    if (!_PyArg_ParseStackAndKeywords(args, nargs, kwargs, &parser,
+        &int_args[0], &int_args[1], &int_args[2], &int_args[3], &int_args[4],
+        &int_args[5], &int_args[6], &int_args[7], &int_args[8], &int_args[9]))
+        return NULL;
+    return Py_BuildValue("iiiiiiiiii",
+        int_args[0], int_args[1], int_args[2], int_args[3], int_args[4],
+        int_args[5], int_args[6], int_args[7], int_args[8], int_args[9]);
+}
+
+/* a parser whose format does not match its keyword list */
+static PyObject *
+getargs_keywords_bad(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static _PyArg_Parser parser = {"ii|i:bad", getargs_keywords_names};
+    int a, b, c;
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwargs, &parser,
+                                          &a, &b, &c))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
 /* Functions to call PyArg_ParseTuple with integer format codes,
    and return the result.
 */
@@ -1579,6 +1630,52 @@ test_capsule(PyObject *self, PyObject *args)
 #undef FAIL
 }
 
+/* Test PyGC_SetHook: the hook sees the start and stop of each collection */
+
+static int gc_hook_events;
+static PyGC_Info gc_hook_info[2];
+
+static void
+gc_hook(int event, PyGC_Info *info, void *arg)
+{
+    if (gc_hook_events < 2 && arg == (void *)&gc_hook_events &&
+        event == gc_hook_events)
+        gc_hook_info[event] = *info;
+    gc_hook_events++;
+}
+
+static PyObject *
+test_gc_hook(PyObject *self)
+{
+    int i;
+    static const int generations[2] = {2, PyGC_INCREMENTAL};
+
+    for (i = 0; i < 2; i++) {
+        gc_hook_events = 0;
+        PyGC_SetHook(gc_hook, (void *)&gc_hook_events);
+        if (i == 0)
+            PyGC_Collect();
+        else
+            PyGC_CollectStep(100);
+        PyGC_SetHook(NULL, NULL);
+        if (gc_hook_events != 2)
+            return raiseTestError("test_gc_hook",
+                                  "hook not called at start and stop");
+        if (gc_hook_info[PyGC_START].generation != generations[i] ||
+            gc_hook_info[PyGC_STOP].generation != generations[i])
+            return raiseTestError("test_gc_hook", "wrong generation");
+        if (gc_hook_info[PyGC_STOP].start != gc_hook_info[PyGC_START].start ||
+            gc_hook_info[PyGC_STOP].duration < 0.0 ||
+            gc_hook_info[PyGC_STOP].examined <= 0)
+            return raiseTestError("test_gc_hook", "wrong statistics");
+    }
+    gc_hook_events = 0;
+    PyGC_Collect();
+    if (gc_hook_events != 0)
+        return raiseTestError("test_gc_hook", "hook not removed");
+    Py_RETURN_NONE;
+}
+
 /* This is here to provide a docstring for test_descr. */
 static PyObject *
 test_with_docstring(PyObject *self)
@@ -1655,12 +1752,19 @@ static PyMethodDef TestMethods[] = {
     {"test_empty_argparse", (PyCFunction)test_empty_argparse,METH_NOARGS},
     {"test_null_strings",       (PyCFunction)test_null_strings,  METH_NOARGS},
     {"test_string_from_format", (PyCFunction)test_string_from_format, METH_NOARGS},
+    {"test_gc_hook",            (PyCFunction)test_gc_hook,       METH_NOARGS},
     {"test_with_docstring", (PyCFunction)test_with_docstring, METH_NOARGS,
      PyDoc_STR("This is a pretty normal docstring.")},
 
     {"getargs_tuple",           getargs_tuple,                   METH_VARARGS},
     {"getargs_keywords", (PyCFunction)getargs_keywords,
       METH_VARARGS|METH_KEYWORDS},
+    {"getargs_keywords_fast", (PyCFunction)getargs_keywords_fast,
+      METH_VARARGS|METH_KEYWORDS},
+    {"getargs_keywords_stack", (PyCFunction)getargs_keywords_stack,
+      METH_FASTCALL|METH_KEYWORDS},
+    {"getargs_keywords_bad", (PyCFunction)getargs_keywords_bad,
+      METH_VARARGS|METH_KEYWORDS},
     {"getargs_b",               getargs_b,                       METH_VARARGS},
     {"getargs_B",               getargs_B,                       METH_VARARGS},
     {"getargs_h",               getargs_h,                       METH_VARARGS},
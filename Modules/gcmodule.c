@@ -19,7 +19,10 @@
 */
 
 #include "Python.h"
-#include "frameobject.h"        /* for PyFrame_ClearFreeList */
+#include "frameobject.h"        /* for _PyFrame_TrimFreeList */
+#ifdef STACKLESS
+#include "core/stackless_impl.h" /* for slp_clock */
+#endif
 
 /* Get an object's GC head */
 #define AS_GC(o) ((PyGC_Head *)(o)-1)
@@ -49,6 +52,12 @@ static struct gc_generation generations[NUM_GENERATIONS] = {
 
 PyGC_Head *_PyGC_generation0 = GEN_HEAD(0);
 
+/* Objects moved out of the generations by gc.freeze().  They are never
+   scanned, so a collection does not write to their headers. */
+static struct gc_generation permanent_generation = {
+    {{&permanent_generation.head, &permanent_generation.head, 0}}, 0, 0
+};
+
 static int enabled = 1; /* automatic collection enabled? */
 
 /* true if we are currently running the collector */
@@ -164,17 +173,159 @@ GC_TENTATIVELY_UNREACHABLE
     Only objects with GC_TENTATIVELY_UNREACHABLE still set are candidates
     for collection.  If it's decided not to collect such an object (e.g.,
     it has a __del__ method), its gc_refs is restored to GC_REACHABLE again.
+
+Objects of the oldest generation can take on a few more values between
+collections.  They all count as reachable, and no code outside of this
+file tells them apart from GC_REACHABLE:
+
+GC_VISITED_A, GC_VISITED_B
+    An incremental pass (see collect_increment) marks the objects it has
+    scanned with one of these, and uses the other one for the pass after
+    it, so no pass has to reset the marks of the previous one.
+
+GC_FROZEN
+    The object is in the permanent generation (see gc.freeze).
 ----------------------------------------------------------------------------
 */
 #define GC_UNTRACKED                    _PyGC_REFS_UNTRACKED
 #define GC_REACHABLE                    _PyGC_REFS_REACHABLE
 #define GC_TENTATIVELY_UNREACHABLE      _PyGC_REFS_TENTATIVELY_UNREACHABLE
+#define GC_VISITED_A                    (-5)
+#define GC_VISITED_B                    (-6)
+#define GC_FROZEN                       (-7)
 
 #define IS_TRACKED(o) ((AS_GC(o))->gc.gc_refs != GC_UNTRACKED)
-#define IS_REACHABLE(o) ((AS_GC(o))->gc.gc_refs == GC_REACHABLE)
+#define IS_REACHABLE(o) ( \
+    (AS_GC(o))->gc.gc_refs == GC_REACHABLE || \
+    (AS_GC(o))->gc.gc_refs <= GC_VISITED_A)
 #define IS_TENTATIVELY_UNREACHABLE(o) ( \
     (AS_GC(o))->gc.gc_refs == GC_TENTATIVELY_UNREACHABLE)
 
+/*** incremental collection of the oldest generation ***/
+
+/* A collection of any set of objects is safe: update_refs() and
+   subtract_refs() find the references that come from outside the set, and
+   whatever they keep alive stays alive.  The young generations rely on
+   this, and so does an incremental pass: each step collects the young
+   generations together with the next objects of the oldest one that the
+   pass has not visited yet, plus the unvisited objects those refer to, so
+   that a cycle among them is found in the same step.  No write barrier is
+   needed, the cost of a step being bounded is only that a cycle too large
+   to fit into a step, or one whose objects the pass visited at different
+   times, survives until a later pass or a full collection.
+
+   While a pass is in progress, the oldest generation's list holds the
+   objects the pass has not reached, and old_visited those it has.  The
+   survivors of each step, young ones included, go to old_visited.
+*/
+
+static Py_ssize_t incremental_step = 0; /* old objects per step, 0 = off */
+static int incremental_pass = 0; /* is a pass in progress? */
+static Py_ssize_t visited_mark = GC_VISITED_A; /* gc_refs of visited objects */
+static Py_ssize_t visited_count = 0; /* objects moved to old_visited */
+static PyGC_Head old_visited = {{&old_visited, &old_visited, 0}};
+
+/* true for a tracked object that the current pass may still pull into a
+   step: neither visited nor frozen */
+#define IS_UNVISITED(g) ( \
+    (g)->gc.gc_refs == GC_REACHABLE || \
+    (g)->gc.gc_refs == (GC_VISITED_A + GC_VISITED_B - visited_mark))
+
+/*** pause times ***/
+
+/* pause_histogram[g][i] counts the collections of generation g, or the
+   incremental steps for g == NUM_GENERATIONS, which took at least 2**(i-1)
+   and less than 2**i microseconds.  The last bucket takes the rest. */
+#define PAUSE_BUCKETS 24
+static Py_ssize_t pause_histogram[NUM_GENERATIONS+1][PAUSE_BUCKETS];
+
+static double
+gc_clock(void)
+{
+#ifdef STACKLESS
+    return slp_clock();
+#else
+    struct timeval t;
+
+#ifdef GETTIMEOFDAY_NO_TZ
+    gettimeofday(&t);
+#else
+    gettimeofday(&t, (struct timezone *) NULL);
+#endif
+    return (double) t.tv_sec + t.tv_usec * 1e-6;
+#endif
+}
+
+/*** statistics ***/
+
+/* the statistics of the collections of a generation, or, at index
+   NUM_GENERATIONS, of the steps of incremental passes */
+#if PyGC_INCREMENTAL != NUM_GENERATIONS
+#error "PyGC_INCREMENTAL must follow the generations"
+#endif
+struct gc_generation_stats {
+    Py_ssize_t collections;
+    Py_ssize_t examined;
+    Py_ssize_t collected;
+    Py_ssize_t uncollectable;
+    double time; /* total seconds */
+    double max_pause;
+    double last_pause;
+};
+static struct gc_generation_stats generation_stats[NUM_GENERATIONS+1];
+
+/* completed incremental passes, and the steps and time of the last one */
+static Py_ssize_t passes = 0;
+static Py_ssize_t last_pass_steps = 0, pass_steps = 0;
+static double last_pass_time = 0.0, pass_time = 0.0;
+
+static PyGC_Hook gc_hook = NULL;
+static void *gc_hook_arg = NULL;
+
+/* start the statistics of a collection of generation `generation` */
+static void
+begin_collection(int generation, PyGC_Info *info)
+{
+    info->generation = generation;
+    info->start = gc_clock();
+    info->duration = 0.0;
+    info->examined = info->collected = info->uncollectable = 0;
+    if (gc_hook != NULL)
+        gc_hook(PyGC_START, info, gc_hook_arg);
+}
+
+static void
+end_collection(PyGC_Info *info)
+{
+    struct gc_generation_stats *st = &generation_stats[info->generation];
+    double seconds = gc_clock() - info->start;
+    int i = 0;
+    double us = seconds * 1e6;
+
+    while (us >= 1.0 && i < PAUSE_BUCKETS-1) {
+        us /= 2.0;
+        i++;
+    }
+    pause_histogram[info->generation][i]++;
+
+    st->collections++;
+    st->examined += info->examined;
+    st->collected += info->collected;
+    st->uncollectable += info->uncollectable;
+    st->time += seconds;
+    st->last_pause = seconds;
+    if (seconds > st->max_pause)
+        st->max_pause = seconds;
+    if (info->generation == PyGC_INCREMENTAL) {
+        pass_steps++;
+        pass_time += seconds;
+    }
+
+    info->duration = seconds;
+    if (gc_hook != NULL)
+        gc_hook(PyGC_STOP, info, gc_hook_arg);
+}
+
 /*** list functions ***/
 
 static void
@@ -281,14 +432,16 @@ append_objects(PyObject *py_list, PyGC_Head *gc_list)
 
 /* Set all gc_refs = ob_refcnt.  After this, gc_refs is > 0 for all objects
  * in containers, and is GC_REACHABLE for all tracked gc objects not in
- * containers.
+ * containers.  Returns the number of objects in containers.
  */
-static void
+static Py_ssize_t
 update_refs(PyGC_Head *containers)
 {
+    Py_ssize_t n = 0;
     PyGC_Head *gc = containers->gc.gc_next;
     for (; gc != containers; gc = gc->gc.gc_next) {
-        assert(gc->gc.gc_refs == GC_REACHABLE);
+        n++;
+        assert(IS_REACHABLE(FROM_GC(gc)));
         gc->gc.gc_refs = Py_REFCNT(FROM_GC(gc));
         /* Python's cyclic gc should never see an incoming refcount
          * of 0:  if something decref'ed to 0, it should have been
@@ -310,6 +463,7 @@ update_refs(PyGC_Head *containers)
          */
         assert(gc->gc.gc_refs != 0);
     }
+    return n;
 }
 
 /* A traversal callback for subtract_refs. */
@@ -379,12 +533,13 @@ visit_reachable(PyObject *op, PyGC_Head *reachable)
          * list, and move_unreachable will eventually get to it.
          * If gc_refs == GC_REACHABLE, it's either in some other
          * generation so we don't care about it, or move_unreachable
-         * already dealt with it.
+         * already dealt with it.  The same goes for the other values
+         * reachable objects of the oldest generation can have.
          * If gc_refs == GC_UNTRACKED, it must be ignored.
          */
          else {
             assert(gc_refs > 0
-                   || gc_refs == GC_REACHABLE
+                   || IS_REACHABLE(op)
                    || gc_refs == GC_UNTRACKED);
          }
     }
@@ -719,6 +874,7 @@ handle_weakrefs(PyGC_Head *unreachable, PyGC_Head *old)
         if (wrcb_to_call.gc.gc_next == gc) {
             /* object is still alive -- move it */
             gc_list_move(gc, old);
+            gc->gc.gc_refs = GC_REACHABLE;
         }
         else
             ++num_freed;
@@ -826,7 +982,7 @@ static void
 clear_freelists(void)
 {
     (void)PyMethod_ClearFreeList();
-    (void)PyFrame_ClearFreeList();
+    (void)_PyFrame_TrimFreeList();
     (void)PyCFunction_ClearFreeList();
     (void)PyTuple_ClearFreeList();
 #ifdef Py_USING_UNICODE
@@ -854,6 +1010,125 @@ get_time(void)
     return result;
 }
 
+/* Deal with the objects a collection found unreachable: keep the ones
+ * reachable from finalizers, clear weakrefs to the others and break their
+ * cycles.  Whatever stays alive is moved to old.  Returns the number of
+ * unreachable objects that were collected, and sets *uncollectable to the
+ * number of those that were not.
+ */
+static Py_ssize_t
+handle_unreachable(PyGC_Head *unreachable, PyGC_Head *old,
+                   Py_ssize_t *uncollectable)
+{
+    Py_ssize_t m = 0; /* # objects collected */
+    Py_ssize_t n = 0; /* # unreachable objects that couldn't be collected */
+#ifdef STACKLESS
+    /* unlinking may occur in a different tasklet during collection
+     * so this must not be on the stack
+     */
+    static PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
+#else
+    PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
+#endif
+    PyGC_Head *gc;
+
+    /* All objects in unreachable are trash, but objects reachable from
+     * finalizers can't safely be deleted.  Python programmers should take
+     * care not to create such things.  For Python, finalizers means
+     * instance objects with __del__ methods.  Weakrefs with callbacks
+     * can also call arbitrary Python code but they will be dealt with by
+     * handle_weakrefs().
+     */
+    gc_list_init(&finalizers);
+    move_finalizers(unreachable, &finalizers);
+    /* finalizers contains the unreachable objects with a finalizer;
+     * unreachable objects reachable *from* those are also uncollectable,
+     * and we move those into the finalizers list too.
+     */
+    move_finalizer_reachable(&finalizers);
+
+    /* Collect statistics on collectable objects found and print
+     * debugging information.
+     */
+    for (gc = unreachable->gc.gc_next; gc != unreachable;
+                    gc = gc->gc.gc_next) {
+        m++;
+        if (debug & DEBUG_COLLECTABLE) {
+            debug_cycle("collectable", FROM_GC(gc));
+        }
+    }
+
+    /* Clear weakrefs and invoke callbacks as necessary. */
+    m += handle_weakrefs(unreachable, old);
+
+    /* Call tp_clear on objects in the unreachable set.  This will cause
+     * the reference cycles to be broken.  It may also cause some objects
+     * in finalizers to be freed.
+     */
+    delete_garbage(unreachable, old);
+
+    /* Collect statistics on uncollectable objects found and print
+     * debugging information. */
+    for (gc = finalizers.gc.gc_next;
+         gc != &finalizers;
+         gc = gc->gc.gc_next) {
+        n++;
+        if (debug & DEBUG_UNCOLLECTABLE)
+            debug_cycle("uncollectable", FROM_GC(gc));
+    }
+
+    /* Append instances in the uncollectable set to a Python
+     * reachable list of garbage.  The programmer has to deal with
+     * this if they insist on creating this type of structure.
+     */
+    (void)handle_finalizers(&finalizers, old);
+
+    *uncollectable = n;
+    return m;
+}
+
+static void
+debug_done(Py_ssize_t m, Py_ssize_t n, double t1)
+{
+    double t2 = get_time();
+    if (m == 0 && n == 0)
+        PySys_WriteStderr("gc: done");
+    else
+        PySys_WriteStderr(
+            "gc: done, "
+            "%" PY_FORMAT_SIZE_T "d unreachable, "
+            "%" PY_FORMAT_SIZE_T "d uncollectable",
+            n+m, n);
+    if (t1 && t2) {
+        PySys_WriteStderr(", %.4fs elapsed", t2-t1);
+    }
+    PySys_WriteStderr(".\n");
+}
+
+static void
+check_error(void)
+{
+    if (PyErr_Occurred()) {
+        if (gc_str == NULL)
+            gc_str = PyString_FromString("garbage collection");
+        PyErr_WriteUnraisable(gc_str);
+        Py_FatalError("unexpected exception during garbage collection");
+    }
+}
+
+/* Stop the incremental pass in progress, if any.  The objects it visited
+ * go back into the oldest generation, where the next pass finds them
+ * unvisited.
+ */
+static void
+end_incremental_pass(void)
+{
+    if (incremental_pass) {
+        gc_list_merge(&old_visited, GEN_HEAD(NUM_GENERATIONS-1));
+        incremental_pass = 0;
+    }
+}
+
 /* This is the main function.  Read this to understand how the
  * collection process works. */
 static Py_ssize_t
@@ -866,15 +1141,13 @@ collect(int generation)
     PyGC_Head *old; /* next older generation */
 #ifdef STACKLESS
     /* unlinking may occur in a different tasklet during collection
-     * so these must not be on the stack
+     * so this must not be on the stack
      */
     static PyGC_Head unreachable; /* non-problematic unreachable trash */
-    static PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
 #else
     PyGC_Head unreachable; /* non-problematic unreachable trash */
-    PyGC_Head finalizers;  /* objects with, & reachable from, __del__ */
 #endif
-    PyGC_Head *gc;
+    PyGC_Info info;
     double t1 = 0.0;
 
     if (delstr == NULL) {
@@ -883,6 +1156,13 @@ collect(int generation)
             Py_FatalError("gc couldn't allocate \"__del__\"");
     }
 
+    /* a full collection looks at the objects an incremental pass has
+     * already visited, too, and makes the pass pointless */
+    if (generation == NUM_GENERATIONS-1)
+        end_incremental_pass();
+
+    begin_collection(generation, &info);
+
     if (debug & DEBUG_STATS) {
         PySys_WriteStderr("gc: collecting generation %d...\n",
                           generation);
@@ -917,7 +1197,7 @@ collect(int generation)
      * refcount greater than 0 when all the references within the
      * set are taken into account).
      */
-    update_refs(young);
+    info.examined = update_refs(young);
     subtract_refs(young);
 
     /* Leave everything reachable from outside young in young, and move
@@ -941,83 +1221,172 @@ collect(int generation)
         long_lived_total = gc_list_size(young);
     }
 
-    /* All objects in unreachable are trash, but objects reachable from
-     * finalizers can't safely be deleted.  Python programmers should take
-     * care not to create such things.  For Python, finalizers means
-     * instance objects with __del__ methods.  Weakrefs with callbacks
-     * can also call arbitrary Python code but they will be dealt with by
-     * handle_weakrefs().
-     */
-    gc_list_init(&finalizers);
-    move_finalizers(&unreachable, &finalizers);
-    /* finalizers contains the unreachable objects with a finalizer;
-     * unreachable objects reachable *from* those are also uncollectable,
-     * and we move those into the finalizers list too.
-     */
-    move_finalizer_reachable(&finalizers);
+    m = handle_unreachable(&unreachable, old, &n);
 
-    /* Collect statistics on collectable objects found and print
-     * debugging information.
+    if (debug & DEBUG_STATS)
+        debug_done(m, n, t1);
+
+    /* Clear free list only during the collection of the highest
+     * generation */
+    if (generation == NUM_GENERATIONS-1) {
+        clear_freelists();
+    }
+
+    check_error();
+    info.collected = m;
+    info.uncollectable = n;
+    end_collection(&info);
+    return n+m;
+}
+
+/* A traversal callback for collect_increment. */
+static int
+visit_increment(PyObject *op, Py_ssize_t *room)
+{
+    /* Every instance refers to its class, and through the class dict
+     * and the functions in it a class reaches most of a program, which a
+     * step has no room for.  Classes are taken in their turn instead.
      */
-    for (gc = unreachable.gc.gc_next; gc != &unreachable;
-                    gc = gc->gc.gc_next) {
-        m++;
-        if (debug & DEBUG_COLLECTABLE) {
-            debug_cycle("collectable", FROM_GC(gc));
+    if (PyObject_IS_GC(op) && *room > 0 && !PyType_Check(op)) {
+        PyGC_Head *gc = AS_GC(op);
+
+        if (IS_UNVISITED(gc)) {
+            /* an object of the oldest generation, or one the pass has
+             * put into old_visited unmarked; take it into the step */
+            gc_list_move(gc, GEN_HEAD(0));
+            gc->gc.gc_refs = Py_REFCNT(op);
+            assert(gc->gc.gc_refs != 0);
+            --*room;
         }
     }
+    return 0;
+}
 
-    /* Clear weakrefs and invoke callbacks as necessary. */
-    m += handle_weakrefs(&unreachable, old);
-
-    /* Call tp_clear on objects in the unreachable set.  This will cause
-     * the reference cycles to be broken.  It may also cause some objects
-     * in finalizers to be freed.
+/* Run one step of an incremental pass over the oldest generation, starting
+ * a pass if none is in progress.  The step collects the young generations,
+ * and about `step` objects of the oldest generation that the pass has not
+ * visited yet.  These are taken one at a time, each along with the
+ * unvisited objects reachable from it, so the objects of a cycle end up
+ * in the same step if there is room for all of them.
+ */
+static Py_ssize_t
+collect_increment(Py_ssize_t step)
+{
+    int i;
+    Py_ssize_t m = 0; /* # objects collected */
+    Py_ssize_t n = 0; /* # unreachable objects that couldn't be collected */
+    Py_ssize_t young_size = 0;
+    int complete = 0; /* is the pass complete after this step? */
+    Py_ssize_t room = step; /* # old objects the step may still take */
+    PyGC_Head *work = GEN_HEAD(0); /* the objects of this step */
+    PyGC_Head *pending = GEN_HEAD(NUM_GENERATIONS-1);
+    PyGC_Head *gc, *scan;
+#ifdef STACKLESS
+    /* unlinking may occur in a different tasklet during collection
+     * so this must not be on the stack
      */
-    delete_garbage(&unreachable, old);
+    static PyGC_Head unreachable; /* non-problematic unreachable trash */
+#else
+    PyGC_Head unreachable; /* non-problematic unreachable trash */
+#endif
+    PyGC_Info info;
+    double t1 = 0.0;
 
-    /* Collect statistics on uncollectable objects found and print
-     * debugging information. */
-    for (gc = finalizers.gc.gc_next;
-         gc != &finalizers;
-         gc = gc->gc.gc_next) {
-        n++;
-        if (debug & DEBUG_UNCOLLECTABLE)
-            debug_cycle("uncollectable", FROM_GC(gc));
+    if (delstr == NULL) {
+        delstr = PyString_InternFromString("__del__");
+        if (delstr == NULL)
+            Py_FatalError("gc couldn't allocate \"__del__\"");
+    }
+
+    if (!incremental_pass) {
+        incremental_pass = 1;
+        /* the marks of the last pass now mean "not visited" */
+        visited_mark = GC_VISITED_A + GC_VISITED_B - visited_mark;
+        visited_count = 0;
+        generations[NUM_GENERATIONS-1].count = 0;
+        pass_steps = 0;
+        pass_time = 0.0;
     }
+    begin_collection(PyGC_INCREMENTAL, &info);
+
     if (debug & DEBUG_STATS) {
-        double t2 = get_time();
-        if (m == 0 && n == 0)
-            PySys_WriteStderr("gc: done");
-        else
-            PySys_WriteStderr(
-                "gc: done, "
-                "%" PY_FORMAT_SIZE_T "d unreachable, "
-                "%" PY_FORMAT_SIZE_T "d uncollectable",
-                n+m, n);
-        if (t1 && t2) {
-            PySys_WriteStderr(", %.4fs elapsed", t2-t1);
-        }
-        PySys_WriteStderr(".\n");
+        PySys_WriteStderr("gc: collecting an increment of generation %d...\n",
+                          NUM_GENERATIONS-1);
+        t1 = get_time();
     }
 
-    /* Append instances in the uncollectable set to a Python
-     * reachable list of garbage.  The programmer has to deal with
-     * this if they insist on creating this type of structure.
+    /* the young generations are collected, too */
+    for (i = 0; i < NUM_GENERATIONS-1; i++)
+        generations[i].count = 0;
+    for (i = 1; i < NUM_GENERATIONS-1; i++)
+        gc_list_merge(GEN_HEAD(i), work);
+    young_size = update_refs(work);
+
+    /* Take the unvisited objects.  visit_increment() appends to work, and
+     * sets gc_refs the way update_refs() would have.
      */
-    (void)handle_finalizers(&finalizers, old);
+    scan = work->gc.gc_prev;
+    while (room > 0) {
+        if (scan->gc.gc_next == work) {
+            /* everything reachable from the step has been taken */
+            if (gc_list_is_empty(pending))
+                break;
+            gc = pending->gc.gc_next;
+            gc_list_move(gc, work);
+            gc->gc.gc_refs = Py_REFCNT(FROM_GC(gc));
+            assert(gc->gc.gc_refs != 0);
+            --room;
+        }
+        scan = scan->gc.gc_next;
+        (void) Py_TYPE(FROM_GC(scan))->tp_traverse(FROM_GC(scan),
+                                       (visitproc)visit_increment,
+                                       (void *)&room);
+    }
 
-    /* Clear free list only during the collection of the highest
-     * generation */
-    if (generation == NUM_GENERATIONS-1) {
+    if (debug & DEBUG_STATS) {
+        PySys_WriteStderr("gc: objects in the step:"
+                          " %" PY_FORMAT_SIZE_T "d young,"
+                          " %" PY_FORMAT_SIZE_T "d old,"
+                          " %" PY_FORMAT_SIZE_T "d old to go\n",
+                          young_size, step - room, gc_list_size(pending));
+    }
+
+    subtract_refs(work);
+    gc_list_init(&unreachable);
+    move_unreachable(work, &unreachable);
+
+    /* the survivors have been visited */
+    for (gc = work->gc.gc_next; gc != work; gc = gc->gc.gc_next) {
+        gc->gc.gc_refs = visited_mark;
+        visited_count++;
+    }
+    gc_list_merge(work, &old_visited);
+
+    m = handle_unreachable(&unreachable, &old_visited, &n);
+
+    if (debug & DEBUG_STATS)
+        debug_done(m, n, t1);
+
+    if (gc_list_is_empty(pending)) {
+        /* The pass is complete.  long_lived_total stays what the last
+         * full collection left, so that long_lived_pending tells how much
+         * the generation has grown since. */
+        long_lived_pending = visited_count > long_lived_total ?
+            visited_count - long_lived_total : 0;
+        end_incremental_pass();
         clear_freelists();
+        complete = 1;
     }
 
-    if (PyErr_Occurred()) {
-        if (gc_str == NULL)
-            gc_str = PyString_FromString("garbage collection");
-        PyErr_WriteUnraisable(gc_str);
-        Py_FatalError("unexpected exception during garbage collection");
+    check_error();
+    info.examined = young_size + step - room;
+    info.collected = m;
+    info.uncollectable = n;
+    end_collection(&info);
+    if (complete) {
+        passes++;
+        last_pass_steps = pass_steps;
+        last_pass_time = pass_time;
     }
     return n+m;
 }
@@ -1028,6 +1397,11 @@ collect_generations(void)
     int i;
     Py_ssize_t n = 0;
 
+    /* While an incremental pass is in progress, each collection of the
+     * young generations does a step of it. */
+    if (incremental_pass && incremental_step > 0)
+        return collect_increment(incremental_step);
+
     /* Find the oldest generation (highest numbered) where the count
      * exceeds the threshold.  Objects in the that generation and
      * generations younger than it will be collected. */
@@ -1040,7 +1414,16 @@ collect_generations(void)
             if (i == NUM_GENERATIONS - 1
                 && long_lived_pending < long_lived_total / 4)
                 continue;
-            n = collect(i);
+            /* Cycles too large for a step, or whose objects a pass
+               visited at different times, survive incremental passes.
+               Fall back to a full collection once the oldest generation
+               has grown by half since the last one.
+            */
+            if (i == NUM_GENERATIONS - 1 && incremental_step > 0
+                && long_lived_pending <= long_lived_total / 2)
+                n = collect_increment(incremental_step);
+            else
+                n = collect(i);
             break;
         }
     }
@@ -1118,6 +1501,166 @@ gc_collect(PyObject *self, PyObject *args, PyObject *kws)
     return PyInt_FromSsize_t(n);
 }
 
+PyDoc_STRVAR(gc_set_incremental__doc__,
+"set_incremental(step) -> None\n"
+"\n"
+"Collect the oldest generation incrementally, examining about step of its\n"
+"objects at a time, and the young generations along with each step.\n"
+"Zero turns incremental collection off.\n");
+
+static PyObject *
+gc_set_incremental(PyObject *self, PyObject *args)
+{
+    Py_ssize_t step;
+
+    if (!PyArg_ParseTuple(args, "n:set_incremental", &step))
+        return NULL;
+    if (step < 0) {
+        PyErr_SetString(PyExc_ValueError, "step must not be negative");
+        return NULL;
+    }
+    incremental_step = step;
+    if (step == 0)
+        end_incremental_pass();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_get_incremental__doc__,
+"get_incremental() -> step\n"
+"\n"
+"Return the step size of incremental collection, 0 if it is off.\n");
+
+static PyObject *
+gc_get_incremental(PyObject *self, PyObject *noargs)
+{
+    return PyInt_FromSsize_t(incremental_step);
+}
+
+PyDoc_STRVAR(gc_collect_step__doc__,
+"collect_step([step]) -> n\n"
+"\n"
+"Run one step of an incremental collection of the oldest generation now,\n"
+"for instance while the scheduler is idle.  step defaults to the value\n"
+"given to set_incremental().  The number of unreachable objects found\n"
+"is returned.\n");
+
+static PyObject *
+gc_collect_step(PyObject *self, PyObject *args)
+{
+    Py_ssize_t step = incremental_step;
+
+    if (!PyArg_ParseTuple(args, "|n:collect_step", &step))
+        return NULL;
+    if (step <= 0) {
+        PyErr_SetString(PyExc_ValueError, "step must be positive");
+        return NULL;
+    }
+    return PyInt_FromSsize_t(PyGC_CollectStep(step));
+}
+
+PyDoc_STRVAR(gc_get_pause_histogram__doc__,
+"get_pause_histogram([reset]) -> (hist0, hist1, hist2, hist_step)\n"
+"\n"
+"Return how long the collections of each generation and the incremental\n"
+"steps paused the program.  Each histogram is a list, whose item i is\n"
+"the number of pauses shorter than 2**i microseconds that were not\n"
+"counted by item i-1.  The last item counts all longer pauses.  If reset\n"
+"is true, the counts start again from zero.\n");
+
+static PyObject *
+gc_get_pause_histogram(PyObject *self, PyObject *args)
+{
+    int i, j, reset = 0;
+    PyObject *result;
+
+    if (!PyArg_ParseTuple(args, "|i:get_pause_histogram", &reset))
+        return NULL;
+    result = PyTuple_New(NUM_GENERATIONS+1);
+    if (result == NULL)
+        return NULL;
+    for (i = 0; i <= NUM_GENERATIONS; i++) {
+        PyObject *hist = PyList_New(PAUSE_BUCKETS);
+        if (hist == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, i, hist);
+        for (j = 0; j < PAUSE_BUCKETS; j++) {
+            PyObject *count = PyInt_FromSsize_t(pause_histogram[i][j]);
+            if (count == NULL) {
+                Py_DECREF(result);
+                return NULL;
+            }
+            PyList_SET_ITEM(hist, j, count);
+        }
+    }
+    if (reset)
+        memset(pause_histogram, 0, sizeof(pause_histogram));
+    return result;
+}
+
+PyDoc_STRVAR(gc_get_stats__doc__,
+"get_stats([reset]) -> [stats0, stats1, stats2, stats_step]\n"
+"\n"
+"Return a dict of statistics for the collections of each generation and\n"
+"for the steps of incremental collection: the number of collections,\n"
+"the objects examined, the unreachable objects collected and those found\n"
+"uncollectable, and the total, longest and last pause in seconds.  The\n"
+"statistics of the steps also give the number of completed passes, and\n"
+"the number of steps and the total pause of the last one.  If reset is\n"
+"true, the statistics start again from zero.\n");
+
+static PyObject *
+gc_get_stats(PyObject *self, PyObject *args)
+{
+    int i, reset = 0;
+    PyObject *result;
+
+    if (!PyArg_ParseTuple(args, "|i:get_stats", &reset))
+        return NULL;
+    result = PyList_New(NUM_GENERATIONS+1);
+    if (result == NULL)
+        return NULL;
+    for (i = 0; i <= NUM_GENERATIONS; i++) {
+        struct gc_generation_stats *st = &generation_stats[i];
+        PyObject *dict;
+
+        if (i < NUM_GENERATIONS)
+            dict = Py_BuildValue("{snsnsnsnsdsdsd}",
+                                 "collections", st->collections,
+                                 "examined", st->examined,
+                                 "collected", st->collected,
+                                 "uncollectable", st->uncollectable,
+                                 "time", st->time,
+                                 "max_pause", st->max_pause,
+                                 "last_pause", st->last_pause);
+        else
+            dict = Py_BuildValue("{snsnsnsnsdsdsdsnsnsd}",
+                                 "collections", st->collections,
+                                 "examined", st->examined,
+                                 "collected", st->collected,
+                                 "uncollectable", st->uncollectable,
+                                 "time", st->time,
+                                 "max_pause", st->max_pause,
+                                 "last_pause", st->last_pause,
+                                 "passes", passes,
+                                 "last_pass_steps", last_pass_steps,
+                                 "last_pass_time", last_pass_time);
+        if (dict == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, dict);
+    }
+    if (reset) {
+        memset(generation_stats, 0, sizeof(generation_stats));
+        passes = last_pass_steps = 0;
+        last_pass_time = 0.0;
+    }
+    return result;
+}
+
 PyDoc_STRVAR(gc_set_debug__doc__,
 "set_debug(flags) -> None\n"
 "\n"
@@ -1207,6 +1750,105 @@ gc_get_count(PyObject *self, PyObject *noargs)
                          generations[2].count);
 }
 
+PyDoc_STRVAR(gc_freeze__doc__,
+"freeze([immortal]) -> None\n"
+"\n"
+"Move all objects tracked by the collector into a permanent generation\n"
+"that is ignored from now on.  Do this in a process that is about to fork,\n"
+"so the children do not copy the pages of the shared objects when they\n"
+"collect.  If immortal is true, the frozen objects and the untracked\n"
+"objects they refer to also become immortal, and are never written to\n"
+"by reference counting again; this needs a Py_IMMORTAL_OBJECTS build.\n");
+
+#ifdef Py_IMMORTAL_OBJECTS
+static void
+make_immortal(PyObject *op)
+{
+#ifdef Py_REF_DEBUG
+    /* the references it holds are never given back */
+    if (!_Py_IsImmortal(op))
+        _Py_RefTotal -= op->ob_refcnt;
+#endif
+    op->ob_refcnt = _Py_IMMORTAL_REFCNT;
+}
+
+static int
+visit_immortal(PyObject *op, void *data)
+{
+    /* tracked objects are frozen themselves; an untracked container
+       may still get tracked and collected later */
+    if (!PyObject_IS_GC(op))
+        make_immortal(op);
+    return 0;
+}
+#endif
+
+static PyObject *
+gc_freeze(PyObject *self, PyObject *args)
+{
+    int i, immortal = 0;
+
+    if (!PyArg_ParseTuple(args, "|i:freeze", &immortal))
+        return NULL;
+#ifndef Py_IMMORTAL_OBJECTS
+    if (immortal) {
+        PyErr_SetString(PyExc_ValueError,
+                        "immortal objects need a Py_IMMORTAL_OBJECTS build");
+        return NULL;
+    }
+#endif
+    end_incremental_pass();
+    for (i = 0; i < NUM_GENERATIONS; i++) {
+        PyGC_Head *gc;
+        for (gc = GEN_HEAD(i)->gc.gc_next; gc != GEN_HEAD(i);
+             gc = gc->gc.gc_next) {
+            /* keep incremental passes from pulling it into a step */
+            gc->gc.gc_refs = GC_FROZEN;
+#ifdef Py_IMMORTAL_OBJECTS
+            if (immortal) {
+                PyObject *op = FROM_GC(gc);
+                make_immortal(op);
+                Py_TYPE(op)->tp_traverse(op, visit_immortal, NULL);
+            }
+#endif
+        }
+        gc_list_merge(GEN_HEAD(i), &permanent_generation.head);
+        generations[i].count = 0;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_unfreeze__doc__,
+"unfreeze() -> None\n"
+"\n"
+"Move the objects of the permanent generation back into the oldest\n"
+"generation.  Objects made immortal stay immortal.\n");
+
+static PyObject *
+gc_unfreeze(PyObject *self, PyObject *noargs)
+{
+    PyGC_Head *gc;
+
+    for (gc = permanent_generation.head.gc.gc_next;
+         gc != &permanent_generation.head; gc = gc->gc.gc_next)
+        gc->gc.gc_refs = GC_REACHABLE;
+    gc_list_merge(&permanent_generation.head, GEN_HEAD(NUM_GENERATIONS-1));
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(gc_get_freeze_count__doc__,
+"get_freeze_count() -> int\n"
+"\n"
+"Return the number of objects in the permanent generation.\n");
+
+static PyObject *
+gc_get_freeze_count(PyObject *self, PyObject *noargs)
+{
+    return PyInt_FromSsize_t(gc_list_size(&permanent_generation.head));
+}
+
 static int
 referrersvisit(PyObject* obj, PyObject *objs)
 {
@@ -1253,6 +1895,10 @@ gc_get_referrers(PyObject *self, PyObject *args)
             return NULL;
         }
     }
+    if (!(gc_referrers_for(args, &old_visited, result))) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1314,6 +1960,10 @@ gc_get_objects(PyObject *self, PyObject *noargs)
             return NULL;
         }
     }
+    if (append_objects(result, &old_visited)) {
+        Py_DECREF(result);
+        return NULL;
+    }
     return result;
 }
 
@@ -1353,7 +2003,15 @@ PyDoc_STRVAR(gc__doc__,
 "get_objects() -- Return a list of all objects tracked by the collector.\n"
 "is_tracked() -- Returns true if a given object is tracked.\n"
 "get_referrers() -- Return the list of objects that refer to an object.\n"
-"get_referents() -- Return the list of objects that an object refers to.\n");
+"get_referents() -- Return the list of objects that an object refers to.\n"
+"freeze() -- Freeze all tracked objects and ignore them in collections.\n"
+"unfreeze() -- Unfreeze all objects in the permanent generation.\n"
+"get_freeze_count() -- Return the number of frozen objects.\n"
+"set_incremental() -- Set the step size of incremental collection.\n"
+"get_incremental() -- Return the step size of incremental collection.\n"
+"collect_step() -- Do a step of an incremental collection right now.\n"
+"get_pause_histogram() -- Return histograms of the collection pauses.\n"
+"get_stats() -- Return statistics of the collections of each generation.\n");
 
 static PyMethodDef GcMethods[] = {
     {"enable",             gc_enable,     METH_NOARGS,  gc_enable__doc__},
@@ -1372,6 +2030,18 @@ static PyMethodDef GcMethods[] = {
         gc_get_referrers__doc__},
     {"get_referents",  gc_get_referents, METH_VARARGS,
         gc_get_referents__doc__},
+    {"freeze",         gc_freeze,     METH_VARARGS, gc_freeze__doc__},
+    {"unfreeze",       gc_unfreeze,   METH_NOARGS,  gc_unfreeze__doc__},
+    {"get_freeze_count", gc_get_freeze_count, METH_NOARGS,
+        gc_get_freeze_count__doc__},
+    {"set_incremental", gc_set_incremental, METH_VARARGS,
+        gc_set_incremental__doc__},
+    {"get_incremental", gc_get_incremental, METH_NOARGS,
+        gc_get_incremental__doc__},
+    {"collect_step",   gc_collect_step, METH_VARARGS, gc_collect_step__doc__},
+    {"get_pause_histogram", gc_get_pause_histogram, METH_VARARGS,
+        gc_get_pause_histogram__doc__},
+    {"get_stats",      gc_get_stats,  METH_VARARGS, gc_get_stats__doc__},
     {NULL,      NULL}           /* Sentinel */
 };
 
@@ -1437,6 +2107,32 @@ PyGC_Collect(void)
     return n;
 }
 
+/* API to run a step of an incremental collection from C, e.g. when the
+   scheduler is idle */
+Py_ssize_t
+PyGC_CollectStep(Py_ssize_t step)
+{
+    Py_ssize_t n;
+
+    if (collecting || step <= 0)
+        n = 0; /* already collecting, don't do anything */
+    else {
+        collecting = 1;
+        n = collect_increment(step);
+        collecting = 0;
+    }
+
+    return n;
+}
+
+/* API to monitor collections */
+void
+PyGC_SetHook(PyGC_Hook hook, void *arg)
+{
+    gc_hook = hook;
+    gc_hook_arg = arg;
+}
+
 /* for debugging */
 void
 _PyGC_Dump(PyGC_Head *g)
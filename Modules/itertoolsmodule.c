@@ -751,12 +751,9 @@ cycle_next(cycleobject *lz)
             }
             return item;
         }
-        if (PyErr_Occurred()) {
-            if (PyErr_ExceptionMatches(PyExc_StopIteration))
-                PyErr_Clear();
-            else
-                return NULL;
-        }
+        /* PyIter_Next() already cleared a StopIteration */
+        if (PyErr_Occurred())
+            return NULL;
         if (PyList_Size(lz->saved) == 0)
             return NULL;
         it = PyObject_GetIter(lz->saved);
@@ -1698,12 +1695,9 @@ chain_next(chainobject *lz)
     item = PyIter_Next(lz->active);
     if (item != NULL)
         return item;
-    if (PyErr_Occurred()) {
-        if (PyErr_ExceptionMatches(PyExc_StopIteration))
-            PyErr_Clear();
-        else
-            return NULL;                                /* input raised an exception */
-    }
+    /* PyIter_Next() already cleared a StopIteration */
+    if (PyErr_Occurred())
+        return NULL;                                    /* input raised an exception */
     Py_CLEAR(lz->active);
     return chain_next(lz);                      /* recurse and use next active */
 }
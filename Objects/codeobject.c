@@ -1,5 +1,6 @@
 #include "Python.h"
 #include "code.h"
+#include "opcode.h"
 #include "structmember.h"
 
 #define NAME_CHARS \
@@ -104,10 +105,256 @@ PyCode_New(int argcount, int nlocals, int stacksize, int flags,
         co->co_lnotab = lnotab;
         co->co_zombieframe = NULL;
         co->co_weakreflist = NULL;
+        co->co_opcache_map = NULL;
+        co->co_opcache = NULL;
+        co->co_opcache_flag = 0;
+        co->co_opcache_size = 0;
+        co->co_profile = NULL;
     }
     return co;
 }
 
+/* Allocate the inline caches of the eval loop, one for each LOAD_GLOBAL
+   and LOAD_ATTR up to _PyCode_OPCACHE_MAX_SIZE.  Returns -1 without
+   setting an exception if memory runs out; the code then simply runs
+   without caches. */
+int
+_PyCode_InitOpcache(PyCodeObject *co)
+{
+    unsigned char *code, *map;
+    Py_ssize_t i, codelen;
+    int opcode, count = 0;
+
+    if (co->co_opcache_map != NULL || !PyString_Check(co->co_code))
+        return 0;
+    code = (unsigned char *)PyString_AS_STRING(co->co_code);
+    codelen = PyString_GET_SIZE(co->co_code);
+    map = (unsigned char *)PyMem_MALLOC(codelen ? codelen : 1);
+    if (map == NULL)
+        return -1;
+    memset(map, 0, codelen);
+    for (i = 0; i < codelen; i += HAS_ARG(opcode) ? 3 : 1) {
+        opcode = code[i];
+        if ((opcode == LOAD_GLOBAL || opcode == LOAD_ATTR) &&
+            count < _PyCode_OPCACHE_MAX_SIZE)
+            map[i] = ++count;
+    }
+    if (count == 0) {
+        PyMem_FREE(map);
+        return 0;
+    }
+    co->co_opcache = PyMem_NEW(_PyOpcache, count);
+    if (co->co_opcache == NULL) {
+        PyMem_FREE(map);
+        return -1;
+    }
+    for (i = 0; i < codelen; i++) {
+        _PyOpcache *oc;
+        if (map[i] == 0)
+            continue;
+        oc = &co->co_opcache[map[i] - 1];
+        if (code[i] == LOAD_GLOBAL) {
+            /* no dict ever has these versions, see dictobject.h */
+            oc->u.lg.globals_ver = (Py_dictversion_t)-1;
+            oc->u.lg.builtins_ver = (Py_dictversion_t)-1;
+            oc->u.lg.ptr = NULL;
+        }
+        else {
+            oc->u.la.type = NULL;
+            oc->u.la.tp_version = 0;
+            oc->u.la.descr = NULL;
+        }
+    }
+    co->co_opcache_map = map;
+    co->co_opcache_size = count;
+    return 0;
+}
+
+/* Opcode profiles, see sys.setopcodeprofile().  The eval loop counts
+   into them, this file keeps them alive and reports them. */
+
+static _PyCodeProfile *profiles = NULL;
+
+_PyCodeProfile *
+_PyCode_GetProfile(PyCodeObject *co, int lines)
+{
+    _PyCodeProfile *p = co->co_profile;
+
+    if (p == NULL) {
+        p = PyMem_NEW(_PyCodeProfile, 1);
+        if (p == NULL)
+            return NULL;
+        memset(p, 0, sizeof(_PyCodeProfile));
+        p->code = co;
+        p->next = profiles;
+        if (profiles != NULL)
+            profiles->prev = p;
+        profiles = p;
+        co->co_profile = p;
+    }
+    if (lines && p->instrcounts == NULL && PyString_Check(co->co_code)) {
+        Py_ssize_t n = PyString_GET_SIZE(co->co_code);
+        p->instrcounts = PyMem_NEW(_Py_profcount_t, n ? n : 1);
+        if (p->instrcounts != NULL)
+            memset(p->instrcounts, 0, n * sizeof(_Py_profcount_t));
+    }
+    return p;
+}
+
+static void
+code_clear_profile(PyCodeObject *co)
+{
+    _PyCodeProfile *p = co->co_profile;
+
+    if (p == NULL)
+        return;
+    if (p->prev != NULL)
+        p->prev->next = p->next;
+    else
+        profiles = p->next;
+    if (p->next != NULL)
+        p->next->prev = p->prev;
+    if (p->instrcounts != NULL)
+        PyMem_FREE(p->instrcounts);
+    PyMem_FREE(p);
+    co->co_profile = NULL;
+}
+
+void
+_PyCode_ClearProfiles(void)
+{
+    while (profiles != NULL)
+        code_clear_profile(profiles->code);
+}
+
+/* The hits of a line are the executions of its most frequent
+   instruction.  Adds the instructions [start, end) of line to dict. */
+static int
+profile_line(PyObject *dict, int line, _Py_profcount_t *counts,
+             Py_ssize_t start, Py_ssize_t end)
+{
+    PyObject *key, *value, *old;
+    _Py_profcount_t hits = 0;
+    int err;
+
+    for (; start < end; start++)
+        if (counts[start] > hits)
+            hits = counts[start];
+    if (hits == 0)
+        return 0;
+    key = PyInt_FromLong(line);
+    value = _Py_profcount_AsObject(hits);
+    if (key == NULL || value == NULL) {
+        Py_XDECREF(key);
+        Py_XDECREF(value);
+        return -1;
+    }
+    old = PyDict_GetItem(dict, key);
+    err = old == NULL ? 0 : PyObject_RichCompareBool(old, value, Py_GE);
+    if (err == 0)
+        err = PyDict_SetItem(dict, key, value);
+    else if (err > 0)
+        err = 0;
+    Py_DECREF(key);
+    Py_DECREF(value);
+    return err;
+}
+
+static PyObject *
+profile_lines(PyCodeObject *co, _Py_profcount_t *counts)
+{
+    PyObject *result;
+    unsigned char *p = (unsigned char *)PyString_AS_STRING(co->co_lnotab);
+    Py_ssize_t size = PyString_GET_SIZE(co->co_lnotab) / 2;
+    Py_ssize_t codelen = PyString_GET_SIZE(co->co_code);
+    Py_ssize_t addr = 0, end;
+    int line = co->co_firstlineno;
+
+    result = PyDict_New();
+    if (result == NULL)
+        return NULL;
+    /* see Objects/lnotab_notes.txt */
+    while (--size >= 0) {
+        end = addr + *p++;
+        if (end > codelen)
+            end = codelen;
+        if (profile_line(result, line, counts, addr, end) < 0)
+            goto error;
+        addr = end;
+        line += *p++;
+    }
+    if (profile_line(result, line, counts, addr, codelen) < 0)
+        goto error;
+    return result;
+error:
+    Py_DECREF(result);
+    return NULL;
+}
+
+/* Returns a list of (code, opcode counts, line hits) tuples, one for
+   each code object that ran while the profile was on.  The opcode
+   counts are a list of 256 ints like sys.getdxp() returns, the line
+   hits a dict, or None if lines were not profiled. */
+PyObject *
+_PyCode_GetProfiles(void)
+{
+    PyObject *result, *item, *counts, *lines;
+    _PyCodeProfile *p;
+    int i;
+
+    result = PyList_New(0);
+    if (result == NULL)
+        return NULL;
+    for (p = profiles; p != NULL; p = p->next) {
+        counts = PyList_New(256);
+        if (counts == NULL)
+            goto error;
+        for (i = 0; i < 256; i++) {
+            PyObject *x = _Py_profcount_AsObject(p->opcounts[i]);
+            if (x == NULL) {
+                Py_DECREF(counts);
+                goto error;
+            }
+            PyList_SET_ITEM(counts, i, x);
+        }
+        if (p->instrcounts != NULL) {
+            lines = profile_lines(p->code, p->instrcounts);
+            if (lines == NULL) {
+                Py_DECREF(counts);
+                goto error;
+            }
+        }
+        else {
+            lines = Py_None;
+            Py_INCREF(lines);
+        }
+        item = Py_BuildValue("(ONN)", p->code, counts, lines);
+        if (item == NULL || PyList_Append(result, item) < 0) {
+            Py_XDECREF(item);
+            goto error;
+        }
+        Py_DECREF(item);
+    }
+    return result;
+error:
+    Py_DECREF(result);
+    return NULL;
+}
+
+void
+_PyCode_ClearOpcache(PyCodeObject *co)
+{
+    if (co->co_opcache_map != NULL) {
+        PyMem_FREE(co->co_opcache_map);
+        co->co_opcache_map = NULL;
+    }
+    if (co->co_opcache != NULL) {
+        PyMem_FREE(co->co_opcache);
+        co->co_opcache = NULL;
+    }
+    co->co_opcache_size = 0;
+}
+
 PyCodeObject *
 PyCode_NewEmpty(const char *filename, const char *funcname, int firstlineno)
 {
@@ -315,6 +562,8 @@ code_dealloc(PyCodeObject *co)
     Py_XDECREF(co->co_lnotab);
     if (co->co_zombieframe != NULL)
         PyObject_GC_Del(co->co_zombieframe);
+    _PyCode_ClearOpcache(co);
+    code_clear_profile(co);
     if (co->co_weakreflist != NULL)
         PyObject_ClearWeakRefs((PyObject*)co);
     PyObject_DEL(co);
@@ -237,6 +237,15 @@ methoddescr_call(PyMethodDescrObject *descr, PyObject *args, PyObject *kwds)
         return NULL;
     }
 
+    if (descr->d_method->ml_flags & METH_FASTCALL) {
+        /* neither a bound method nor an argument tuple is needed */
+        STACKLESS_PROMOTE_ALL();
+        result = _PyMethodDef_FastCall(descr->d_method, self,
+                                       &PyTuple_GET_ITEM(args, 1),
+                                       argc - 1, kwds);
+        STACKLESS_ASSERT();
+        return result;
+    }
     func = PyCFunction_New(descr->d_method, self);
     if (func == NULL)
         return NULL;
@@ -8,6 +8,7 @@
 */
 
 #include "Python.h"
+#include "structmember.h" /* we need the offsetof() macro from there */
 
 
 /* Set a key error with the specified argument, wrapping it in a
@@ -134,20 +135,177 @@ practice, this probably won't make a lick of difference for many years (at
 which point everyone will have terabytes of RAM on 64-bit boxes).
 */
 
-/* Object used as dummy key to fill deleted entries */
-static PyObject *dummy = NULL; /* Initialized by first call to newPyDictObject() */
+/*
+The table of a dict is a PyDictKeysObject:  a reference count, the
+lookup function in use, a hash table of dk_size indices (dk_size being
+a power of 2) and a dense array of entries, kept in insertion order.
+The hash table only maps a hash to the position of its entry, so it can
+use 1, 2, 4 or 8 byte indices depending on its size, see DK_IXSIZE(),
+and the entries take room for the USABLE_FRACTION() of dk_size items
+that may be stored, not for every slot.  Iteration walks the first
+dk_nentries entries, skipping deleted ones, so dicts iterate in
+insertion order.
+
+An index is one of:
+    DKIX_EMPTY   never used; ends a probe sequence
+    DKIX_DUMMY   its entry was deleted; the probe sequence continues
+    ix >= 0      the position of an active entry in the entries array
+
+Deleting a key turns its index into DKIX_DUMMY and clears its entry; the
+entries array is only compacted by dictresize(), so dk_usable, the number
+of entries that may still be appended, never grows back.
+
+A combined table (ma_values == NULL) holds the keys and the values of a
+single dict.  A split table holds only keys, all of them exact strings,
+and is shared by dicts that keep their values in their own ma_values
+arrays, indexed like the entries.  The instances of a class share the
+split table the class keeps in ht_cached_keys (cl_cached_keys for
+classic classes), so each instance __dict__ costs a values array
+instead of a table.
+
+A split table never contains dummies:  deleting from a split dict makes
+it combined first.  So does setting an attribute out of the order of
+the shared table, as the values of a split dict must fill its entries
+from the start for iteration to stay in insertion order; a new key is
+appended to a shared table while it has usable entries left, which is
+how the table learns the attribute names of a class.  Anything else --
+a non-string key, a full table, popitem() -- makes the dict combined as
+well, see dictresize().  Empty dicts share the static table Py_EMPTY_KEYS
+and empty_values, so an empty dict owns no table at all.
+
+To ensure the lookup algorithm terminates, there must be at least one
+DKIX_EMPTY index in the hash table, and to avoid slowing down lookups
+on a near-full table we resize when it's two-thirds full:  only
+USABLE_FRACTION() of dk_size entries are usable.
+*/
 
-#ifdef Py_REF_DEBUG
-PyObject *
-_PyDict_Dummy(void)
-{
-    return dummy;
-}
+#define DKIX_EMPTY (-1)
+#define DKIX_DUMMY (-2)         /* only found in the hash table */
+#define DKIX_ERROR (-3)         /* returned by the lookup functions */
+
+typedef Py_ssize_t (*dict_lookup_func)
+    (PyDictObject *mp, PyObject *key, long hash, PyObject ***value_addr,
+     Py_ssize_t *hashpos);
+
+struct _dictkeysobject {
+    Py_ssize_t dk_refcnt;
+    Py_ssize_t dk_size;         /* size of the hash table dk_indices */
+    dict_lookup_func dk_lookup;
+    Py_ssize_t dk_usable;       /* entries that may still be appended */
+    Py_ssize_t dk_nentries;     /* entries used, deleted ones included */
+    /* The hash table.  Its indices are as_1 for dk_size <= 128, as_2
+       up to 2**15 and as_4 up to 2**31, see DK_IXSIZE().  The entries
+       array follows the dk_size indices, see DK_ENTRIES(). */
+    union {
+        signed char as_1[8];
+        short as_2[4];
+        int as_4[2];
+#if SIZEOF_VOID_P > 4
+        Py_ssize_t as_8[1];
 #endif
+    } dk_indices;
+};
 
 /* forward declarations */
-static PyDictEntry *
-lookdict_string(PyDictObject *mp, PyObject *key, long hash);
+static Py_ssize_t lookdict(PyDictObject *mp, PyObject *key, long hash,
+                           PyObject ***value_addr, Py_ssize_t *hashpos);
+static Py_ssize_t lookdict_string(PyDictObject *mp, PyObject *key, long hash,
+                                  PyObject ***value_addr,
+                                  Py_ssize_t *hashpos);
+static Py_ssize_t lookdict_string_nodummy(PyDictObject *mp, PyObject *key,
+                                          long hash, PyObject ***value_addr,
+                                          Py_ssize_t *hashpos);
+static Py_ssize_t lookdict_split(PyDictObject *mp, PyObject *key, long hash,
+                                 PyObject ***value_addr, Py_ssize_t *hashpos);
+static int dictresize(PyDictObject *mp, Py_ssize_t minused);
+
+/* The table shared by all empty dicts.  Its reference count never
+   drops to zero, and it has no usable entries, so the first insertion
+   always allocates a real table. */
+static PyDictKeysObject empty_keys_struct = {
+    1,                  /* dk_refcnt */
+    1,                  /* dk_size */
+    lookdict_split,     /* dk_lookup */
+    0,                  /* dk_usable */
+    0,                  /* dk_nentries */
+    {{DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY,
+      DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY, DKIX_EMPTY}} /* dk_indices */
+};
+
+static PyObject *empty_values[1] = { NULL };
+
+#define Py_EMPTY_KEYS &empty_keys_struct
+
+#define USABLE_FRACTION(n) ((((n) << 1)+1)/3)
+/* The argument for dictresize() that makes room for n items */
+#define ESTIMATE_SIZE(n) (((n)*3) >> 1)
+
+#define DK_SIZE(dk) ((dk)->dk_size)
+#define DK_MASK(dk) (((dk)->dk_size)-1)
+/* The width of the indices of a hash table of the given size */
+#if SIZEOF_VOID_P > 4
+#define IXSIZE(size)                                                    \
+    ((size) <= 0xff ? 1 : (size) <= 0xffff ? 2 :                        \
+     (size) <= 0xffffffff ? 4 : (int)sizeof(Py_ssize_t))
+#else
+#define IXSIZE(size) ((size) <= 0xff ? 1 : (size) <= 0xffff ? 2 : 4)
+#endif
+#define DK_IXSIZE(dk) IXSIZE(DK_SIZE(dk))
+#define DK_ENTRIES(dk)                                                  \
+    ((PyDictEntry *)((char *)&(dk)->dk_indices + DK_SIZE(dk) * DK_IXSIZE(dk)))
+#define DK_INCREF(dk) (++(dk)->dk_refcnt)
+#define DK_DECREF(dk) do {                                              \
+    if (--(dk)->dk_refcnt == 0)                                         \
+        free_keys_object(dk);                                           \
+    } while(0)
+#define IS_POWER_OF_2(x) (((x) & ((x)-1)) == 0)
+
+/* The value of entry i of either kind of table */
+#define DK_VALUE(mp, i)                                                 \
+    ((mp)->ma_values != NULL ? (mp)->ma_values[i] :                     \
+     DK_ENTRIES((mp)->ma_keys)[i].me_value)
+
+/* lookdict_string_nodummy() cannot cope with dummies; switch to
+   lookdict_string() before deleting from a combined table */
+#define ENSURE_ALLOWS_DELETIONS(mp) do {                                \
+    if ((mp)->ma_keys->dk_lookup == lookdict_string_nodummy)            \
+        (mp)->ma_keys->dk_lookup = lookdict_string;                     \
+    } while(0)
+
+/* The entry index stored at position i of the hash table */
+Py_LOCAL_INLINE(Py_ssize_t)
+dk_get_index(PyDictKeysObject *keys, Py_ssize_t i)
+{
+    Py_ssize_t s = DK_SIZE(keys);
+
+    if (s <= 0xff)
+        return keys->dk_indices.as_1[i];
+    if (s <= 0xffff)
+        return keys->dk_indices.as_2[i];
+#if SIZEOF_VOID_P > 4
+    if (s > 0xffffffff)
+        return keys->dk_indices.as_8[i];
+#endif
+    return keys->dk_indices.as_4[i];
+}
+
+Py_LOCAL_INLINE(void)
+dk_set_index(PyDictKeysObject *keys, Py_ssize_t i, Py_ssize_t ix)
+{
+    Py_ssize_t s = DK_SIZE(keys);
+
+    assert(ix >= DKIX_DUMMY);
+    if (s <= 0xff)
+        keys->dk_indices.as_1[i] = (signed char)ix;
+    else if (s <= 0xffff)
+        keys->dk_indices.as_2[i] = (short)ix;
+#if SIZEOF_VOID_P > 4
+    else if (s > 0xffffffff)
+        keys->dk_indices.as_8[i] = ix;
+#endif
+    else
+        keys->dk_indices.as_4[i] = (int)ix;
+}
 
 #ifdef SHOW_CONVERSION_COUNTS
 static long created = 0L;
@@ -197,26 +355,10 @@ show_track(void)
 }
 #endif
 
+/* Source of ma_version values, see dictobject.h */
+static Py_dictversion_t pydict_global_version = 0;
 
-/* Initialization macros.
-   There are two ways to create a dict:  PyDict_New() is the main C API
-   function, and the tp_new slot maps to dict_new().  In the latter case we
-   can save a little time over what PyDict_New does because it's guaranteed
-   that the PyDictObject struct is already zeroed out.
-   Everyone except dict_new() should use EMPTY_TO_MINSIZE (unless they have
-   an excellent reason not to).
-*/
-
-#define INIT_NONZERO_DICT_SLOTS(mp) do {                                \
-    (mp)->ma_table = (mp)->ma_smalltable;                               \
-    (mp)->ma_mask = PyDict_MINSIZE - 1;                                 \
-    } while(0)
-
-#define EMPTY_TO_MINSIZE(mp) do {                                       \
-    memset((mp)->ma_smalltable, 0, sizeof((mp)->ma_smalltable));        \
-    (mp)->ma_used = (mp)->ma_fill = 0;                                  \
-    INIT_NONZERO_DICT_SLOTS(mp);                                        \
-    } while(0)
+#define DICT_MODIFIED(mp) ((mp)->ma_version = ++pydict_global_version)
 
 /* Dictionary reuse scheme to save calls to malloc, free, and memset */
 #ifndef PyDict_MAXFREELIST
@@ -224,6 +366,9 @@ show_track(void)
 #endif
 static PyDictObject *free_list[PyDict_MAXFREELIST];
 static int numfree = 0;
+/* Tables of PyDict_MINSIZE slots are recycled the same way */
+static PyDictKeysObject *keys_free_list[PyDict_MAXFREELIST];
+static int numfreekeys = 0;
 
 void
 PyDict_Fini(void)
@@ -235,54 +380,112 @@ PyDict_Fini(void)
         assert(PyDict_CheckExact(op));
         PyObject_GC_Del(op);
     }
+    while (numfreekeys)
+        PyObject_FREE(keys_free_list[--numfreekeys]);
 }
 
-PyObject *
-PyDict_New(void)
+/* Tables and values arrays are mostly small, so they come from
+   pymalloc rather than from the system malloc. */
+static PyDictKeysObject *
+new_keys_object(Py_ssize_t size)
 {
-    register PyDictObject *mp;
-    if (dummy == NULL) { /* Auto-initialize dummy */
-        dummy = PyString_FromString("<dummy key>");
-        if (dummy == NULL)
+    PyDictKeysObject *dk;
+    Py_ssize_t usable = USABLE_FRACTION(size);
+    Py_ssize_t i;
+
+    assert(size >= PyDict_MINSIZE);
+    assert(IS_POWER_OF_2(size));
+    if (size == PyDict_MINSIZE && numfreekeys > 0) {
+        dk = keys_free_list[--numfreekeys];
+    }
+    else {
+        if ((size_t)size > (PY_SSIZE_T_MAX - sizeof(PyDictKeysObject)) /
+                           (sizeof(Py_ssize_t) + sizeof(PyDictEntry))) {
+            PyErr_NoMemory();
             return NULL;
-#ifdef SHOW_CONVERSION_COUNTS
-        Py_AtExit(show_counts);
-#endif
-#ifdef SHOW_ALLOC_COUNT
-        Py_AtExit(show_alloc);
-#endif
-#ifdef SHOW_TRACK_COUNT
-        Py_AtExit(show_track);
-#endif
+        }
+        dk = (PyDictKeysObject *)PyObject_MALLOC(
+            offsetof(PyDictKeysObject, dk_indices) +
+            (size_t)size * IXSIZE(size) +
+            sizeof(PyDictEntry) * usable);
+        if (dk == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+    }
+    dk->dk_refcnt = 1;
+    dk->dk_size = size;
+    dk->dk_usable = usable;
+    dk->dk_nentries = 0;
+    dk->dk_lookup = lookdict_string_nodummy;
+    if (DK_IXSIZE(dk) == 1)
+        memset(&dk->dk_indices.as_1[0], 0xff, size);
+    else
+        for (i = 0; i < size; i++)
+            dk_set_index(dk, i, DKIX_EMPTY);
+    memset(DK_ENTRIES(dk), 0, sizeof(PyDictEntry) * usable);
+    return dk;
+}
+
+/* Release a table whose entries hold no references any more */
+static void
+free_keys_memory(PyDictKeysObject *keys)
+{
+    assert(keys != Py_EMPTY_KEYS);
+    if (DK_SIZE(keys) == PyDict_MINSIZE && numfreekeys < PyDict_MAXFREELIST)
+        keys_free_list[numfreekeys++] = keys;
+    else
+        PyObject_FREE(keys);
+}
+
+static void
+free_keys_object(PyDictKeysObject *keys)
+{
+    PyDictEntry *entries = DK_ENTRIES(keys);
+    Py_ssize_t i, n;
+
+    for (i = 0, n = keys->dk_nentries; i < n; i++) {
+        Py_XDECREF(entries[i].me_key);
+        Py_XDECREF(entries[i].me_value);
     }
+    free_keys_memory(keys);
+}
+
+#define new_values(size) \
+    ((PyObject **)PyObject_MALLOC(sizeof(PyObject *) * (size)))
+#define free_values(values) PyObject_FREE(values)
+
+/* Consumes a reference to the keys object */
+static PyObject *
+new_dict(PyDictKeysObject *keys, PyObject **values)
+{
+    register PyDictObject *mp;
+
+    assert(keys != NULL);
     if (numfree) {
         mp = free_list[--numfree];
         assert (mp != NULL);
         assert (Py_TYPE(mp) == &PyDict_Type);
         _Py_NewReference((PyObject *)mp);
-        if (mp->ma_fill) {
-            EMPTY_TO_MINSIZE(mp);
-        } else {
-            /* At least set ma_table and ma_mask; these are wrong
-               if an empty but presized dict is added to freelist */
-            INIT_NONZERO_DICT_SLOTS(mp);
-        }
-        assert (mp->ma_used == 0);
-        assert (mp->ma_table == mp->ma_smalltable);
-        assert (mp->ma_mask == PyDict_MINSIZE - 1);
 #ifdef SHOW_ALLOC_COUNT
         count_reuse++;
 #endif
     } else {
         mp = PyObject_GC_New(PyDictObject, &PyDict_Type);
-        if (mp == NULL)
+        if (mp == NULL) {
+            DK_DECREF(keys);
+            if (values != empty_values)
+                free_values(values);
             return NULL;
-        EMPTY_TO_MINSIZE(mp);
+        }
 #ifdef SHOW_ALLOC_COUNT
         count_alloc++;
 #endif
     }
-    mp->ma_lookup = lookdict_string;
+    mp->ma_keys = keys;
+    mp->ma_values = values;
+    mp->ma_used = 0;
+    mp->ma_version = 0;
 #ifdef SHOW_TRACK_COUNT
     count_untracked++;
 #endif
@@ -292,6 +495,45 @@ PyDict_New(void)
     return (PyObject *)mp;
 }
 
+/* Consumes a reference to the keys object */
+static PyObject *
+new_dict_with_shared_keys(PyDictKeysObject *keys)
+{
+    PyObject **values;
+    Py_ssize_t i, size;
+
+    size = USABLE_FRACTION(DK_SIZE(keys));
+    values = new_values(size);
+    if (values == NULL) {
+        DK_DECREF(keys);
+        return PyErr_NoMemory();
+    }
+    for (i = 0; i < size; i++)
+        values[i] = NULL;
+    return new_dict(keys, values);
+}
+
+PyObject *
+PyDict_New(void)
+{
+    static int initialized = 0;
+
+    if (!initialized) {
+        initialized = 1;
+#ifdef SHOW_CONVERSION_COUNTS
+        Py_AtExit(show_counts);
+#endif
+#ifdef SHOW_ALLOC_COUNT
+        Py_AtExit(show_alloc);
+#endif
+#ifdef SHOW_TRACK_COUNT
+        Py_AtExit(show_track);
+#endif
+    }
+    DK_INCREF(Py_EMPTY_KEYS);
+    return new_dict(Py_EMPTY_KEYS, empty_values);
+}
+
 /*
 The basic lookup function used by all operations.
 This is based on Algorithm D from Knuth Vol. 3, Sec. 6.4.
@@ -307,45 +549,73 @@ All arithmetic on hash should ignore overflow.
 contributions by Reimer Behrends, Jyrki Alakuijala, Vladimir Marangozov and
 Christian Tismer).
 
-lookdict() is general-purpose, and may return NULL if (and only if) a
+lookdict() is general-purpose, and may return DKIX_ERROR if (and only if) a
 comparison raises an exception (this was new in Python 2.5).
 lookdict_string() below is specialized to string keys, comparison of which can
-never raise an exception; that function can never return NULL.  For both, when
-the key isn't found a PyDictEntry* is returned for which the me_value field is
-NULL; this is the slot in the dict at which the key would have been found, and
-the caller can (if it wishes) add the <key, value> pair to the returned
-PyDictEntry*.
+never raise an exception; that function can never return DKIX_ERROR.  All of
+them return the index of the entry of the key, or DKIX_EMPTY if the key isn't
+found.
+*value_addr is set to the address of the value of the key:  &ep->me_value for
+a combined table, the matching element of ma_values for a split one, where
+the value may be NULL.  It is set to NULL if the key isn't found.
+If hashpos is not NULL, *hashpos is set to the position of the key in the
+hash table, or, when the key isn't found, to the position at which it would
+be inserted.
 */
-static PyDictEntry *
-lookdict(PyDictObject *mp, PyObject *key, register long hash)
+static Py_ssize_t
+lookdict(PyDictObject *mp, PyObject *key, register long hash,
+         PyObject ***value_addr, Py_ssize_t *hashpos)
 {
     register size_t i;
     register size_t perturb;
-    register PyDictEntry *freeslot;
-    register size_t mask = (size_t)mp->ma_mask;
-    PyDictEntry *ep0 = mp->ma_table;
+    register Py_ssize_t ix;
+    Py_ssize_t freeslot;
+    size_t mask;
+    PyDictKeysObject *dk;
+    PyDictEntry *ep0;
     register PyDictEntry *ep;
     register int cmp;
     PyObject *startkey;
 
+top:
+    dk = mp->ma_keys;
+    mask = (size_t)DK_MASK(dk);
+    ep0 = DK_ENTRIES(dk);
     i = (size_t)hash & mask;
-    ep = &ep0[i];
-    if (ep->me_key == NULL || ep->me_key == key)
-        return ep;
-
-    if (ep->me_key == dummy)
-        freeslot = ep;
+    ix = dk_get_index(dk, i);
+    if (ix == DKIX_EMPTY) {
+        if (hashpos != NULL)
+            *hashpos = i;
+        *value_addr = NULL;
+        return DKIX_EMPTY;
+    }
+    if (ix == DKIX_DUMMY)
+        freeslot = i;
     else {
+        ep = &ep0[ix];
+        assert(ep->me_key != NULL);
+        if (ep->me_key == key) {
+            if (hashpos != NULL)
+                *hashpos = i;
+            *value_addr = &ep->me_value;
+            return ix;
+        }
         if (ep->me_hash == hash) {
             startkey = ep->me_key;
             Py_INCREF(startkey);
             cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
             Py_DECREF(startkey);
-            if (cmp < 0)
-                return NULL;
-            if (ep0 == mp->ma_table && ep->me_key == startkey) {
-                if (cmp > 0)
-                    return ep;
+            if (cmp < 0) {
+                *value_addr = NULL;
+                return DKIX_ERROR;
+            }
+            if (dk == mp->ma_keys && ep->me_key == startkey) {
+                if (cmp > 0) {
+                    if (hashpos != NULL)
+                        *hashpos = i;
+                    *value_addr = &ep->me_value;
+                    return ix;
+                }
             }
             else {
                 /* The compare did major nasty stuff to the
@@ -353,31 +623,52 @@ lookdict(PyDictObject *mp, PyObject *key, register long hash)
                  * XXX A clever adversary could prevent this
                  * XXX from terminating.
                  */
-                return lookdict(mp, key, hash);
+                goto top;
             }
         }
-        freeslot = NULL;
+        freeslot = -1;
     }
 
-    /* In the loop, me_key == dummy is by far (factor of 100s) the
+    /* In the loop, DKIX_DUMMY is by far (factor of 100s) the
        least likely outcome, so test for that last. */
     for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
         i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
-        if (ep->me_key == NULL)
-            return freeslot == NULL ? ep : freeslot;
-        if (ep->me_key == key)
-            return ep;
-        if (ep->me_hash == hash && ep->me_key != dummy) {
+        ix = dk_get_index(dk, i & mask);
+        if (ix == DKIX_EMPTY) {
+            if (hashpos != NULL)
+                *hashpos = freeslot == -1 ? (Py_ssize_t)(i & mask) : freeslot;
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        if (ix == DKIX_DUMMY) {
+            if (freeslot == -1)
+                freeslot = i & mask;
+            continue;
+        }
+        ep = &ep0[ix];
+        assert(ep->me_key != NULL);
+        if (ep->me_key == key) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = &ep->me_value;
+            return ix;
+        }
+        if (ep->me_hash == hash) {
             startkey = ep->me_key;
             Py_INCREF(startkey);
             cmp = PyObject_RichCompareBool(startkey, key, Py_EQ);
             Py_DECREF(startkey);
-            if (cmp < 0)
-                return NULL;
-            if (ep0 == mp->ma_table && ep->me_key == startkey) {
-                if (cmp > 0)
-                    return ep;
+            if (cmp < 0) {
+                *value_addr = NULL;
+                return DKIX_ERROR;
+            }
+            if (dk == mp->ma_keys && ep->me_key == startkey) {
+                if (cmp > 0) {
+                    if (hashpos != NULL)
+                        *hashpos = i & mask;
+                    *value_addr = &ep->me_value;
+                    return ix;
+                }
             }
             else {
                 /* The compare did major nasty stuff to the
@@ -385,11 +676,9 @@ lookdict(PyDictObject *mp, PyObject *key, register long hash)
                  * XXX A clever adversary could prevent this
                  * XXX from terminating.
                  */
-                return lookdict(mp, key, hash);
+                goto top;
             }
         }
-        else if (ep->me_key == dummy && freeslot == NULL)
-            freeslot = ep;
     }
     assert(0);          /* NOT REACHED */
     return 0;
@@ -404,14 +693,17 @@ lookdict(PyDictObject *mp, PyObject *key, register long hash)
  *
  * This is valuable because dicts with only string keys are very common.
  */
-static PyDictEntry *
-lookdict_string(PyDictObject *mp, PyObject *key, register long hash)
+static Py_ssize_t
+lookdict_string(PyDictObject *mp, PyObject *key, register long hash,
+                PyObject ***value_addr, Py_ssize_t *hashpos)
 {
     register size_t i;
     register size_t perturb;
-    register PyDictEntry *freeslot;
-    register size_t mask = (size_t)mp->ma_mask;
-    PyDictEntry *ep0 = mp->ma_table;
+    register Py_ssize_t ix;
+    Py_ssize_t freeslot;
+    PyDictKeysObject *dk = mp->ma_keys;
+    register size_t mask = (size_t)DK_MASK(dk);
+    PyDictEntry *ep0 = DK_ENTRIES(dk);
     register PyDictEntry *ep;
 
     /* Make sure this function doesn't have to handle non-string keys,
@@ -422,35 +714,152 @@ lookdict_string(PyDictObject *mp, PyObject *key, register long hash)
 #ifdef SHOW_CONVERSION_COUNTS
         ++converted;
 #endif
-        mp->ma_lookup = lookdict;
-        return lookdict(mp, key, hash);
+        dk->dk_lookup = lookdict;
+        return lookdict(mp, key, hash, value_addr, hashpos);
     }
     i = hash & mask;
-    ep = &ep0[i];
-    if (ep->me_key == NULL || ep->me_key == key)
-        return ep;
-    if (ep->me_key == dummy)
-        freeslot = ep;
+    ix = dk_get_index(dk, i);
+    if (ix == DKIX_EMPTY) {
+        if (hashpos != NULL)
+            *hashpos = i;
+        *value_addr = NULL;
+        return DKIX_EMPTY;
+    }
+    if (ix == DKIX_DUMMY)
+        freeslot = i;
     else {
-        if (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))
-            return ep;
-        freeslot = NULL;
+        ep = &ep0[ix];
+        if (ep->me_key == key ||
+            (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))) {
+            if (hashpos != NULL)
+                *hashpos = i;
+            *value_addr = &ep->me_value;
+            return ix;
+        }
+        freeslot = -1;
     }
 
-    /* In the loop, me_key == dummy is by far (factor of 100s) the
+    /* In the loop, DKIX_DUMMY is by far (factor of 100s) the
        least likely outcome, so test for that last. */
     for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
         i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
-        if (ep->me_key == NULL)
-            return freeslot == NULL ? ep : freeslot;
-        if (ep->me_key == key
-            || (ep->me_hash == hash
-            && ep->me_key != dummy
-            && _PyString_Eq(ep->me_key, key)))
-            return ep;
-        if (ep->me_key == dummy && freeslot == NULL)
-            freeslot = ep;
+        ix = dk_get_index(dk, i & mask);
+        if (ix == DKIX_EMPTY) {
+            if (hashpos != NULL)
+                *hashpos = freeslot == -1 ? (Py_ssize_t)(i & mask) : freeslot;
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        if (ix == DKIX_DUMMY) {
+            if (freeslot == -1)
+                freeslot = i & mask;
+            continue;
+        }
+        ep = &ep0[ix];
+        if (ep->me_key == key ||
+            (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = &ep->me_value;
+            return ix;
+        }
+    }
+    assert(0);          /* NOT REACHED */
+    return 0;
+}
+
+/* Faster version of lookdict_string() for tables that never had a key
+ * deleted, so contain no dummies.  Most dicts are like that.
+ */
+static Py_ssize_t
+lookdict_string_nodummy(PyDictObject *mp, PyObject *key, register long hash,
+                        PyObject ***value_addr, Py_ssize_t *hashpos)
+{
+    register size_t i;
+    register size_t perturb;
+    register Py_ssize_t ix;
+    PyDictKeysObject *dk = mp->ma_keys;
+    register size_t mask = (size_t)DK_MASK(dk);
+    PyDictEntry *ep0 = DK_ENTRIES(dk);
+    register PyDictEntry *ep;
+
+    if (!PyString_CheckExact(key)) {
+#ifdef SHOW_CONVERSION_COUNTS
+        ++converted;
+#endif
+        dk->dk_lookup = lookdict;
+        return lookdict(mp, key, hash, value_addr, hashpos);
+    }
+    i = hash & mask;
+    for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
+        ix = dk_get_index(dk, i & mask);
+        assert(ix != DKIX_DUMMY);
+        if (ix == DKIX_EMPTY) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        ep = &ep0[ix];
+        assert(PyString_CheckExact(ep->me_key));
+        if (ep->me_key == key ||
+            (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = &ep->me_value;
+            return ix;
+        }
+        i = (i << 2) + i + perturb + 1;
+    }
+    assert(0);          /* NOT REACHED */
+    return 0;
+}
+
+/* Version of lookdict_string_nodummy() for split tables.  All split
+ * tables and only split tables use this lookup function; a non-string
+ * key is looked up with lookdict(), but the table is left alone, as it
+ * is shared.  Inserting such a key makes the dict combined first.
+ */
+static Py_ssize_t
+lookdict_split(PyDictObject *mp, PyObject *key, register long hash,
+               PyObject ***value_addr, Py_ssize_t *hashpos)
+{
+    register size_t i;
+    register size_t perturb;
+    register Py_ssize_t ix;
+    PyDictKeysObject *dk = mp->ma_keys;
+    register size_t mask = (size_t)DK_MASK(dk);
+    PyDictEntry *ep0 = DK_ENTRIES(dk);
+    register PyDictEntry *ep;
+
+    if (!PyString_CheckExact(key)) {
+        ix = lookdict(mp, key, hash, value_addr, hashpos);
+        /* lookdict() assumed a combined table; point value_addr into
+           ma_values unless a comparison made the dict combined */
+        if (ix >= 0 && mp->ma_values != NULL)
+            *value_addr = &mp->ma_values[ix];
+        return ix;
+    }
+    i = hash & mask;
+    for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
+        ix = dk_get_index(dk, i & mask);
+        assert(ix != DKIX_DUMMY);
+        if (ix == DKIX_EMPTY) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = NULL;
+            return DKIX_EMPTY;
+        }
+        ep = &ep0[ix];
+        assert(PyString_CheckExact(ep->me_key));
+        if (ep->me_key == key ||
+            (ep->me_hash == hash && _PyString_Eq(ep->me_key, key))) {
+            if (hashpos != NULL)
+                *hashpos = i & mask;
+            *value_addr = &mp->ma_values[ix];
+            return ix;
+        }
+        i = (i << 2) + i + perturb + 1;
     }
     assert(0);          /* NOT REACHED */
     return 0;
@@ -482,30 +891,74 @@ _PyDict_MaybeUntrack(PyObject *op)
 {
     PyDictObject *mp;
     PyObject *value;
-    Py_ssize_t mask, i;
+    Py_ssize_t i, n;
     PyDictEntry *ep;
 
     if (!PyDict_CheckExact(op) || !_PyObject_GC_IS_TRACKED(op))
         return;
 
     mp = (PyDictObject *) op;
-    ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0; i <= mask; i++) {
-        if ((value = ep[i].me_value) == NULL)
-            continue;
-        if (_PyObject_GC_MAY_BE_TRACKED(value) ||
-            _PyObject_GC_MAY_BE_TRACKED(ep[i].me_key))
-            return;
+    ep = DK_ENTRIES(mp->ma_keys);
+    n = mp->ma_keys->dk_nentries;
+    if (mp->ma_values != NULL) {
+        /* the keys of a split table are strings */
+        for (i = 0; i < n; i++) {
+            if ((value = mp->ma_values[i]) == NULL)
+                continue;
+            if (_PyObject_GC_MAY_BE_TRACKED(value))
+                return;
+        }
+    }
+    else {
+        for (i = 0; i < n; i++) {
+            if ((value = ep[i].me_value) == NULL)
+                continue;
+            if (_PyObject_GC_MAY_BE_TRACKED(value) ||
+                _PyObject_GC_MAY_BE_TRACKED(ep[i].me_key))
+                return;
+        }
     }
     DECREASE_TRACK_COUNT
     _PyObject_GC_UNTRACK(op);
 }
 
+/* Grow the table to make room for a new key.  Normally, this doubles or
+ * quadruples the size, but it's also possible for the dict to shrink
+ * (if there are many dummies, meaning a lot of dict keys have been
+ * deleted).
+ *
+ * Quadrupling the size improves average dictionary sparseness
+ * (reducing collisions) at the cost of some memory.  It also halves
+ * the number of expensive resize operations in a growing dictionary.
+ *
+ * Very large dictionaries (over 50K items) use doubling instead.
+ * This may help applications with severe memory constraints.
+ */
+static int
+insertion_resize(PyDictObject *mp)
+{
+    return dictresize(mp, (mp->ma_used > 50000 ? 2 : 4) * mp->ma_used);
+}
+
+/* Find the position in the hash table for a key known to be absent from
+   a table without dummies, as after dictresize() */
+static Py_ssize_t
+find_empty_slot(PyDictKeysObject *keys, long hash)
+{
+    register size_t i;
+    register size_t perturb;
+    register size_t mask = (size_t)DK_MASK(keys);
+
+    i = hash & mask;
+    for (perturb = hash; dk_get_index(keys, i & mask) != DKIX_EMPTY;
+         perturb >>= PERTURB_SHIFT)
+        i = (i << 2) + i + perturb + 1;
+    return i & mask;
+}
 
 /*
 Internal routine to insert a new item into the table.
-Used both by the internal resize routine and by the public insert routine.
+Used by the public insert routines and merges.
 Eats a reference to key and one to value.
 Returns -1 if an error occurred, or 0 on success.
 */
@@ -513,84 +966,109 @@ static int
 insertdict(register PyDictObject *mp, PyObject *key, long hash, PyObject *value)
 {
     PyObject *old_value;
-    register PyDictEntry *ep;
-    typedef PyDictEntry *(*lookupfunc)(PyDictObject *, PyObject *, long);
+    PyObject **value_addr;
+    PyDictKeysObject *keys;
+    PyDictEntry *ep;
+    Py_ssize_t ix, hashpos;
 
-    assert(mp->ma_lookup != NULL);
-    ep = mp->ma_lookup(mp, key, hash);
-    if (ep == NULL) {
-        Py_DECREF(key);
-        Py_DECREF(value);
-        return -1;
+    /* A shared table takes string keys only */
+    if (mp->ma_values != NULL && !PyString_CheckExact(key)) {
+        if (insertion_resize(mp) < 0)
+            goto Fail;
     }
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, &hashpos);
+    if (ix == DKIX_ERROR)
+        goto Fail;
     MAINTAIN_TRACKING(mp, key, value);
-    if (ep->me_value != NULL) {
-        old_value = ep->me_value;
-        ep->me_value = value;
-        Py_DECREF(old_value); /* which **CAN** re-enter */
-        Py_DECREF(key);
-    }
-    else {
-        if (ep->me_key == NULL)
-            mp->ma_fill++;
-        else {
-            assert(ep->me_key == dummy);
-            Py_DECREF(dummy);
+    DICT_MODIFIED(mp);
+
+    /* The values of a split dict fill the entries of the shared table
+       from the start; a key set in another order makes it combined */
+    if (mp->ma_values != NULL &&
+        ((ix >= 0 && *value_addr == NULL && ix != mp->ma_used) ||
+         (ix == DKIX_EMPTY && mp->ma_keys->dk_nentries != mp->ma_used))) {
+        if (insertion_resize(mp) < 0)
+            goto Fail;
+        hashpos = find_empty_slot(mp->ma_keys, hash);
+        ix = DKIX_EMPTY;
+    }
+    if (ix == DKIX_EMPTY) {
+        /* A new key */
+        if (mp->ma_keys->dk_usable <= 0) {
+            /* Need to resize. */
+            if (insertion_resize(mp) < 0)
+                goto Fail;
+            hashpos = find_empty_slot(mp->ma_keys, hash);
         }
+        keys = mp->ma_keys;
+        ix = keys->dk_nentries;
+        ep = &DK_ENTRIES(keys)[ix];
+        dk_set_index(keys, hashpos, ix);
         ep->me_key = key;
         ep->me_hash = (Py_ssize_t)hash;
-        ep->me_value = value;
+        if (mp->ma_values != NULL) {
+            assert(mp->ma_values[ix] == NULL);
+            mp->ma_values[ix] = value;
+        }
+        else
+            ep->me_value = value;
+        keys->dk_usable--;
+        keys->dk_nentries++;
+        assert(keys->dk_usable >= 0);
         mp->ma_used++;
+        return 0;
     }
+    old_value = *value_addr;
+    if (old_value != NULL) {
+        *value_addr = value;
+        Py_DECREF(old_value); /* which **CAN** re-enter */
+        Py_DECREF(key);
+        return 0;
+    }
+    /* The next key of the shared table, which this dict has no value
+       for yet */
+    assert(mp->ma_values != NULL && ix == mp->ma_used);
+    *value_addr = value;
+    mp->ma_used++;
+    Py_DECREF(key);
     return 0;
+
+Fail:
+    Py_DECREF(key);
+    Py_DECREF(value);
+    return -1;
 }
 
 /*
-Internal routine used by dictresize() to insert an item which is
-known to be absent from the dict.  This routine also assumes that
-the dict contains no deleted entries.  Besides the performance benefit,
-using insertdict() in dictresize() is dangerous (SF bug #1456209).
-Note that no refcounts are changed by this routine; if needed, the caller
-is responsible for incref'ing `key` and `value`.
+Internal routine used by dictresize() to fill the hash table of a table
+whose first n entries are active, as in a freshly rebuilt table.  Using
+insertdict() in dictresize() is dangerous (SF bug #1456209).
 */
 static void
-insertdict_clean(register PyDictObject *mp, PyObject *key, long hash,
-                 PyObject *value)
+build_indices(PyDictKeysObject *keys, PyDictEntry *ep, Py_ssize_t n)
 {
-    register size_t i;
-    register size_t perturb;
-    register size_t mask = (size_t)mp->ma_mask;
-    PyDictEntry *ep0 = mp->ma_table;
-    register PyDictEntry *ep;
+    Py_ssize_t ix;
 
-    MAINTAIN_TRACKING(mp, key, value);
-    i = hash & mask;
-    ep = &ep0[i];
-    for (perturb = hash; ep->me_key != NULL; perturb >>= PERTURB_SHIFT) {
-        i = (i << 2) + i + perturb + 1;
-        ep = &ep0[i & mask];
-    }
-    assert(ep->me_value == NULL);
-    mp->ma_fill++;
-    ep->me_key = key;
-    ep->me_hash = (Py_ssize_t)hash;
-    ep->me_value = value;
-    mp->ma_used++;
+    for (ix = 0; ix != n; ix++, ep++)
+        dk_set_index(keys, find_empty_slot(keys, (long)ep->me_hash), ix);
 }
 
 /*
 Restructure the table by allocating a new table and reinserting all
-items again.  When entries have been deleted, the new table may
-actually be smaller than the old one.
+items again, in order.  When entries have been deleted, the new table
+may actually be smaller than the old one.
+The result is always a combined table.  The values of a split dict are
+copied into the new table, which gets its own references to the keys;
+the shared table itself is left alone.
 */
 static int
 dictresize(PyDictObject *mp, Py_ssize_t minused)
 {
-    Py_ssize_t newsize;
-    PyDictEntry *oldtable, *newtable, *ep;
-    Py_ssize_t i;
-    int is_oldtable_malloced;
-    PyDictEntry small_copy[PyDict_MINSIZE];
+    Py_ssize_t newsize, numentries;
+    PyDictKeysObject *oldkeys;
+    PyObject **oldvalues;
+    PyDictEntry *oldentries, *newentries;
+    Py_ssize_t i, j, n;
 
     assert(minused >= 0);
 
@@ -605,65 +1083,99 @@ dictresize(PyDictObject *mp, Py_ssize_t minused)
     }
 
     /* Get space for a new table. */
-    oldtable = mp->ma_table;
-    assert(oldtable != NULL);
-    is_oldtable_malloced = oldtable != mp->ma_smalltable;
-
-    if (newsize == PyDict_MINSIZE) {
-        /* A large table is shrinking, or we can't get any smaller. */
-        newtable = mp->ma_smalltable;
-        if (newtable == oldtable) {
-            if (mp->ma_fill == mp->ma_used) {
-                /* No dummies, so no point doing anything. */
-                return 0;
+    oldkeys = mp->ma_keys;
+    oldvalues = mp->ma_values;
+    mp->ma_keys = new_keys_object(newsize);
+    if (mp->ma_keys == NULL) {
+        mp->ma_keys = oldkeys;
+        return -1;
+    }
+    assert(mp->ma_keys->dk_usable >= mp->ma_used);
+    if (oldkeys->dk_lookup == lookdict)
+        mp->ma_keys->dk_lookup = lookdict;
+    mp->ma_values = NULL;
+    numentries = mp->ma_used;
+    oldentries = DK_ENTRIES(oldkeys);
+    newentries = DK_ENTRIES(mp->ma_keys);
+    n = oldkeys->dk_nentries;
+
+    if (oldvalues != NULL) {
+        /* Copy the values over; the new table needs references to
+           the keys, which stay in the shared table as well */
+        for (i = j = 0; i < n; i++) {
+            if (oldvalues[i] != NULL) {
+                Py_INCREF(oldentries[i].me_key);
+                newentries[j].me_key = oldentries[i].me_key;
+                newentries[j].me_hash = oldentries[i].me_hash;
+                newentries[j].me_value = oldvalues[i];
+                j++;
             }
-            /* We're not going to resize it, but rebuild the
-               table anyway to purge old dummy entries.
-               Subtle:  This is *necessary* if fill==size,
-               as lookdict needs at least one virgin slot to
-               terminate failing searches.  If fill < size, it's
-               merely desirable, as dummies slow searches. */
-            assert(mp->ma_fill > mp->ma_used);
-            memcpy(small_copy, oldtable, sizeof(small_copy));
-            oldtable = small_copy;
         }
+        assert(j == numentries);
+        if (oldvalues != empty_values)
+            free_values(oldvalues);
+        DK_DECREF(oldkeys);
     }
     else {
-        newtable = PyMem_NEW(PyDictEntry, newsize);
-        if (newtable == NULL) {
-            PyErr_NoMemory();
-            return -1;
+        /* Move the active entries over, closing the gaps left by
+           deleted ones; this is refcount-neutral */
+        assert(oldkeys->dk_refcnt == 1);
+        if (n == numentries)
+            memcpy(newentries, oldentries, numentries * sizeof(PyDictEntry));
+        else {
+            for (i = j = 0; i < n; i++) {
+                if (oldentries[i].me_value != NULL)
+                    newentries[j++] = oldentries[i];
+            }
+            assert(j == numentries);
         }
+        free_keys_memory(oldkeys);
     }
+    build_indices(mp->ma_keys, newentries, numentries);
+    mp->ma_keys->dk_usable -= numentries;
+    mp->ma_keys->dk_nentries = numentries;
+    return 0;
+}
 
-    /* Make the dict empty, using the new table. */
-    assert(newtable != oldtable);
-    mp->ma_table = newtable;
-    mp->ma_mask = newsize - 1;
-    memset(newtable, 0, sizeof(PyDictEntry) * newsize);
-    mp->ma_used = 0;
-    i = mp->ma_fill;
-    mp->ma_fill = 0;
-
-    /* Copy the data over; this is refcount-neutral for active entries;
-       dummy entries aren't copied over, of course */
-    for (ep = oldtable; i > 0; ep++) {
-        if (ep->me_value != NULL) {             /* active entry */
-            --i;
-            insertdict_clean(mp, ep->me_key, (long)ep->me_hash,
-                             ep->me_value);
+/* Make the table of mp a split table, so other dicts can share it, and
+   return it with a new reference.  The table is rebuilt tightly around
+   the current keys, leaving a few usable entries for more attributes.
+   Returns NULL if the table cannot be shared (non-string keys), with an
+   exception set only if an error occurred. */
+static PyDictKeysObject *
+make_keys_shared(PyDictObject *mp)
+{
+    Py_ssize_t i, size, n;
+    PyDictEntry *ep0;
+    PyObject **values;
+
+    if (!PyDict_CheckExact(mp) || mp->ma_used == 0)
+        return NULL;
+    if (mp->ma_values == NULL) {
+        if (mp->ma_keys->dk_lookup == lookdict)
+            return NULL;
+        if (dictresize(mp, ESTIMATE_SIZE(mp->ma_used)) < 0)
+            return NULL;
+        assert(mp->ma_keys->dk_lookup == lookdict_string_nodummy);
+        size = USABLE_FRACTION(DK_SIZE(mp->ma_keys));
+        values = new_values(size);
+        if (values == NULL) {
+            PyErr_NoMemory();
+            return NULL;
         }
-        else if (ep->me_key != NULL) {          /* dummy entry */
-            --i;
-            assert(ep->me_key == dummy);
-            Py_DECREF(ep->me_key);
+        ep0 = DK_ENTRIES(mp->ma_keys);
+        n = mp->ma_keys->dk_nentries;
+        for (i = 0; i < n; i++) {
+            values[i] = ep0[i].me_value;
+            ep0[i].me_value = NULL;
         }
-        /* else key == value == NULL:  nothing to do */
+        for (; i < size; i++)
+            values[i] = NULL;
+        mp->ma_keys->dk_lookup = lookdict_split;
+        mp->ma_values = values;
     }
-
-    if (is_oldtable_malloced)
-        PyMem_DEL(oldtable);
-    return 0;
+    DK_INCREF(mp->ma_keys);
+    return mp->ma_keys;
 }
 
 /* Create a new dictionary pre-sized to hold an estimated number of elements.
@@ -676,13 +1188,85 @@ _PyDict_NewPresized(Py_ssize_t minused)
 {
     PyObject *op = PyDict_New();
 
-    if (minused>5 && op != NULL && dictresize((PyDictObject *)op, minused) == -1) {
+    if (minused>5 && op != NULL &&
+        dictresize((PyDictObject *)op, ESTIMATE_SIZE(minused)) == -1) {
         Py_DECREF(op);
         return NULL;
     }
     return op;
 }
 
+PyDictKeysObject *
+_PyDict_NewKeysForClass(void)
+{
+    PyDictKeysObject *keys = new_keys_object(PyDict_MINSIZE);
+    if (keys == NULL)
+        PyErr_Clear();
+    else
+        keys->dk_lookup = lookdict_split;
+    return keys;
+}
+
+void
+_PyDictKeys_DecRef(PyDictKeysObject *keys)
+{
+    DK_DECREF(keys);
+}
+
+/* Create the __dict__ of an instance, sharing the table of its class
+   if there is one */
+PyObject *
+_PyObjectDict_New(PyDictKeysObject **cachedp)
+{
+    if (cachedp == NULL || *cachedp == NULL)
+        return PyDict_New();
+    DK_INCREF(*cachedp);
+    return new_dict_with_shared_keys(*cachedp);
+}
+
+/* Set (value != NULL) or delete (value == NULL) an item of the __dict__
+   of an instance, creating the dict as needed.  If the dict had to stop
+   sharing the table of its class, the class either shares the new table
+   of this dict instead, when no other dict uses the old one, or gives
+   up sharing. */
+int
+_PyObjectDict_SetItem(PyDictKeysObject **cachedp, PyObject **dictptr,
+                      PyObject *key, PyObject *value)
+{
+    PyObject *dict = *dictptr;
+    PyDictKeysObject *cached = cachedp != NULL ? *cachedp : NULL;
+    int res, was_shared;
+
+    if (dict == NULL) {
+        assert(value != NULL);
+        dict = _PyObjectDict_New(cachedp);
+        if (dict == NULL)
+            return -1;
+        *dictptr = dict;
+    }
+    Py_INCREF(dict);
+    was_shared = cached != NULL &&
+                 ((PyDictObject *)dict)->ma_keys == cached;
+    if (value == NULL)
+        res = PyDict_DelItem(dict, key);
+    else
+        res = PyDict_SetItem(dict, key, value);
+    if (was_shared && *cachedp == cached &&
+        ((PyDictObject *)dict)->ma_keys != cached) {
+        if (cached->dk_refcnt == 1) {
+            *cachedp = make_keys_shared((PyDictObject *)dict);
+            /* sharing is only an optimization */
+            if (*cachedp == NULL && res == 0)
+                PyErr_Clear();
+        }
+        else
+            *cachedp = NULL;
+        DK_DECREF(cached);
+    }
+    Py_DECREF(dict);
+    return res;
+}
+
 /* Note that, for historical reasons, PyDict_GetItem() suppresses all errors
  * that may occur (originally dicts supported only string keys, and exceptions
  * weren't possible).  So, while the original intent was that a NULL return
@@ -698,8 +1282,9 @@ PyDict_GetItem(PyObject *op, PyObject *key)
 {
     long hash;
     PyDictObject *mp = (PyDictObject *)op;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
     PyThreadState *tstate;
+    PyObject **value_addr;
     if (!PyDict_Check(op))
         return NULL;
     if (!PyString_CheckExact(key) ||
@@ -722,20 +1307,53 @@ PyDict_GetItem(PyObject *op, PyObject *key)
         /* preserve the existing exception */
         PyObject *err_type, *err_value, *err_tb;
         PyErr_Fetch(&err_type, &err_value, &err_tb);
-        ep = (mp->ma_lookup)(mp, key, hash);
+        ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
         /* ignore errors */
         PyErr_Restore(err_type, err_value, err_tb);
-        if (ep == NULL)
+        if (ix < 0)
             return NULL;
     }
     else {
-        ep = (mp->ma_lookup)(mp, key, hash);
-        if (ep == NULL) {
-            PyErr_Clear();
+        ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+        if (ix < 0) {
+            if (ix == DKIX_ERROR)
+                PyErr_Clear();
             return NULL;
         }
     }
-    return ep->me_value;
+    return *value_addr;
+}
+
+/* Fast path for LOAD_GLOBAL:  the key is looked up in globals, then in
+   builtins, without suppressing errors.  Both must be exact dicts. */
+PyObject *
+_PyDict_LoadGlobal(PyDictObject *globals, PyDictObject *builtins,
+                   PyObject *key)
+{
+    long hash;
+    Py_ssize_t ix;
+    PyObject **value_addr;
+
+    if (!PyString_CheckExact(key) ||
+        (hash = ((PyStringObject *) key)->ob_shash) == -1)
+    {
+        hash = PyObject_Hash(key);
+        if (hash == -1)
+            return NULL;
+    }
+
+    /* namespace 1: globals */
+    ix = globals->ma_keys->dk_lookup(globals, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
+        return NULL;
+    if (ix >= 0 && *value_addr != NULL)
+        return *value_addr;
+
+    /* namespace 2: builtins */
+    ix = builtins->ma_keys->dk_lookup(builtins, key, hash, &value_addr, NULL);
+    if (ix < 0)
+        return NULL;
+    return *value_addr;
 }
 
 /* CAUTION: PyDict_SetItem() must guarantee that it won't resize the
@@ -747,9 +1365,7 @@ PyDict_GetItem(PyObject *op, PyObject *key)
 int
 PyDict_SetItem(register PyObject *op, PyObject *key, PyObject *value)
 {
-    register PyDictObject *mp;
     register long hash;
-    register Py_ssize_t n_used;
 
     if (!PyDict_Check(op)) {
         PyErr_BadInternalCall();
@@ -757,7 +1373,6 @@ PyDict_SetItem(register PyObject *op, PyObject *key, PyObject *value)
     }
     assert(key);
     assert(value);
-    mp = (PyDictObject *)op;
     if (PyString_CheckExact(key)) {
         hash = ((PyStringObject *)key)->ob_shash;
         if (hash == -1)
@@ -768,29 +1383,75 @@ PyDict_SetItem(register PyObject *op, PyObject *key, PyObject *value)
         if (hash == -1)
             return -1;
     }
-    assert(mp->ma_fill <= mp->ma_mask);  /* at least one empty slot */
-    n_used = mp->ma_used;
     Py_INCREF(value);
     Py_INCREF(key);
-    if (insertdict(mp, key, hash, value) != 0)
-        return -1;
-    /* If we added a key, we can safely resize.  Otherwise just return!
-     * If fill >= 2/3 size, adjust size.  Normally, this doubles or
-     * quaduples the size, but it's also possible for the dict to shrink
-     * (if ma_fill is much larger than ma_used, meaning a lot of dict
-     * keys have been * deleted).
-     *
-     * Quadrupling the size improves average dictionary sparseness
-     * (reducing collisions) at the cost of some memory and iteration
-     * speed (which loops over every possible entry).  It also halves
-     * the number of expensive resize operations in a growing dictionary.
-     *
-     * Very large dictionaries (over 50K items) use doubling instead.
-     * This may help applications with severe memory constraints.
-     */
-    if (!(mp->ma_used > n_used && mp->ma_fill*3 >= (mp->ma_mask+1)*2))
-        return 0;
-    return dictresize(mp, (mp->ma_used > 50000 ? 2 : 4) * mp->ma_used);
+    /* insertdict() handles any resizing that might be necessary */
+    return insertdict((PyDictObject *)op, key, hash, value);
+}
+
+/* Find the position in the hash table that holds entry index */
+static Py_ssize_t
+lookdict_index(PyDictKeysObject *keys, long hash, Py_ssize_t index)
+{
+    register size_t i;
+    register size_t perturb;
+    register size_t mask = (size_t)DK_MASK(keys);
+    Py_ssize_t ix;
+
+    i = hash & mask;
+    for (perturb = hash; ; perturb >>= PERTURB_SHIFT) {
+        ix = dk_get_index(keys, i & mask);
+        if (ix == index)
+            return i & mask;
+        if (ix == DKIX_EMPTY)
+            return DKIX_EMPTY;
+        i = (i << 2) + i + perturb + 1;
+    }
+    assert(0);          /* NOT REACHED */
+    return 0;
+}
+
+/* A split table never contains dummies, so a split dict is made
+   combined before deleting from it.  Returns the entry index of key in
+   the new table and sets *hashpos, or returns DKIX_ERROR. */
+static Py_ssize_t
+combine_for_deletion(PyDictObject *mp, PyObject *key, long hash,
+                     Py_ssize_t *hashpos)
+{
+    PyObject **value_addr;
+    Py_ssize_t ix;
+
+    if (dictresize(mp, ESTIMATE_SIZE(mp->ma_used)) < 0)
+        return DKIX_ERROR;
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, hashpos);
+    if (ix == DKIX_EMPTY) {
+        /* a comparison removed the key */
+        set_key_error(key);
+        return DKIX_ERROR;
+    }
+    return ix;
+}
+
+/* Remove entry ix, found at position hashpos of the hash table, from a
+   combined dict and return its value, which the caller now owns */
+static PyObject *
+delitem_common(PyDictObject *mp, Py_ssize_t hashpos, Py_ssize_t ix)
+{
+    PyDictEntry *ep;
+    PyObject *old_key, *old_value;
+
+    assert(mp->ma_values == NULL);
+    ENSURE_ALLOWS_DELETIONS(mp);
+    mp->ma_used--;
+    DICT_MODIFIED(mp);
+    dk_set_index(mp->ma_keys, hashpos, DKIX_DUMMY);
+    ep = &DK_ENTRIES(mp->ma_keys)[ix];
+    old_key = ep->me_key;
+    old_value = ep->me_value;
+    ep->me_key = NULL;
+    ep->me_value = NULL;
+    Py_DECREF(old_key);
+    return old_value;
 }
 
 int
@@ -798,8 +1459,9 @@ PyDict_DelItem(PyObject *op, PyObject *key)
 {
     register PyDictObject *mp;
     register long hash;
-    register PyDictEntry *ep;
-    PyObject *old_value, *old_key;
+    Py_ssize_t ix, hashpos;
+    PyObject *old_value;
+    PyObject **value_addr;
 
     if (!PyDict_Check(op)) {
         PyErr_BadInternalCall();
@@ -813,21 +1475,20 @@ PyDict_DelItem(PyObject *op, PyObject *key)
             return -1;
     }
     mp = (PyDictObject *)op;
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, &hashpos);
+    if (ix == DKIX_ERROR)
         return -1;
-    if (ep->me_value == NULL) {
+    if (ix == DKIX_EMPTY || *value_addr == NULL) {
         set_key_error(key);
         return -1;
     }
-    old_key = ep->me_key;
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
-    old_value = ep->me_value;
-    ep->me_value = NULL;
-    mp->ma_used--;
+    if (mp->ma_values != NULL) {
+        ix = combine_for_deletion(mp, key, hash, &hashpos);
+        if (ix < 0)
+            return -1;
+    }
+    old_value = delitem_common(mp, hashpos, ix);
     Py_DECREF(old_value);
-    Py_DECREF(old_key);
     return 0;
 }
 
@@ -835,25 +1496,17 @@ void
 PyDict_Clear(PyObject *op)
 {
     PyDictObject *mp;
-    PyDictEntry *ep, *table;
-    int table_is_malloced;
-    Py_ssize_t fill;
-    PyDictEntry small_copy[PyDict_MINSIZE];
-#ifdef Py_DEBUG
+    PyDictKeysObject *oldkeys;
+    PyObject **oldvalues;
     Py_ssize_t i, n;
-#endif
 
     if (!PyDict_Check(op))
         return;
     mp = (PyDictObject *)op;
-#ifdef Py_DEBUG
-    n = mp->ma_mask + 1;
-    i = 0;
-#endif
-
-    table = mp->ma_table;
-    assert(table != NULL);
-    table_is_malloced = table != mp->ma_smalltable;
+    oldkeys = mp->ma_keys;
+    oldvalues = mp->ma_values;
+    if (oldvalues == empty_values)
+        return;
 
     /* This is delicate.  During the process of clearing the dict,
      * decrefs can cause the dict to mutate.  To avoid fatal confusion
@@ -861,43 +1514,58 @@ PyDict_Clear(PyObject *op)
      * clearing the slots, and never refer to anything via mp->xxx while
      * clearing.
      */
-    fill = mp->ma_fill;
-    if (table_is_malloced)
-        EMPTY_TO_MINSIZE(mp);
-
-    else if (fill > 0) {
-        /* It's a small table with something that needs to be cleared.
-         * Afraid the only safe way is to copy the dict entries into
-         * another small table first.
-         */
-        memcpy(small_copy, table, sizeof(small_copy));
-        table = small_copy;
-        EMPTY_TO_MINSIZE(mp);
-    }
-    /* else it's a small table that's already empty */
+    DK_INCREF(Py_EMPTY_KEYS);
+    mp->ma_keys = Py_EMPTY_KEYS;
+    mp->ma_values = empty_values;
+    mp->ma_used = 0;
+    DICT_MODIFIED(mp);
 
-    /* Now we can finally clear things.  If C had refcounts, we could
-     * assert that the refcount on table is 1 now, i.e. that this function
-     * has unique access to it, so decref side-effects can't alter it.
+    /* Now we can finally clear things.  The old table and values are
+     * only reachable from here, so decref side-effects can't alter them.
      */
-    for (ep = table; fill > 0; ++ep) {
-#ifdef Py_DEBUG
-        assert(i < n);
-        ++i;
-#endif
-        if (ep->me_key) {
-            --fill;
-            Py_DECREF(ep->me_key);
-            Py_XDECREF(ep->me_value);
-        }
-#ifdef Py_DEBUG
-        else
-            assert(ep->me_value == NULL);
-#endif
+    if (oldvalues != NULL) {
+        n = oldkeys->dk_nentries;
+        for (i = 0; i < n; i++)
+            Py_CLEAR(oldvalues[i]);
+        free_values(oldvalues);
+        DK_DECREF(oldkeys);
     }
+    else {
+        assert(oldkeys->dk_refcnt == 1);
+        DK_DECREF(oldkeys);
+    }
+}
+
+/* Return the index of the first active entry at or after i, or -1 if
+ * there is none.  *pvalue is set to its value if pvalue is not NULL.
+ */
+Py_LOCAL_INLINE(Py_ssize_t)
+dict_next(PyDictObject *mp, Py_ssize_t i, PyObject **pvalue)
+{
+    Py_ssize_t n;
 
-    if (table_is_malloced)
-        PyMem_DEL(table);
+    if (i < 0)
+        return -1;
+    n = mp->ma_keys->dk_nentries;
+    if (mp->ma_values != NULL) {
+        PyObject **values = mp->ma_values;
+        while (i < n && values[i] == NULL)
+            i++;
+        if (i >= n)
+            return -1;
+        if (pvalue)
+            *pvalue = values[i];
+    }
+    else {
+        PyDictEntry *ep = DK_ENTRIES(mp->ma_keys);
+        while (i < n && ep[i].me_value == NULL)
+            i++;
+        if (i >= n)
+            return -1;
+        if (pvalue)
+            *pvalue = ep[i].me_value;
+    }
+    return i;
 }
 
 /*
@@ -919,25 +1587,20 @@ int
 PyDict_Next(PyObject *op, Py_ssize_t *ppos, PyObject **pkey, PyObject **pvalue)
 {
     register Py_ssize_t i;
-    register Py_ssize_t mask;
-    register PyDictEntry *ep;
+    PyDictObject *mp;
 
     if (!PyDict_Check(op))
         return 0;
-    i = *ppos;
-    if (i < 0)
+    mp = (PyDictObject *)op;
+    i = dict_next(mp, *ppos, pvalue);
+    if (i < 0) {
+        if (*ppos >= 0)
+            *ppos = mp->ma_keys->dk_nentries + 1;
         return 0;
-    ep = ((PyDictObject *)op)->ma_table;
-    mask = ((PyDictObject *)op)->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
-        i++;
+    }
     *ppos = i+1;
-    if (i > mask)
-        return 0;
     if (pkey)
-        *pkey = ep[i].me_key;
-    if (pvalue)
-        *pvalue = ep[i].me_value;
+        *pkey = DK_ENTRIES(mp->ma_keys)[i].me_key;
     return 1;
 }
 
@@ -946,26 +1609,21 @@ int
 _PyDict_Next(PyObject *op, Py_ssize_t *ppos, PyObject **pkey, PyObject **pvalue, long *phash)
 {
     register Py_ssize_t i;
-    register Py_ssize_t mask;
-    register PyDictEntry *ep;
+    PyDictObject *mp;
 
     if (!PyDict_Check(op))
         return 0;
-    i = *ppos;
-    if (i < 0)
+    mp = (PyDictObject *)op;
+    i = dict_next(mp, *ppos, pvalue);
+    if (i < 0) {
+        if (*ppos >= 0)
+            *ppos = mp->ma_keys->dk_nentries + 1;
         return 0;
-    ep = ((PyDictObject *)op)->ma_table;
-    mask = ((PyDictObject *)op)->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
-        i++;
+    }
     *ppos = i+1;
-    if (i > mask)
-        return 0;
-    *phash = (long)(ep[i].me_hash);
+    *phash = (long)(DK_ENTRIES(mp->ma_keys)[i].me_hash);
     if (pkey)
-        *pkey = ep[i].me_key;
-    if (pvalue)
-        *pvalue = ep[i].me_value;
+        *pkey = DK_ENTRIES(mp->ma_keys)[i].me_key;
     return 1;
 }
 
@@ -974,19 +1632,23 @@ _PyDict_Next(PyObject *op, Py_ssize_t *ppos, PyObject **pkey, PyObject **pvalue,
 static void
 dict_dealloc(register PyDictObject *mp)
 {
-    register PyDictEntry *ep;
-    Py_ssize_t fill = mp->ma_fill;
+    PyObject **values = mp->ma_values;
+    PyDictKeysObject *keys = mp->ma_keys;
+    Py_ssize_t i, n;
     PyObject_GC_UnTrack(mp);
     Py_TRASHCAN_SAFE_BEGIN(mp)
-    for (ep = mp->ma_table; fill > 0; ep++) {
-        if (ep->me_key) {
-            --fill;
-            Py_DECREF(ep->me_key);
-            Py_XDECREF(ep->me_value);
+    if (values != NULL) {
+        if (values != empty_values) {
+            for (i = 0, n = keys->dk_nentries; i < n; i++)
+                Py_XDECREF(values[i]);
+            free_values(values);
         }
+        DK_DECREF(keys);
+    }
+    else {
+        assert(keys->dk_refcnt == 1);
+        DK_DECREF(keys);
     }
-    if (mp->ma_table != mp->ma_smalltable)
-        PyMem_DEL(mp->ma_table);
     if (numfree < PyDict_MAXFREELIST && Py_TYPE(mp) == &PyDict_Type)
         free_list[numfree++] = mp;
     else
@@ -1000,6 +1662,7 @@ dict_print(register PyDictObject *mp, register FILE *fp, register int flags)
     register Py_ssize_t i;
     register Py_ssize_t any;
     int status;
+    PyObject *pkey, *pvalue;
 
     status = Py_ReprEnter((PyObject*)mp);
     if (status != 0) {
@@ -1015,33 +1678,33 @@ dict_print(register PyDictObject *mp, register FILE *fp, register int flags)
     fprintf(fp, "{");
     Py_END_ALLOW_THREADS
     any = 0;
-    for (i = 0; i <= mp->ma_mask; i++) {
-        PyDictEntry *ep = mp->ma_table + i;
-        PyObject *pvalue = ep->me_value;
-        if (pvalue != NULL) {
-            /* Prevent PyObject_Repr from deleting value during
-               key format */
-            Py_INCREF(pvalue);
-            if (any++ > 0) {
-                Py_BEGIN_ALLOW_THREADS
-                fprintf(fp, ", ");
-                Py_END_ALLOW_THREADS
-            }
-            if (PyObject_Print((PyObject *)ep->me_key, fp, 0)!=0) {
-                Py_DECREF(pvalue);
-                Py_ReprLeave((PyObject*)mp);
-                return -1;
-            }
+    for (i = 0; (i = dict_next(mp, i, &pvalue)) >= 0; i++) {
+        pkey = DK_ENTRIES(mp->ma_keys)[i].me_key;
+        /* Prevent PyObject_Repr from deleting key or value during
+           key format */
+        Py_INCREF(pkey);
+        Py_INCREF(pvalue);
+        if (any++ > 0) {
             Py_BEGIN_ALLOW_THREADS
-            fprintf(fp, ": ");
+            fprintf(fp, ", ");
             Py_END_ALLOW_THREADS
-            if (PyObject_Print(pvalue, fp, 0) != 0) {
-                Py_DECREF(pvalue);
-                Py_ReprLeave((PyObject*)mp);
-                return -1;
-            }
+        }
+        if (PyObject_Print(pkey, fp, 0)!=0) {
+            Py_DECREF(pkey);
             Py_DECREF(pvalue);
+            Py_ReprLeave((PyObject*)mp);
+            return -1;
+        }
+        Py_DECREF(pkey);
+        Py_BEGIN_ALLOW_THREADS
+        fprintf(fp, ": ");
+        Py_END_ALLOW_THREADS
+        if (PyObject_Print(pvalue, fp, 0) != 0) {
+            Py_DECREF(pvalue);
+            Py_ReprLeave((PyObject*)mp);
+            return -1;
         }
+        Py_DECREF(pvalue);
     }
     Py_BEGIN_ALLOW_THREADS
     fprintf(fp, "}");
@@ -1140,18 +1803,18 @@ dict_subscript(PyDictObject *mp, register PyObject *key)
 {
     PyObject *v;
     long hash;
-    PyDictEntry *ep;
-    assert(mp->ma_table != NULL);
+    Py_ssize_t ix;
+    PyObject **value_addr;
     if (!PyString_CheckExact(key) ||
         (hash = ((PyStringObject *) key)->ob_shash) == -1) {
         hash = PyObject_Hash(key);
         if (hash == -1)
             return NULL;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
         return NULL;
-    v = ep->me_value;
+    v = ix < 0 ? NULL : *value_addr;
     if (v == NULL) {
         if (!PyDict_CheckExact(mp)) {
             /* Look up __missing__ method if we're a subclass. */
@@ -1197,8 +1860,7 @@ dict_keys(register PyDictObject *mp)
 {
     register PyObject *v;
     register Py_ssize_t i, j;
-    PyDictEntry *ep;
-    Py_ssize_t mask, n;
+    Py_ssize_t n;
 
   again:
     n = mp->ma_used;
@@ -1212,15 +1874,11 @@ dict_keys(register PyDictObject *mp)
         Py_DECREF(v);
         goto again;
     }
-    ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if (ep[i].me_value != NULL) {
-            PyObject *key = ep[i].me_key;
-            Py_INCREF(key);
-            PyList_SET_ITEM(v, j, key);
-            j++;
-        }
+    for (i = 0, j = 0; (i = dict_next(mp, i, NULL)) >= 0; i++) {
+        PyObject *key = DK_ENTRIES(mp->ma_keys)[i].me_key;
+        Py_INCREF(key);
+        PyList_SET_ITEM(v, j, key);
+        j++;
     }
     assert(j == n);
     return v;
@@ -1231,8 +1889,8 @@ dict_values(register PyDictObject *mp)
 {
     register PyObject *v;
     register Py_ssize_t i, j;
-    PyDictEntry *ep;
-    Py_ssize_t mask, n;
+    Py_ssize_t n;
+    PyObject *value;
 
   again:
     n = mp->ma_used;
@@ -1246,15 +1904,10 @@ dict_values(register PyDictObject *mp)
         Py_DECREF(v);
         goto again;
     }
-    ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if (ep[i].me_value != NULL) {
-            PyObject *value = ep[i].me_value;
-            Py_INCREF(value);
-            PyList_SET_ITEM(v, j, value);
-            j++;
-        }
+    for (i = 0, j = 0; (i = dict_next(mp, i, &value)) >= 0; i++) {
+        Py_INCREF(value);
+        PyList_SET_ITEM(v, j, value);
+        j++;
     }
     assert(j == n);
     return v;
@@ -1265,9 +1918,7 @@ dict_items(register PyDictObject *mp)
 {
     register PyObject *v;
     register Py_ssize_t i, j, n;
-    Py_ssize_t mask;
     PyObject *item, *key, *value;
-    PyDictEntry *ep;
 
     /* Preallocate the list of tuples, to avoid allocations during
      * the loop over the items, which could trigger GC, which
@@ -1294,18 +1945,14 @@ dict_items(register PyDictObject *mp)
         goto again;
     }
     /* Nothing we do below makes any function calls. */
-    ep = mp->ma_table;
-    mask = mp->ma_mask;
-    for (i = 0, j = 0; i <= mask; i++) {
-        if ((value=ep[i].me_value) != NULL) {
-            key = ep[i].me_key;
-            item = PyList_GET_ITEM(v, j);
-            Py_INCREF(key);
-            PyTuple_SET_ITEM(item, 0, key);
-            Py_INCREF(value);
-            PyTuple_SET_ITEM(item, 1, value);
-            j++;
-        }
+    for (i = 0, j = 0; (i = dict_next(mp, i, &value)) >= 0; i++) {
+        key = DK_ENTRIES(mp->ma_keys)[i].me_key;
+        item = PyList_GET_ITEM(v, j);
+        Py_INCREF(key);
+        PyTuple_SET_ITEM(item, 0, key);
+        Py_INCREF(value);
+        PyTuple_SET_ITEM(item, 1, value);
+        j++;
     }
     assert(j == n);
     return v;
@@ -1335,7 +1982,7 @@ dict_fromkeys(PyObject *cls, PyObject *args)
         PyObject *key;
         long hash;
 
-        if (dictresize(mp, Py_SIZE(seq)))
+        if (dictresize(mp, ESTIMATE_SIZE(((PyDictObject *)seq)->ma_used)))
             return NULL;
 
         while (_PyDict_Next(seq, &pos, &key, &oldvalue, &hash)) {
@@ -1353,7 +2000,7 @@ dict_fromkeys(PyObject *cls, PyObject *args)
         PyObject *key;
         long hash;
 
-        if (dictresize(mp, PySet_GET_SIZE(seq)))
+        if (dictresize(mp, ESTIMATE_SIZE(PySet_GET_SIZE(seq))))
             return NULL;
 
         while (_PySet_NextEntry(seq, &pos, &key, &hash)) {
@@ -1518,6 +2165,7 @@ PyDict_Merge(PyObject *a, PyObject *b, int override)
     register PyDictObject *mp, *other;
     register Py_ssize_t i;
     PyDictEntry *entry;
+    PyObject *key, *value;
 
     /* We accept for the argument either a concrete dictionary object,
      * or an abstract "mapping" object.  For the former, we can do
@@ -1542,31 +2190,40 @@ PyDict_Merge(PyObject *a, PyObject *b, int override)
             override = 1;
         /* Do one big resize at the start, rather than
          * incrementally resizing as we insert new items.  Expect
-         * that there will be no (or few) overlapping keys.
+         * that there will be no (or few) overlapping keys.  A split
+         * table is left as it is, so an instance dict keeps sharing
+         * the table of its class for as long as it can.
          */
-        if ((mp->ma_fill + other->ma_used)*3 >= (mp->ma_mask+1)*2) {
-           if (dictresize(mp, (mp->ma_used + other->ma_used)*2) != 0)
+        if (mp->ma_keys->dk_usable < other->ma_used &&
+            (mp->ma_values == NULL || mp->ma_values == empty_values)) {
+           if (dictresize(mp,
+                          ESTIMATE_SIZE(mp->ma_used + other->ma_used)) != 0)
                return -1;
         }
-        for (i = 0; i <= other->ma_mask; i++) {
-            entry = &other->ma_table[i];
-            if (entry->me_value != NULL &&
-                (override ||
-                 PyDict_GetItem(a, entry->me_key) == NULL)) {
-                Py_INCREF(entry->me_key);
-                Py_INCREF(entry->me_value);
-                if (insertdict(mp, entry->me_key,
-                               (long)entry->me_hash,
-                               entry->me_value) != 0)
+        for (i = 0; i < other->ma_keys->dk_nentries; i++) {
+            entry = &DK_ENTRIES(other->ma_keys)[i];
+            value = DK_VALUE(other, i);
+            if (value == NULL)
+                continue;
+            key = entry->me_key;
+            /* PyDict_GetItem() may mutate other */
+            Py_INCREF(key);
+            Py_INCREF(value);
+            if (override || PyDict_GetItem(a, key) == NULL) {
+                /* insertdict() eats the references */
+                if (insertdict(mp, key, (long)entry->me_hash, value) != 0)
                     return -1;
             }
+            else {
+                Py_DECREF(key);
+                Py_DECREF(value);
+            }
         }
     }
     else {
         /* Do it the generic, slower way */
         PyObject *keys = PyMapping_Keys(b);
         PyObject *iter;
-        PyObject *key, *value;
         int status;
 
         if (keys == NULL)
@@ -1619,11 +2276,40 @@ PyObject *
 PyDict_Copy(PyObject *o)
 {
     PyObject *copy;
+    PyDictObject *mp;
+    Py_ssize_t i, n;
 
     if (o == NULL || !PyDict_Check(o)) {
         PyErr_BadInternalCall();
         return NULL;
     }
+    mp = (PyDictObject *)o;
+    if (mp->ma_values != NULL && mp->ma_values != empty_values) {
+        /* The copy of a split dict shares its table */
+        PyDictObject *split_copy;
+        PyObject **newvalues;
+        n = USABLE_FRACTION(DK_SIZE(mp->ma_keys));
+        newvalues = new_values(n);
+        if (newvalues == NULL)
+            return PyErr_NoMemory();
+        DK_INCREF(mp->ma_keys);
+        split_copy = (PyDictObject *)new_dict(mp->ma_keys, newvalues);
+        if (split_copy == NULL)
+            return NULL;
+        for (i = 0; i < n; i++) {
+            PyObject *value = mp->ma_values[i];
+            Py_XINCREF(value);
+            newvalues[i] = value;
+        }
+        split_copy->ma_used = mp->ma_used;
+        if (split_copy->ma_used != 0)
+            DICT_MODIFIED(split_copy);
+        if (_PyObject_GC_IS_TRACKED(mp)) {
+            _PyObject_GC_TRACK(split_copy);
+            INCREASE_TRACK_COUNT
+        }
+        return (PyObject *)split_copy;
+    }
     copy = PyDict_New();
     if (copy == NULL)
         return NULL;
@@ -1689,11 +2375,11 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
     Py_ssize_t i;
     int cmp;
 
-    for (i = 0; i <= a->ma_mask; i++) {
+    for (i = 0; i < a->ma_keys->dk_nentries; i++) {
         PyObject *thiskey, *thisaval, *thisbval;
-        if (a->ma_table[i].me_value == NULL)
+        if (DK_VALUE(a, i) == NULL)
             continue;
-        thiskey = a->ma_table[i].me_key;
+        thiskey = DK_ENTRIES(a->ma_keys)[i].me_key;
         Py_INCREF(thiskey);  /* keep alive across compares */
         if (akey != NULL) {
             cmp = PyObject_RichCompareBool(akey, thiskey, Py_LT);
@@ -1702,8 +2388,8 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
                 goto Fail;
             }
             if (cmp > 0 ||
-                i > a->ma_mask ||
-                a->ma_table[i].me_value == NULL)
+                i >= a->ma_keys->dk_nentries ||
+                DK_VALUE(a, i) == NULL)
             {
                 /* Not the *smallest* a key; or maybe it is
                  * but the compare shrunk the dict so we can't
@@ -1717,7 +2403,7 @@ characterize(PyDictObject *a, PyDictObject *b, PyObject **pval)
         }
 
         /* Compare a[thiskey] to b[thiskey]; cmp <- true iff equal. */
-        thisaval = a->ma_table[i].me_value;
+        thisaval = DK_VALUE(a, i);
         assert(thisaval);
         Py_INCREF(thisaval);   /* keep alive */
         thisbval = PyDict_GetItem((PyObject *)b, thiskey);
@@ -1817,12 +2503,12 @@ dict_equal(PyDictObject *a, PyDictObject *b)
         return 0;
 
     /* Same # of entries -- check all of 'em.  Exit early on any diff. */
-    for (i = 0; i <= a->ma_mask; i++) {
-        PyObject *aval = a->ma_table[i].me_value;
+    for (i = 0; i < a->ma_keys->dk_nentries; i++) {
+        PyObject *aval = DK_VALUE(a, i);
         if (aval != NULL) {
             int cmp;
             PyObject *bval;
-            PyObject *key = a->ma_table[i].me_key;
+            PyObject *key = DK_ENTRIES(a->ma_keys)[i].me_key;
             /* temporarily bump aval's refcount to ensure it stays
                alive until we're done with it */
             Py_INCREF(aval);
@@ -1874,7 +2560,8 @@ static PyObject *
 dict_contains(register PyDictObject *mp, PyObject *key)
 {
     long hash;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
+    PyObject **value_addr;
 
     if (!PyString_CheckExact(key) ||
         (hash = ((PyStringObject *) key)->ob_shash) == -1) {
@@ -1882,10 +2569,10 @@ dict_contains(register PyDictObject *mp, PyObject *key)
         if (hash == -1)
             return NULL;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
         return NULL;
-    return PyBool_FromLong(ep->me_value != NULL);
+    return PyBool_FromLong(ix >= 0 && *value_addr != NULL);
 }
 
 static PyObject *
@@ -1898,15 +2585,16 @@ dict_has_key(register PyDictObject *mp, PyObject *key)
 }
 
 static PyObject *
-dict_get(register PyDictObject *mp, PyObject *args)
+dict_get(register PyDictObject *mp, PyObject **args, Py_ssize_t nargs)
 {
     PyObject *key;
     PyObject *failobj = Py_None;
     PyObject *val = NULL;
     long hash;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
+    PyObject **value_addr;
 
-    if (!PyArg_UnpackTuple(args, "get", 1, 2, &key, &failobj))
+    if (!_PyArg_UnpackStack(args, nargs, "get", 1, 2, &key, &failobj))
         return NULL;
 
     if (!PyString_CheckExact(key) ||
@@ -1915,10 +2603,10 @@ dict_get(register PyDictObject *mp, PyObject *args)
         if (hash == -1)
             return NULL;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
         return NULL;
-    val = ep->me_value;
+    val = ix < 0 ? NULL : *value_addr;
     if (val == NULL)
         val = failobj;
     Py_INCREF(val);
@@ -1933,7 +2621,8 @@ dict_setdefault(register PyDictObject *mp, PyObject *args)
     PyObject *failobj = Py_None;
     PyObject *val = NULL;
     long hash;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
+    PyObject **value_addr;
 
     if (!PyArg_UnpackTuple(args, "setdefault", 1, 2, &key, &failobj))
         return NULL;
@@ -1944,10 +2633,10 @@ dict_setdefault(register PyDictObject *mp, PyObject *args)
         if (hash == -1)
             return NULL;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
         return NULL;
-    val = ep->me_value;
+    val = ix < 0 ? NULL : *value_addr;
     if (val == NULL) {
         val = failobj;
         if (PyDict_SetItem((PyObject*)mp, key, failobj))
@@ -1969,9 +2658,9 @@ static PyObject *
 dict_pop(PyDictObject *mp, PyObject *args)
 {
     long hash;
-    PyDictEntry *ep;
-    PyObject *old_value, *old_key;
+    Py_ssize_t ix, hashpos;
     PyObject *key, *deflt = NULL;
+    PyObject **value_addr;
 
     if(!PyArg_UnpackTuple(args, "pop", 1, 2, &key, &deflt))
         return NULL;
@@ -1989,10 +2678,10 @@ dict_pop(PyDictObject *mp, PyObject *args)
         if (hash == -1)
             return NULL;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    if (ep == NULL)
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, &hashpos);
+    if (ix == DKIX_ERROR)
         return NULL;
-    if (ep->me_value == NULL) {
+    if (ix == DKIX_EMPTY || *value_addr == NULL) {
         if (deflt) {
             Py_INCREF(deflt);
             return deflt;
@@ -2000,21 +2689,19 @@ dict_pop(PyDictObject *mp, PyObject *args)
         set_key_error(key);
         return NULL;
     }
-    old_key = ep->me_key;
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
-    old_value = ep->me_value;
-    ep->me_value = NULL;
-    mp->ma_used--;
-    Py_DECREF(old_key);
-    return old_value;
+    if (mp->ma_values != NULL) {
+        ix = combine_for_deletion(mp, key, hash, &hashpos);
+        if (ix < 0)
+            return NULL;
+    }
+    return delitem_common(mp, hashpos, ix);
 }
 
 static PyObject *
 dict_popitem(PyDictObject *mp)
 {
-    Py_ssize_t i = 0;
-    PyDictEntry *ep;
+    Py_ssize_t i, hashpos;
+    PyDictEntry *ep, *ep0;
     PyObject *res;
 
     /* Allocate the result tuple before checking the size.  Believe it
@@ -2035,48 +2722,46 @@ dict_popitem(PyDictObject *mp)
                         "popitem(): dictionary is empty");
         return NULL;
     }
-    /* Set ep to "the first" dict entry with a value.  We abuse the hash
-     * field of slot 0 to hold a search finger:
-     * If slot 0 has a value, use slot 0.
-     * Else slot 0 is being used to hold a search finger,
-     * and we use its hash value as the first index to look.
-     */
-    ep = &mp->ma_table[0];
-    if (ep->me_value == NULL) {
-        i = ep->me_hash;
-        /* The hash field may be a real hash value, or it may be a
-         * legit search finger, or it may be a once-legit search
-         * finger that's out of bounds now because it wrapped around
-         * or the table shrunk -- simply make sure it's in bounds now.
-         */
-        if (i > mp->ma_mask || i < 1)
-            i = 1;              /* skip slot 0 */
-        while ((ep = &mp->ma_table[i])->me_value == NULL) {
-            i++;
-            if (i > mp->ma_mask)
-                i = 1;
+    /* The entries of a split table cannot be removed */
+    if (mp->ma_values != NULL) {
+        if (dictresize(mp, ESTIMATE_SIZE(mp->ma_used))) {
+            Py_DECREF(res);
+            return NULL;
         }
     }
+    ENSURE_ALLOWS_DELETIONS(mp);
+    /* Pop the last entry, skipping deleted ones; popping in insertion
+     * order from the end keeps "while d: d.popitem()" linear.
+     */
+    ep0 = DK_ENTRIES(mp->ma_keys);
+    i = mp->ma_keys->dk_nentries - 1;
+    while (i >= 0 && ep0[i].me_value == NULL)
+        i--;
+    assert(i >= 0);
+    ep = &ep0[i];
+    hashpos = lookdict_index(mp->ma_keys, (long)ep->me_hash, i);
+    assert(hashpos >= 0);
+    dk_set_index(mp->ma_keys, hashpos, DKIX_DUMMY);
     PyTuple_SET_ITEM(res, 0, ep->me_key);
     PyTuple_SET_ITEM(res, 1, ep->me_value);
-    Py_INCREF(dummy);
-    ep->me_key = dummy;
+    ep->me_key = NULL;
     ep->me_value = NULL;
+    /* The hash table keeps a dummy, so dk_usable stays as it is */
+    mp->ma_keys->dk_nentries = i;
     mp->ma_used--;
-    assert(mp->ma_table[0].me_value == NULL);
-    mp->ma_table[0].me_hash = i + 1;  /* next place to start */
+    DICT_MODIFIED(mp);
     return res;
 }
 
 static int
 dict_traverse(PyObject *op, visitproc visit, void *arg)
 {
-    Py_ssize_t i = 0;
-    PyObject *pk;
+    PyDictObject *mp = (PyDictObject *)op;
+    Py_ssize_t i;
     PyObject *pv;
 
-    while (PyDict_Next(op, &i, &pk, &pv)) {
-        Py_VISIT(pk);
+    for (i = 0; (i = dict_next(mp, i, &pv)) >= 0; i++) {
+        Py_VISIT(DK_ENTRIES(mp->ma_keys)[i].me_key);
         Py_VISIT(pv);
     }
     return 0;
@@ -2119,8 +2804,13 @@ dict_sizeof(PyDictObject *mp)
     Py_ssize_t res;
 
     res = sizeof(PyDictObject);
-    if (mp->ma_table != mp->ma_smalltable)
-        res = res + (mp->ma_mask + 1) * sizeof(PyDictEntry);
+    if (mp->ma_values != NULL && mp->ma_values != empty_values)
+        res += USABLE_FRACTION(DK_SIZE(mp->ma_keys)) * sizeof(PyObject *);
+    /* A shared table is accounted to its class */
+    if (mp->ma_keys->dk_refcnt == 1)
+        res += offsetof(PyDictKeysObject, dk_indices) +
+               DK_SIZE(mp->ma_keys) * DK_IXSIZE(mp->ma_keys) +
+               USABLE_FRACTION(DK_SIZE(mp->ma_keys)) * sizeof(PyDictEntry);
     return PyInt_FromSsize_t(res);
 }
 
@@ -2204,7 +2894,7 @@ static PyMethodDef mapp_methods[] = {
      sizeof__doc__},
     {"has_key",         (PyCFunction)dict_has_key,      METH_O,
      has_key__doc__},
-    {"get",         (PyCFunction)dict_get,          METH_VARARGS,
+    {"get",         (PyCFunction)dict_get,          METH_FASTCALL,
      get__doc__},
     {"setdefault",  (PyCFunction)dict_setdefault,   METH_VARARGS,
      setdefault_doc__},
@@ -2247,7 +2937,8 @@ PyDict_Contains(PyObject *op, PyObject *key)
 {
     long hash;
     PyDictObject *mp = (PyDictObject *)op;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
+    PyObject **value_addr;
 
     if (!PyString_CheckExact(key) ||
         (hash = ((PyStringObject *) key)->ob_shash) == -1) {
@@ -2255,8 +2946,10 @@ PyDict_Contains(PyObject *op, PyObject *key)
         if (hash == -1)
             return -1;
     }
-    ep = (mp->ma_lookup)(mp, key, hash);
-    return ep == NULL ? -1 : (ep->me_value != NULL);
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
+        return -1;
+    return ix >= 0 && *value_addr != NULL;
 }
 
 /* Internal version of PyDict_Contains used when the hash value is already known */
@@ -2264,10 +2957,13 @@ int
 _PyDict_Contains(PyObject *op, PyObject *key, long hash)
 {
     PyDictObject *mp = (PyDictObject *)op;
-    PyDictEntry *ep;
+    Py_ssize_t ix;
+    PyObject **value_addr;
 
-    ep = (mp->ma_lookup)(mp, key, hash);
-    return ep == NULL ? -1 : (ep->me_value != NULL);
+    ix = mp->ma_keys->dk_lookup(mp, key, hash, &value_addr, NULL);
+    if (ix == DKIX_ERROR)
+        return -1;
+    return ix >= 0 && *value_addr != NULL;
 }
 
 /* Hack to implement "key in dict" */
@@ -2294,9 +2990,10 @@ dict_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     if (self != NULL) {
         PyDictObject *d = (PyDictObject *)self;
         /* It's guaranteed that tp->alloc zeroed out the struct. */
-        assert(d->ma_table == NULL && d->ma_fill == 0 && d->ma_used == 0);
-        INIT_NONZERO_DICT_SLOTS(d);
-        d->ma_lookup = lookdict_string;
+        assert(d->ma_keys == NULL && d->ma_used == 0);
+        DK_INCREF(Py_EMPTY_KEYS);
+        d->ma_keys = Py_EMPTY_KEYS;
+        d->ma_values = empty_values;
         /* The object has been implicitely tracked by tp_alloc */
         if (type == &PyDict_Type)
             _PyObject_GC_UNTRACK(d);
@@ -2491,8 +3188,7 @@ static PyMethodDef dictiter_methods[] = {
 static PyObject *dictiter_iternextkey(dictiterobject *di)
 {
     PyObject *key;
-    register Py_ssize_t i, mask;
-    register PyDictEntry *ep;
+    register Py_ssize_t i;
     PyDictObject *d = di->di_dict;
 
     if (d == NULL)
@@ -2506,18 +3202,12 @@ static PyObject *dictiter_iternextkey(dictiterobject *di)
         return NULL;
     }
 
-    i = di->di_pos;
+    i = dict_next(d, di->di_pos, NULL);
     if (i < 0)
         goto fail;
-    ep = d->ma_table;
-    mask = d->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
-        i++;
     di->di_pos = i+1;
-    if (i > mask)
-        goto fail;
     di->len--;
-    key = ep[i].me_key;
+    key = DK_ENTRIES(d->ma_keys)[i].me_key;
     Py_INCREF(key);
     return key;
 
@@ -2563,8 +3253,7 @@ PyTypeObject PyDictIterKey_Type = {
 static PyObject *dictiter_iternextvalue(dictiterobject *di)
 {
     PyObject *value;
-    register Py_ssize_t i, mask;
-    register PyDictEntry *ep;
+    register Py_ssize_t i;
     PyDictObject *d = di->di_dict;
 
     if (d == NULL)
@@ -2578,16 +3267,9 @@ static PyObject *dictiter_iternextvalue(dictiterobject *di)
         return NULL;
     }
 
-    i = di->di_pos;
-    mask = d->ma_mask;
-    if (i < 0 || i > mask)
+    i = dict_next(d, di->di_pos, &value);
+    if (i < 0)
         goto fail;
-    ep = d->ma_table;
-    while ((value=ep[i].me_value) == NULL) {
-        i++;
-        if (i > mask)
-            goto fail;
-    }
     di->di_pos = i+1;
     di->len--;
     Py_INCREF(value);
@@ -2635,8 +3317,7 @@ PyTypeObject PyDictIterValue_Type = {
 static PyObject *dictiter_iternextitem(dictiterobject *di)
 {
     PyObject *key, *value, *result = di->di_result;
-    register Py_ssize_t i, mask;
-    register PyDictEntry *ep;
+    register Py_ssize_t i;
     PyDictObject *d = di->di_dict;
 
     if (d == NULL)
@@ -2650,16 +3331,13 @@ static PyObject *dictiter_iternextitem(dictiterobject *di)
         return NULL;
     }
 
-    i = di->di_pos;
+    i = dict_next(d, di->di_pos, &value);
     if (i < 0)
         goto fail;
-    ep = d->ma_table;
-    mask = d->ma_mask;
-    while (i <= mask && ep[i].me_value == NULL)
-        i++;
     di->di_pos = i+1;
-    if (i > mask)
-        goto fail;
+    key = DK_ENTRIES(d->ma_keys)[i].me_key;
+    Py_INCREF(key);
+    Py_INCREF(value);
 
     if (result->ob_refcnt == 1) {
         Py_INCREF(result);
@@ -2667,14 +3345,13 @@ static PyObject *dictiter_iternextitem(dictiterobject *di)
         Py_DECREF(PyTuple_GET_ITEM(result, 1));
     } else {
         result = PyTuple_New(2);
-        if (result == NULL)
+        if (result == NULL) {
+            Py_DECREF(key);
+            Py_DECREF(value);
             return NULL;
+        }
     }
     di->len--;
-    key = ep[i].me_key;
-    value = ep[i].me_value;
-    Py_INCREF(key);
-    Py_INCREF(value);
     PyTuple_SET_ITEM(result, 0, key);
     PyTuple_SET_ITEM(result, 1, value);
     return result;
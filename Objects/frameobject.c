@@ -441,32 +441,58 @@ static PyGetSetDef frame_getsetlist[] = {
      * f_localsplus does not require re-allocation and
        the local variables in f_localsplus are NULL.
 
-   2. We also maintain a separate free list of stack frames (just like
-   integers are allocated in a special way -- see intobject.c).  When
-   a stack frame is on the free list, only the following members have
+   2. We also maintain separate free lists of stack frames (just like
+   tuples are allocated in a special way -- see tupleobject.c).  When
+   a stack frame is on a free list, only the following members have
    a meaning:
     ob_type             == &Frametype
     f_back              next item on free list, or NULL
-    f_stacksize         size of value stack
     ob_size             size of localsplus
-   Note that the value and block stacks are preserved -- this can save
-   another malloc() call or two (and two free() calls as well!).
-   Also note that, unlike for integers, each frame object is a
-   malloc'ed object in its own right -- it is only the actual calls to
-   malloc() that we are trying to save here, not the administration.
-   After all, while a typical program may make millions of calls, a
-   call depth of more than 20 or 30 is probably already exceptional
-   unless the program contains run-away recursion.  I hope.
-
-   Later, PyFrame_MAXFREELIST was added to bound the # of frames saved on
-   free_list.  Else programs creating lots of cyclic trash involving
-   frames could provoke free_list into growing without bound.
+   Note that, unlike for integers, each frame object is a malloc'ed
+   object in its own right -- it is only the actual calls to malloc()
+   that we are trying to save here, not the administration.
+
+   The zombie frame does not help when many frames of the same code
+   are alive at the same time, as with thousands of tasklets running
+   the same functions.  So the free lists are kept by size class: the
+   size of localsplus is rounded up to a multiple of FRAME_CLASS_SLOTS,
+   and every frame on free_list[c] has room for FRAME_CLASS_SIZE(c)
+   slots.  A frame from a free list never needs a realloc, and the
+   frames of different code objects of similar size are interchangeable.
+   Frames bigger than the largest class are not cached.
+
+   The number of frames kept in a class adapts to the program: the limit
+   starts at PyFrame_MINFREELIST and grows by one for every frame which
+   had to be malloc'ed while the class was empty, up to PyFrame_MAXFREELIST.
+   A full collection frees half of the cached frames and lowers the
+   limits by as much (see _PyFrame_TrimFreeList), so a burst of calls
+   does not pin its frames forever, while the lists of a program that
+   keeps using its frames stay large.
 */
 
-static PyFrameObject *free_list = NULL;
-static int numfree = 0;         /* number of frames currently in free_list */
-/* max value for numfree */
-#define PyFrame_MAXFREELIST 200
+#define FRAME_CLASS_SLOTS 8
+#define FRAME_NUMCLASSES 32
+#define FRAME_CLASS(extras) \
+    ((extras) > 0 ? ((extras) - 1) / FRAME_CLASS_SLOTS : 0)
+#define FRAME_CLASS_SIZE(c) (((c) + 1) * FRAME_CLASS_SLOTS)
+
+/* initial and maximal value of maxfree[c] */
+#define PyFrame_MINFREELIST 16
+#define PyFrame_MAXFREELIST 16384
+
+static PyFrameObject *free_list[FRAME_NUMCLASSES];
+static int numfree[FRAME_NUMCLASSES];   /* frames currently in free_list */
+static int numgrown[FRAME_NUMCLASSES];  /* growth of the limit of numfree */
+#define FRAME_MAXFREE(c) (PyFrame_MINFREELIST + numgrown[c])
+
+static struct {
+    Py_ssize_t allocs;          /* frames handed out by PyFrame_New */
+    Py_ssize_t zombie_hits;     /* ... which were a code's zombie frame */
+    Py_ssize_t freelist_hits;   /* ... which came from a free list */
+    Py_ssize_t deallocs;        /* frames given back by frame_dealloc */
+    Py_ssize_t zombie_saves;    /* ... which became a zombie frame */
+    Py_ssize_t freelist_saves;  /* ... which went to a free list */
+} frame_stats;
 
 static void
 frame_dealloc(PyFrameObject *f)
@@ -497,15 +523,24 @@ frame_dealloc(PyFrameObject *f)
     Py_CLEAR(f->f_exc_traceback);
 
     co = f->f_code;
-    if (co->co_zombieframe == NULL)
+    frame_stats.deallocs++;
+    if (co->co_zombieframe == NULL) {
         co->co_zombieframe = f;
-    else if (numfree < PyFrame_MAXFREELIST) {
-        ++numfree;
-        f->f_back = free_list;
-        free_list = f;
+        frame_stats.zombie_saves++;
+    }
+    else {
+        /* the largest class that f has room for */
+        Py_ssize_t c = Py_SIZE(f) / FRAME_CLASS_SLOTS - 1;
+        if (c >= 0 && c < FRAME_NUMCLASSES &&
+            numfree[c] < FRAME_MAXFREE(c)) {
+            ++numfree[c];
+            f->f_back = free_list[c];
+            free_list[c] = f;
+            frame_stats.freelist_saves++;
+        }
+        else
+            PyObject_GC_Del(f);
     }
-    else
-        PyObject_GC_Del(f);
 
     Py_DECREF(co);
     Py_TRASHCAN_SAFE_END(f)
@@ -688,19 +723,37 @@ PyFrame_New(PyThreadState *tstate, PyCodeObject *code, PyObject *globals,
         assert(builtins != NULL && PyDict_Check(builtins));
         Py_INCREF(builtins);
     }
+    frame_stats.allocs++;
     if (code->co_zombieframe != NULL) {
         f = code->co_zombieframe;
         code->co_zombieframe = NULL;
         _Py_NewReference((PyObject *)f);
         assert(f->f_code == code);
+        frame_stats.zombie_hits++;
     }
     else {
-        Py_ssize_t extras, ncells, nfrees;
+        Py_ssize_t extras, ncells, nfrees, c;
         ncells = PyTuple_GET_SIZE(code->co_cellvars);
         nfrees = PyTuple_GET_SIZE(code->co_freevars);
         extras = code->co_stacksize + code->co_nlocals + ncells +
             nfrees;
-        if (free_list == NULL) {
+        c = FRAME_CLASS(extras);
+        if (c < FRAME_NUMCLASSES && free_list[c] != NULL) {
+            assert(numfree[c] > 0);
+            assert(Py_SIZE(free_list[c]) >= extras);
+            --numfree[c];
+            f = free_list[c];
+            free_list[c] = f->f_back;
+            _Py_NewReference((PyObject *)f);
+            frame_stats.freelist_hits++;
+        }
+        else {
+            if (c < FRAME_NUMCLASSES) {
+                /* round up, so the frame can go to the free list */
+                extras = FRAME_CLASS_SIZE(c);
+                if (FRAME_MAXFREE(c) < PyFrame_MAXFREELIST)
+                    numgrown[c]++;
+            }
             f = PyObject_GC_NewVar(PyFrameObject, &PyFrame_Type,
             extras);
             if (f == NULL) {
@@ -708,20 +761,6 @@ PyFrame_New(PyThreadState *tstate, PyCodeObject *code, PyObject *globals,
                 return NULL;
             }
         }
-        else {
-            assert(numfree > 0);
-            --numfree;
-            f = free_list;
-            free_list = free_list->f_back;
-            if (Py_SIZE(f) < extras) {
-                f = PyObject_GC_Resize(PyFrameObject, f, extras);
-                if (f == NULL) {
-                    Py_DECREF(builtins);
-                    return NULL;
-                }
-            }
-            _Py_NewReference((PyObject *)f);
-        }
 
         f->f_code = code;
         extras = code->co_nlocals + ncells + nfrees;
@@ -984,22 +1023,88 @@ PyFrame_LocalsToFast(PyFrameObject *f, int clear)
     PyErr_Restore(error_type, error_value, error_traceback);
 }
 
-/* Clear out the free list */
+/* Free the frames of class c above keep */
+static int
+frame_free_class(int c, int keep)
+{
+    int freed = 0;
+
+    while (numfree[c] > keep) {
+        PyFrameObject *f = free_list[c];
+        free_list[c] = f->f_back;
+        PyObject_GC_Del(f);
+        --numfree[c];
+        ++freed;
+    }
+    return freed;
+}
+
+/* Clear out the free lists */
 int
 PyFrame_ClearFreeList(void)
 {
-    int freelist_size = numfree;
+    int c, freelist_size = 0;
 
-    while (free_list != NULL) {
-        PyFrameObject *f = free_list;
-        free_list = free_list->f_back;
-        PyObject_GC_Del(f);
-        --numfree;
+    for (c = 0; c < FRAME_NUMCLASSES; c++) {
+        freelist_size += frame_free_class(c, 0);
+        assert(free_list[c] == NULL);
+        numgrown[c] = 0;
     }
-    assert(numfree == 0);
     return freelist_size;
 }
 
+/* Give back half of the cached frames, called by full collections */
+int
+_PyFrame_TrimFreeList(void)
+{
+    int c, n, freed = 0;
+
+    for (c = 0; c < FRAME_NUMCLASSES; c++) {
+        n = frame_free_class(c, numfree[c] / 2);
+        numgrown[c] -= n;
+        if (numgrown[c] < 0)
+            numgrown[c] = 0;
+        freed += n;
+    }
+    return freed;
+}
+
+/* Return the statistics of the frame allocator as a dict */
+PyObject *
+_PyFrame_GetStats(void)
+{
+    PyObject *d, *classes, *item;
+    int c, cached = 0;
+
+    classes = PyList_New(0);
+    if (classes == NULL)
+        return NULL;
+    for (c = 0; c < FRAME_NUMCLASSES; c++) {
+        if (numfree[c] == 0 && numgrown[c] == 0)
+            continue;
+        cached += numfree[c];
+        item = Py_BuildValue("(nii)", (Py_ssize_t) FRAME_CLASS_SIZE(c),
+                             numfree[c], FRAME_MAXFREE(c));
+        if (item == NULL || PyList_Append(classes, item) < 0) {
+            Py_XDECREF(item);
+            Py_DECREF(classes);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    d = Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:n,s:n,s:i,s:N}",
+                      "allocs", frame_stats.allocs,
+                      "zombie_hits", frame_stats.zombie_hits,
+                      "freelist_hits", frame_stats.freelist_hits,
+                      "deallocs", frame_stats.deallocs,
+                      "zombie_saves", frame_stats.zombie_saves,
+                      "freelist_saves", frame_stats.freelist_saves,
+                      "live", frame_stats.allocs - frame_stats.deallocs,
+                      "cached", cached,
+                      "classes", classes);
+    return d;
+}
+
 void
 PyFrame_Fini(void)
 {
@@ -17,6 +17,29 @@
 #define KARATSUBA_CUTOFF 70
 #define KARATSUBA_SQUARE_CUTOFF (2 * KARATSUBA_CUTOFF)
 
+/* Balanced multiplications where both operands contain more than
+ * TOOM3_CUTOFF digits use Toom-Cook 3-way splitting instead, which does
+ * 5 multiplications of numbers a third of the size, where Karatsuba does
+ * 3 of half the size.
+ */
+#define TOOM3_CUTOFF 300
+
+/* Division with a divisor of more than DIVIDE_CUTOFF digits, and a
+ * quotient of more than DIVIDE_CUTOFF digits, uses the recursive
+ * Burnikel-Ziegler algorithm, which costs a couple of multiplications of
+ * the same size instead of the O(N**2) school algorithm.
+ */
+#define DIVIDE_CUTOFF 100
+
+/* Strings of more than FROM_STRING_CUTOFF digits in a non-binary base,
+ * and longs of more than TO_DECIMAL_CUTOFF digits converted to decimal,
+ * are split in halves at a power of the base, and the halves are converted
+ * recursively.  This makes conversion about as fast as multiplication
+ * resp. division, where the school algorithms are quadratic.
+ */
+#define FROM_STRING_CUTOFF 2000
+#define TO_DECIMAL_CUTOFF 200
+
 /* For exponentiation, use the binary left-to-right algorithm
  * unless the exponent contains more than FIVEARY_CUTOFF digits.
  * In that case, do 5 bits at a time.  The potential drawback is that
@@ -1311,6 +1334,102 @@ divrem1(PyLongObject *a, digit n, digit *prem)
     return long_normalize(z);
 }
 
+/* Convert abs(a) to an array of base _PyLong_DECIMAL_BASE digits in pout,
+   following Knuth (TAOCP, Volume 2 (3rd edn), section 4.4, Method 1b).
+   Return the number of digits, which is 0 for a = 0, or -1 if interrupted
+   by a signal.  pout needs room for the result, which is at most
+   1 + ABS(Py_SIZE(a)) * PyLong_SHIFT / (3 * _PyLong_DECIMAL_SHIFT) digits
+   (see long_to_decimal_string below). */
+
+static Py_ssize_t
+decimal_digits(PyLongObject *a, digit *pout)
+{
+    Py_ssize_t size, i, j;
+    digit *pin;
+
+    pin = a->ob_digit;
+    size = 0;
+    for (i = ABS(Py_SIZE(a)); --i >= 0; ) {
+        digit hi = pin[i];
+        for (j = 0; j < size; j++) {
+            twodigits z = (twodigits)pout[j] << PyLong_SHIFT | hi;
+            hi = (digit)(z / _PyLong_DECIMAL_BASE);
+            pout[j] = (digit)(z - (twodigits)hi *
+                              _PyLong_DECIMAL_BASE);
+        }
+        while (hi) {
+            pout[size++] = hi % _PyLong_DECIMAL_BASE;
+            hi /= _PyLong_DECIMAL_BASE;
+        }
+        /* check for keyboard interrupt */
+        SIGCHECK({
+                return -1;
+            });
+    }
+    return size;
+}
+
+/* forward */
+static int long_divrem(PyLongObject *, PyLongObject *,
+                       PyLongObject **, PyLongObject **);
+static PyLongObject *x_add(PyLongObject *, PyLongObject *);
+static PyLongObject *k_mul(PyLongObject *, PyLongObject *);
+static PyObject *long_pow(PyObject *, PyObject *, PyObject *);
+
+/* Return base**exp as a new long, or NULL on error. */
+
+static PyLongObject *
+long_from_power(digit base, long exp)
+{
+    PyObject *b, *e, *z;
+
+    b = PyLong_FromLong((long)base);
+    e = PyLong_FromLong(exp);
+    z = b == NULL || e == NULL ? NULL : long_pow(b, e, Py_None);
+    Py_XDECREF(b);
+    Py_XDECREF(e);
+    return (PyLongObject *)z;
+}
+
+/* Convert abs(a) < _PyLong_DECIMAL_BASE**(unit << k) to exactly unit << k
+   base _PyLong_DECIMAL_BASE digits in pout, zero padded.  Above k = 0,
+   the digits are split in halves by dividing by
+   powers[k-1] = _PyLong_DECIMAL_BASE**(unit << (k-1)), and both halves
+   are converted recursively.  This takes a few times as long as dividing
+   a by its square root, where decimal_digits takes time quadratic in
+   the size of a. */
+
+static int
+decimal_digits_split(PyLongObject *a, PyLongObject **powers, int k,
+                     Py_ssize_t unit, digit *pout)
+{
+    PyLongObject *q, *r;
+    Py_ssize_t size, width = unit << k;
+    int status;
+
+    if (k == 0) {
+        size = decimal_digits(a, pout);
+        if (size < 0)
+            return -1;
+        assert(size <= width);
+        memset(pout + size, 0, (width - size) * sizeof(digit));
+        return 0;
+    }
+    if (Py_SIZE(a) == 0) {
+        memset(pout, 0, width * sizeof(digit));
+        return 0;
+    }
+    if (long_divrem(a, powers[k-1], &q, &r) < 0)
+        return -1;
+    status = decimal_digits_split(r, powers, k-1, unit, pout);
+    if (status == 0)
+        status = decimal_digits_split(q, powers, k-1, unit,
+                                      pout + (width >> 1));
+    Py_DECREF(q);
+    Py_DECREF(r);
+    return status;
+}
+
 /* Convert a long integer to a base 10 string.  Returns a new non-shared
    string.  (Return value is non-shared so that callers can modify the
    returned value if necessary.) */
@@ -1321,7 +1440,7 @@ long_to_decimal_string(PyObject *aa, int addL)
     PyLongObject *scratch, *a;
     PyObject *str;
     Py_ssize_t size, strlen, size_a, i, j;
-    digit *pout, *pin, rem, tenpow;
+    digit *pout, rem, tenpow;
     char *p;
     int negative;
 
@@ -1349,33 +1468,53 @@ long_to_decimal_string(PyObject *aa, int addL)
     }
     /* the expression size_a * PyLong_SHIFT is now safe from overflow */
     size = 1 + size_a * PyLong_SHIFT / (3 * _PyLong_DECIMAL_SHIFT);
-    scratch = _PyLong_New(size);
-    if (scratch == NULL)
-        return NULL;
 
-    /* convert array of base _PyLong_BASE digits in pin to an array of
-       base _PyLong_DECIMAL_BASE digits in pout, following Knuth (TAOCP,
-       Volume 2 (3rd edn), section 4.4, Method 1b). */
-    pin = a->ob_digit;
-    pout = scratch->ob_digit;
-    size = 0;
-    for (i = size_a; --i >= 0; ) {
-        digit hi = pin[i];
-        for (j = 0; j < size; j++) {
-            twodigits z = (twodigits)pout[j] << PyLong_SHIFT | hi;
-            hi = (digit)(z / _PyLong_DECIMAL_BASE);
-            pout[j] = (digit)(z - (twodigits)hi *
-                              _PyLong_DECIMAL_BASE);
+    if (size_a <= TO_DECIMAL_CUTOFF) {
+        scratch = _PyLong_New(size);
+        if (scratch == NULL)
+            return NULL;
+        pout = scratch->ob_digit;
+        size = decimal_digits(a, pout);
+        if (size < 0) {
+            Py_DECREF(scratch);
+            return NULL;
         }
-        while (hi) {
-            pout[size++] = hi % _PyLong_DECIMAL_BASE;
-            hi /= _PyLong_DECIMAL_BASE;
+    }
+    else {
+        /* Split a at powers of _PyLong_DECIMAL_BASE whose exponents are
+           unit << k, with unit chosen so that each piece converted by
+           decimal_digits has about TO_DECIMAL_CUTOFF / 2 digits.
+           powers[k] is the first one longer than a. */
+        PyLongObject *powers[8 * sizeof(Py_ssize_t)];
+        const Py_ssize_t unit = TO_DECIMAL_CUTOFF * PyLong_SHIFT /
+            (7 * _PyLong_DECIMAL_SHIFT);
+        int k = 0, status = -1;
+
+        scratch = NULL;
+        powers[0] = long_from_power(_PyLong_DECIMAL_BASE, (long)unit);
+        if (powers[0] == NULL)
+            return NULL;
+        while (Py_SIZE(powers[k]) <= size_a) {
+            powers[k+1] = k_mul(powers[k], powers[k]);
+            if (powers[k+1] == NULL)
+                goto split_done;
+            k++;
         }
-        /* check for keyboard interrupt */
-        SIGCHECK({
-                Py_DECREF(scratch);
-                return NULL;
-            });
+        scratch = _PyLong_New(unit << k);
+        if (scratch == NULL)
+            goto split_done;
+        pout = scratch->ob_digit;
+        status = decimal_digits_split(a, powers, k, unit, pout);
+      split_done:
+        for (i = 0; i <= k; i++)
+            Py_DECREF(powers[i]);
+        if (status < 0) {
+            Py_XDECREF(scratch);
+            return NULL;
+        }
+        size = unit << k;
+        while (size > 0 && pout[size-1] == 0)
+            size--;
     }
     /* pout should have at least one digit, so that the case when a = 0
        works correctly */
@@ -1693,62 +1832,12 @@ long_from_binary_base(char **str, int base)
     return long_normalize(z);
 }
 
-PyObject *
-PyLong_FromString(char *str, char **pend, int base)
-{
-    int sign = 1;
-    char *start, *orig_str = str;
-    PyLongObject *z;
-    PyObject *strobj, *strrepr;
-    Py_ssize_t slen;
-
-    if ((base != 0 && base < 2) || base > 36) {
-        PyErr_SetString(PyExc_ValueError,
-                        "long() arg 2 must be >= 2 and <= 36");
-        return NULL;
-    }
-    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
-        str++;
-    if (*str == '+')
-        ++str;
-    else if (*str == '-') {
-        ++str;
-        sign = -1;
-    }
-    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
-        str++;
-    if (base == 0) {
-        /* No base given.  Deduce the base from the contents
-           of the string */
-        if (str[0] != '0')
-            base = 10;
-        else if (str[1] == 'x' || str[1] == 'X')
-            base = 16;
-        else if (str[1] == 'o' || str[1] == 'O')
-            base = 8;
-        else if (str[1] == 'b' || str[1] == 'B')
-            base = 2;
-        else
-            /* "old" (C-style) octal literal, still valid in
-               2.x, although illegal in 3.x */
-            base = 8;
-    }
-    /* Whether or not we were deducing the base, skip leading chars
-       as needed */
-    if (str[0] == '0' &&
-        ((base == 16 && (str[1] == 'x' || str[1] == 'X')) ||
-         (base == 8  && (str[1] == 'o' || str[1] == 'O')) ||
-         (base == 2  && (str[1] == 'b' || str[1] == 'B'))))
-        str += 2;
-
-    start = str;
-    if ((base & (base - 1)) == 0)
-        z = long_from_binary_base(&str, base);
-    else {
 /***
 Binary bases can be converted in time linear in the number of digits, because
 Python's representation base is binary.  Other bases (including decimal!) use
 the simple quadratic-time algorithm below, complicated by some speed tricks.
+Strings of more than FROM_STRING_CUTOFF digits are first split in pieces
+small enough for it, see long_from_long_string.
 
 First some math:  the largest integer that can be expressed in N base-B digits
 is B**N-1.  Consequently, if we have an N-digit input in base B, the worst-
@@ -1832,116 +1921,251 @@ that triggers it(!).  Instead the code was tested by artificially allocating
 just 1 digit at the start, so that the copying code was exercised for every
 digit beyond the first.
 ***/
-        register twodigits c;           /* current input character */
-        Py_ssize_t size_z;
-        int i;
-        int convwidth;
-        twodigits convmultmax, convmult;
-        digit *pz, *pzstop;
-        char* scan;
-
-        static double log_base_PyLong_BASE[37] = {0.0e0,};
-        static int convwidth_base[37] = {0,};
-        static twodigits convmultmax_base[37] = {0,};
-
-        if (log_base_PyLong_BASE[base] == 0.0) {
-            twodigits convmax = base;
-            int i = 1;
-
-            log_base_PyLong_BASE[base] = (log((double)base) /
-                                          log((double)PyLong_BASE));
-            for (;;) {
-                twodigits next = convmax * base;
-                if (next > PyLong_BASE)
-                    break;
-                convmax = next;
-                ++i;
-            }
-            convmultmax_base[base] = convmax;
-            assert(i > 0);
-            convwidth_base[base] = i;
+
+/* Convert the digits str[0:scan-str] in the non-binary base `base` to a
+   nonnegative long. */
+
+static PyLongObject *
+long_from_non_binary_base(char *str, char *scan, int base)
+{
+    PyLongObject *z;
+    register twodigits c;           /* current input character */
+    Py_ssize_t size_z;
+    int i;
+    int convwidth;
+    twodigits convmultmax, convmult;
+    digit *pz, *pzstop;
+
+    static double log_base_PyLong_BASE[37] = {0.0e0,};
+    static int convwidth_base[37] = {0,};
+    static twodigits convmultmax_base[37] = {0,};
+
+    if (log_base_PyLong_BASE[base] == 0.0) {
+        twodigits convmax = base;
+        int i = 1;
+
+        log_base_PyLong_BASE[base] = (log((double)base) /
+                                      log((double)PyLong_BASE));
+        for (;;) {
+            twodigits next = convmax * base;
+            if (next > PyLong_BASE)
+                break;
+            convmax = next;
+            ++i;
         }
+        convmultmax_base[base] = convmax;
+        assert(i > 0);
+        convwidth_base[base] = i;
+    }
 
-        /* Find length of the string of numeric characters. */
-        scan = str;
-        while (_PyLong_DigitValue[Py_CHARMASK(*scan)] < base)
-            ++scan;
+    /* Create a long object that can contain the largest possible
+     * integer with this base and length.  Note that there's no
+     * need to initialize z->ob_digit -- no slot is read up before
+     * being stored into.
+     */
+    size_z = (Py_ssize_t)((scan - str) * log_base_PyLong_BASE[base]) + 1;
+    /* Uncomment next line to test exceedingly rare copy code */
+    /* size_z = 1; */
+    assert(size_z > 0);
+    z = _PyLong_New(size_z);
+    if (z == NULL)
+        return NULL;
+    Py_SIZE(z) = 0;
 
-        /* Create a long object that can contain the largest possible
-         * integer with this base and length.  Note that there's no
-         * need to initialize z->ob_digit -- no slot is read up before
-         * being stored into.
-         */
-        size_z = (Py_ssize_t)((scan - str) * log_base_PyLong_BASE[base]) + 1;
-        /* Uncomment next line to test exceedingly rare copy code */
-        /* size_z = 1; */
-        assert(size_z > 0);
-        z = _PyLong_New(size_z);
-        if (z == NULL)
-            return NULL;
-        Py_SIZE(z) = 0;
+    /* `convwidth` consecutive input digits are treated as a single
+     * digit in base `convmultmax`.
+     */
+    convwidth = convwidth_base[base];
+    convmultmax = convmultmax_base[base];
+
+    /* Work ;-) */
+    while (str < scan) {
+        /* grab up to convwidth digits from the input string */
+        c = (digit)_PyLong_DigitValue[Py_CHARMASK(*str++)];
+        for (i = 1; i < convwidth && str != scan; ++i, ++str) {
+            c = (twodigits)(c *  base +
+                            _PyLong_DigitValue[Py_CHARMASK(*str)]);
+            assert(c < PyLong_BASE);
+        }
 
-        /* `convwidth` consecutive input digits are treated as a single
-         * digit in base `convmultmax`.
+        convmult = convmultmax;
+        /* Calculate the shift only if we couldn't get
+         * convwidth digits.
          */
-        convwidth = convwidth_base[base];
-        convmultmax = convmultmax_base[base];
-
-        /* Work ;-) */
-        while (str < scan) {
-            /* grab up to convwidth digits from the input string */
-            c = (digit)_PyLong_DigitValue[Py_CHARMASK(*str++)];
-            for (i = 1; i < convwidth && str != scan; ++i, ++str) {
-                c = (twodigits)(c *  base +
-                                _PyLong_DigitValue[Py_CHARMASK(*str)]);
-                assert(c < PyLong_BASE);
-            }
-
-            convmult = convmultmax;
-            /* Calculate the shift only if we couldn't get
-             * convwidth digits.
-             */
-            if (i != convwidth) {
-                convmult = base;
-                for ( ; i > 1; --i)
-                    convmult *= base;
-            }
+        if (i != convwidth) {
+            convmult = base;
+            for ( ; i > 1; --i)
+                convmult *= base;
+        }
 
-            /* Multiply z by convmult, and add c. */
-            pz = z->ob_digit;
-            pzstop = pz + Py_SIZE(z);
-            for (; pz < pzstop; ++pz) {
-                c += (twodigits)*pz * convmult;
-                *pz = (digit)(c & PyLong_MASK);
-                c >>= PyLong_SHIFT;
+        /* Multiply z by convmult, and add c. */
+        pz = z->ob_digit;
+        pzstop = pz + Py_SIZE(z);
+        for (; pz < pzstop; ++pz) {
+            c += (twodigits)*pz * convmult;
+            *pz = (digit)(c & PyLong_MASK);
+            c >>= PyLong_SHIFT;
+        }
+        /* carry off the current end? */
+        if (c) {
+            assert(c < PyLong_BASE);
+            if (Py_SIZE(z) < size_z) {
+                *pz = (digit)c;
+                ++Py_SIZE(z);
             }
-            /* carry off the current end? */
-            if (c) {
-                assert(c < PyLong_BASE);
-                if (Py_SIZE(z) < size_z) {
-                    *pz = (digit)c;
-                    ++Py_SIZE(z);
-                }
-                else {
-                    PyLongObject *tmp;
-                    /* Extremely rare.  Get more space. */
-                    assert(Py_SIZE(z) == size_z);
-                    tmp = _PyLong_New(size_z + 1);
-                    if (tmp == NULL) {
-                        Py_DECREF(z);
-                        return NULL;
-                    }
-                    memcpy(tmp->ob_digit,
-                           z->ob_digit,
-                           sizeof(digit) * size_z);
+            else {
+                PyLongObject *tmp;
+                /* Extremely rare.  Get more space. */
+                assert(Py_SIZE(z) == size_z);
+                tmp = _PyLong_New(size_z + 1);
+                if (tmp == NULL) {
                     Py_DECREF(z);
-                    z = tmp;
-                    z->ob_digit[size_z] = (digit)c;
-                    ++size_z;
+                    return NULL;
                 }
+                memcpy(tmp->ob_digit,
+                       z->ob_digit,
+                       sizeof(digit) * size_z);
+                Py_DECREF(z);
+                z = tmp;
+                z->ob_digit[size_z] = (digit)c;
+                ++size_z;
             }
         }
     }
+    return z;
+}
+
+/* Convert the digits str[0:n] in the non-binary base `base`, where
+   n <= unit << k, to a nonnegative long.  Above k = 0, the digits are
+   split in halves, whose values are combined as hi * powers[k-1] + lo,
+   where powers[k-1] = base**(unit << (k-1)).  This takes a few times as
+   long as multiplying numbers of half the size of the result, where
+   long_from_non_binary_base takes time quadratic in n. */
+
+static PyLongObject *
+long_from_split_string(char *str, Py_ssize_t n, int base,
+                       PyLongObject **powers, int k, Py_ssize_t unit)
+{
+    PyLongObject *hi, *lo, *z;
+    Py_ssize_t half;
+
+    if (k == 0)
+        return long_from_non_binary_base(str, str + n, base);
+    half = unit << (k-1);
+    if (n <= half)
+        return long_from_split_string(str, n, base, powers, k-1, unit);
+    hi = long_from_split_string(str, n - half, base, powers, k-1, unit);
+    if (hi == NULL)
+        return NULL;
+    z = k_mul(hi, powers[k-1]);
+    Py_DECREF(hi);
+    if (z == NULL)
+        return NULL;
+    lo = long_from_split_string(str + n - half, half, base,
+                                powers, k-1, unit);
+    if (lo == NULL) {
+        Py_DECREF(z);
+        return NULL;
+    }
+    hi = z;
+    z = x_add(hi, lo);
+    Py_DECREF(hi);
+    Py_DECREF(lo);
+    return z;
+}
+
+/* Convert a long string of digits in a non-binary base, by splitting it
+   in pieces of unit = FROM_STRING_CUTOFF / 2 digits and combining them
+   with the powers base**(unit << k). */
+
+static PyLongObject *
+long_from_long_string(char *str, char *scan, int base)
+{
+    PyLongObject *powers[8 * sizeof(Py_ssize_t)];
+    PyLongObject *z = NULL;
+    const Py_ssize_t unit = FROM_STRING_CUTOFF / 2;
+    const Py_ssize_t n = scan - str;
+    int i, k = 0;
+
+    powers[0] = long_from_power((digit)base, (long)unit);
+    if (powers[0] == NULL)
+        return NULL;
+    while (unit << (k+1) < n) {
+        powers[k+1] = k_mul(powers[k], powers[k]);
+        if (powers[k+1] == NULL)
+            goto done;
+        k++;
+    }
+    z = long_from_split_string(str, n, base, powers, k+1, unit);
+  done:
+    for (i = 0; i <= k; i++)
+        Py_DECREF(powers[i]);
+    return z;
+}
+
+PyObject *
+PyLong_FromString(char *str, char **pend, int base)
+{
+    int sign = 1;
+    char *start, *orig_str = str;
+    PyLongObject *z;
+    PyObject *strobj, *strrepr;
+    Py_ssize_t slen;
+
+    if ((base != 0 && base < 2) || base > 36) {
+        PyErr_SetString(PyExc_ValueError,
+                        "long() arg 2 must be >= 2 and <= 36");
+        return NULL;
+    }
+    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
+        str++;
+    if (*str == '+')
+        ++str;
+    else if (*str == '-') {
+        ++str;
+        sign = -1;
+    }
+    while (*str != '\0' && isspace(Py_CHARMASK(*str)))
+        str++;
+    if (base == 0) {
+        /* No base given.  Deduce the base from the contents
+           of the string */
+        if (str[0] != '0')
+            base = 10;
+        else if (str[1] == 'x' || str[1] == 'X')
+            base = 16;
+        else if (str[1] == 'o' || str[1] == 'O')
+            base = 8;
+        else if (str[1] == 'b' || str[1] == 'B')
+            base = 2;
+        else
+            /* "old" (C-style) octal literal, still valid in
+               2.x, although illegal in 3.x */
+            base = 8;
+    }
+    /* Whether or not we were deducing the base, skip leading chars
+       as needed */
+    if (str[0] == '0' &&
+        ((base == 16 && (str[1] == 'x' || str[1] == 'X')) ||
+         (base == 8  && (str[1] == 'o' || str[1] == 'O')) ||
+         (base == 2  && (str[1] == 'b' || str[1] == 'B'))))
+        str += 2;
+
+    start = str;
+    if ((base & (base - 1)) == 0)
+        z = long_from_binary_base(&str, base);
+    else {
+        char *scan = str;
+
+        /* Find length of the string of numeric characters. */
+        while (_PyLong_DigitValue[Py_CHARMASK(*scan)] < base)
+            ++scan;
+        if (scan - str > FROM_STRING_CUTOFF)
+            z = long_from_long_string(str, scan, base);
+        else
+            z = long_from_non_binary_base(str, scan, base);
+        str = scan;
+    }
     if (z == NULL)
         return NULL;
     if (str == start)
@@ -1998,6 +2222,8 @@ PyLong_FromUnicode(Py_UNICODE *u, Py_ssize_t length, int base)
 /* forward */
 static PyLongObject *x_divrem
     (PyLongObject *, PyLongObject *, PyLongObject **);
+static PyLongObject *bz_divrem
+    (PyLongObject *, PyLongObject *, PyLongObject **);
 static PyObject *long_long(PyObject *v);
 
 /* Long division with remainder, top-level routine */
@@ -2036,6 +2262,11 @@ long_divrem(PyLongObject *a, PyLongObject *b,
             return -1;
         }
     }
+    else if (size_b > DIVIDE_CUTOFF && size_a - size_b > DIVIDE_CUTOFF) {
+        z = bz_divrem(a, b, prem);
+        if (z == NULL)
+            return -1;
+    }
     else {
         z = x_divrem(a, b, prem);
         if (z == NULL)
@@ -2672,6 +2903,7 @@ kmul_split(PyLongObject *n,
 }
 
 static PyLongObject *k_lopsided_mul(PyLongObject *a, PyLongObject *b);
+static PyLongObject *toom3_mul(PyLongObject *a, PyLongObject *b);
 
 /* Karatsuba multiplication.  Ignores the input signs, and returns the
  * absolute value of the product (or NULL if error).
@@ -2730,6 +2962,10 @@ k_mul(PyLongObject *a, PyLongObject *b)
     if (2 * asize <= bsize)
         return k_lopsided_mul(a, b);
 
+    /* Very large balanced operands go to Toom-Cook. */
+    if (asize > TOOM3_CUTOFF)
+        return toom3_mul(a, b);
+
     /* Split a & b into hi & lo pieces. */
     shift = bsize >> 1;
     if (kmul_split(a, shift, &ah, &al) < 0) goto fail;
@@ -2952,6 +3188,447 @@ k_lopsided_mul(PyLongObject *a, PyLongObject *b)
     return NULL;
 }
 
+/* Replace *x, which we own a reference to, by *x + y resp. *x - y
+ * (keeping signs), and release the old *x.  Return 0 on success, or -1
+ * with *x set to NULL on error.
+ */
+static int
+l_iadd(PyLongObject **x, PyLongObject *y)
+{
+    PyLongObject *z = (PyLongObject *)long_add(*x, y);
+
+    Py_DECREF(*x);
+    *x = z;
+    return z == NULL ? -1 : 0;
+}
+
+static int
+l_isub(PyLongObject **x, PyLongObject *y)
+{
+    PyLongObject *z = (PyLongObject *)long_sub(*x, y);
+
+    Py_DECREF(*x);
+    *x = z;
+    return z == NULL ? -1 : 0;
+}
+
+/* Helpers for toom3_mul.  toom3_split sets parts[0..2] such that
+ * abs(n) == (parts[2] << 2*size) + (parts[1] << size) + parts[0], viewing
+ * the shifts as being by digits.  toom3_eval evaluates the polynomial
+ * parts[0] + parts[1]*x + parts[2]*x**2 at x = 1, -1 and -2.  toom3_idiv
+ * replaces *x by *x / n, where n must divide *x exactly, keeping the sign.
+ */
+static int
+toom3_split(PyLongObject *n, Py_ssize_t size, PyLongObject **parts)
+{
+    PyLongObject *hi;
+
+    if (kmul_split(n, size, &hi, &parts[0]) < 0)
+        return -1;
+    if (kmul_split(hi, size, &parts[2], &parts[1]) < 0) {
+        Py_DECREF(hi);
+        Py_CLEAR(parts[0]);
+        return -1;
+    }
+    Py_DECREF(hi);
+    return 0;
+}
+
+static int
+toom3_idiv(PyLongObject **x, digit n)
+{
+    PyLongObject *z;
+    digit rem;
+
+    z = divrem1(*x, n, &rem);
+    assert(rem == 0);
+    if (z != NULL && Py_SIZE(*x) < 0)
+        Py_SIZE(z) = -Py_SIZE(z);
+    Py_DECREF(*x);
+    *x = z;
+    return z == NULL ? -1 : 0;
+}
+
+static int
+toom3_eval(PyLongObject **parts, PyLongObject **values)
+{
+    /* p(1) = (p0 + p2) + p1, p(-1) = (p0 + p2) - p1 and
+       p(-2) = 2 * (p(-1) + p2) - p0 */
+    values[0] = x_add(parts[0], parts[2]);
+    if (values[0] == NULL)
+        return -1;
+    values[1] = x_sub(values[0], parts[1]);
+    if (values[1] == NULL || l_iadd(&values[0], parts[1]) < 0)
+        goto fail;
+    values[2] = (PyLongObject *)long_add(values[1], parts[2]);
+    if (values[2] == NULL || l_iadd(&values[2], values[2]) < 0 ||
+        l_isub(&values[2], parts[0]) < 0)
+        goto fail;
+    return 0;
+
+  fail:
+    Py_CLEAR(values[0]);
+    Py_CLEAR(values[1]);
+    Py_CLEAR(values[2]);
+    return -1;
+}
+
+/* Toom-Cook 3-way multiplication.  Ignores the input signs, and returns the
+ * absolute value of the product (or NULL if error).  Called by k_mul for
+ * operands with asize <= bsize < 2*asize.
+ *
+ * Splitting both operands in three pieces of X = PyLong_BASE**shift digits
+ * makes them polynomials p and q of degree 2 evaluated at X, and their
+ * product the polynomial r = p*q of degree 4.  Its 5 coefficients follow
+ * from its values at 0, 1, -1, -2 and infinity (the product of the leading
+ * coefficients), which takes 5 recursive multiplications of numbers with
+ * shift digits.  The interpolation uses the sequence found by Marco Bodrato,
+ * with 2 exact divisions by 2 and 1 by 3.
+ */
+static PyLongObject *
+toom3_mul(PyLongObject *a, PyLongObject *b)
+{
+    const Py_ssize_t asize = ABS(Py_SIZE(a));
+    const Py_ssize_t bsize = ABS(Py_SIZE(b));
+    const Py_ssize_t shift = (bsize + 2) / 3;
+    PyLongObject *ap[3] = {NULL, NULL, NULL}, *bp[3] = {NULL, NULL, NULL};
+    PyLongObject *av[3] = {NULL, NULL, NULL}, *bv[3] = {NULL, NULL, NULL};
+    PyLongObject *r[5] = {NULL, NULL, NULL, NULL, NULL};
+    PyLongObject *rm1 = NULL, *rm2 = NULL, *ret = NULL;
+    Py_ssize_t i;
+
+    assert(asize > TOOM3_CUTOFF);
+    assert(asize <= bsize && bsize < 2 * asize);
+
+    /* Split and evaluate at 1, -1 and -2. */
+    if (toom3_split(a, shift, ap) < 0 || toom3_eval(ap, av) < 0)
+        goto fail;
+    if (a == b) {
+        for (i = 0; i < 3; i++) {
+            bp[i] = ap[i];
+            bv[i] = av[i];
+            Py_INCREF(bp[i]);
+            Py_INCREF(bv[i]);
+        }
+    }
+    else if (toom3_split(b, shift, bp) < 0 || toom3_eval(bp, bv) < 0)
+        goto fail;
+
+    /* The values of r at 0, 1, -1, -2 and infinity.  p(1) and q(1) are
+       nonnegative; k_mul ignores the signs of the others. */
+    if ((r[0] = k_mul(ap[0], bp[0])) == NULL ||
+        (r[1] = k_mul(av[0], bv[0])) == NULL ||
+        (rm1 = k_mul(av[1], bv[1])) == NULL ||
+        (rm2 = k_mul(av[2], bv[2])) == NULL ||
+        (r[4] = k_mul(ap[2], bp[2])) == NULL)
+        goto fail;
+    if ((Py_SIZE(av[1]) ^ Py_SIZE(bv[1])) < 0)
+        Py_SIZE(rm1) = -Py_SIZE(rm1);
+    if ((Py_SIZE(av[2]) ^ Py_SIZE(bv[2])) < 0)
+        Py_SIZE(rm2) = -Py_SIZE(rm2);
+
+    /* Interpolate:
+         r3 <- (r(-2) - r(1)) / 3
+         r1 <- (r(1) - r(-1)) / 2
+         r2 <- r(-1) - r(0)
+         r3 <- (r2 - r3) / 2 + 2 * r(inf)
+         r2 <- r2 + r1 - r(inf)
+         r1 <- r1 - r3 */
+    r[3] = rm2;
+    rm2 = NULL;
+    if (l_isub(&r[3], r[1]) < 0 || toom3_idiv(&r[3], 3) < 0)
+        goto fail;
+    if (l_isub(&r[1], rm1) < 0 || toom3_idiv(&r[1], 2) < 0)
+        goto fail;
+    r[2] = rm1;
+    rm1 = NULL;
+    if (l_isub(&r[2], r[0]) < 0)
+        goto fail;
+    if (l_isub(&r[3], r[2]) < 0)
+        goto fail;
+    Py_SIZE(r[3]) = -Py_SIZE(r[3]);
+    if (toom3_idiv(&r[3], 2) < 0 || l_iadd(&r[3], r[4]) < 0 ||
+        l_iadd(&r[3], r[4]) < 0)
+        goto fail;
+    if (l_iadd(&r[2], r[1]) < 0 || l_isub(&r[2], r[4]) < 0)
+        goto fail;
+    if (l_isub(&r[1], r[3]) < 0)
+        goto fail;
+
+    /* Add the coefficients into the result at multiples of shift.  They
+       are all nonnegative, and so each one fits where the product does. */
+    ret = _PyLong_New(asize + bsize);
+    if (ret == NULL)
+        goto fail;
+    memset(ret->ob_digit, 0, Py_SIZE(ret) * sizeof(digit));
+    for (i = 0; i < 5; i++) {
+        assert(Py_SIZE(r[i]) >= 0);
+        if (Py_SIZE(r[i]) > 0) {
+            assert(i * shift + Py_SIZE(r[i]) <= Py_SIZE(ret));
+            (void)v_iadd(ret->ob_digit + i * shift, Py_SIZE(ret) - i * shift,
+                         r[i]->ob_digit, Py_SIZE(r[i]));
+        }
+    }
+    long_normalize(ret);
+
+  fail:
+    for (i = 0; i < 3; i++) {
+        Py_XDECREF(ap[i]);
+        Py_XDECREF(bp[i]);
+        Py_XDECREF(av[i]);
+        Py_XDECREF(bv[i]);
+    }
+    for (i = 0; i < 5; i++)
+        Py_XDECREF(r[i]);
+    Py_XDECREF(rm1);
+    Py_XDECREF(rm2);
+    return ret;
+}
+
+/* Helpers for bz_divrem.  long_slice returns digits lo through hi-1 of
+ * abs(n) as a new nonnegative long.  long_join returns (hi << shift) + lo,
+ * viewing the shift as being by digits, for hi >= 0 and
+ * 0 <= lo < PyLong_BASE**shift; lo may be NULL for 0.
+ */
+static PyLongObject *
+long_slice(PyLongObject *n, Py_ssize_t lo, Py_ssize_t hi)
+{
+    PyLongObject *z;
+
+    hi = MIN(hi, ABS(Py_SIZE(n)));
+    lo = MIN(lo, hi);
+    z = _PyLong_New(hi - lo);
+    if (z == NULL)
+        return NULL;
+    memcpy(z->ob_digit, n->ob_digit + lo, (hi - lo) * sizeof(digit));
+    return long_normalize(z);
+}
+
+static PyLongObject *
+long_join(PyLongObject *hi, Py_ssize_t shift, PyLongObject *lo)
+{
+    const Py_ssize_t size_hi = Py_SIZE(hi);
+    const Py_ssize_t size_lo = lo == NULL ? 0 : Py_SIZE(lo);
+    PyLongObject *z;
+
+    assert(size_hi >= 0 && size_lo >= 0 && size_lo <= shift);
+    if (size_hi == 0) {
+        if (lo == NULL)
+            return _PyLong_New(0);
+        Py_INCREF(lo);
+        return lo;
+    }
+    z = _PyLong_New(shift + size_hi);
+    if (z == NULL)
+        return NULL;
+    if (size_lo)
+        memcpy(z->ob_digit, lo->ob_digit, size_lo * sizeof(digit));
+    memset(z->ob_digit + size_lo, 0, (shift - size_lo) * sizeof(digit));
+    memcpy(z->ob_digit + shift, hi->ob_digit, size_hi * sizeof(digit));
+    return z;
+}
+
+static int bz_div2n1n(PyLongObject *a, PyLongObject *b, Py_ssize_t n,
+                      PyLongObject **pq, PyLongObject **pr);
+
+/* Divide (a12 << n) + a3 by the 2n-digit b = (b1 << n) + b2, where
+ * a3 < PyLong_BASE**n, the quotient is known to fit in n digits and b is
+ * normalized.  The quotient estimated from the top digits is at most 2 too
+ * large.
+ */
+static int
+bz_div3n2n(PyLongObject *a12, PyLongObject *a3, PyLongObject *b,
+           PyLongObject *b1, PyLongObject *b2, Py_ssize_t n,
+           PyLongObject **pq, PyLongObject **pr)
+{
+    PyLongObject *q = NULL, *r = NULL, *t, *one = NULL;
+    Py_ssize_t i;
+    int cmp;
+
+    t = long_slice(a12, n, PY_SSIZE_T_MAX);
+    if (t == NULL)
+        return -1;
+    cmp = long_compare(t, b1);
+    Py_DECREF(t);
+    if (cmp == 0) {
+        /* q = PyLong_BASE**n - 1, r = a12 - (b1 << n) + b1 */
+        q = _PyLong_New(n);
+        if (q == NULL)
+            return -1;
+        for (i = 0; i < n; i++)
+            q->ob_digit[i] = PyLong_MASK;
+        t = long_join(b1, n, NULL);
+        if (t == NULL)
+            goto fail;
+        r = (PyLongObject *)long_sub(a12, t);
+        Py_DECREF(t);
+        if (r == NULL || l_iadd(&r, b1) < 0)
+            goto fail;
+    }
+    else if (bz_div2n1n(a12, b1, n, &q, &r) < 0)
+        return -1;
+
+    /* r = (r << n) + a3 - q*b2, corrected by adding b back */
+    t = long_join(r, n, a3);
+    Py_DECREF(r);
+    r = t;
+    if (r == NULL || (t = k_mul(q, b2)) == NULL)
+        goto fail;
+    cmp = l_isub(&r, t);
+    Py_DECREF(t);
+    if (cmp < 0)
+        goto fail;
+    while (Py_SIZE(r) < 0) {
+        if (one == NULL && (one = (PyLongObject *)PyLong_FromLong(1)) == NULL)
+            goto fail;
+        if (l_isub(&q, one) < 0 || l_iadd(&r, b) < 0)
+            goto fail;
+    }
+    Py_XDECREF(one);
+    *pq = q;
+    *pr = r;
+    return 0;
+
+  fail:
+    Py_XDECREF(q);
+    Py_XDECREF(r);
+    Py_XDECREF(one);
+    return -1;
+}
+
+/* Divide a by the n-digit b, where 0 <= a < b << n (shifting by digits)
+ * and the top digit of b has its top bit set.  Both halves of the
+ * quotient are found by bz_div3n2n, which recurses here with half as many
+ * digits.
+ */
+static int
+bz_div2n1n(PyLongObject *a, PyLongObject *b, Py_ssize_t n,
+           PyLongObject **pq, PyLongObject **pr)
+{
+    PyLongObject *a1 = NULL, *a2 = NULL, *b1 = NULL, *b2 = NULL;
+    PyLongObject *q1 = NULL, *q2 = NULL, *r = NULL;
+    Py_ssize_t half;
+    int status = -1;
+
+    if (n <= DIVIDE_CUTOFF)
+        return long_divrem(a, b, pq, pr);
+    if (n & 1) {
+        /* Multiply both by PyLong_BASE to get an even number of digits. */
+        if ((a1 = long_join(a, 1, NULL)) == NULL ||
+            (b1 = long_join(b, 1, NULL)) == NULL ||
+            bz_div2n1n(a1, b1, n + 1, pq, &r) < 0)
+            goto done;
+        if ((*pr = long_slice(r, 1, PY_SSIZE_T_MAX)) == NULL) {
+            Py_CLEAR(*pq);
+            goto done;
+        }
+        status = 0;
+        goto done;
+    }
+
+    half = n >> 1;
+    if ((b1 = long_slice(b, half, n)) == NULL ||
+        (b2 = long_slice(b, 0, half)) == NULL ||
+        (a1 = long_slice(a, n, PY_SSIZE_T_MAX)) == NULL ||
+        (a2 = long_slice(a, half, n)) == NULL ||
+        bz_div3n2n(a1, a2, b, b1, b2, half, &q1, &r) < 0)
+        goto done;
+    Py_DECREF(a1);
+    Py_DECREF(a2);
+    a1 = r;
+    r = NULL;
+    if ((a2 = long_slice(a, 0, half)) == NULL ||
+        bz_div3n2n(a1, a2, b, b1, b2, half, &q2, pr) < 0)
+        goto done;
+    if ((*pq = long_join(q1, half, q2)) == NULL) {
+        Py_CLEAR(*pr);
+        goto done;
+    }
+    status = 0;
+
+  done:
+    Py_XDECREF(a1);
+    Py_XDECREF(a2);
+    Py_XDECREF(b1);
+    Py_XDECREF(b2);
+    Py_XDECREF(q1);
+    Py_XDECREF(q2);
+    Py_XDECREF(r);
+    return status;
+}
+
+/* Unsigned long division with remainder, for large divisors and quotients:
+ * the recursive algorithm of Burnikel and Ziegler ("Fast Recursive
+ * Division", MPI-I-98-1-022).  v1 is shifted so that w1 gets a normalized
+ * top digit, and divided by it as a number in base PyLong_BASE**size_w,
+ * one big digit at a time.  Each step divides 2 big digits by one, which
+ * takes 2 recursive divisions and 2 multiplications of half the size.
+ */
+static PyLongObject *
+bz_divrem(PyLongObject *v1, PyLongObject *w1, PyLongObject **prem)
+{
+    const Py_ssize_t size_v = ABS(Py_SIZE(v1)), n = ABS(Py_SIZE(w1));
+    PyLongObject *v = NULL, *w = NULL, *q = NULL, *r = NULL;
+    PyLongObject *t, *qi;
+    Py_ssize_t i, nchunks;
+    int d;
+
+    assert(size_v > n && n >= 2);
+    *prem = NULL;
+    d = PyLong_SHIFT - bits_in_digit(w1->ob_digit[n-1]);
+    if ((w = _PyLong_New(n)) == NULL || (v = _PyLong_New(size_v + 1)) == NULL)
+        goto fail;
+    (void)v_lshift(w->ob_digit, w1->ob_digit, n, d);
+    v->ob_digit[size_v] = v_lshift(v->ob_digit, v1->ob_digit, size_v, d);
+    long_normalize(v);
+
+    nchunks = (Py_SIZE(v) + n - 1) / n;
+    if ((q = _PyLong_New(nchunks * n)) == NULL ||
+        (r = _PyLong_New(0)) == NULL)
+        goto fail;
+    memset(q->ob_digit, 0, Py_SIZE(q) * sizeof(digit));
+    for (i = nchunks; --i >= 0; ) {
+        /* (r << n) + the next chunk of v is less than w << n */
+        if ((qi = long_slice(v, i * n, (i + 1) * n)) == NULL)
+            goto fail;
+        t = long_join(r, n, qi);
+        Py_DECREF(qi);
+        Py_DECREF(r);
+        r = NULL;
+        if (t == NULL)
+            goto fail;
+        if (bz_div2n1n(t, w, n, &qi, &r) < 0) {
+            Py_DECREF(t);
+            goto fail;
+        }
+        Py_DECREF(t);
+        assert(Py_SIZE(qi) <= n);
+        memcpy(q->ob_digit + i * n, qi->ob_digit,
+               Py_SIZE(qi) * sizeof(digit));
+        Py_DECREF(qi);
+        SIGCHECK({
+                goto fail;
+            });
+    }
+
+    /* unshift the remainder */
+    if ((t = _PyLong_New(Py_SIZE(r))) == NULL)
+        goto fail;
+    (void)v_rshift(t->ob_digit, r->ob_digit, Py_SIZE(r), d);
+    *prem = long_normalize(t);
+    Py_DECREF(v);
+    Py_DECREF(w);
+    Py_DECREF(r);
+    return long_normalize(q);
+
+  fail:
+    Py_XDECREF(v);
+    Py_XDECREF(w);
+    Py_XDECREF(q);
+    Py_XDECREF(r);
+    return NULL;
+}
+
 static PyObject *
 long_mul(PyLongObject *v, PyLongObject *w)
 {
@@ -123,6 +123,14 @@ PyCFunction_Call(PyObject *func, PyObject *arg, PyObject *kw)
             return NULL;
         }
         break;
+    case METH_FASTCALL:
+        if (kw == NULL || PyDict_Size(kw) == 0)
+            WRAP_RETURN( (*(_PyCFunctionFast)meth)(self,
+                &PyTuple_GET_ITEM(arg, 0), PyTuple_GET_SIZE(arg)) )
+        break;
+    case METH_FASTCALL | METH_KEYWORDS:
+        WRAP_RETURN( (*(_PyCFunctionFastWithKeywords)meth)(self,
+            &PyTuple_GET_ITEM(arg, 0), PyTuple_GET_SIZE(arg), kw) )
     case METH_OLDARGS:
         /* the really old style */
         if (kw == NULL || PyDict_Size(kw) == 0) {
@@ -143,6 +151,32 @@ PyCFunction_Call(PyObject *func, PyObject *arg, PyObject *kw)
     return NULL;
 }
 
+PyObject *
+_PyMethodDef_FastCall(PyMethodDef *ml, PyObject *self, PyObject **args,
+                      Py_ssize_t nargs, PyObject *kw)
+{
+    STACKLESS_GETARG();
+    PyObject *retval;
+
+    assert(ml->ml_flags & METH_FASTCALL);
+    if (ml->ml_flags & METH_KEYWORDS) {
+        STACKLESS_PROMOTE_FLAG(ml->ml_flags & METH_STACKLESS);
+        retval = (*(_PyCFunctionFastWithKeywords)ml->ml_meth)(self,
+            args, nargs, kw);
+    }
+    else if (kw == NULL || PyDict_Size(kw) == 0) {
+        STACKLESS_PROMOTE_FLAG(ml->ml_flags & METH_STACKLESS);
+        retval = (*(_PyCFunctionFast)ml->ml_meth)(self, args, nargs);
+    }
+    else {
+        PyErr_Format(PyExc_TypeError,
+                     "%.200s() takes no keyword arguments", ml->ml_name);
+        return NULL;
+    }
+    STACKLESS_ASSERT();
+    return retval;
+}
+
 /* Methods (the standard built-in methods, that is) */
 
 static void
@@ -96,6 +96,27 @@ PyModule_GetFilename(PyObject *m)
     return PyString_AsString(fileobj);
 }
 
+/* Replace the value of one name with None, if the pass clears it. */
+static void
+module_clear_name(PyObject *d, PyObject *key, int pass)
+{
+    PyObject *value;
+    char *s;
+
+    if (!PyString_Check(key))
+        return;
+    value = PyDict_GetItem(d, key);
+    if (value == NULL || value == Py_None)
+        return;
+    s = PyString_AS_STRING(key);
+    if (pass == 1 ? s[0] == '_' && s[1] != '_'
+                  : s[0] != '_' || strcmp(s, "__builtins__") != 0) {
+        if (Py_VerboseFlag > 1)
+            PySys_WriteStderr("#   clear[%d] %s\n", pass, s);
+        PyDict_SetItem(d, key, Py_None);
+    }
+}
+
 void
 _PyModule_Clear(PyObject *m)
 {
@@ -104,41 +125,38 @@ _PyModule_Clear(PyObject *m)
        whose name starts with a single underscore, before we clear
        the entire dictionary.  We zap them by replacing them with
        None, rather than deleting them from the dictionary, to
-       avoid rehashing the dictionary (to some extent). */
+       avoid rehashing the dictionary (to some extent).
+
+       Within each pass the names are cleared in reverse insertion
+       order, latest binding first, so that the destructor of a
+       global object can still use the globals bound before it. */
 
     Py_ssize_t pos;
     PyObject *key, *value;
-    PyObject *d;
+    PyObject *d, *keys;
+    int pass;
 
     d = ((PyModuleObject *)m)->md_dict;
     if (d == NULL)
         return;
 
-    /* First, clear only names starting with a single underscore */
-    pos = 0;
-    while (PyDict_Next(d, &pos, &key, &value)) {
-        if (value != Py_None && PyString_Check(key)) {
-            char *s = PyString_AsString(key);
-            if (s[0] == '_' && s[1] != '_') {
-                if (Py_VerboseFlag > 1)
-                    PySys_WriteStderr("#   clear[1] %s\n", s);
-                PyDict_SetItem(d, key, Py_None);
-            }
+    /* First, clear only names starting with a single underscore.
+       Next, clear all names except for __builtins__ */
+    keys = PyDict_Keys(d);
+    if (keys == NULL)
+        PyErr_Clear();
+    for (pass = 1; pass <= 2; ++pass) {
+        if (keys != NULL) {
+            for (pos = PyList_GET_SIZE(keys); --pos >= 0; )
+                module_clear_name(d, PyList_GET_ITEM(keys, pos), pass);
         }
-    }
-
-    /* Next, clear all names except for __builtins__ */
-    pos = 0;
-    while (PyDict_Next(d, &pos, &key, &value)) {
-        if (value != Py_None && PyString_Check(key)) {
-            char *s = PyString_AsString(key);
-            if (s[0] != '_' || strcmp(s, "__builtins__") != 0) {
-                if (Py_VerboseFlag > 1)
-                    PySys_WriteStderr("#   clear[2] %s\n", s);
-                PyDict_SetItem(d, key, Py_None);
-            }
+        else {
+            pos = 0;
+            while (PyDict_Next(d, &pos, &key, &value))
+                module_clear_name(d, key, pass);
         }
     }
+    Py_XDECREF(keys);
 
     /* Note: we leave __builtins__ in place, so that destructors
        of non-global objects defined in this module can still use
@@ -2,6 +2,19 @@
 
 #ifdef WITH_PYMALLOC
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(_POSIX_MAPPED_FILES) && !defined(MS_WINDOWS)
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifdef MAP_ANONYMOUS
+#define ARENAS_USE_MMAP
+#endif
+#endif
+
 #ifdef WITH_VALGRIND
 #include <valgrind/valgrind.h>
 
@@ -149,6 +162,10 @@ static int running_on_valgrind = -1;
 #define SMALL_REQUEST_THRESHOLD 256
 #define NB_SMALL_SIZE_CLASSES   (SMALL_REQUEST_THRESHOLD / ALIGNMENT)
 
+#if NB_SMALL_SIZE_CLASSES > PyMalloc_MAX_CLASSES
+#error "too many size classes for _PyMallocStats"
+#endif
+
 /*
  * The system's VMM page size can be obtained on most unices with a
  * getpagesize() call or deduced from various header files. To make
@@ -159,7 +176,9 @@ static int running_on_valgrind = -1;
  * violation fault.  4K is apparently OK for all the platforms that python
  * currently targets.
  */
+#ifndef SYSTEM_PAGE_SIZE
 #define SYSTEM_PAGE_SIZE        (4 * 1024)
+#endif
 #define SYSTEM_PAGE_SIZE_MASK   (SYSTEM_PAGE_SIZE - 1)
 
 /*
@@ -182,20 +201,43 @@ static int running_on_valgrind = -1;
  *
  * Therefore, allocating arenas with malloc is not optimal, because there is
  * some address space wastage, but this is the most portable way to request
- * memory from the system across various platforms.
+ * memory from the system across various platforms.  It also lets the C
+ * library keep the memory of freed arenas for the next ones, instead of
+ * the system handing out (and faulting in) fresh pages every time.  Only
+ * huge page arenas, which must be aligned, are mapped directly (see
+ * arena_map()).
+ *
+ * ARENA_SIZE is the default.  The size in use is arena_size, which can be
+ * set at startup with PYTHONARENASIZE, to a power of 2 between
+ * MIN_ARENA_SIZE and MAX_ARENA_SIZE.  A big heap in small arenas spreads
+ * over many mappings; bigger arenas, backed by huge pages where the system
+ * has them (PYTHONHUGEPAGES), take fewer TLB entries.  HUGE_PAGE_SIZE is
+ * the size and alignment of such arenas.
  */
 #define ARENA_SIZE              (256 << 10)     /* 256KB */
+#define MIN_ARENA_SIZE          (64 << 10)      /* 64KB */
+#define MAX_ARENA_SIZE          (1 << 30)       /* 1GB */
+#define HUGE_PAGE_SIZE          (2 << 20)       /* 2MB */
 
 #ifdef WITH_MEMORY_LIMITS
-#define MAX_ARENAS              (SMALL_MEMORY_LIMIT / ARENA_SIZE)
+#define MAX_ARENAS              (SMALL_MEMORY_LIMIT / arena_size)
 #endif
 
 /*
  * Size of the pools used for small blocks. Should be a power of 2,
- * between 1K and SYSTEM_PAGE_SIZE, that is: 1k, 2k, 4k.
+ * between 1K and SYSTEM_PAGE_SIZE, that is: 1k, 2k, 4k with the default
+ * page size.  It is the page size unless defined otherwise.  A pool may
+ * not be larger than a page: POOL_ADDR() of an address obmalloc does not
+ * control must stay on a page that is mapped (see Py_ADDRESS_IN_RANGE).
  */
+#ifndef POOL_SIZE
 #define POOL_SIZE               SYSTEM_PAGE_SIZE        /* must be 2^N */
-#define POOL_SIZE_MASK          SYSTEM_PAGE_SIZE_MASK
+#endif
+#define POOL_SIZE_MASK          (POOL_SIZE - 1)
+
+#if POOL_SIZE > SYSTEM_PAGE_SIZE || MIN_ARENA_SIZE < 4 * POOL_SIZE
+#error "POOL_SIZE must be at most SYSTEM_PAGE_SIZE and MIN_ARENA_SIZE / 4"
+#endif
 
 /*
  * -- End of tunable settings section --
@@ -505,14 +547,108 @@ static struct arena_object* usable_arenas = NULL;
  */
 #define INITIAL_ARENA_OBJECTS 16
 
+/* The size of every arena, and whether arenas are mapped on huge pages.
+ * Both are set by configure_arenas() before the first arena is allocated,
+ * and never change afterwards.
+ */
+static size_t arena_size = ARENA_SIZE;
+static int arena_hugepages = 0;
+
 /* Number of arenas allocated that haven't been free()'d. */
 static size_t narenas_currently_allocated = 0;
 
-#ifdef PYMALLOC_DEBUG
 /* Total number of times malloc() called to allocate an arena. */
 static size_t ntimes_arena_allocated = 0;
 /* High water mark (max value ever seen) for narenas_currently_allocated. */
 static size_t narenas_highwater = 0;
+
+/* Parse a PYTHONARENASIZE value: a number of bytes, optionally followed by
+ * k or m for KB or MB.  Return it rounded up to a power of 2, or 0 if it
+ * isn't a number or is out of range.
+ */
+static size_t
+parse_arena_size(const char *s)
+{
+    char *end;
+    unsigned long n;
+    size_t size;
+    int shift = 0;
+
+    n = strtoul(s, &end, 10);
+    if (end == s)
+        return 0;
+    if (*end == 'k' || *end == 'K')
+        shift = 10;
+    else if (*end == 'm' || *end == 'M')
+        shift = 20;
+    if (shift)
+        ++end;
+    if (*end != '\0' || n == 0 || n > (MAX_ARENA_SIZE >> shift))
+        return 0;
+    n <<= shift;
+    for (size = MIN_ARENA_SIZE; size < n; size <<= 1)
+        ;
+    return size;
+}
+
+/* Read the arena settings from the environment.  This runs when the first
+ * arena is allocated; the settings must not change once there are arenas,
+ * since Py_ADDRESS_IN_RANGE checks every address against arena_size.
+ */
+static void
+configure_arenas(void)
+{
+    char *p;
+    size_t size = 0;
+
+    if ((p = Py_GETENV("PYTHONARENASIZE")) && *p != '\0')
+        size = parse_arena_size(p);
+    if ((p = Py_GETENV("PYTHONHUGEPAGES")) && *p != '\0') {
+#ifdef ARENAS_USE_MMAP
+        arena_hugepages = 1;
+        if (size < HUGE_PAGE_SIZE)
+            size = HUGE_PAGE_SIZE;
+#endif
+    }
+    if (size != 0)
+        arena_size = size;
+}
+
+#ifdef ARENAS_USE_MMAP
+/* Map a huge page arena of arena_size bytes, or return NULL.  Map
+ * HUGE_PAGE_SIZE more than needed and unmap what lies outside the aligned
+ * arena, so that the system can back all of it with huge pages.
+ * MADV_HUGEPAGE asks for that where transparent huge pages are only used
+ * on request; elsewhere the alignment alone lets them be used.
+ */
+static void *
+arena_map(void)
+{
+    size_t extra = HUGE_PAGE_SIZE;
+    uchar *p, *arena;
+
+    p = (uchar *)mmap(NULL, arena_size + extra, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == (uchar *)MAP_FAILED)
+        return NULL;
+    arena = (uchar *)(((uptr)p + HUGE_PAGE_SIZE - 1) &
+                      ~(uptr)(HUGE_PAGE_SIZE - 1));
+    if (arena != p)
+        munmap(p, arena - p);
+    if (arena != p + extra)
+        munmap(arena + arena_size, p + extra - arena);
+#ifdef MADV_HUGEPAGE
+    madvise(arena, arena_size, MADV_HUGEPAGE);
+#endif
+    return arena;
+}
+
+#define ARENA_ALLOC()   (arena_hugepages ? arena_map() : malloc(arena_size))
+#define ARENA_FREE(p)   (arena_hugepages ? (void)munmap((p), arena_size) : \
+                                           free(p))
+#else
+#define ARENA_ALLOC()   malloc(arena_size)
+#define ARENA_FREE(p)   free(p)
 #endif
 
 /* Allocate a new arena.  If we run out of memory, return NULL.  Else
@@ -535,6 +671,8 @@ new_arena(void)
         uint numarenas;
         size_t nbytes;
 
+        if (maxarenas == 0)
+            configure_arenas();
         /* Double the number of arena objects on each allocation.
          * Note that it's possible for `numarenas` to overflow.
          */
@@ -577,7 +715,7 @@ new_arena(void)
     arenaobj = unused_arena_objects;
     unused_arena_objects = arenaobj->nextarena;
     assert(arenaobj->address == 0);
-    arenaobj->address = (uptr)malloc(ARENA_SIZE);
+    arenaobj->address = (uptr)ARENA_ALLOC();
     if (arenaobj->address == 0) {
         /* The allocation failed: return NULL after putting the
          * arenaobj back.
@@ -588,17 +726,15 @@ new_arena(void)
     }
 
     ++narenas_currently_allocated;
-#ifdef PYMALLOC_DEBUG
     ++ntimes_arena_allocated;
     if (narenas_currently_allocated > narenas_highwater)
         narenas_highwater = narenas_currently_allocated;
-#endif
     arenaobj->freepools = NULL;
     /* pool_address <- first pool-aligned address in the arena
        nfreepools <- number of whole pools that fit after alignment */
     arenaobj->pool_address = (block*)arenaobj->address;
-    arenaobj->nfreepools = ARENA_SIZE / POOL_SIZE;
-    assert(POOL_SIZE * arenaobj->nfreepools == ARENA_SIZE);
+    arenaobj->nfreepools = (uint)(arena_size / POOL_SIZE);
+    assert(POOL_SIZE * arenaobj->nfreepools == arena_size);
     excess = (uint)(arenaobj->address & POOL_SIZE_MASK);
     if (excess != 0) {
         --arenaobj->nfreepools;
@@ -622,11 +758,11 @@ called on every alloc/realloc/free, micro-efficiency is important here).
 Tricky:  Let B be the arena base address associated with the pool, B =
 arenas[(POOL)->arenaindex].address.  Then P belongs to the arena if and only if
 
-    B <= P < B + ARENA_SIZE
+    B <= P < B + arena_size
 
 Subtracting B throughout, this is true iff
 
-    0 <= P-B < ARENA_SIZE
+    0 <= P-B < arena_size
 
 By using unsigned arithmetic, the "0 <=" half of the test can be skipped.
 
@@ -639,7 +775,7 @@ into a NULL arenas.
 Details:  given P and POOL, the arena_object corresponding to P is AO =
 arenas[(POOL)->arenaindex].  Suppose obmalloc controls P.  Then (barring wild
 stores, etc), POOL is the correct address of P's pool, AO.address is the
-correct base address of the pool's arena, and P must be within ARENA_SIZE of
+correct base address of the pool's arena, and P must be within arena_size of
 AO.address.  In addition, AO.address is not 0 (no arena can start at address 0
 (NULL)).  Therefore Py_ADDRESS_IN_RANGE correctly reports that obmalloc
 controls P.
@@ -652,7 +788,7 @@ control P.
 
 Else arenaindex is < maxarena, and AO is read up.  If AO corresponds to an
 allocated arena, obmalloc controls all the memory in slice AO.address :
-AO.address+ARENA_SIZE.  By case assumption, P is not controlled by obmalloc,
+AO.address+arena_size.  By case assumption, P is not controlled by obmalloc,
 so P doesn't lie in that slice, so the macro correctly reports that P is not
 controlled by obmalloc.
 
@@ -660,19 +796,19 @@ Finally, if P is not controlled by obmalloc and AO corresponds to an unused
 arena_object (one not currently associated with an allocated arena),
 AO.address is 0, and the second test in the macro reduces to:
 
-    P < ARENA_SIZE
+    P < arena_size
 
-If P >= ARENA_SIZE (extremely likely), the macro again correctly concludes
-that P is not controlled by obmalloc.  However, if P < ARENA_SIZE, this part
+If P >= arena_size (extremely likely), the macro again correctly concludes
+that P is not controlled by obmalloc.  However, if P < arena_size, this part
 of the test still passes, and the third clause (AO.address != 0) is necessary
 to get the correct result:  AO.address is 0 in this case, so the macro
 correctly reports that P is not controlled by obmalloc (despite that P lies in
-slice AO.address : AO.address + ARENA_SIZE).
+slice AO.address : AO.address + arena_size).
 
 Note:  The third (AO.address != 0) clause was added in Python 2.5.  Before
 2.5, arenas were never free()'ed, and an arenaindex < maxarena always
 corresponded to a currently-allocated arena, so the "P is not controlled by
-obmalloc, AO corresponds to an unused arena_object, and P < ARENA_SIZE" case
+obmalloc, AO corresponds to an unused arena_object, and P < arena_size" case
 was impossible.
 
 Note that the logic is excruciating, and reading up possibly uninitialized
@@ -685,7 +821,7 @@ extremely desirable that it be this fast.
 */
 #define Py_ADDRESS_IN_RANGE(P, POOL)                    \
     ((POOL)->arenaindex < maxarenas &&                  \
-     (uptr)(P) - arenas[(POOL)->arenaindex].address < (uptr)ARENA_SIZE && \
+     (uptr)(P) - arenas[(POOL)->arenaindex].address < (uptr)arena_size && \
      arenas[(POOL)->arenaindex].address != 0)
 
 
@@ -722,6 +858,134 @@ int Py_ADDRESS_IN_RANGE(void *P, poolp pool) Py_NO_INLINE;
 
 /*==========================================================================*/
 
+/*
+ * Allocation site sampling.
+ *
+ * When _PyObject_SetMallocSampling(rate, sampler) is on, every rate'th
+ * small allocation is a sample: sampler->where() gives the site, a key and
+ * a line (sys.setmallocsampling() uses the code object of the innermost
+ * Python frame), which is looked up in sample_sites with the block's size
+ * class, and the block is remembered in sample_blocks until it is freed.
+ * Each site counts the sampled blocks allocated there and those still
+ * alive, so that a size class that keeps growing can be traced to the code
+ * filling it.  This file is also linked into pgen, so it knows nothing of
+ * frames and code objects itself.
+ *
+ * Both tables are open addressed and are malloc'ed when sampling starts;
+ * they must not use the object allocator they are watching.  Sites are
+ * never removed while sampling is on, and hold on to their key through
+ * sampler->hold().  Blocks are removed with backward shifting, so that no
+ * tombstones are needed.  A sample that finds a table three quarters full
+ * is dropped and counted in sample_lost.
+ *
+ * When sampling is off, sample_countdown is PY_SSIZE_T_MAX and
+ * sample_nblocks is 0, so the cost is a decrement in PyObject_Malloc and a
+ * test in PyObject_Free.
+ */
+#define SAMPLE_SITES            4096            /* must be 2^N */
+#define SAMPLE_BLOCKS           (1 << 16)       /* must be 2^N */
+
+struct sample_site {
+    void *key;                  /* NULL for an unknown site */
+    int lineno;
+    uint szidx;
+    size_t allocated;           /* sampled blocks allocated, 0 if unused */
+    size_t live;                /* of those, not yet freed */
+};
+
+struct sample_block {
+    block *bp;                  /* NULL if unused */
+    struct sample_site *site;
+};
+
+static Py_ssize_t sample_rate = 0;
+static Py_ssize_t sample_countdown = PY_SSIZE_T_MAX;
+static _PyMallocSampler sampler;
+static struct sample_site *sample_sites = NULL;
+static size_t sample_nsites = 0;
+static struct sample_block *sample_blocks = NULL;
+static size_t sample_nblocks = 0;
+static size_t sample_lost = 0;
+
+#define SITE_HASH(KEY, LINENO, SZIDX) \
+    ((size_t)((uptr)(KEY) >> 4) ^ (size_t)(LINENO) * 31 ^ (size_t)(SZIDX) << 12)
+#define BLOCK_HASH(BP) ((size_t)((uptr)(BP) >> ALIGNMENT_SHIFT) * 2654435761UL)
+
+/* Record the sampled block bp of size class szidx. */
+static void
+record_sample(block *bp, uint szidx)
+{
+    int lineno = 0;
+    void *key = sampler.where(&lineno);
+    struct sample_site *site;
+    size_t i;
+
+    if (sample_nblocks >= SAMPLE_BLOCKS / 4 * 3) {
+        ++sample_lost;
+        return;
+    }
+    i = SITE_HASH(key, lineno, szidx);
+    for (;;) {
+        site = &sample_sites[i & (SAMPLE_SITES - 1)];
+        if (site->allocated == 0) {
+            if (sample_nsites >= SAMPLE_SITES / 4 * 3) {
+                ++sample_lost;
+                return;
+            }
+            ++sample_nsites;
+            if (key != NULL)
+                sampler.hold(key, 1);
+            site->key = key;
+            site->lineno = lineno;
+            site->szidx = szidx;
+            break;
+        }
+        if (site->key == key && site->lineno == lineno &&
+            site->szidx == szidx)
+            break;
+        ++i;
+    }
+    ++site->allocated;
+    ++site->live;
+
+    i = BLOCK_HASH(bp);
+    while (sample_blocks[i & (SAMPLE_BLOCKS - 1)].bp != NULL)
+        ++i;
+    sample_blocks[i & (SAMPLE_BLOCKS - 1)].bp = bp;
+    sample_blocks[i & (SAMPLE_BLOCKS - 1)].site = site;
+    ++sample_nblocks;
+}
+
+/* The block bp is freed: forget it if it is a sample. */
+static void
+forget_sample(block *bp)
+{
+    const size_t mask = SAMPLE_BLOCKS - 1;
+    size_t i, j, k;
+
+    i = BLOCK_HASH(bp) & mask;
+    while (sample_blocks[i].bp != bp) {
+        if (sample_blocks[i].bp == NULL)
+            return;
+        i = (i + 1) & mask;
+    }
+    --sample_blocks[i].site->live;
+    --sample_nblocks;
+    /* Move back the entries after i that would no longer be found. */
+    for (j = (i + 1) & mask; sample_blocks[j].bp != NULL; j = (j + 1) & mask) {
+        k = BLOCK_HASH(sample_blocks[j].bp) & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        sample_blocks[i] = sample_blocks[j];
+        i = j;
+    }
+    sample_blocks[i].bp = NULL;
+}
+
+static void *sample_malloc(size_t nbytes);
+
+/*==========================================================================*/
+
 /* malloc.  Note that nbytes==0 tries to return a non-NULL pointer, distinct
  * from all other currently live pointers.  This may not be possible.
  */
@@ -763,6 +1027,8 @@ PyObject_Malloc(size_t nbytes)
      * This implicitly redirects malloc(0).
      */
     if ((nbytes - 1) < SMALL_REQUEST_THRESHOLD) {
+        if (--sample_countdown == 0)
+            return sample_malloc(nbytes);
         LOCK();
         /*
          * Most frequent paths first
@@ -859,7 +1125,7 @@ PyObject_Malloc(size_t nbytes)
                 assert(usable_arenas->freepools != NULL ||
                        usable_arenas->pool_address <=
                        (block*)usable_arenas->address +
-                           ARENA_SIZE - POOL_SIZE);
+                           arena_size - POOL_SIZE);
             }
         init_pool:
             /* Frontlink to used pools. */
@@ -900,7 +1166,7 @@ PyObject_Malloc(size_t nbytes)
         assert(usable_arenas->freepools == NULL);
         pool = (poolp)usable_arenas->pool_address;
         assert((block*)pool <= (block*)usable_arenas->address +
-                               ARENA_SIZE - POOL_SIZE);
+                               arena_size - POOL_SIZE);
         pool->arenaindex = usable_arenas - arenas;
         assert(&arenas[pool->arenaindex] == usable_arenas);
         pool->szidx = DUMMY_SIZE_IDX;
@@ -935,6 +1201,24 @@ redirect:
     return (void *)malloc(nbytes);
 }
 
+/* Allocate a block that is a sample of the allocation sites. */
+static void *
+sample_malloc(size_t nbytes)
+{
+    block *bp;
+    poolp pool;
+
+    sample_countdown = PY_SSIZE_T_MAX;
+    bp = (block *)PyObject_Malloc(nbytes);
+    if (sample_rate == 0)
+        return bp;
+    sample_countdown = sample_rate;
+    pool = POOL_ADDR(bp);
+    if (bp != NULL && Py_ADDRESS_IN_RANGE(bp, pool))
+        record_sample(bp, pool->szidx);
+    return bp;
+}
+
 /* free */
 
 #undef PyObject_Free
@@ -958,6 +1242,8 @@ PyObject_Free(void *p)
     if (Py_ADDRESS_IN_RANGE(p, pool)) {
         /* We allocated this address. */
         LOCK();
+        if (sample_nblocks != 0)
+            forget_sample((block *)p);
         /* Link p to the start of the pool's freeblock list.  Since
          * the pool had at least the p block outstanding, the pool
          * wasn't empty (so it's already in a usedpools[] list, or
@@ -1043,7 +1329,7 @@ PyObject_Free(void *p)
                 unused_arena_objects = ao;
 
                 /* Free the entire arena. */
-                free((void *)ao->address);
+                ARENA_FREE((void *)ao->address);
                 ao->address = 0;                        /* mark unassociated */
                 --narenas_currently_allocated;
 
@@ -1238,6 +1524,194 @@ PyObject_Realloc(void *p, size_t nbytes)
     return bp ? bp : p;
 }
 
+#ifdef Py_DEBUG
+/* Is target in the list?  The list is traversed via the nextpool pointers.
+ * The list may be NULL-terminated, or circular.  Return 1 if target is in
+ * list, else 0.
+ */
+static int
+pool_is_in_list(const poolp target, poolp list)
+{
+    poolp origlist = list;
+    assert(target != NULL);
+    if (list == NULL)
+        return 0;
+    do {
+        if (target == list)
+            return 1;
+        list = list->nextpool;
+    } while (list != NULL && list != origlist);
+    return 0;
+}
+
+#else
+#define pool_is_in_list(X, Y) 1
+
+#endif  /* Py_DEBUG */
+
+/* Walk all arenas and count the pools, the allocated blocks and the free
+ * blocks of every size class, and the free pools.  Full pools aren't
+ * linked to from anything, so this is the only way to find them.  Return
+ * the number of allocated arenas.  If arena_alignment isn't NULL, add the
+ * bytes lost to aligning the arenas' pools.
+ */
+static size_t
+count_blocks(size_t *numpools, size_t *numblocks, size_t *numfreeblocks,
+             size_t *numfreepools, size_t *arena_alignment)
+{
+    uint i;
+    size_t narenas = 0;
+
+    for (i = 0; i < NB_SMALL_SIZE_CLASSES; ++i)
+        numpools[i] = numblocks[i] = numfreeblocks[i] = 0;
+    *numfreepools = 0;
+
+    for (i = 0; i < maxarenas; ++i) {
+        uptr base = arenas[i].address;
+
+        /* Skip arenas which are not allocated. */
+        if (arenas[i].address == (uptr)NULL)
+            continue;
+        narenas += 1;
+
+        *numfreepools += arenas[i].nfreepools;
+
+        /* round up to pool alignment */
+        if (base & (uptr)POOL_SIZE_MASK) {
+            if (arena_alignment != NULL)
+                *arena_alignment += POOL_SIZE;
+            base &= ~(uptr)POOL_SIZE_MASK;
+            base += POOL_SIZE;
+        }
+
+        /* visit every pool in the arena */
+        assert(base <= (uptr) arenas[i].pool_address);
+        for (; base < (uptr) arenas[i].pool_address; base += POOL_SIZE) {
+            poolp p = (poolp)base;
+            const uint sz = p->szidx;
+            uint freeblocks;
+
+            if (p->ref.count == 0) {
+                /* currently unused */
+                assert(pool_is_in_list(p, arenas[i].freepools));
+                continue;
+            }
+            ++numpools[sz];
+            numblocks[sz] += p->ref.count;
+            freeblocks = NUMBLOCKS(sz) - p->ref.count;
+            numfreeblocks[sz] += freeblocks;
+#ifdef Py_DEBUG
+            if (freeblocks > 0)
+                assert(pool_is_in_list(p, usedpools[sz + sz]));
+#endif
+        }
+    }
+    assert(narenas == narenas_currently_allocated);
+    return narenas;
+}
+
+/* Fill in the statistics of sys.getmallocstats(). */
+void
+_PyObject_GetMallocStats(_PyMallocStats *stats)
+{
+    size_t numpools[NB_SMALL_SIZE_CLASSES];
+    size_t numblocks[NB_SMALL_SIZE_CLASSES];
+    size_t numfreeblocks[NB_SMALL_SIZE_CLASSES];
+    uint i;
+
+    stats->arena_size = arena_size;
+    stats->pool_size = POOL_SIZE;
+    stats->hugepages = arena_hugepages;
+    stats->arenas = count_blocks(numpools, numblocks, numfreeblocks,
+                                 &stats->free_pools, NULL);
+    stats->arenas_allocated = ntimes_arena_allocated;
+    stats->arenas_highwater = narenas_highwater;
+    stats->sample_rate = sample_rate;
+    stats->samples_lost = sample_lost;
+    stats->nclasses = NB_SMALL_SIZE_CLASSES;
+    for (i = 0; i < NB_SMALL_SIZE_CLASSES; ++i) {
+        stats->classes[i].size = INDEX2SIZE(i);
+        stats->classes[i].pools = numpools[i];
+        stats->classes[i].blocks = numblocks[i];
+        stats->classes[i].free_blocks = numfreeblocks[i];
+    }
+}
+
+/* Sample every rate'th small allocation at the sites given by sampler, or
+ * stop sampling and discard the samples if rate is 0.  Return -1 if out of
+ * memory.
+ */
+int
+_PyObject_SetMallocSampling(Py_ssize_t rate, const _PyMallocSampler *s)
+{
+    struct sample_site *sites;
+    size_t i;
+
+    assert(rate >= 0);
+    if (rate == 0) {
+        /* Detach the tables first: letting go of a key may free
+         * blocks. */
+        sites = sample_sites;
+        sample_rate = 0;
+        sample_countdown = PY_SSIZE_T_MAX;
+        sample_sites = NULL;
+        sample_nsites = 0;
+        free(sample_blocks);
+        sample_blocks = NULL;
+        sample_nblocks = 0;
+        sample_lost = 0;
+        if (sites != NULL) {
+            for (i = 0; i < SAMPLE_SITES; ++i)
+                if (sites[i].allocated != 0 && sites[i].key != NULL)
+                    sampler.hold(sites[i].key, -1);
+            free(sites);
+        }
+        return 0;
+    }
+    if (sample_sites == NULL) {
+        sample_sites = (struct sample_site *)calloc(
+            SAMPLE_SITES, sizeof(struct sample_site));
+        sample_blocks = (struct sample_block *)calloc(
+            SAMPLE_BLOCKS, sizeof(struct sample_block));
+        if (sample_sites == NULL || sample_blocks == NULL) {
+            free(sample_sites);
+            free(sample_blocks);
+            sample_sites = NULL;
+            sample_blocks = NULL;
+            return -1;
+        }
+        sampler = *s;
+    }
+    assert(s->where == sampler.where && s->hold == sampler.hold);
+    sample_rate = rate;
+    sample_countdown = rate;
+    return 0;
+}
+
+/* Call visit for every site of the samples, until it returns non-zero.
+ * Return that value, or 0.  No samples are taken meanwhile.
+ */
+int
+_PyObject_VisitMallocSamples(_PyMallocSampleVisit visit, void *arg)
+{
+    Py_ssize_t countdown = sample_countdown;
+    int err = 0;
+    size_t i;
+
+    if (sample_sites == NULL)
+        return 0;
+    sample_countdown = PY_SSIZE_T_MAX;
+    /* visit may run code that stops sampling. */
+    for (i = 0; i < SAMPLE_SITES && err == 0 && sample_sites != NULL; ++i) {
+        struct sample_site *site = &sample_sites[i];
+        if (site->allocated != 0)
+            err = visit(INDEX2SIZE(site->szidx), site->key, site->lineno,
+                        site->allocated, site->live, arg);
+    }
+    sample_countdown = sample_rate != 0 ? countdown : PY_SSIZE_T_MAX;
+    return err;
+}
+
 #else   /* ! WITH_PYMALLOC */
 
 /*==========================================================================*/
@@ -1325,31 +1799,6 @@ write_size_t(void *p, size_t n)
     }
 }
 
-#ifdef Py_DEBUG
-/* Is target in the list?  The list is traversed via the nextpool pointers.
- * The list may be NULL-terminated, or circular.  Return 1 if target is in
- * list, else 0.
- */
-static int
-pool_is_in_list(const poolp target, poolp list)
-{
-    poolp origlist = list;
-    assert(target != NULL);
-    if (list == NULL)
-        return 0;
-    do {
-        if (target == list)
-            return 1;
-        list = list->nextpool;
-    } while (list != NULL && list != origlist);
-    return 0;
-}
-
-#else
-#define pool_is_in_list(X, Y) 1
-
-#endif  /* Py_DEBUG */
-
 /* Let S = sizeof(size_t).  The debug malloc asks for 4*S extra bytes and
    fills them with useful stuff, here calling the underlying malloc's result p:
 
@@ -1734,7 +2183,7 @@ _PyObject_DebugMallocStats(void)
     /* total # of available bytes in used pools */
     size_t available_bytes = 0;
     /* # of free pools + pools not yet carved out of current arena */
-    uint numfreepools = 0;
+    size_t numfreepools;
     /* # of bytes for arena alignment padding */
     size_t arena_alignment = 0;
     /* # of bytes in used and full pools used for pool_headers */
@@ -1745,64 +2194,16 @@ _PyObject_DebugMallocStats(void)
      */
     size_t quantization = 0;
     /* # of arenas actually allocated. */
-    size_t narenas = 0;
-    /* running total -- should equal narenas * ARENA_SIZE */
+    size_t narenas;
+    /* running total -- should equal narenas * arena_size */
     size_t total;
     char buf[128];
 
     fprintf(stderr, "Small block threshold = %d, in %u size classes.\n",
             SMALL_REQUEST_THRESHOLD, numclasses);
 
-    for (i = 0; i < numclasses; ++i)
-        numpools[i] = numblocks[i] = numfreeblocks[i] = 0;
-
-    /* Because full pools aren't linked to from anything, it's easiest
-     * to march over all the arenas.  If we're lucky, most of the memory
-     * will be living in full pools -- would be a shame to miss them.
-     */
-    for (i = 0; i < maxarenas; ++i) {
-        uint j;
-        uptr base = arenas[i].address;
-
-        /* Skip arenas which are not allocated. */
-        if (arenas[i].address == (uptr)NULL)
-            continue;
-        narenas += 1;
-
-        numfreepools += arenas[i].nfreepools;
-
-        /* round up to pool alignment */
-        if (base & (uptr)POOL_SIZE_MASK) {
-            arena_alignment += POOL_SIZE;
-            base &= ~(uptr)POOL_SIZE_MASK;
-            base += POOL_SIZE;
-        }
-
-        /* visit every pool in the arena */
-        assert(base <= (uptr) arenas[i].pool_address);
-        for (j = 0;
-                    base < (uptr) arenas[i].pool_address;
-                    ++j, base += POOL_SIZE) {
-            poolp p = (poolp)base;
-            const uint sz = p->szidx;
-            uint freeblocks;
-
-            if (p->ref.count == 0) {
-                /* currently unused */
-                assert(pool_is_in_list(p, arenas[i].freepools));
-                continue;
-            }
-            ++numpools[sz];
-            numblocks[sz] += p->ref.count;
-            freeblocks = NUMBLOCKS(sz) - p->ref.count;
-            numfreeblocks[sz] += freeblocks;
-#ifdef Py_DEBUG
-            if (freeblocks > 0)
-                assert(pool_is_in_list(p, usedpools[sz + sz]));
-#endif
-        }
-    }
-    assert(narenas == narenas_currently_allocated);
+    narenas = count_blocks(numpools, numblocks, numfreeblocks,
+                           &numfreepools, &arena_alignment);
 
     fputc('\n', stderr);
     fputs("class   size   num pools   blocks in use  avail blocks\n"
@@ -1837,9 +2238,9 @@ _PyObject_DebugMallocStats(void)
     (void)printone("# arenas allocated current", narenas);
 
     PyOS_snprintf(buf, sizeof(buf),
-        "%" PY_FORMAT_SIZE_T "u arenas * %d bytes/arena",
-        narenas, ARENA_SIZE);
-    (void)printone(buf, narenas * ARENA_SIZE);
+        "%" PY_FORMAT_SIZE_T "u arenas * %" PY_FORMAT_SIZE_T "u bytes/arena",
+        narenas, arena_size);
+    (void)printone(buf, narenas * arena_size);
 
     fputc('\n', stderr);
 
@@ -1847,7 +2248,8 @@ _PyObject_DebugMallocStats(void)
     total += printone("# bytes in available blocks", available_bytes);
 
     PyOS_snprintf(buf, sizeof(buf),
-        "%u unused pools * %d bytes", numfreepools, POOL_SIZE);
+        "%" PY_FORMAT_SIZE_T "u unused pools * %d bytes",
+        numfreepools, POOL_SIZE);
     total += printone(buf, (size_t)numfreepools * POOL_SIZE);
 
     total += printone("# bytes lost to pool headers", pool_header_bytes);
@@ -1866,7 +2268,7 @@ int
 Py_ADDRESS_IN_RANGE(void *P, poolp pool)
 {
     return pool->arenaindex < maxarenas &&
-           (uptr)P - arenas[pool->arenaindex].address < (uptr)ARENA_SIZE &&
+           (uptr)P - arenas[pool->arenaindex].address < (uptr)arena_size &&
            arenas[pool->arenaindex].address != 0;
 }
 #endif
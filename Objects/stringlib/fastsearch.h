@@ -33,6 +33,187 @@
 #define STRINGLIB_BLOOM(mask, ch)     \
     ((mask &  (1UL << ((ch) & (STRINGLIB_BLOOM_WIDTH -1)))))
 
+/* on x86, the single character loops and searches for short patterns test
+   a vector of positions at a time.  SSE2 is always there on x86-64; AVX2
+   kernels are compiled alongside, and picked at run time if the CPU has
+   them.  this needs a compiler that can enable an instruction set for a
+   single function (gcc 4.9, clang). */
+
+#if defined(__SSE2__) && (defined(__clang__) || __GNUC__ > 4 || \
+                          (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define STRINGLIB_SIMD
+#endif
+
+#ifdef STRINGLIB_SIMD
+
+#include <immintrin.h>
+
+/* strings shorter than this are searched one character at a time */
+#define STRINGLIB_SIMD_CUTOFF 32
+
+/* longer patterns use the boyer-moore-horspool search below, which can
+   skip over more than a vector at a time */
+#define STRINGLIB_SIMD_MAX_PATTERN 64
+
+#if STRINGLIB_SIZEOF_CHAR == 1
+#define STRINGLIB_CHAR_BITS 8
+#define STRINGLIB_CHAR_SHIFT 0
+#define STRINGLIB_CHAR_MASK 0xffffffffU
+#elif STRINGLIB_SIZEOF_CHAR == 2
+#define STRINGLIB_CHAR_BITS 16
+#define STRINGLIB_CHAR_SHIFT 1
+#define STRINGLIB_CHAR_MASK 0x55555555U
+#elif STRINGLIB_SIZEOF_CHAR == 4
+#define STRINGLIB_CHAR_BITS 32
+#define STRINGLIB_CHAR_SHIFT 2
+#define STRINGLIB_CHAR_MASK 0x11111111U
+#else
+#error "unsupported STRINGLIB_SIZEOF_CHAR"
+#endif
+
+/* STRINGLIB_EPI(_mm_cmpeq) is _mm_cmpeq_epi8 for 8-bit characters */
+#define STRINGLIB_PASTE(a, b, c) a ## b ## c
+#define STRINGLIB_XPASTE(a, b, c) STRINGLIB_PASTE(a, b, c)
+#define STRINGLIB_EPI(op) STRINGLIB_XPASTE(op, _epi, STRINGLIB_CHAR_BITS)
+
+#define STRINGLIB_VEC            __m128i
+#define STRINGLIB_VEC_NAME(f)    f ## _sse2
+#define STRINGLIB_VEC_TARGET
+#define STRINGLIB_VEC_LOAD(p)    _mm_loadu_si128((const __m128i *)(p))
+#define STRINGLIB_VEC_SET1       STRINGLIB_EPI(_mm_set1)
+#define STRINGLIB_VEC_EQ         STRINGLIB_EPI(_mm_cmpeq)
+#define STRINGLIB_VEC_GT         STRINGLIB_EPI(_mm_cmpgt)
+#define STRINGLIB_VEC_SUB        STRINGLIB_EPI(_mm_sub)
+#define STRINGLIB_VEC_AND        _mm_and_si128
+#define STRINGLIB_VEC_OR         _mm_or_si128
+#define STRINGLIB_VEC_XOR        _mm_xor_si128
+#define STRINGLIB_VEC_MASK       _mm_movemask_epi8
+#include "fastsearch_simd.h"
+#undef STRINGLIB_VEC
+#undef STRINGLIB_VEC_NAME
+#undef STRINGLIB_VEC_TARGET
+#undef STRINGLIB_VEC_LOAD
+#undef STRINGLIB_VEC_SET1
+#undef STRINGLIB_VEC_EQ
+#undef STRINGLIB_VEC_GT
+#undef STRINGLIB_VEC_SUB
+#undef STRINGLIB_VEC_AND
+#undef STRINGLIB_VEC_OR
+#undef STRINGLIB_VEC_XOR
+#undef STRINGLIB_VEC_MASK
+
+#define STRINGLIB_VEC            __m256i
+#define STRINGLIB_VEC_NAME(f)    f ## _avx2
+#define STRINGLIB_VEC_TARGET     __attribute__((target("avx2,popcnt")))
+#define STRINGLIB_VEC_LOAD(p)    _mm256_loadu_si256((const __m256i *)(p))
+#define STRINGLIB_VEC_SET1       STRINGLIB_EPI(_mm256_set1)
+#define STRINGLIB_VEC_EQ         STRINGLIB_EPI(_mm256_cmpeq)
+#define STRINGLIB_VEC_GT         STRINGLIB_EPI(_mm256_cmpgt)
+#define STRINGLIB_VEC_SUB        STRINGLIB_EPI(_mm256_sub)
+#define STRINGLIB_VEC_AND        _mm256_and_si256
+#define STRINGLIB_VEC_OR         _mm256_or_si256
+#define STRINGLIB_VEC_XOR        _mm256_xor_si256
+#define STRINGLIB_VEC_MASK       _mm256_movemask_epi8
+#include "fastsearch_simd.h"
+#undef STRINGLIB_VEC
+#undef STRINGLIB_VEC_NAME
+#undef STRINGLIB_VEC_TARGET
+#undef STRINGLIB_VEC_LOAD
+#undef STRINGLIB_VEC_SET1
+#undef STRINGLIB_VEC_EQ
+#undef STRINGLIB_VEC_GT
+#undef STRINGLIB_VEC_SUB
+#undef STRINGLIB_VEC_AND
+#undef STRINGLIB_VEC_OR
+#undef STRINGLIB_VEC_XOR
+#undef STRINGLIB_VEC_MASK
+
+/* -1 until the first call */
+static int stringlib_have_avx2 = -1;
+
+#define STRINGLIB_SIMD_CALL(f, args)                    \
+    (stringlib_avx2() ? f ## _avx2 args : f ## _sse2 args)
+
+Py_LOCAL_INLINE(int)
+stringlib_avx2(void)
+{
+    if (stringlib_have_avx2 < 0) {
+        __builtin_cpu_init();
+        stringlib_have_avx2 = __builtin_cpu_supports("avx2") != 0;
+    }
+    return stringlib_have_avx2;
+}
+
+#endif /* STRINGLIB_SIMD */
+
+/* helpers for the single character loops in split.h */
+
+Py_LOCAL_INLINE(Py_ssize_t)
+stringlib_find_char(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                    STRINGLIB_CHAR ch)
+{
+    Py_ssize_t i;
+
+#ifdef STRINGLIB_SIMD
+    if (n >= STRINGLIB_SIMD_CUTOFF)
+        return STRINGLIB_SIMD_CALL(stringlib_find_char, (s, n, ch));
+#endif
+    for (i = 0; i < n; i++)
+        if (s[i] == ch)
+            return i;
+    return -1;
+}
+
+Py_LOCAL_INLINE(Py_ssize_t)
+stringlib_rfind_char(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                     STRINGLIB_CHAR ch)
+{
+    Py_ssize_t i;
+
+#ifdef STRINGLIB_SIMD
+    if (n >= STRINGLIB_SIMD_CUTOFF)
+        return STRINGLIB_SIMD_CALL(stringlib_rfind_char, (s, n, ch));
+#endif
+    for (i = n - 1; i >= 0; i--)
+        if (s[i] == ch)
+            return i;
+    return -1;
+}
+
+/* index of the first whitespace character in s[0:n], or n */
+
+Py_LOCAL_INLINE(Py_ssize_t)
+stringlib_find_space(const STRINGLIB_CHAR* s, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+#ifdef STRINGLIB_SIMD
+    if (n >= STRINGLIB_SIMD_CUTOFF)
+        return STRINGLIB_SIMD_CALL(stringlib_find_space, (s, n));
+#endif
+    for (i = 0; i < n; i++)
+        if (STRINGLIB_ISSPACE(s[i]))
+            return i;
+    return n;
+}
+
+/* index of the last whitespace character in s[0:n], or -1 */
+
+Py_LOCAL_INLINE(Py_ssize_t)
+stringlib_rfind_space(const STRINGLIB_CHAR* s, Py_ssize_t n)
+{
+    Py_ssize_t i;
+
+#ifdef STRINGLIB_SIMD
+    if (n >= STRINGLIB_SIMD_CUTOFF)
+        return STRINGLIB_SIMD_CALL(stringlib_rfind_space, (s, n));
+#endif
+    for (i = n - 1; i >= 0; i--)
+        if (STRINGLIB_ISSPACE(s[i]))
+            return i;
+    return -1;
+}
+
 Py_LOCAL_INLINE(Py_ssize_t)
 fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
            const STRINGLIB_CHAR* p, Py_ssize_t m,
@@ -52,6 +233,17 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
         if (m <= 0)
             return -1;
         /* use special case for 1-character strings */
+#ifdef STRINGLIB_SIMD
+        if (n >= STRINGLIB_SIMD_CUTOFF) {
+            if (mode == FAST_COUNT)
+                return STRINGLIB_SIMD_CALL(stringlib_count_char,
+                                           (s, n, p[0], maxcount));
+            else if (mode == FAST_SEARCH)
+                return stringlib_find_char(s, n, p[0]);
+            else
+                return stringlib_rfind_char(s, n, p[0]);
+        }
+#endif
         if (mode == FAST_COUNT) {
             for (i = 0; i < n; i++)
                 if (s[i] == p[0]) {
@@ -72,6 +264,13 @@ fastsearch(const STRINGLIB_CHAR* s, Py_ssize_t n,
         return -1;
     }
 
+#ifdef STRINGLIB_SIMD
+    if (mode != FAST_RSEARCH && n >= STRINGLIB_SIMD_CUTOFF &&
+        m <= STRINGLIB_SIMD_MAX_PATTERN)
+        return STRINGLIB_SIMD_CALL(stringlib_search,
+                                   (s, n, p, m, maxcount, mode));
+#endif
+
     mlast = m - 1;
     skip = mlast - 1;
     mask = 0;
@@ -0,0 +1,237 @@
+/* stringlib: SSE2/AVX2 search kernels */
+
+/* this file is included twice by fastsearch.h, once per vector size, with
+   these macros defined:
+
+   STRINGLIB_VEC            the vector type
+   STRINGLIB_VEC_NAME(f)    f with the instruction set appended to it
+   STRINGLIB_VEC_TARGET     attribute enabling the instruction set
+   STRINGLIB_VEC_LOAD(p)    unaligned load from p
+   STRINGLIB_VEC_SET1(c)    c in every character
+   STRINGLIB_VEC_EQ(a, b)   per character a == b
+   STRINGLIB_VEC_GT(a, b)   per character a > b, signed
+   STRINGLIB_VEC_SUB(a, b)  per character a - b
+   STRINGLIB_VEC_AND(a, b)  bitwise and
+   STRINGLIB_VEC_OR(a, b)   bitwise or
+   STRINGLIB_VEC_XOR(a, b)  bitwise xor
+   STRINGLIB_VEC_MASK(a)    the top bit of every byte of a
+
+   a comparison sets every bit of the matching characters, so the byte
+   mask has sizeof(STRINGLIB_CHAR) bits per character; the kernels keep
+   only the lowest of those (STRINGLIB_CHAR_MASK), and shift bit numbers
+   right by STRINGLIB_CHAR_SHIFT to get character offsets.  the kernels
+   only read s[0:n]. */
+
+#define VEC_CHARS ((Py_ssize_t)(sizeof(STRINGLIB_VEC) / STRINGLIB_SIZEOF_CHAR))
+
+#define VEC_BITS(v) \
+    ((unsigned int)STRINGLIB_VEC_MASK(v) & STRINGLIB_CHAR_MASK)
+
+#define VEC_MATCH(p, c) VEC_BITS(STRINGLIB_VEC_EQ(STRINGLIB_VEC_LOAD(p), c))
+
+#define VEC_FIRST(bits) (__builtin_ctz(bits) >> STRINGLIB_CHAR_SHIFT)
+#define VEC_LAST(bits) ((31 - __builtin_clz(bits)) >> STRINGLIB_CHAR_SHIFT)
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_find_char)(const STRINGLIB_CHAR* s,
+                                        Py_ssize_t n, STRINGLIB_CHAR ch)
+{
+    STRINGLIB_VEC c = STRINGLIB_VEC_SET1(ch);
+    unsigned int bits;
+    Py_ssize_t i;
+
+    for (i = 0; i + 2 * VEC_CHARS <= n; i += 2 * VEC_CHARS) {
+        /* test two vectors at a time, they usually both miss */
+        STRINGLIB_VEC a = STRINGLIB_VEC_EQ(STRINGLIB_VEC_LOAD(s + i), c);
+        STRINGLIB_VEC b = STRINGLIB_VEC_EQ(
+            STRINGLIB_VEC_LOAD(s + i + VEC_CHARS), c);
+        if (VEC_BITS(STRINGLIB_VEC_OR(a, b))) {
+            bits = VEC_BITS(a);
+            if (bits)
+                return i + VEC_FIRST(bits);
+            return i + VEC_CHARS + VEC_FIRST(VEC_BITS(b));
+        }
+    }
+    if (i + VEC_CHARS <= n) {
+        bits = VEC_MATCH(s + i, c);
+        if (bits)
+            return i + VEC_FIRST(bits);
+        i += VEC_CHARS;
+    }
+    for (; i < n; i++)
+        if (s[i] == ch)
+            return i;
+    return -1;
+}
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_rfind_char)(const STRINGLIB_CHAR* s,
+                                         Py_ssize_t n, STRINGLIB_CHAR ch)
+{
+    STRINGLIB_VEC c = STRINGLIB_VEC_SET1(ch);
+    unsigned int bits;
+    Py_ssize_t i;
+
+    for (i = n - VEC_CHARS; i >= 0; i -= VEC_CHARS) {
+        bits = VEC_MATCH(s + i, c);
+        if (bits)
+            return i + VEC_LAST(bits);
+    }
+    for (i += VEC_CHARS - 1; i >= 0; i--)
+        if (s[i] == ch)
+            return i;
+    return -1;
+}
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_count_char)(const STRINGLIB_CHAR* s,
+                                         Py_ssize_t n, STRINGLIB_CHAR ch,
+                                         Py_ssize_t maxcount)
+{
+    STRINGLIB_VEC c = STRINGLIB_VEC_SET1(ch);
+    Py_ssize_t i, count = 0;
+
+    for (i = 0; i + VEC_CHARS <= n; i += VEC_CHARS) {
+        count += __builtin_popcount(VEC_MATCH(s + i, c));
+        if (count >= maxcount)
+            return maxcount;
+    }
+    for (; i < n; i++)
+        if (s[i] == ch) {
+            count++;
+            if (count == maxcount)
+                return maxcount;
+        }
+    return count;
+}
+
+/* substring search that compares the first and the last character of the
+   pattern at a vector of positions at once, and checks the rest of the
+   pattern only where both match.  m must be at least 2. */
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_search)(const STRINGLIB_CHAR* s, Py_ssize_t n,
+                                     const STRINGLIB_CHAR* p, Py_ssize_t m,
+                                     Py_ssize_t maxcount, int mode)
+{
+    STRINGLIB_VEC first = STRINGLIB_VEC_SET1(p[0]);
+    STRINGLIB_VEC last = STRINGLIB_VEC_SET1(p[m - 1]);
+    size_t size = (m - 2) * sizeof(STRINGLIB_CHAR);
+    Py_ssize_t i, j, mlast = m - 1, next = 0, count = 0;
+    unsigned int bits;
+
+    for (i = 0; i + VEC_CHARS + mlast <= n; i += VEC_CHARS) {
+        bits = VEC_BITS(STRINGLIB_VEC_AND(
+            STRINGLIB_VEC_EQ(STRINGLIB_VEC_LOAD(s + i), first),
+            STRINGLIB_VEC_EQ(STRINGLIB_VEC_LOAD(s + i + mlast), last)));
+        while (bits) {
+            j = i + VEC_FIRST(bits);
+            bits &= bits - 1;
+            /* in count mode, skip candidates overlapping the last match */
+            if (j >= next && memcmp(s + j + 1, p + 1, size) == 0) {
+                if (mode != FAST_COUNT)
+                    return j;
+                count++;
+                if (count == maxcount)
+                    return maxcount;
+                next = j + m;
+            }
+        }
+    }
+    for (j = i > next ? i : next; j + mlast < n; j++)
+        if (s[j] == p[0] && s[j + mlast] == p[mlast] &&
+            memcmp(s + j + 1, p + 1, size) == 0) {
+            if (mode != FAST_COUNT)
+                return j;
+            count++;
+            if (count == maxcount)
+                return maxcount;
+            j = j + mlast;
+        }
+    if (mode != FAST_COUNT)
+        return -1;
+    return count;
+}
+
+/* whitespace is below '!' or, for unicode, not ascii.  the kernels pick
+   out those characters with one unsigned range compare, and confirm them
+   with STRINGLIB_ISSPACE. */
+
+#if STRINGLIB_SIZEOF_CHAR == 1
+#define VEC_GRAPH_MAX 0xff
+#else
+#define VEC_GRAPH_MAX 0x7f
+#endif
+
+#define VEC_SIGN ((STRINGLIB_CHAR)(1UL << (8 * STRINGLIB_SIZEOF_CHAR - 1)))
+
+/* bits of the characters at p outside '!'..VEC_GRAPH_MAX */
+#define VEC_SPACE(p)                                                    \
+    VEC_BITS(STRINGLIB_VEC_GT(                                          \
+        STRINGLIB_VEC_XOR(STRINGLIB_VEC_SUB(STRINGLIB_VEC_LOAD(p), bang), \
+                          sign),                                        \
+        limit))
+
+#define VEC_SPACE_CONSTANTS                                             \
+    STRINGLIB_VEC bang = STRINGLIB_VEC_SET1((STRINGLIB_CHAR)'!');       \
+    STRINGLIB_VEC sign = STRINGLIB_VEC_SET1(VEC_SIGN);                  \
+    STRINGLIB_VEC limit = STRINGLIB_VEC_SET1(                           \
+        (STRINGLIB_CHAR)((VEC_GRAPH_MAX - '!') ^ VEC_SIGN))
+
+/* return the index of the first whitespace character in s[0:n], or n */
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_find_space)(const STRINGLIB_CHAR* s,
+                                         Py_ssize_t n)
+{
+    VEC_SPACE_CONSTANTS;
+    unsigned int bits;
+    Py_ssize_t i, j;
+
+    for (i = 0; i + VEC_CHARS <= n; i += VEC_CHARS) {
+        for (bits = VEC_SPACE(s + i); bits; bits &= bits - 1) {
+            j = i + VEC_FIRST(bits);
+            if (STRINGLIB_ISSPACE(s[j]))
+                return j;
+        }
+    }
+    for (; i < n; i++)
+        if (STRINGLIB_ISSPACE(s[i]))
+            return i;
+    return n;
+}
+
+/* return the index of the last whitespace character in s[0:n], or -1 */
+
+STRINGLIB_VEC_TARGET static Py_ssize_t
+STRINGLIB_VEC_NAME(stringlib_rfind_space)(const STRINGLIB_CHAR* s,
+                                          Py_ssize_t n)
+{
+    VEC_SPACE_CONSTANTS;
+    unsigned int bits;
+    Py_ssize_t i, j;
+
+    for (i = n - VEC_CHARS; i >= 0; i -= VEC_CHARS) {
+        bits = VEC_SPACE(s + i);
+        while (bits) {
+            j = i + VEC_LAST(bits);
+            if (STRINGLIB_ISSPACE(s[j]))
+                return j;
+            bits &= ~(1U << (31 - __builtin_clz(bits)));
+        }
+    }
+    for (i += VEC_CHARS - 1; i >= 0; i--)
+        if (STRINGLIB_ISSPACE(s[i]))
+            return i;
+    return -1;
+}
+
+#undef VEC_CHARS
+#undef VEC_BITS
+#undef VEC_MATCH
+#undef VEC_FIRST
+#undef VEC_LAST
+#undef VEC_GRAPH_MAX
+#undef VEC_SIGN
+#undef VEC_SPACE
+#undef VEC_SPACE_CONSTANTS
@@ -71,8 +71,7 @@ stringlib_split_whitespace(PyObject* str_obj,
             i++;
         if (i == str_len) break;
         j = i; i++;
-        while (i < str_len && !STRINGLIB_ISSPACE(str[i]))
-            i++;
+        i += stringlib_find_space(str + i, str_len - i);
 #ifndef STRINGLIB_MUTABLE
         if (j == 0 && i == str_len && STRINGLIB_CHECK_EXACT(str_obj)) {
             /* No whitespace in str_obj, so just use it as list[0] */
@@ -107,7 +106,7 @@ stringlib_split_char(PyObject* str_obj,
                      const STRINGLIB_CHAR ch,
                      Py_ssize_t maxcount)
 {
-    Py_ssize_t i, j, count=0;
+    Py_ssize_t i, j, pos, count=0;
     PyObject *list = PyList_New(PREALLOC_SIZE(maxcount));
     PyObject *sub;
 
@@ -116,14 +115,12 @@ stringlib_split_char(PyObject* str_obj,
 
     i = j = 0;
     while ((j < str_len) && (maxcount-- > 0)) {
-        for(; j < str_len; j++) {
-            /* I found that using memchr makes no difference */
-            if (str[j] == ch) {
-                SPLIT_ADD(str, i, j);
-                i = j = j + 1;
-                break;
-            }
-        }
+        pos = stringlib_find_char(str + j, str_len - j, ch);
+        if (pos < 0)
+            break;
+        j += pos;
+        SPLIT_ADD(str, i, j);
+        i = j = j + 1;
     }
 #ifndef STRINGLIB_MUTABLE
     if (count == 0 && STRINGLIB_CHECK_EXACT(str_obj)) {
@@ -210,8 +207,7 @@ stringlib_rsplit_whitespace(PyObject* str_obj,
             i--;
         if (i < 0) break;
         j = i; i--;
-        while (i >= 0 && !STRINGLIB_ISSPACE(str[i]))
-            i--;
+        i = stringlib_rfind_space(str, i + 1);
 #ifndef STRINGLIB_MUTABLE
         if (j == str_len - 1 && i < 0 && STRINGLIB_CHECK_EXACT(str_obj)) {
             /* No whitespace in str_obj, so just use it as list[0] */
@@ -257,13 +253,11 @@ stringlib_rsplit_char(PyObject* str_obj,
 
     i = j = str_len - 1;
     while ((i >= 0) && (maxcount-- > 0)) {
-        for(; i >= 0; i--) {
-            if (str[i] == ch) {
-                SPLIT_ADD(str, i + 1, j + 1);
-                j = i = i - 1;
-                break;
-            }
-        }
+        i = stringlib_rfind_char(str, i + 1, ch);
+        if (i < 0)
+            break;
+        SPLIT_ADD(str, i + 1, j + 1);
+        j = i = i - 1;
     }
 #ifndef STRINGLIB_MUTABLE
     if (count == 0 && STRINGLIB_CHECK_EXACT(str_obj)) {
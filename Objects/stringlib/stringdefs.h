@@ -8,6 +8,7 @@
 
 #define STRINGLIB_OBJECT         PyStringObject
 #define STRINGLIB_CHAR           char
+#define STRINGLIB_SIZEOF_CHAR    1
 #define STRINGLIB_TYPE_NAME      "string"
 #define STRINGLIB_PARSE_CODE     "S"
 #define STRINGLIB_EMPTY          nullstring
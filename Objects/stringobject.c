@@ -1691,7 +1691,8 @@ _PyString_Join(PyObject *sep, PyObject *x)
     }
 
 Py_LOCAL_INLINE(Py_ssize_t)
-string_find_internal(PyStringObject *self, PyObject *args, int dir)
+string_find_internal(PyStringObject *self, PyObject **args,
+                     Py_ssize_t nargs, int dir)
 {
     PyObject *subobj;
     const char *sub;
@@ -1699,8 +1700,8 @@ string_find_internal(PyStringObject *self, PyObject *args, int dir)
     Py_ssize_t start=0, end=PY_SSIZE_T_MAX;
     PyObject *obj_start=Py_None, *obj_end=Py_None;
 
-    if (!PyArg_ParseTuple(args, "O|OO:find/rfind/index/rindex", &subobj,
-        &obj_start, &obj_end))
+    if (!_PyArg_ParseStack(args, nargs, "O|OO:find/rfind/index/rindex",
+        &subobj, &obj_start, &obj_end))
         return -2;
     /* To support None in "start" and "end" arguments, meaning
        the same as if they were not passed.
@@ -1747,9 +1748,9 @@ arguments start and end are interpreted as in slice notation.\n\
 Return -1 on failure.");
 
 static PyObject *
-string_find(PyStringObject *self, PyObject *args)
+string_find(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    Py_ssize_t result = string_find_internal(self, args, +1);
+    Py_ssize_t result = string_find_internal(self, args, nargs, +1);
     if (result == -2)
         return NULL;
     return PyInt_FromSsize_t(result);
@@ -1762,9 +1763,9 @@ PyDoc_STRVAR(index__doc__,
 Like S.find() but raise ValueError when the substring is not found.");
 
 static PyObject *
-string_index(PyStringObject *self, PyObject *args)
+string_index(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    Py_ssize_t result = string_find_internal(self, args, +1);
+    Py_ssize_t result = string_find_internal(self, args, nargs, +1);
     if (result == -2)
         return NULL;
     if (result == -1) {
@@ -1786,9 +1787,9 @@ arguments start and end are interpreted as in slice notation.\n\
 Return -1 on failure.");
 
 static PyObject *
-string_rfind(PyStringObject *self, PyObject *args)
+string_rfind(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    Py_ssize_t result = string_find_internal(self, args, -1);
+    Py_ssize_t result = string_find_internal(self, args, nargs, -1);
     if (result == -2)
         return NULL;
     return PyInt_FromSsize_t(result);
@@ -1801,9 +1802,9 @@ PyDoc_STRVAR(rindex__doc__,
 Like S.rfind() but raise ValueError when the substring is not found.");
 
 static PyObject *
-string_rindex(PyStringObject *self, PyObject *args)
+string_rindex(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    Py_ssize_t result = string_find_internal(self, args, -1);
+    Py_ssize_t result = string_find_internal(self, args, nargs, -1);
     if (result == -2)
         return NULL;
     if (result == -1) {
@@ -1879,11 +1880,12 @@ do_strip(PyStringObject *self, int striptype)
 
 
 Py_LOCAL_INLINE(PyObject *)
-do_argstrip(PyStringObject *self, int striptype, PyObject *args)
+do_argstrip(PyStringObject *self, int striptype, PyObject **args,
+            Py_ssize_t nargs)
 {
     PyObject *sep = NULL;
 
-    if (!PyArg_ParseTuple(args, (char *)stripformat[striptype], &sep))
+    if (!_PyArg_ParseStack(args, nargs, stripformat[striptype], &sep))
         return NULL;
 
     if (sep != NULL && sep != Py_None) {
@@ -1924,12 +1926,12 @@ If chars is given and not None, remove characters in chars instead.\n\
 If chars is unicode, S will be converted to unicode before stripping");
 
 static PyObject *
-string_strip(PyStringObject *self, PyObject *args)
+string_strip(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    if (PyTuple_GET_SIZE(args) == 0)
+    if (nargs == 0)
         return do_strip(self, BOTHSTRIP); /* Common case */
     else
-        return do_argstrip(self, BOTHSTRIP, args);
+        return do_argstrip(self, BOTHSTRIP, args, nargs);
 }
 
 
@@ -1941,12 +1943,12 @@ If chars is given and not None, remove characters in chars instead.\n\
 If chars is unicode, S will be converted to unicode before stripping");
 
 static PyObject *
-string_lstrip(PyStringObject *self, PyObject *args)
+string_lstrip(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    if (PyTuple_GET_SIZE(args) == 0)
+    if (nargs == 0)
         return do_strip(self, LEFTSTRIP); /* Common case */
     else
-        return do_argstrip(self, LEFTSTRIP, args);
+        return do_argstrip(self, LEFTSTRIP, args, nargs);
 }
 
 
@@ -1958,12 +1960,12 @@ If chars is given and not None, remove characters in chars instead.\n\
 If chars is unicode, S will be converted to unicode before stripping");
 
 static PyObject *
-string_rstrip(PyStringObject *self, PyObject *args)
+string_rstrip(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
-    if (PyTuple_GET_SIZE(args) == 0)
+    if (nargs == 0)
         return do_strip(self, RIGHTSTRIP); /* Common case */
     else
-        return do_argstrip(self, RIGHTSTRIP, args);
+        return do_argstrip(self, RIGHTSTRIP, args, nargs);
 }
 
 
@@ -2909,14 +2911,14 @@ With optional end, stop comparing S at that position.\n\
 prefix can also be a tuple of strings to try.");
 
 static PyObject *
-string_startswith(PyStringObject *self, PyObject *args)
+string_startswith(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
     Py_ssize_t start = 0;
     Py_ssize_t end = PY_SSIZE_T_MAX;
     PyObject *subobj;
     int result;
 
-    if (!PyArg_ParseTuple(args, "O|O&O&:startswith", &subobj,
+    if (!_PyArg_ParseStack(args, nargs, "O|O&O&:startswith", &subobj,
         _PyEval_SliceIndex, &start, _PyEval_SliceIndex, &end))
         return NULL;
     if (PyTuple_Check(subobj)) {
@@ -2950,14 +2952,14 @@ With optional end, stop comparing S at that position.\n\
 suffix can also be a tuple of strings to try.");
 
 static PyObject *
-string_endswith(PyStringObject *self, PyObject *args)
+string_endswith(PyStringObject *self, PyObject **args, Py_ssize_t nargs)
 {
     Py_ssize_t start = 0;
     Py_ssize_t end = PY_SSIZE_T_MAX;
     PyObject *subobj;
     int result;
 
-    if (!PyArg_ParseTuple(args, "O|O&O&:endswith", &subobj,
+    if (!_PyArg_ParseStack(args, nargs, "O|O&O&:endswith", &subobj,
         _PyEval_SliceIndex, &start, _PyEval_SliceIndex, &end))
         return NULL;
     if (PyTuple_Check(subobj)) {
@@ -3639,21 +3641,21 @@ string_methods[] = {
     {"capitalize", (PyCFunction)string_capitalize, METH_NOARGS,
      capitalize__doc__},
     {"count", (PyCFunction)string_count, METH_VARARGS, count__doc__},
-    {"endswith", (PyCFunction)string_endswith, METH_VARARGS,
+    {"endswith", (PyCFunction)string_endswith, METH_FASTCALL,
      endswith__doc__},
     {"partition", (PyCFunction)string_partition, METH_O, partition__doc__},
-    {"find", (PyCFunction)string_find, METH_VARARGS, find__doc__},
-    {"index", (PyCFunction)string_index, METH_VARARGS, index__doc__},
-    {"lstrip", (PyCFunction)string_lstrip, METH_VARARGS, lstrip__doc__},
+    {"find", (PyCFunction)string_find, METH_FASTCALL, find__doc__},
+    {"index", (PyCFunction)string_index, METH_FASTCALL, index__doc__},
+    {"lstrip", (PyCFunction)string_lstrip, METH_FASTCALL, lstrip__doc__},
     {"replace", (PyCFunction)string_replace, METH_VARARGS, replace__doc__},
-    {"rfind", (PyCFunction)string_rfind, METH_VARARGS, rfind__doc__},
-    {"rindex", (PyCFunction)string_rindex, METH_VARARGS, rindex__doc__},
-    {"rstrip", (PyCFunction)string_rstrip, METH_VARARGS, rstrip__doc__},
+    {"rfind", (PyCFunction)string_rfind, METH_FASTCALL, rfind__doc__},
+    {"rindex", (PyCFunction)string_rindex, METH_FASTCALL, rindex__doc__},
+    {"rstrip", (PyCFunction)string_rstrip, METH_FASTCALL, rstrip__doc__},
     {"rpartition", (PyCFunction)string_rpartition, METH_O,
      rpartition__doc__},
-    {"startswith", (PyCFunction)string_startswith, METH_VARARGS,
+    {"startswith", (PyCFunction)string_startswith, METH_FASTCALL,
      startswith__doc__},
-    {"strip", (PyCFunction)string_strip, METH_VARARGS, strip__doc__},
+    {"strip", (PyCFunction)string_strip, METH_FASTCALL, strip__doc__},
     {"swapcase", (PyCFunction)string_swapcase, METH_NOARGS,
      swapcase__doc__},
     {"translate", (PyCFunction)string_translate, METH_VARARGS,
@@ -1847,7 +1847,7 @@ subtype_dict(PyObject *obj, void *context)
     }
     dict = *dictptr;
     if (dict == NULL)
-        *dictptr = dict = PyDict_New();
+        *dictptr = dict = _PyObjectDict_New(_PyType_CACHED_KEYS(Py_TYPE(obj)));
     Py_XINCREF(dict);
     return dict;
 }
@@ -2454,6 +2454,10 @@ type_new(PyTypeObject *metatype, PyObject *args, PyObject *kwds)
     /* Put the proper slots in place */
     fixup_slot_dispatchers(type);
 
+    /* Let the instance dicts share their keys */
+    if (type->tp_dictoffset != 0)
+        et->ht_cached_keys = _PyDict_NewKeysForClass();
+
 #ifdef STACKLESS
     /* check if we support stackless call */
     {
@@ -2648,6 +2652,8 @@ type_dealloc(PyTypeObject *type)
     PyObject_Free((char *)type->tp_doc);
     Py_XDECREF(et->ht_name);
     Py_XDECREF(et->ht_slots);
+    if (et->ht_cached_keys != NULL)
+        _PyDictKeys_DecRef(et->ht_cached_keys);
     Py_TYPE(type)->tp_free((PyObject *)type);
 }
 
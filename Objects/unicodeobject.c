@@ -1857,6 +1857,142 @@ encode_char:
 #undef DECODE_DIRECT
 #undef ENCODE_DIRECT
 
+/* --- ASCII and Latin-1 runs --------------------------------------------- */
+
+/* The UTF-8, ASCII and Latin-1 codecs spend most of their time in runs of
+   characters below 128 (or 256), which map one to one between bytes and
+   Py_UNICODE.  These helpers convert a whole run at once: 16 characters
+   per step with SSE2, which x86-64 always has, and 8 per step elsewhere.
+   A step converts all of its characters and then counts how many belong
+   to the run, so the output must have room for n characters even when
+   the run is shorter. */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+/* widen the 16 bytes of v into p[0:16] */
+Py_LOCAL_INLINE(void) widen_16(__m128i v, Py_UNICODE *p)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+#if Py_UNICODE_SIZE == 2
+    _mm_storeu_si128((__m128i *)p, lo);
+    _mm_storeu_si128((__m128i *)(p + 8), hi);
+#else
+    _mm_storeu_si128((__m128i *)p, _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128((__m128i *)(p + 4), _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128((__m128i *)(p + 8), _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128((__m128i *)(p + 12), _mm_unpackhi_epi16(hi, zero));
+#endif
+}
+#endif
+
+/* widen the ASCII bytes at the start of s[0:n] into p, and return how many
+   there are */
+Py_LOCAL_INLINE(Py_ssize_t) ascii_decode_run(const char *s, Py_ssize_t n,
+                                             Py_UNICODE *p)
+{
+    Py_ssize_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        int high = _mm_movemask_epi8(v);
+        widen_16(v, p + i);
+        if (high)
+            return i + __builtin_ctz(high);
+    }
+#else
+    int k;
+    for (; i + 8 <= n; i += 8) {
+        unsigned char bits = 0;
+        for (k = 0; k < 8; k++)
+            bits |= (unsigned char)s[i + k];
+        if (bits & 0x80)
+            break;
+        for (k = 0; k < 8; k++)
+            p[i + k] = (unsigned char)s[i + k];
+    }
+#endif
+    for (; i < n && (unsigned char)s[i] < 0x80; i++)
+        p[i] = (unsigned char)s[i];
+    return i;
+}
+
+/* widen all of s[0:n] into p */
+Py_LOCAL_INLINE(void) latin1_decode_run(const char *s, Py_ssize_t n,
+                                        Py_UNICODE *p)
+{
+    Py_ssize_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= n; i += 16)
+        widen_16(_mm_loadu_si128((const __m128i *)(s + i)), p + i);
+#endif
+    for (; i < n; i++)
+        p[i] = (unsigned char)s[i];
+}
+
+/* narrow the characters below limit at the start of p[0:n] into s, and
+   return how many there are.  limit is 128 or 256. */
+Py_LOCAL_INLINE(Py_ssize_t) ucs1_encode_run(const Py_UNICODE *p,
+                                            Py_ssize_t n, char *s,
+                                            Py_UCS4 limit)
+{
+    Py_ssize_t i = 0;
+#ifdef __SSE2__
+    /* a character is below limit if it has none of the bits in high.  the
+       packs below saturate the others, and the comparisons turn into a
+       mask with a bit per character */
+    __m128i zero = _mm_setzero_si128();
+    int low;
+#if Py_UNICODE_SIZE == 2
+    __m128i high = _mm_set1_epi16((short)(0x10000 - limit));
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + i + 8));
+        _mm_storeu_si128((__m128i *)(s + i), _mm_packus_epi16(a, b));
+        low = _mm_movemask_epi8(_mm_packs_epi16(
+            _mm_cmpeq_epi16(_mm_and_si128(a, high), zero),
+            _mm_cmpeq_epi16(_mm_and_si128(b, high), zero)));
+        if (low != 0xffff)
+            return i + __builtin_ctz(~low);
+    }
+#else
+    __m128i high = _mm_set1_epi32((int)(0U - limit));
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + i + 4));
+        __m128i c = _mm_loadu_si128((const __m128i *)(p + i + 8));
+        __m128i d = _mm_loadu_si128((const __m128i *)(p + i + 12));
+        _mm_storeu_si128((__m128i *)(s + i),
+                         _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                          _mm_packs_epi32(c, d)));
+        low = _mm_movemask_epi8(_mm_packs_epi16(
+            _mm_packs_epi32(_mm_cmpeq_epi32(_mm_and_si128(a, high), zero),
+                            _mm_cmpeq_epi32(_mm_and_si128(b, high), zero)),
+            _mm_packs_epi32(_mm_cmpeq_epi32(_mm_and_si128(c, high), zero),
+                            _mm_cmpeq_epi32(_mm_and_si128(d, high), zero))));
+        if (low != 0xffff)
+            return i + __builtin_ctz(~low);
+    }
+#endif
+#else
+    int k;
+    for (; i + 8 <= n; i += 8) {
+        Py_UNICODE bits = 0;
+        for (k = 0; k < 8; k++)
+            bits |= p[i + k];
+        if (bits >= limit)
+            break;
+        for (k = 0; k < 8; k++)
+            s[i + k] = (char)p[i + k];
+    }
+#endif
+    for (; i < n && p[i] < limit; i++)
+        s[i] = (char)p[i];
+    return i;
+}
+
 /* --- UTF-8 Codec -------------------------------------------------------- */
 
 static
@@ -1896,6 +2032,7 @@ PyObject *PyUnicode_DecodeUTF8Stateful(const char *s,
     const char *starts = s;
     int n;
     int k;
+    Py_ssize_t run;
     Py_ssize_t startinpos;
     Py_ssize_t endinpos;
     Py_ssize_t outpos;
@@ -1927,6 +2064,13 @@ PyObject *PyUnicode_DecodeUTF8Stateful(const char *s,
         if (ch < 0x80) {
             *p++ = (Py_UNICODE)ch;
             s++;
+            /* and the rest of the run, unless this was a single space
+               between words of another script */
+            if (s < e && (unsigned char)*s < 0x80) {
+                run = ascii_decode_run(s, e - s, p);
+                s += run;
+                p += run;
+            }
             continue;
         }
 
@@ -2081,6 +2225,7 @@ PyUnicode_EncodeUTF8(const Py_UNICODE *s,
 #define MAX_SHORT_UNICHARS 300  /* largest size we'll do on the stack */
 
     Py_ssize_t i;           /* index into s of next input byte */
+    Py_ssize_t run;         /* length of a run of ASCII */
     PyObject *v;        /* result string object */
     char *p;            /* next free byte in output buffer */
     Py_ssize_t nallocated;  /* number of result bytes allocated */
@@ -2113,10 +2258,16 @@ PyUnicode_EncodeUTF8(const Py_UNICODE *s,
     for (i = 0; i < size;) {
         Py_UCS4 ch = s[i++];
 
-        if (ch < 0x80)
+        if (ch < 0x80) {
             /* Encode ASCII */
             *p++ = (char) ch;
-
+            if (i == size || s[i] >= 0x80)
+                continue;
+            /* and the rest of the run */
+            run = ucs1_encode_run(s + i, size - i, p, 0x80);
+            i += run;
+            p += run;
+        }
         else if (ch < 0x0800) {
             /* Encode Latin-1 */
             *p++ = (char)(0xc0 | (ch >> 6));
@@ -3461,8 +3612,7 @@ PyObject *PyUnicode_DecodeLatin1(const char *s,
     if (size == 0)
         return (PyObject *)v;
     p = PyUnicode_AS_UNICODE(v);
-    while (size-- > 0)
-        *p++ = (unsigned char)*s++;
+    latin1_decode_run(s, size, p);
     return (PyObject *)v;
 
   onError:
@@ -3602,8 +3752,9 @@ static PyObject *unicode_encode_ucs1(const Py_UNICODE *p,
         /* can we encode this? */
         if (c<limit) {
             /* no overflow check, because we know that the space is enough */
-            *str++ = (char)c;
-            ++p;
+            Py_ssize_t run = ucs1_encode_run(p, endp-p, str, limit);
+            str += run;
+            p += run;
         }
         else {
             Py_ssize_t unicodepos = p-startp;
@@ -3786,8 +3937,9 @@ PyObject *PyUnicode_DecodeASCII(const char *s,
     while (s < e) {
         register unsigned char c = (unsigned char)*s;
         if (c < 128) {
-            *p++ = c;
-            ++s;
+            Py_ssize_t run = ascii_decode_run(s, e - s, p);
+            p += run;
+            s += run;
         }
         else {
             startinpos = s-starts;
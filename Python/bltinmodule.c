@@ -815,12 +815,12 @@ globals and locals.  If only globals is given, locals defaults to it.");
 
 
 static PyObject *
-builtin_getattr(PyObject *self, PyObject *args)
+builtin_getattr(PyObject *self, PyObject **args, Py_ssize_t nargs)
 {
     PyObject *v, *result, *dflt = NULL;
     PyObject *name;
 
-    if (!PyArg_UnpackTuple(args, "getattr", 2, 3, &v, &name, &dflt))
+    if (!_PyArg_UnpackStack(args, nargs, "getattr", 2, 3, &v, &name, &dflt))
         return NULL;
 #ifdef Py_USING_UNICODE
     if (PyUnicode_Check(name)) {
@@ -871,12 +871,12 @@ Return the dictionary containing the current scope's global variables.");
 
 
 static PyObject *
-builtin_hasattr(PyObject *self, PyObject *args)
+builtin_hasattr(PyObject *self, PyObject **args, Py_ssize_t nargs)
 {
     PyObject *v;
     PyObject *name;
 
-    if (!PyArg_UnpackTuple(args, "hasattr", 2, 2, &v, &name))
+    if (!_PyArg_UnpackStack(args, nargs, "hasattr", 2, 2, &v, &name))
         return NULL;
 #ifdef Py_USING_UNICODE
     if (PyUnicode_Check(name)) {
@@ -1343,15 +1343,17 @@ PyDoc_STRVAR(locals_doc,
 Update and return a dictionary containing the current scope's local variables.");
 
 
+/* With several arguments they are compared directly, without building
+   an iterator over them. */
+
 static PyObject *
-min_max(PyObject *args, PyObject *kwds, int op)
+min_max(PyObject **args, Py_ssize_t nargs, PyObject *kwds, int op)
 {
-    PyObject *v, *it, *item, *val, *maxitem, *maxval, *keyfunc=NULL;
+    PyObject *v, *it = NULL, *item, *val, *maxitem, *maxval, *keyfunc=NULL;
     const char *name = op == Py_LT ? "min" : "max";
+    Py_ssize_t i = 0;
 
-    if (PyTuple_Size(args) > 1)
-        v = args;
-    else if (!PyArg_UnpackTuple(args, (char *)name, 1, 1, &v))
+    if (nargs <= 1 && !_PyArg_UnpackStack(args, nargs, name, 1, 1, &v))
         return NULL;
 
     if (kwds != NULL && PyDict_Check(kwds) && PyDict_Size(kwds)) {
@@ -1364,15 +1366,25 @@ min_max(PyObject *args, PyObject *kwds, int op)
         Py_INCREF(keyfunc);
     }
 
-    it = PyObject_GetIter(v);
-    if (it == NULL) {
-        Py_XDECREF(keyfunc);
-        return NULL;
+    if (nargs <= 1) {
+        it = PyObject_GetIter(v);
+        if (it == NULL) {
+            Py_XDECREF(keyfunc);
+            return NULL;
+        }
     }
 
     maxitem = NULL; /* the result */
     maxval = NULL;  /* the value associated with the result */
-    while (( item = PyIter_Next(it) )) {
+    for (;;) {
+        if (it == NULL) {
+            if (i == nargs)
+                break;
+            item = args[i++];
+            Py_INCREF(item);
+        }
+        else if ((item = PyIter_Next(it)) == NULL)
+            break;
         /* get the value from the key function */
         if (keyfunc != NULL) {
             val = PyObject_CallFunctionObjArgs(keyfunc, item, NULL);
@@ -1416,7 +1428,7 @@ min_max(PyObject *args, PyObject *kwds, int op)
     }
     else
         Py_DECREF(maxval);
-    Py_DECREF(it);
+    Py_XDECREF(it);
     Py_XDECREF(keyfunc);
     return maxitem;
 
@@ -1427,15 +1439,15 @@ Fail_it_item:
 Fail_it:
     Py_XDECREF(maxval);
     Py_XDECREF(maxitem);
-    Py_DECREF(it);
+    Py_XDECREF(it);
     Py_XDECREF(keyfunc);
     return NULL;
 }
 
 static PyObject *
-builtin_min(PyObject *self, PyObject *args, PyObject *kwds)
+builtin_min(PyObject *self, PyObject **args, Py_ssize_t nargs, PyObject *kwds)
 {
-    return min_max(args, kwds, Py_LT);
+    return min_max(args, nargs, kwds, Py_LT);
 }
 
 PyDoc_STRVAR(min_doc,
@@ -1447,9 +1459,9 @@ With two or more arguments, return the smallest argument.");
 
 
 static PyObject *
-builtin_max(PyObject *self, PyObject *args, PyObject *kwds)
+builtin_max(PyObject *self, PyObject **args, Py_ssize_t nargs, PyObject *kwds)
 {
-    return min_max(args, kwds, Py_GT);
+    return min_max(args, nargs, kwds, Py_GT);
 }
 
 PyDoc_STRVAR(max_doc,
@@ -2438,13 +2450,13 @@ empty, returns start.");
 
 
 static PyObject *
-builtin_isinstance(PyObject *self, PyObject *args)
+builtin_isinstance(PyObject *self, PyObject **args, Py_ssize_t nargs)
 {
     PyObject *inst;
     PyObject *cls;
     int retval;
 
-    if (!PyArg_UnpackTuple(args, "isinstance", 2, 2, &inst, &cls))
+    if (!_PyArg_UnpackStack(args, nargs, "isinstance", 2, 2, &inst, &cls))
         return NULL;
 
     retval = PyObject_IsInstance(inst, cls);
@@ -2463,13 +2475,13 @@ isinstance(x, A) or isinstance(x, B) or ... (etc.).");
 
 
 static PyObject *
-builtin_issubclass(PyObject *self, PyObject *args)
+builtin_issubclass(PyObject *self, PyObject **args, Py_ssize_t nargs)
 {
     PyObject *derived;
     PyObject *cls;
     int retval;
 
-    if (!PyArg_UnpackTuple(args, "issubclass", 2, 2, &derived, &cls))
+    if (!_PyArg_UnpackStack(args, nargs, "issubclass", 2, 2, &derived, &cls))
         return NULL;
 
     retval = PyObject_IsSubclass(derived, cls);
@@ -2624,22 +2636,22 @@ static PyMethodDef builtin_methods[] = {
 #endif
     {"filter",          builtin_filter,     METH_VARARGS, filter_doc},
     {"format",          builtin_format,     METH_VARARGS, format_doc},
-    {"getattr",         builtin_getattr,    METH_VARARGS, getattr_doc},
+    {"getattr",         (PyCFunction)builtin_getattr, METH_FASTCALL, getattr_doc},
     {"globals",         (PyCFunction)builtin_globals,    METH_NOARGS, globals_doc},
-    {"hasattr",         builtin_hasattr,    METH_VARARGS, hasattr_doc},
+    {"hasattr",         (PyCFunction)builtin_hasattr, METH_FASTCALL, hasattr_doc},
     {"hash",            builtin_hash,       METH_O, hash_doc},
     {"hex",             builtin_hex,        METH_O, hex_doc},
     {"id",              builtin_id,         METH_O, id_doc},
     {"input",           builtin_input,      METH_VARARGS, input_doc},
     {"intern",          builtin_intern,     METH_VARARGS, intern_doc},
-    {"isinstance",  builtin_isinstance, METH_VARARGS, isinstance_doc},
-    {"issubclass",  builtin_issubclass, METH_VARARGS, issubclass_doc},
+    {"isinstance",  (PyCFunction)builtin_isinstance, METH_FASTCALL, isinstance_doc},
+    {"issubclass",  (PyCFunction)builtin_issubclass, METH_FASTCALL, issubclass_doc},
     {"iter",            builtin_iter,       METH_VARARGS, iter_doc},
     {"len",             builtin_len,        METH_O, len_doc},
     {"locals",          (PyCFunction)builtin_locals,     METH_NOARGS, locals_doc},
     {"map",             builtin_map,        METH_VARARGS, map_doc},
-    {"max",             (PyCFunction)builtin_max,        METH_VARARGS | METH_KEYWORDS, max_doc},
-    {"min",             (PyCFunction)builtin_min,        METH_VARARGS | METH_KEYWORDS, min_doc},
+    {"max",             (PyCFunction)builtin_max,        METH_FASTCALL | METH_KEYWORDS, max_doc},
+    {"min",             (PyCFunction)builtin_min,        METH_FASTCALL | METH_KEYWORDS, min_doc},
     {"next",            builtin_next,       METH_VARARGS, next_doc},
     {"oct",             builtin_oct,        METH_O, oct_doc},
     {"open",            (PyCFunction)builtin_open,       METH_VARARGS | METH_KEYWORDS, open_doc},
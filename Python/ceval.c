@@ -149,6 +149,7 @@ static PyObject * string_concatenate(PyObject *, PyObject *,
                                      PyFrameObject *, unsigned char *);
 static PyObject * kwd_as_string(PyObject *);
 static PyObject * special_lookup(PyObject *, char *, PyObject **);
+static PyObject * load_attr_cached(_PyOpcache *, PyObject *, PyObject *);
 
 #define NAME_ERROR_MSG \
     "name '%.200s' is not defined"
@@ -234,36 +235,83 @@ PyEval_GetCallStats(PyObject *self)
 #endif
 #include "pythread.h"
 
-static PyThread_type_lock interpreter_lock = 0; /* This is the GIL */
 static PyThread_type_lock pending_lock = 0; /* for pending calls */
 static long main_thread = 0;
 
+#if (defined(_POSIX_THREADS) && !defined(HAVE_PTH)) || defined(NT_THREADS)
+
+#include "ceval_gil.h"
+
+#else
+
+/* The other thread libraries of Python/thread.c have no condition
+   variables, so they keep the old GIL: a plain lock which the main loop
+   releases and takes again at every periodic check.  The switch
+   interval is kept for sys.getswitchinterval() but has no effect. */
+
+static PyThread_type_lock interpreter_lock = 0; /* This is the GIL */
+static unsigned long gil_interval = 5000;
+
+#define gil_created() (interpreter_lock != 0)
+#define gil_drop_request gil_created()
+#define create_gil() (interpreter_lock = PyThread_allocate_lock())
+#define recreate_gil() create_gil()
+#define take_gil(tstate) PyThread_acquire_lock(interpreter_lock, 1)
+#define drop_gil(tstate) PyThread_release_lock(interpreter_lock)
+
+void _PyEval_SetSwitchInterval(unsigned long microseconds)
+{
+    gil_interval = microseconds;
+}
+
+unsigned long _PyEval_GetSwitchInterval(void)
+{
+    return gil_interval;
+}
+
+#ifdef STACKLESS
+void slp_gil_handoff(PyThreadState *tstate)
+{
+    /* the woken up thread just competes for the lock */
+}
+#endif
+
+#endif
+
 int
 PyEval_ThreadsInitialized(void)
 {
-    return interpreter_lock != 0;
+    return gil_created();
 }
 
 void
 PyEval_InitThreads(void)
 {
-    if (interpreter_lock)
+    if (gil_created())
         return;
-    interpreter_lock = PyThread_allocate_lock();
-    PyThread_acquire_lock(interpreter_lock, 1);
+    create_gil();
+    take_gil(PyThreadState_GET());
     main_thread = PyThread_get_thread_ident();
+    if (!pending_lock)
+        pending_lock = PyThread_allocate_lock();
 }
 
 void
 PyEval_AcquireLock(void)
 {
-    PyThread_acquire_lock(interpreter_lock, 1);
+    /* Existing callers take the lock before making a thread state
+       current, so NULL is fine here. */
+    take_gil((PyThreadState*)_PyThreadState_Current);
 }
 
 void
 PyEval_ReleaseLock(void)
 {
-    PyThread_release_lock(interpreter_lock);
+    /* This function must succeed when the current thread state is NULL.
+       We therefore avoid PyThreadState_GET() which dumps a fatal error
+       in debug mode.
+    */
+    drop_gil((PyThreadState*)_PyThreadState_Current);
 }
 
 void
@@ -272,8 +320,8 @@ PyEval_AcquireThread(PyThreadState *tstate)
     if (tstate == NULL)
         Py_FatalError("PyEval_AcquireThread: NULL new thread state");
     /* Check someone has called PyEval_InitThreads() to create the lock */
-    assert(interpreter_lock);
-    PyThread_acquire_lock(interpreter_lock, 1);
+    assert(gil_created());
+    take_gil(tstate);
     if (PyThreadState_Swap(tstate) != NULL)
         Py_FatalError(
             "PyEval_AcquireThread: non-NULL old thread state");
@@ -286,7 +334,7 @@ PyEval_ReleaseThread(PyThreadState *tstate)
         Py_FatalError("PyEval_ReleaseThread: NULL thread state");
     if (PyThreadState_Swap(NULL) != tstate)
         Py_FatalError("PyEval_ReleaseThread: wrong thread state");
-    PyThread_release_lock(interpreter_lock);
+    drop_gil(tstate);
 }
 
 /* This function is called from PyOS_AfterFork to ensure that newly
@@ -298,22 +346,21 @@ void
 PyEval_ReInitThreads(void)
 {
     PyObject *threading, *result;
-    PyThreadState *tstate;
+    PyThreadState *tstate = PyThreadState_GET();
 
-    if (!interpreter_lock)
+    if (!gil_created())
         return;
     /*XXX Can't use PyThread_free_lock here because it does too
       much error-checking.  Doing this cleanly would require
       adding a new function to each thread_*.h.  Instead, just
       create a new lock and waste a little bit of memory */
-    interpreter_lock = PyThread_allocate_lock();
+    recreate_gil();
     pending_lock = PyThread_allocate_lock();
-    PyThread_acquire_lock(interpreter_lock, 1);
+    take_gil(tstate);
     main_thread = PyThread_get_thread_ident();
 
     /* Update the threading module with the new state.
      */
-    tstate = PyThreadState_GET();
     threading = PyMapping_GetItemString(tstate->interp->modules,
                                         "threading");
     if (threading == NULL) {
@@ -341,8 +388,8 @@ PyEval_SaveThread(void)
     if (tstate == NULL)
         Py_FatalError("PyEval_SaveThread: NULL tstate");
 #ifdef WITH_THREAD
-    if (interpreter_lock)
-        PyThread_release_lock(interpreter_lock);
+    if (gil_created())
+        drop_gil(tstate);
 #endif
     return tstate;
 }
@@ -353,9 +400,9 @@ PyEval_RestoreThread(PyThreadState *tstate)
     if (tstate == NULL)
         Py_FatalError("PyEval_RestoreThread: NULL tstate");
 #ifdef WITH_THREAD
-    if (interpreter_lock) {
+    if (gil_created()) {
         int err = errno;
-        PyThread_acquire_lock(interpreter_lock, 1);
+        take_gil(tstate);
         errno = err;
     }
 #endif
@@ -657,6 +704,15 @@ static int unpack_iterable(PyObject *, int, PyObject **);
    fast_next_opcode*/
 static int _Py_TracingPossible = 0;
 
+/* The runtime opcode profile, see sys.setopcodeprofile().  While it is
+   on, _Py_TracingPossible is raised by one so that every opcode passes
+   fast_next_opcode, also with computed gotos, and PREDICT() is
+   suppressed.  When it is off the main loop pays nothing for it. */
+static int opcode_profile = 0;
+static int opcode_profile_last = 0;
+static _Py_profcount_t (*opcode_pairs)[256] = NULL;
+static void profile_opcode(PyCodeObject *, int);
+
 /* for manipulating the thread switch and periodic "stuff" - used to be
    per thread, now just a pair o' globals */
 int _Py_CheckInterval = 100;
@@ -725,6 +781,7 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
     PyObject *retval = NULL;            /* Return value */
     PyThreadState *tstate = PyThreadState_GET();
     PyCodeObject *co;
+    _PyOpcache *oc;             /* Inline cache of the current opcode */
 
     /* when tracing we set things up so that
 
@@ -823,12 +880,17 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
     predictions turned-on and interpret the results as if some opcodes
     had been combined or turn-off predictions so that the opcode frequency
     counter updates for both opcodes.
+
+    With computed gotos, every opcode ends in its own indirect jump, which
+    the processor predicts separately, so PREDICT() is turned off.
 */
 
-#ifdef DYNAMIC_EXECUTION_PROFILE
+#if defined(DYNAMIC_EXECUTION_PROFILE) || defined(USE_COMPUTED_GOTOS)
 #define PREDICT(op)             if (0) goto PRED_##op
 #else
-#define PREDICT(op)             if (*next_instr == op) goto PRED_##op
+/* the runtime opcode profile has to see both opcodes */
+#define PREDICT(op) \
+    if (*next_instr == op && !opcode_profile) goto PRED_##op
 #endif
 
 #define PREDICTED(op)           PRED_##op: next_instr++
@@ -846,6 +908,100 @@ PyEval_EvalFrameEx(PyFrameObject *f, int throwflag)
 #endif
 #endif
 
+/* Computed gotos ("threaded code")
+    When configured --with-computed-gotos, each opcode jumps directly to
+    the next one through the opcode_targets table, instead of going back
+    to the single switch at the top of the loop. TARGET() emits both the
+    label and the case, so the switch is still used after the periodic
+    checks, for EXTENDED_ARG and for tracing. DISPATCH() replaces
+    "continue" and keeps the _Py_Ticker countdown, so the periodic code,
+    thread switching and the Stackless watchdog interrupt still run at
+    the same rate. FAST_DISPATCH() replaces "goto fast_next_opcode".
+    Opcodes sharing one implementation jump to it with TARGET_WITH_IMPL(),
+    so that each of them still sets opcode.
+*/
+
+#if defined(DYNAMIC_EXECUTION_PROFILE) && defined(USE_COMPUTED_GOTOS)
+#undef USE_COMPUTED_GOTOS
+#endif
+
+#ifdef USE_COMPUTED_GOTOS
+
+#define TARGET_LABEL(label, op) \
+    label: \
+        opcode = op; \
+        if (HAS_ARG(op)) \
+            oparg = NEXTARG(); \
+    case op:
+
+#define TARGET(op)                      TARGET_LABEL(TARGET_##op, op)
+#define TARGET_WITH_IMPL(op, impl)      TARGET_LABEL(TARGET_##op, op) goto impl;
+#define TARGET_SLICE(name, op, impl)    TARGET_LABEL(TARGET_##name, op) goto impl;
+
+#ifdef LLTRACE
+#define FAST_DISPATCH() \
+    { \
+        if (!lltrace && !_Py_TracingPossible) { \
+            f->f_lasti = INSTR_OFFSET(); \
+            goto *opcode_targets[*next_instr++]; \
+        } \
+        goto fast_next_opcode; \
+    }
+#else
+#define FAST_DISPATCH() \
+    { \
+        if (!_Py_TracingPossible) { \
+            f->f_lasti = INSTR_OFFSET(); \
+            goto *opcode_targets[*next_instr++]; \
+        } \
+        goto fast_next_opcode; \
+    }
+#endif
+
+#define DISPATCH() \
+    { \
+        if (_Py_Ticker > 0) { \
+            --_Py_Ticker; \
+            FAST_DISPATCH(); \
+        } \
+        continue; \
+    }
+
+#else
+
+#define TARGET(op)                      case op:
+#define TARGET_WITH_IMPL(op, impl)      if (0) goto impl; case op:
+#define TARGET_SLICE(name, op, impl)    if (0) goto impl; case op:
+#define FAST_DISPATCH()                 goto fast_next_opcode
+#define DISPATCH()                      continue
+
+#endif
+
+/* Inline caches: OPCACHE_CHECK() points oc at the cache of the current
+   instruction, or sets it to NULL if the code object has none (yet).
+   Only valid directly after the 3 byte instruction has been fetched. */
+
+#define OPCACHE_CHECK() \
+    do { \
+        oc = NULL; \
+        if (co->co_opcache != NULL) { \
+            unsigned char oi = co->co_opcache_map[INSTR_OFFSET() - 3]; \
+            if (oi != 0) \
+                oc = &co->co_opcache[oi - 1]; \
+        } \
+    } while (0)
+
+/* Superinstructions: SECOND_INSTR() skips the opcode of the second
+   instruction of a pair and fetches its argument.  f_lasti is set to it,
+   so that an error there is reported at its line. */
+
+#define SECOND_INSTR() \
+    do { \
+        next_instr++; \
+        oparg = NEXTARG(); \
+        f->f_lasti = INSTR_OFFSET() - 3; \
+    } while (0)
+
 /* Stack manipulation macros */
 
 /* The stack can grow at most MAXINT deep, as co_nlocals and
@@ -1024,6 +1180,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
     register PyObject **fastlocals, **freevars;
     PyThreadState *tstate = PyThreadState_GET();
     PyCodeObject *co;
+    _PyOpcache *oc;             /* Inline cache of the current opcode */
 
     /* when tracing we set things up so that
 
@@ -1043,6 +1200,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
 #endif
 
 #endif /* STACKLESS */
+#ifdef USE_COMPUTED_GOTOS
+/* Import the static jump table, labels are local to this function */
+#include "opcode_targets.h"
+#endif
 
     co = f->f_code;
     names = co->co_names;
@@ -1050,6 +1211,12 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
     fastlocals = f->f_localsplus;
     freevars = f->f_localsplus + co->co_nlocals;
     first_instr = (unsigned char*) PyString_AS_STRING(co->co_code);
+    if (co->co_opcache_flag < _PyCode_OPCACHE_MIN_RUNS &&
+        ++co->co_opcache_flag == _PyCode_OPCACHE_MIN_RUNS) {
+        /* The code is hot, give it inline caches.  Without memory
+           it runs just as well without them. */
+        (void)_PyCode_InitOpcache(co);
+    }
     /* An explanation is in order for the next line.
 
        f->f_lasti now refers to the index of the last instruction
@@ -1217,19 +1384,20 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     _Py_Ticker = 0;
             }
 #ifdef WITH_THREAD
-            if (interpreter_lock) {
+            if (gil_drop_request) {
                 /* Give another thread a chance */
 
                 if (PyThreadState_Swap(NULL) != tstate)
                     Py_FatalError("ceval: tstate mix-up");
-                PyThread_release_lock(interpreter_lock);
+                drop_gil(tstate);
 
                 /* Other threads may run now */
 
-                PyThread_acquire_lock(interpreter_lock, 1);
+                take_gil(tstate);
                 if (PyThreadState_Swap(tstate) != NULL)
                     Py_FatalError("ceval: orphan tstate");
-
+            }
+            if (gil_created()) {
                 /* Check for thread interrupts */
 
                 if (tstate->async_exc != NULL) {
@@ -1249,26 +1417,29 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
 
         /* line-by-line tracing support */
 
-        if (_Py_TracingPossible &&
-            tstate->c_tracefunc != NULL && !tstate->tracing) {
-            /* see maybe_call_line_trace
-               for expository comments */
-            f->f_stacktop = stack_pointer;
-
-            err = maybe_call_line_trace(tstate->c_tracefunc,
-                                        tstate->c_traceobj,
-                                        f, &instr_lb, &instr_ub,
-                                        &instr_prev);
-            /* Reload possibly changed frame fields */
-            JUMPTO(f->f_lasti);
-            if (f->f_stacktop != NULL) {
-                stack_pointer = f->f_stacktop;
-                f->f_stacktop = NULL;
-            }
-            if (err) {
-                /* trace function raised an exception */
-                goto on_error;
+        if (_Py_TracingPossible) {
+            if (tstate->c_tracefunc != NULL && !tstate->tracing) {
+                /* see maybe_call_line_trace
+                   for expository comments */
+                f->f_stacktop = stack_pointer;
+
+                err = maybe_call_line_trace(tstate->c_tracefunc,
+                                            tstate->c_traceobj,
+                                            f, &instr_lb, &instr_ub,
+                                            &instr_prev);
+                /* Reload possibly changed frame fields */
+                JUMPTO(f->f_lasti);
+                if (f->f_stacktop != NULL) {
+                    stack_pointer = f->f_stacktop;
+                    f->f_stacktop = NULL;
+                }
+                if (err) {
+                    /* trace function raised an exception */
+                    goto on_error;
+                }
             }
+            if (opcode_profile)
+                profile_opcode(co, INSTR_OFFSET());
         }
 
         /* Extract opcode and argument */
@@ -1314,55 +1485,57 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
 
         /* case STOP_CODE: this is an error! */
 
-        case NOP:
-            goto fast_next_opcode;
+        TARGET(NOP)
+            FAST_DISPATCH();
 
-        case LOAD_FAST:
+        TARGET(LOAD_FAST)
+        _load_fast:
             x = GETLOCAL(oparg);
             if (x != NULL) {
                 Py_INCREF(x);
                 PUSH(x);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             format_exc_check_arg(PyExc_UnboundLocalError,
                 UNBOUNDLOCAL_ERROR_MSG,
                 PyTuple_GetItem(co->co_varnames, oparg));
             break;
 
-        case LOAD_CONST:
+        TARGET(LOAD_CONST)
+        _load_const:
             x = GETITEM(consts, oparg);
             Py_INCREF(x);
             PUSH(x);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
         PREDICTED_WITH_ARG(STORE_FAST);
-        case STORE_FAST:
+        TARGET(STORE_FAST)
             v = POP();
             SETLOCAL(oparg, v);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case POP_TOP:
+        TARGET(POP_TOP)
             v = POP();
             Py_DECREF(v);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case ROT_TWO:
+        TARGET(ROT_TWO)
             v = TOP();
             w = SECOND();
             SET_TOP(w);
             SET_SECOND(v);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case ROT_THREE:
+        TARGET(ROT_THREE)
             v = TOP();
             w = SECOND();
             x = THIRD();
             SET_TOP(w);
             SET_SECOND(x);
             SET_THIRD(v);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case ROT_FOUR:
+        TARGET(ROT_FOUR)
             u = TOP();
             v = SECOND();
             w = THIRD();
@@ -1371,15 +1544,15 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             SET_SECOND(w);
             SET_THIRD(x);
             SET_FOURTH(u);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case DUP_TOP:
+        TARGET(DUP_TOP)
             v = TOP();
             Py_INCREF(v);
             PUSH(v);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
-        case DUP_TOPX:
+        TARGET(DUP_TOPX)
             if (oparg == 2) {
                 x = TOP();
                 Py_INCREF(x);
@@ -1388,7 +1561,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 STACKADJ(2);
                 SET_TOP(x);
                 SET_SECOND(w);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             } else if (oparg == 3) {
                 x = TOP();
                 Py_INCREF(x);
@@ -1400,84 +1573,84 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 SET_TOP(x);
                 SET_SECOND(w);
                 SET_THIRD(v);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             Py_FatalError("invalid argument to DUP_TOPX"
                           " (bytecode corruption?)");
             /* Never returns, so don't bother to set why. */
             break;
 
-        case UNARY_POSITIVE:
+        TARGET(UNARY_POSITIVE)
             v = TOP();
             x = PyNumber_Positive(v);
             Py_DECREF(v);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case UNARY_NEGATIVE:
+        TARGET(UNARY_NEGATIVE)
             v = TOP();
             x = PyNumber_Negative(v);
             Py_DECREF(v);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case UNARY_NOT:
+        TARGET(UNARY_NOT)
             v = TOP();
             err = PyObject_IsTrue(v);
             Py_DECREF(v);
             if (err == 0) {
                 Py_INCREF(Py_True);
                 SET_TOP(Py_True);
-                continue;
+                DISPATCH();
             }
             else if (err > 0) {
                 Py_INCREF(Py_False);
                 SET_TOP(Py_False);
                 err = 0;
-                continue;
+                DISPATCH();
             }
             STACKADJ(-1);
             break;
 
-        case UNARY_CONVERT:
+        TARGET(UNARY_CONVERT)
             v = TOP();
             x = PyObject_Repr(v);
             Py_DECREF(v);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case UNARY_INVERT:
+        TARGET(UNARY_INVERT)
             v = TOP();
             x = PyNumber_Invert(v);
             Py_DECREF(v);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_POWER:
+        TARGET(BINARY_POWER)
             w = POP();
             v = TOP();
             x = PyNumber_Power(v, w, Py_None);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_MULTIPLY:
+        TARGET(BINARY_MULTIPLY)
             w = POP();
             v = TOP();
             x = PyNumber_Multiply(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_DIVIDE:
+        TARGET(BINARY_DIVIDE)
             if (!_Py_QnewFlag) {
                 w = POP();
                 v = TOP();
@@ -1485,32 +1658,32 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 Py_DECREF(v);
                 Py_DECREF(w);
                 SET_TOP(x);
-                if (x != NULL) continue;
+                if (x != NULL) DISPATCH();
                 break;
             }
             /* -Qnew is in effect:  fall through to
                BINARY_TRUE_DIVIDE */
-        case BINARY_TRUE_DIVIDE:
+        TARGET(BINARY_TRUE_DIVIDE)
             w = POP();
             v = TOP();
             x = PyNumber_TrueDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_FLOOR_DIVIDE:
+        TARGET(BINARY_FLOOR_DIVIDE)
             w = POP();
             v = TOP();
             x = PyNumber_FloorDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_MODULO:
+        TARGET(BINARY_MODULO)
             w = POP();
             v = TOP();
             if (PyString_CheckExact(v))
@@ -1520,10 +1693,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_ADD:
+        TARGET(BINARY_ADD)
             w = POP();
             v = TOP();
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
@@ -1552,10 +1725,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
           skip_decref_vx:
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_SUBTRACT:
+        TARGET(BINARY_SUBTRACT)
             w = POP();
             v = TOP();
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
@@ -1577,10 +1750,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_SUBSCR:
+        TARGET(BINARY_SUBSCR)
             w = POP();
             v = TOP();
             if (PyList_CheckExact(v) && PyInt_CheckExact(w)) {
@@ -1601,102 +1774,102 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_LSHIFT:
+        TARGET(BINARY_LSHIFT)
             w = POP();
             v = TOP();
             x = PyNumber_Lshift(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_RSHIFT:
+        TARGET(BINARY_RSHIFT)
             w = POP();
             v = TOP();
             x = PyNumber_Rshift(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_AND:
+        TARGET(BINARY_AND)
             w = POP();
             v = TOP();
             x = PyNumber_And(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_XOR:
+        TARGET(BINARY_XOR)
             w = POP();
             v = TOP();
             x = PyNumber_Xor(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case BINARY_OR:
+        TARGET(BINARY_OR)
             w = POP();
             v = TOP();
             x = PyNumber_Or(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case LIST_APPEND:
+        TARGET(LIST_APPEND)
             w = POP();
             v = PEEK(oparg);
             err = PyList_Append(v, w);
             Py_DECREF(w);
             if (err == 0) {
                 PREDICT(JUMP_ABSOLUTE);
-                continue;
+                DISPATCH();
             }
             break;
 
-        case SET_ADD:
+        TARGET(SET_ADD)
             w = POP();
             v = stack_pointer[-oparg];
             err = PySet_Add(v, w);
             Py_DECREF(w);
             if (err == 0) {
                 PREDICT(JUMP_ABSOLUTE);
-                continue;
+                DISPATCH();
             }
             break;
 
-        case INPLACE_POWER:
+        TARGET(INPLACE_POWER)
             w = POP();
             v = TOP();
             x = PyNumber_InPlacePower(v, w, Py_None);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_MULTIPLY:
+        TARGET(INPLACE_MULTIPLY)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceMultiply(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_DIVIDE:
+        TARGET(INPLACE_DIVIDE)
             if (!_Py_QnewFlag) {
                 w = POP();
                 v = TOP();
@@ -1704,42 +1877,42 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 Py_DECREF(v);
                 Py_DECREF(w);
                 SET_TOP(x);
-                if (x != NULL) continue;
+                if (x != NULL) DISPATCH();
                 break;
             }
             /* -Qnew is in effect:  fall through to
                INPLACE_TRUE_DIVIDE */
-        case INPLACE_TRUE_DIVIDE:
+        TARGET(INPLACE_TRUE_DIVIDE)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceTrueDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_FLOOR_DIVIDE:
+        TARGET(INPLACE_FLOOR_DIVIDE)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceFloorDivide(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_MODULO:
+        TARGET(INPLACE_MODULO)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceRemainder(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_ADD:
+        TARGET(INPLACE_ADD)
             w = POP();
             v = TOP();
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
@@ -1766,10 +1939,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
           skip_decref_v:
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_SUBTRACT:
+        TARGET(INPLACE_SUBTRACT)
             w = POP();
             v = TOP();
             if (PyInt_CheckExact(v) && PyInt_CheckExact(w)) {
@@ -1789,63 +1962,64 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_LSHIFT:
+        TARGET(INPLACE_LSHIFT)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceLshift(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_RSHIFT:
+        TARGET(INPLACE_RSHIFT)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceRshift(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_AND:
+        TARGET(INPLACE_AND)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceAnd(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_XOR:
+        TARGET(INPLACE_XOR)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceXor(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case INPLACE_OR:
+        TARGET(INPLACE_OR)
             w = POP();
             v = TOP();
             x = PyNumber_InPlaceOr(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case SLICE+0:
-        case SLICE+1:
-        case SLICE+2:
-        case SLICE+3:
+        TARGET_SLICE(SLICE_0, SLICE+0, _slice)
+        TARGET_SLICE(SLICE_1, SLICE+1, _slice)
+        TARGET_SLICE(SLICE_2, SLICE+2, _slice)
+        TARGET_SLICE(SLICE_3, SLICE+3, _slice)
+        _slice:
             if ((opcode-SLICE) & 2)
                 w = POP();
             else
@@ -1860,13 +2034,14 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_XDECREF(v);
             Py_XDECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case STORE_SLICE+0:
-        case STORE_SLICE+1:
-        case STORE_SLICE+2:
-        case STORE_SLICE+3:
+        TARGET_SLICE(STORE_SLICE_0, STORE_SLICE+0, _store_slice)
+        TARGET_SLICE(STORE_SLICE_1, STORE_SLICE+1, _store_slice)
+        TARGET_SLICE(STORE_SLICE_2, STORE_SLICE+2, _store_slice)
+        TARGET_SLICE(STORE_SLICE_3, STORE_SLICE+3, _store_slice)
+        _store_slice:
             if ((opcode-STORE_SLICE) & 2)
                 w = POP();
             else
@@ -1882,13 +2057,14 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(u);
             Py_XDECREF(v);
             Py_XDECREF(w);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case DELETE_SLICE+0:
-        case DELETE_SLICE+1:
-        case DELETE_SLICE+2:
-        case DELETE_SLICE+3:
+        TARGET_SLICE(DELETE_SLICE_0, DELETE_SLICE+0, _delete_slice)
+        TARGET_SLICE(DELETE_SLICE_1, DELETE_SLICE+1, _delete_slice)
+        TARGET_SLICE(DELETE_SLICE_2, DELETE_SLICE+2, _delete_slice)
+        TARGET_SLICE(DELETE_SLICE_3, DELETE_SLICE+3, _delete_slice)
+        _delete_slice:
             if ((opcode-DELETE_SLICE) & 2)
                 w = POP();
             else
@@ -1903,10 +2079,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(u);
             Py_XDECREF(v);
             Py_XDECREF(w);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case STORE_SUBSCR:
+        TARGET(STORE_SUBSCR)
             w = TOP();
             v = SECOND();
             u = THIRD();
@@ -1916,10 +2092,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(u);
             Py_DECREF(v);
             Py_DECREF(w);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case DELETE_SUBSCR:
+        TARGET(DELETE_SUBSCR)
             w = TOP();
             v = SECOND();
             STACKADJ(-2);
@@ -1927,10 +2103,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             err = PyObject_DelItem(v, w);
             Py_DECREF(v);
             Py_DECREF(w);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case PRINT_EXPR:
+        TARGET(PRINT_EXPR)
             v = POP();
             w = PySys_GetObject("displayhook");
             if (w == NULL) {
@@ -1954,11 +2130,11 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_XDECREF(x);
             break;
 
-        case PRINT_ITEM_TO:
+        TARGET(PRINT_ITEM_TO)
             w = stream = POP();
             /* fall through to PRINT_ITEM */
 
-        case PRINT_ITEM:
+        TARGET(PRINT_ITEM)
             v = POP();
             if (stream == NULL || stream == Py_None) {
                 w = PySys_GetObject("stdout");
@@ -2005,14 +2181,14 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_XDECREF(stream);
             stream = NULL;
             if (err == 0)
-                continue;
+                DISPATCH();
             break;
 
-        case PRINT_NEWLINE_TO:
+        TARGET(PRINT_NEWLINE_TO)
             w = stream = POP();
             /* fall through to PRINT_NEWLINE */
 
-        case PRINT_NEWLINE:
+        TARGET(PRINT_NEWLINE)
             if (stream == NULL || stream == Py_None) {
                 w = PySys_GetObject("stdout");
                 if (w == NULL) {
@@ -2038,7 +2214,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
 #ifdef CASE_TOO_BIG
         default: switch (opcode) {
 #endif
-        case RAISE_VARARGS:
+        TARGET(RAISE_VARARGS)
             u = v = w = NULL;
             switch (oparg) {
             case 3:
@@ -2060,27 +2236,27 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             }
             break;
 
-        case LOAD_LOCALS:
+        TARGET(LOAD_LOCALS)
             if ((x = f->f_locals) != NULL) {
                 Py_INCREF(x);
                 PUSH(x);
-                continue;
+                DISPATCH();
             }
             PyErr_SetString(PyExc_SystemError, "no locals");
             break;
 
-        case RETURN_VALUE:
+        TARGET(RETURN_VALUE)
             retval = POP();
             why = WHY_RETURN;
             goto fast_block_end;
 
-        case YIELD_VALUE:
+        TARGET(YIELD_VALUE)
             retval = POP();
             f->f_stacktop = stack_pointer;
             why = WHY_YIELD;
             goto fast_yield;
 
-        case EXEC_STMT:
+        TARGET(EXEC_STMT)
             w = TOP();
             v = SECOND();
             u = THIRD();
@@ -2093,7 +2269,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(w);
             break;
 
-        case POP_BLOCK:
+        TARGET(POP_BLOCK)
             {
                 PyTryBlock *b = PyFrame_BlockPop(f);
                 while (STACK_LEVEL() > b->b_level) {
@@ -2101,10 +2277,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     Py_DECREF(v);
                 }
             }
-            continue;
+            DISPATCH();
 
         PREDICTED(END_FINALLY);
-        case END_FINALLY:
+        TARGET(END_FINALLY)
             v = POP();
             if (PyInt_Check(v)) {
                 why = (enum why_code) PyInt_AS_LONG(v);
@@ -2129,7 +2305,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             break;
 
-        case BUILD_CLASS:
+        TARGET(BUILD_CLASS)
             u = TOP();
             v = SECOND();
             w = THIRD();
@@ -2141,7 +2317,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(w);
             break;
 
-        case STORE_NAME:
+        TARGET(STORE_NAME)
             w = GETITEM(names, oparg);
             v = POP();
             if ((x = f->f_locals) != NULL) {
@@ -2150,7 +2326,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 else
                     err = PyObject_SetItem(x, w, v);
                 Py_DECREF(v);
-                if (err == 0) continue;
+                if (err == 0) DISPATCH();
                 break;
             }
             PyErr_Format(PyExc_SystemError,
@@ -2158,7 +2334,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                          PyObject_REPR(w));
             break;
 
-        case DELETE_NAME:
+        TARGET(DELETE_NAME)
             w = GETITEM(names, oparg);
             if ((x = f->f_locals) != NULL) {
                 if ((err = PyObject_DelItem(x, w)) != 0)
@@ -2173,7 +2349,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             break;
 
         PREDICTED_WITH_ARG(UNPACK_SEQUENCE);
-        case UNPACK_SEQUENCE:
+        TARGET(UNPACK_SEQUENCE)
             v = POP();
             if (PyTuple_CheckExact(v) &&
                 PyTuple_GET_SIZE(v) == oparg) {
@@ -2185,7 +2361,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     PUSH(w);
                 }
                 Py_DECREF(v);
-                continue;
+                DISPATCH();
             } else if (PyList_CheckExact(v) &&
                        PyList_GET_SIZE(v) == oparg) {
                 PyObject **items = \
@@ -2205,7 +2381,7 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             break;
 
-        case STORE_ATTR:
+        TARGET(STORE_ATTR)
             w = GETITEM(names, oparg);
             v = TOP();
             u = SECOND();
@@ -2213,10 +2389,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             err = PyObject_SetAttr(v, w, u); /* v.w = u */
             Py_DECREF(v);
             Py_DECREF(u);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case DELETE_ATTR:
+        TARGET(DELETE_ATTR)
             w = GETITEM(names, oparg);
             v = POP();
             err = PyObject_SetAttr(v, w, (PyObject *)NULL);
@@ -2224,22 +2400,22 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(v);
             break;
 
-        case STORE_GLOBAL:
+        TARGET(STORE_GLOBAL)
             w = GETITEM(names, oparg);
             v = POP();
             err = PyDict_SetItem(f->f_globals, w, v);
             Py_DECREF(v);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case DELETE_GLOBAL:
+        TARGET(DELETE_GLOBAL)
             w = GETITEM(names, oparg);
             if ((err = PyDict_DelItem(f->f_globals, w)) != 0)
                 format_exc_check_arg(
                     PyExc_NameError, GLOBAL_NAME_ERROR_MSG, w);
             break;
 
-        case LOAD_NAME:
+        TARGET(LOAD_NAME)
             w = GETITEM(names, oparg);
             if ((v = f->f_locals) == NULL) {
                 PyErr_Format(PyExc_SystemError,
@@ -2275,44 +2451,50 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 Py_INCREF(x);
             }
             PUSH(x);
-            continue;
+            DISPATCH();
 
-        case LOAD_GLOBAL:
+        TARGET(LOAD_GLOBAL)
             w = GETITEM(names, oparg);
+            OPCACHE_CHECK();
+            if (oc != NULL) {
+                _PyOpcache_LoadGlobal *lg = &oc->u.lg;
+                Py_dictversion_t gv = _PyDict_VERSION(f->f_globals);
+                Py_dictversion_t bv = _PyDict_VERSION(f->f_builtins);
+                if (lg->globals_ver == gv && lg->builtins_ver == bv) {
+                    x = lg->ptr;
+                    Py_INCREF(x);
+                    PUSH(x);
+                    DISPATCH();
+                }
+                x = PyDict_GetItem(f->f_globals, w);
+                if (x == NULL) {
+                    x = PyDict_GetItem(f->f_builtins, w);
+                    if (x == NULL)
+                        goto load_global_error;
+                }
+                /* the versions from before the lookups are safe: if
+                   it mutated a dict, the entry just never matches */
+                lg->globals_ver = gv;
+                lg->builtins_ver = bv;
+                lg->ptr = x;
+                Py_INCREF(x);
+                PUSH(x);
+                DISPATCH();
+            }
             if (PyString_CheckExact(w)) {
-                /* Inline the PyDict_GetItem() calls.
-                   WARNING: this is an extreme speed hack.
-                   Do not try this at home. */
-                long hash = ((PyStringObject *)w)->ob_shash;
-                if (hash != -1) {
-                    PyDictObject *d;
-                    PyDictEntry *e;
-                    d = (PyDictObject *)(f->f_globals);
-                    e = d->ma_lookup(d, w, hash);
-                    if (e == NULL) {
-                        x = NULL;
-                        break;
-                    }
-                    x = e->me_value;
-                    if (x != NULL) {
-                        Py_INCREF(x);
-                        PUSH(x);
-                        continue;
-                    }
-                    d = (PyDictObject *)(f->f_builtins);
-                    e = d->ma_lookup(d, w, hash);
-                    if (e == NULL) {
-                        x = NULL;
+                /* Look in both dicts at once, with the hash computed
+                   only once; unlike PyDict_GetItem() this does not
+                   swallow errors from comparisons. */
+                x = _PyDict_LoadGlobal((PyDictObject *)f->f_globals,
+                                       (PyDictObject *)f->f_builtins, w);
+                if (x == NULL) {
+                    if (PyErr_Occurred())
                         break;
-                    }
-                    x = e->me_value;
-                    if (x != NULL) {
-                        Py_INCREF(x);
-                        PUSH(x);
-                        continue;
-                    }
                     goto load_global_error;
                 }
+                Py_INCREF(x);
+                PUSH(x);
+                DISPATCH();
             }
             /* This is the un-inlined version of the code above */
             x = PyDict_GetItem(f->f_globals, w);
@@ -2328,13 +2510,13 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             }
             Py_INCREF(x);
             PUSH(x);
-            continue;
+            DISPATCH();
 
-        case DELETE_FAST:
+        TARGET(DELETE_FAST)
             x = GETLOCAL(oparg);
             if (x != NULL) {
                 SETLOCAL(oparg, NULL);
-                continue;
+                DISPATCH();
             }
             format_exc_check_arg(
                 PyExc_UnboundLocalError,
@@ -2343,19 +2525,19 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 );
             break;
 
-        case LOAD_CLOSURE:
+        TARGET(LOAD_CLOSURE)
             x = freevars[oparg];
             Py_INCREF(x);
             PUSH(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case LOAD_DEREF:
+        TARGET(LOAD_DEREF)
             x = freevars[oparg];
             w = PyCell_Get(x);
             if (w != NULL) {
                 PUSH(w);
-                continue;
+                DISPATCH();
             }
             err = -1;
             /* Don't stomp existing exception */
@@ -2376,14 +2558,14 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             }
             break;
 
-        case STORE_DEREF:
+        TARGET(STORE_DEREF)
             w = POP();
             x = freevars[oparg];
             PyCell_Set(x, w);
             Py_DECREF(w);
-            continue;
+            DISPATCH();
 
-        case BUILD_TUPLE:
+        TARGET(BUILD_TUPLE)
             x = PyTuple_New(oparg);
             if (x != NULL) {
                 for (; --oparg >= 0;) {
@@ -2391,11 +2573,11 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     PyTuple_SET_ITEM(x, oparg, w);
                 }
                 PUSH(x);
-                continue;
+                DISPATCH();
             }
             break;
 
-        case BUILD_LIST:
+        TARGET(BUILD_LIST)
             x =  PyList_New(oparg);
             if (x != NULL) {
                 for (; --oparg >= 0;) {
@@ -2403,11 +2585,11 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     PyList_SET_ITEM(x, oparg, w);
                 }
                 PUSH(x);
-                continue;
+                DISPATCH();
             }
             break;
 
-        case BUILD_SET:
+        TARGET(BUILD_SET)
             x = PySet_New(NULL);
             if (x != NULL) {
                 for (; --oparg >= 0;) {
@@ -2421,18 +2603,18 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                     break;
                 }
                 PUSH(x);
-                continue;
+                DISPATCH();
             }
             break;
 
 
-        case BUILD_MAP:
+        TARGET(BUILD_MAP)
             x = _PyDict_NewPresized((Py_ssize_t)oparg);
             PUSH(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case STORE_MAP:
+        TARGET(STORE_MAP)
             w = TOP();     /* key */
             u = SECOND();  /* value */
             v = THIRD();   /* dict */
@@ -2441,10 +2623,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             err = PyDict_SetItem(v, w, u);  /* v[w] = u */
             Py_DECREF(u);
             Py_DECREF(w);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case MAP_ADD:
+        TARGET(MAP_ADD)
             w = TOP();     /* key */
             u = SECOND();  /* value */
             STACKADJ(-2);
@@ -2455,20 +2637,25 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             Py_DECREF(w);
             if (err == 0) {
                 PREDICT(JUMP_ABSOLUTE);
-                continue;
+                DISPATCH();
             }
             break;
 
-        case LOAD_ATTR:
+        TARGET(LOAD_ATTR)
             w = GETITEM(names, oparg);
             v = TOP();
-            x = PyObject_GetAttr(v, w);
+            OPCACHE_CHECK();
+            if (oc != NULL)
+                x = load_attr_cached(oc, v, w);
+            else
+                x = PyObject_GetAttr(v, w);
             Py_DECREF(v);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case COMPARE_OP:
+        TARGET(COMPARE_OP)
+        _compare_op:
             w = POP();
             v = TOP();
             if (PyInt_CheckExact(w) && PyInt_CheckExact(v)) {
@@ -2501,9 +2688,9 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             if (x == NULL) break;
             PREDICT(POP_JUMP_IF_FALSE);
             PREDICT(POP_JUMP_IF_TRUE);
-            continue;
+            DISPATCH();
 
-        case IMPORT_NAME:
+        TARGET(IMPORT_NAME)
             w = GETITEM(names, oparg);
             x = PyDict_GetItemString(f->f_builtins, "__import__");
             if (x == NULL) {
@@ -2544,10 +2731,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             READ_TIMESTAMP(intr1);
             Py_DECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case IMPORT_STAR:
+        TARGET(IMPORT_STAR)
             v = POP();
             PyFrame_FastToLocals(f);
             if ((x = f->f_locals) == NULL) {
@@ -2560,34 +2747,35 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             READ_TIMESTAMP(intr1);
             PyFrame_LocalsToFast(f, 0);
             Py_DECREF(v);
-            if (err == 0) continue;
+            if (err == 0) DISPATCH();
             break;
 
-        case IMPORT_FROM:
+        TARGET(IMPORT_FROM)
             w = GETITEM(names, oparg);
             v = TOP();
             READ_TIMESTAMP(intr0);
             x = import_from(v, w);
             READ_TIMESTAMP(intr1);
             PUSH(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case JUMP_FORWARD:
+        TARGET(JUMP_FORWARD)
             JUMPBY(oparg);
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 
         PREDICTED_WITH_ARG(POP_JUMP_IF_FALSE);
-        case POP_JUMP_IF_FALSE:
+        TARGET(POP_JUMP_IF_FALSE)
+        _pop_jump_if_false:
             w = POP();
             if (w == Py_True) {
                 Py_DECREF(w);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             if (w == Py_False) {
                 Py_DECREF(w);
                 JUMPTO(oparg);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             err = PyObject_IsTrue(w);
             Py_DECREF(w);
@@ -2597,19 +2785,19 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 JUMPTO(oparg);
             else
                 break;
-            continue;
+            DISPATCH();
 
         PREDICTED_WITH_ARG(POP_JUMP_IF_TRUE);
-        case POP_JUMP_IF_TRUE:
+        TARGET(POP_JUMP_IF_TRUE)
             w = POP();
             if (w == Py_False) {
                 Py_DECREF(w);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             if (w == Py_True) {
                 Py_DECREF(w);
                 JUMPTO(oparg);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             err = PyObject_IsTrue(w);
             Py_DECREF(w);
@@ -2621,18 +2809,18 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 ;
             else
                 break;
-            continue;
+            DISPATCH();
 
-        case JUMP_IF_FALSE_OR_POP:
+        TARGET(JUMP_IF_FALSE_OR_POP)
             w = TOP();
             if (w == Py_True) {
                 STACKADJ(-1);
                 Py_DECREF(w);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             if (w == Py_False) {
                 JUMPTO(oparg);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             err = PyObject_IsTrue(w);
             if (err > 0) {
@@ -2644,18 +2832,18 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                 JUMPTO(oparg);
             else
                 break;
-            continue;
+            DISPATCH();
 
-        case JUMP_IF_TRUE_OR_POP:
+        TARGET(JUMP_IF_TRUE_OR_POP)
             w = TOP();
             if (w == Py_False) {
                 STACKADJ(-1);
                 Py_DECREF(w);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             if (w == Py_True) {
                 JUMPTO(oparg);
-                goto fast_next_opcode;
+                FAST_DISPATCH();
             }
             err = PyObject_IsTrue(w);
             if (err > 0) {
@@ -2668,10 +2856,10 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             }
             else
                 break;
-            continue;
+            DISPATCH();
 
         PREDICTED_WITH_ARG(JUMP_ABSOLUTE);
-        case JUMP_ABSOLUTE:
+        TARGET(JUMP_ABSOLUTE)
             JUMPTO(oparg);
 #if FAST_LOOPS
             /* Enabling this path speeds-up all while and for-loops by bypassing
@@ -2679,14 +2867,14 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
                because it prevents detection of a control-break in tight loops like
                "while 1: pass".  Compile with this option turned-on when you need
                the speed-up and do not need break checking inside tight loops (ones
-               that contain only instructions ending with goto fast_next_opcode).
+               that contain only instructions ending with FAST_DISPATCH()).
             */
-            goto fast_next_opcode;
+            FAST_DISPATCH();
 #else
-            continue;
+            DISPATCH();
 #endif
 
-        case GET_ITER:
+        TARGET(GET_ITER)
             /* before: [obj]; after [getiter(obj)] */
             v = TOP();
             x = PyObject_GetIter(v);
@@ -2694,13 +2882,13 @@ PyEval_EvalFrame_value(PyFrameObject *f, int throwflag, PyObject *retval)
             if (x != NULL) {
                 SET_TOP(x);
                 PREDICT(FOR_ITER);
-                continue;
+                DISPATCH();
             }
             STACKADJ(-1);
             break;
 
         PREDICTED_WITH_ARG(FOR_ITER);
-        case FOR_ITER:
+        TARGET(FOR_ITER)
             /* before: [iter]; after: [iter, iter()] *or* [] */
             v = TOP();
 #ifdef STACKLESS
@@ -2719,7 +2907,7 @@ stackless_iter_return:
                 PUSH(x);
                 PREDICT(STORE_FAST);
                 PREDICT(UNPACK_SEQUENCE);
-                continue;
+                DISPATCH();
             }
             if (PyErr_Occurred()) {
                 if (!PyErr_ExceptionMatches(
@@ -2731,13 +2919,13 @@ stackless_iter_return:
             x = v = POP();
             Py_DECREF(v);
             JUMPBY(oparg);
-            continue;
+            DISPATCH();
 
-        case BREAK_LOOP:
+        TARGET(BREAK_LOOP)
             why = WHY_BREAK;
             goto fast_block_end;
 
-        case CONTINUE_LOOP:
+        TARGET(CONTINUE_LOOP)
             retval = PyInt_FromLong(oparg);
             if (!retval) {
                 x = NULL;
@@ -2746,9 +2934,10 @@ stackless_iter_return:
             why = WHY_CONTINUE;
             goto fast_block_end;
 
-        case SETUP_LOOP:
-        case SETUP_EXCEPT:
-        case SETUP_FINALLY:
+        TARGET_WITH_IMPL(SETUP_LOOP, _setup_finally)
+        TARGET_WITH_IMPL(SETUP_EXCEPT, _setup_finally)
+        TARGET(SETUP_FINALLY)
+        _setup_finally:
             /* NOTE: If you add any new block-setup opcodes that
                are not try/except/finally handlers, you may need
                to update the PyGen_NeedsFinalizing() function.
@@ -2756,9 +2945,9 @@ stackless_iter_return:
 
             PyFrame_BlockSetup(f, opcode, INSTR_OFFSET() + oparg,
                                STACK_LEVEL());
-            continue;
+            DISPATCH();
 
-        case SETUP_WITH:
+        TARGET(SETUP_WITH)
         {
             static PyObject *exit, *enter;
             w = TOP();
@@ -2784,10 +2973,10 @@ stackless_iter_return:
                                STACK_LEVEL());
 
             PUSH(x);
-            continue;
+            DISPATCH();
         }
 
-        case WITH_CLEANUP:
+        TARGET(WITH_CLEANUP)
         {
             /* At the top of the stack are 1-3 values indicating
                how/why we entered the finally clause:
@@ -2875,7 +3064,7 @@ stackless_iter_return:
             break;
         }
 
-        case CALL_FUNCTION:
+        TARGET(CALL_FUNCTION)
         {
             PyObject **sp;
             PCALL(PCALL_ALL);
@@ -2894,13 +3083,14 @@ stackless_call_return:
 #endif
             PUSH(x);
             if (x != NULL)
-                continue;
+                DISPATCH();
             break;
         }
 
-        case CALL_FUNCTION_VAR:
-        case CALL_FUNCTION_KW:
-        case CALL_FUNCTION_VAR_KW:
+        TARGET_WITH_IMPL(CALL_FUNCTION_VAR, _call_function_var_kw)
+        TARGET_WITH_IMPL(CALL_FUNCTION_KW, _call_function_var_kw)
+        TARGET(CALL_FUNCTION_VAR_KW)
+        _call_function_var_kw:
         {
             int na = oparg & 0xff;
             int nk = (oparg>>8) & 0xff;
@@ -2944,11 +3134,11 @@ stackless_call_return:
 #endif
             PUSH(x);
             if (x != NULL)
-                continue;
+                DISPATCH();
             break;
         }
 
-        case MAKE_FUNCTION:
+        TARGET(MAKE_FUNCTION)
             v = POP(); /* code object */
             x = PyFunction_New(v, f->f_globals);
             Py_DECREF(v);
@@ -2970,7 +3160,7 @@ stackless_call_return:
             PUSH(x);
             break;
 
-        case MAKE_CLOSURE:
+        TARGET(MAKE_CLOSURE)
         {
             v = POP(); /* code object */
             x = PyFunction_New(v, f->f_globals);
@@ -3005,7 +3195,7 @@ stackless_call_return:
             break;
         }
 
-        case BUILD_SLICE:
+        TARGET(BUILD_SLICE)
             if (oparg == 3)
                 w = POP();
             else
@@ -3017,14 +3207,104 @@ stackless_call_return:
             Py_DECREF(v);
             Py_XDECREF(w);
             SET_TOP(x);
-            if (x != NULL) continue;
+            if (x != NULL) DISPATCH();
             break;
 
-        case EXTENDED_ARG:
+        /* Superinstructions, see peephole.c.  While tracing or profiling
+           they run their first instruction only, so that the second
+           one is seen on its own. */
+
+        TARGET(LOAD_FAST__LOAD_FAST)
+            x = GETLOCAL(oparg);
+            if (x == NULL || _Py_TracingPossible)
+                goto _load_fast;
+            Py_INCREF(x);
+            PUSH(x);
+            SECOND_INSTR();
+            x = GETLOCAL(oparg);
+            if (x != NULL) {
+                Py_INCREF(x);
+                PUSH(x);
+                FAST_DISPATCH();
+            }
+            format_exc_check_arg(PyExc_UnboundLocalError,
+                UNBOUNDLOCAL_ERROR_MSG,
+                PyTuple_GetItem(co->co_varnames, oparg));
+            break;
+
+        TARGET(LOAD_FAST__LOAD_ATTR)
+            v = GETLOCAL(oparg);
+            if (v == NULL || _Py_TracingPossible)
+                goto _load_fast;
+            Py_INCREF(v);
+            SECOND_INSTR();
+            w = GETITEM(names, oparg);
+            OPCACHE_CHECK();
+            if (oc != NULL)
+                x = load_attr_cached(oc, v, w);
+            else
+                x = PyObject_GetAttr(v, w);
+            Py_DECREF(v);
+            PUSH(x);
+            if (x != NULL) DISPATCH();
+            break;
+
+        TARGET(COMPARE_OP__POP_JUMP_IF_FALSE)
+            if (_Py_TracingPossible)
+                goto _compare_op;
+            w = POP();
+            v = POP();
+            if (PyInt_CheckExact(w) && PyInt_CheckExact(v)) {
+                /* INLINE: cmp(int, int) */
+                register long a, b;
+                register int res;
+                a = PyInt_AS_LONG(v);
+                b = PyInt_AS_LONG(w);
+                switch (oparg) {
+                case PyCmp_LT: res = a <  b; break;
+                case PyCmp_LE: res = a <= b; break;
+                case PyCmp_EQ: res = a == b; break;
+                case PyCmp_NE: res = a != b; break;
+                case PyCmp_GT: res = a >  b; break;
+                case PyCmp_GE: res = a >= b; break;
+                case PyCmp_IS: res = v == w; break;
+                case PyCmp_IS_NOT: res = v != w; break;
+                default: goto fused_slow_compare;
+                }
+                Py_DECREF(v);
+                Py_DECREF(w);
+                SECOND_INSTR();
+                if (!res)
+                    JUMPTO(oparg);
+                FAST_DISPATCH();
+            }
+          fused_slow_compare:
+            x = cmp_outcome(oparg, v, w);
+            Py_DECREF(v);
+            Py_DECREF(w);
+            PUSH(x);
+            if (x == NULL) break;
+            SECOND_INSTR();
+            goto _pop_jump_if_false;
+
+        TARGET(LOAD_CONST__RETURN_VALUE)
+            if (_Py_TracingPossible)
+                goto _load_const;
+            retval = GETITEM(consts, oparg);
+            Py_INCREF(retval);
+            next_instr++;
+            f->f_lasti = INSTR_OFFSET() - 1;
+            why = WHY_RETURN;
+            goto fast_block_end;
+
+        TARGET(EXTENDED_ARG)
             opcode = NEXTOP();
             oparg = oparg<<16 | NEXTARG();
             goto dispatch_opcode;
 
+#ifdef USE_COMPUTED_GOTOS
+        _unknown_opcode:
+#endif
         default:
             fprintf(stderr,
                 "XXX lineno: %d, opcode: %d\n",
@@ -3826,8 +4106,15 @@ do_raise(PyObject *type, PyObject *value, PyObject *tb)
         Py_DECREF(tmp);
     }
 
-    if (PyExceptionClass_Check(type))
-        PyErr_NormalizeException(&type, &value, &tb);
+    if (PyExceptionClass_Check(type)) {
+        /* A bare "raise StopIteration" mostly ends a loop that throws
+           it away, so leave it unnormalized like PyErr_SetNone().  An
+           except clause catching it gets the instance as usual, and so
+           does the 'exception' event of a trace function. */
+        if (type != PyExc_StopIteration || value != Py_None ||
+            PyThreadState_GET()->use_tracing)
+            PyErr_NormalizeException(&type, &value, &tb);
+    }
 
     else if (PyExceptionInstance_Check(type)) {
         /* Raising an instance.  The value should be a dummy. */
@@ -4333,6 +4620,22 @@ call_function(PyObject ***pp_stack, int oparg
                 x = NULL;
             }
         }
+        else if (flags & METH_FASTCALL) {
+            /* the arguments stay on the stack until the call returns */
+            PyCFunction meth = PyCFunction_GET_FUNCTION(func);
+            PyObject *self = PyCFunction_GET_SELF(func);
+            PyObject **args = (*pp_stack) - na;
+            READ_TIMESTAMP(*pintr0);
+            STACKLESS_PROPOSE_FLAG(flags & METH_STACKLESS);
+            if (flags & METH_KEYWORDS) {
+                C_TRACE(x, (*(_PyCFunctionFastWithKeywords)meth)(self,
+                    args, na, NULL));
+            }
+            else {
+                C_TRACE(x, (*(_PyCFunctionFast)meth)(self, args, na));
+            }
+            READ_TIMESTAMP(*pintr1);
+        }
         else {
             PyObject *callargs;
             callargs = load_args(pp_stack, na);
@@ -5099,6 +5402,73 @@ exec_statement(PyFrameObject *f, PyObject *prog, PyObject *globals,
     return 0;
 }
 
+/* LOAD_ATTR with an inline cache.  For the common objects that use
+   PyObject_GenericGetAttr this is PyObject_GenericGetAttr with the
+   _PyType_Lookup() replaced by the cached result; everything else takes
+   the normal route. */
+
+static PyObject *
+load_attr_cached(_PyOpcache *oc, PyObject *owner, PyObject *name)
+{
+    _PyOpcache_LoadAttr *la = &oc->u.la;
+    PyTypeObject *tp = Py_TYPE(owner);
+    PyObject *descr, *dict, *res;
+    descrgetfunc f;
+
+    if (la->type != tp || la->tp_version != tp->tp_version_tag ||
+        !PyType_HasFeature(tp, Py_TPFLAGS_VALID_VERSION_TAG)) {
+        if (tp->tp_getattro != PyObject_GenericGetAttr ||
+            tp->tp_dictoffset < 0 || !PyString_CheckExact(name))
+            return PyObject_GetAttr(owner, name);
+        /* this assigns a version tag if the type can have one */
+        descr = _PyType_Lookup(tp, name);
+        if (!PyType_HasFeature(tp, Py_TPFLAGS_VALID_VERSION_TAG))
+            return PyObject_GetAttr(owner, name);
+        la->type = tp;
+        la->tp_version = tp->tp_version_tag;
+        la->descr = descr;
+    }
+
+    /* from here on like _PyObject_GenericGetAttrWithDict() */
+    descr = la->descr;
+    Py_XINCREF(descr);
+    f = NULL;
+    if (descr != NULL &&
+        PyType_HasFeature(Py_TYPE(descr), Py_TPFLAGS_HAVE_CLASS)) {
+        f = Py_TYPE(descr)->tp_descr_get;
+        if (f != NULL && PyDescr_IsData(descr)) {
+            res = f(descr, owner, (PyObject *)tp);
+            Py_DECREF(descr);
+            return res;
+        }
+    }
+    if (tp->tp_dictoffset != 0) {
+        dict = *(PyObject **)((char *)owner + tp->tp_dictoffset);
+        if (dict != NULL) {
+            Py_INCREF(dict);
+            res = PyDict_GetItem(dict, name);
+            if (res != NULL) {
+                Py_INCREF(res);
+                Py_XDECREF(descr);
+                Py_DECREF(dict);
+                return res;
+            }
+            Py_DECREF(dict);
+        }
+    }
+    if (f != NULL) {
+        res = f(descr, owner, (PyObject *)tp);
+        Py_DECREF(descr);
+        return res;
+    }
+    if (descr != NULL)
+        return descr;
+    PyErr_Format(PyExc_AttributeError,
+                 "'%.50s' object has no attribute '%.400s'",
+                 tp->tp_name, PyString_AS_STRING(name));
+    return NULL;
+}
+
 static void
 format_exc_check_arg(PyObject *exc, char *format_str, PyObject *obj)
 {
@@ -5195,6 +5565,95 @@ string_concatenate(PyObject *v, PyObject *w,
     }
 }
 
+static void
+profile_opcode(PyCodeObject *co, int offset)
+{
+    int opcode = ((unsigned char *)PyString_AS_STRING(co->co_code))[offset];
+    _PyCodeProfile *p;
+
+    p = _PyCode_GetProfile(co, opcode_profile & PyEval_PROFILE_LINES);
+    if (p != NULL) {
+        p->opcounts[opcode]++;
+        if (p->instrcounts != NULL)
+            p->instrcounts[offset]++;
+    }
+    if (opcode_pairs != NULL && (opcode_profile & PyEval_PROFILE_PAIRS))
+        opcode_pairs[opcode_profile_last][opcode]++;
+    opcode_profile_last = opcode;
+}
+
+int
+_PyEval_SetOpcodeProfile(int flags)
+{
+    if (flags & PyEval_PROFILE_PAIRS && opcode_pairs == NULL) {
+        opcode_pairs = PyMem_Malloc(256 * sizeof(*opcode_pairs));
+        if (opcode_pairs == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        memset(opcode_pairs, 0, 256 * sizeof(*opcode_pairs));
+    }
+    if (flags)
+        flags |= PyEval_PROFILE_OPCODES;
+    _Py_TracingPossible += (flags != 0) - (opcode_profile != 0);
+    opcode_profile = flags;
+    return 0;
+}
+
+int
+_PyEval_GetOpcodeProfile(void)
+{
+    return opcode_profile;
+}
+
+/* Returns (per code list, pairs), the list as _PyCode_GetProfiles()
+   returns it, pairs a list of 256 lists of 256 ints indexed by the
+   previous and the current opcode, or None. */
+PyObject *
+_PyEval_GetOpcodeStats(void)
+{
+    PyObject *codes, *pairs, *row, *x;
+    int i, j;
+
+    codes = _PyCode_GetProfiles();
+    if (codes == NULL)
+        return NULL;
+    if (opcode_pairs == NULL)
+        return Py_BuildValue("(NO)", codes, Py_None);
+    pairs = PyList_New(256);
+    if (pairs == NULL)
+        goto error;
+    for (i = 0; i < 256; i++) {
+        row = PyList_New(256);
+        if (row == NULL)
+            goto error;
+        PyList_SET_ITEM(pairs, i, row);
+        for (j = 0; j < 256; j++) {
+            x = _Py_profcount_AsObject(opcode_pairs[i][j]);
+            if (x == NULL)
+                goto error;
+            PyList_SET_ITEM(row, j, x);
+        }
+    }
+    return Py_BuildValue("(NN)", codes, pairs);
+error:
+    Py_DECREF(codes);
+    Py_XDECREF(pairs);
+    return NULL;
+}
+
+void
+_PyEval_ClearOpcodeStats(void)
+{
+    _PyCode_ClearProfiles();
+    if (opcode_pairs != NULL && !(opcode_profile & PyEval_PROFILE_PAIRS)) {
+        PyMem_Free(opcode_pairs);
+        opcode_pairs = NULL;
+    }
+    else if (opcode_pairs != NULL)
+        memset(opcode_pairs, 0, 256 * sizeof(*opcode_pairs));
+}
+
 #ifdef DYNAMIC_EXECUTION_PROFILE
 
 static PyObject *
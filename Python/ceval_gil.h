@@ -0,0 +1,435 @@
+/*
+ * Implementation of the Global Interpreter Lock (GIL).
+ *
+ * Only for pthreads and Windows threads; with the other thread libraries
+ * ceval.c keeps the GIL a plain lock.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+
+
+/* First some general settings */
+
+/* microseconds (the Python API uses seconds, though) */
+#define DEFAULT_INTERVAL 5000
+static unsigned long gil_interval = DEFAULT_INTERVAL;
+#define INTERVAL (gil_interval >= 1 ? gil_interval : 1)
+
+/* Enable if you want to force the switching of threads at least every `gil_interval` */
+#undef FORCE_SWITCHING
+#define FORCE_SWITCHING
+
+
+/*
+   Notes about the implementation:
+
+   - The GIL is just a boolean variable (gil_locked) whose access is protected
+     by a mutex (gil_mutex), and whose changes are signalled by a condition
+     variable (gil_cond). gil_mutex is taken for short periods of time,
+     and therefore mostly uncontended.
+
+   - In the GIL-holding thread, the main loop (PyEval_EvalFrameEx) must be
+     able to release the GIL on demand by another thread. A volatile boolean
+     variable (gil_drop_request) is used for that purpose, which is checked
+     at the periodic check of the main loop. Waiting threads set
+     _Py_Ticker to 0 along with the request, so the check comes at the
+     next opcode.
+
+   - A thread wanting to take the GIL will first let pass a given amount of
+     time (`interval` microseconds) before setting gil_drop_request. This
+     encourages a defined switching period, but doesn't enforce it since
+     opcodes can take an arbitrary time to execute.
+
+     The `interval` value is available for the user to read and modify
+     using the Python API `sys.{get,set}switchinterval()`.
+
+   - When a thread releases the GIL and gil_drop_request is set, that thread
+     ensures that another GIL-awaiting thread gets scheduled.
+     It does so by waiting on a condition variable (switch_cond) until
+     the value of gil_last_holder is changed to something else than its
+     own thread state pointer, indicating that another thread was able to
+     take the GIL.
+
+     This is meant to prohibit the latency-adverse behaviour on multi-core
+     machines where one thread would speculatively release the GIL, but still
+     run and end up being the first to re-acquire it, making the "timeslices"
+     much longer than expected.
+     (Note: this mechanism is enabled with FORCE_SWITCHING above)
+
+   - Stackless: a thread whose scheduler was blocked, because all of its
+     tasklets wait for tasklets of other threads, is woken up by
+     slp_thread_unblock() when one of them becomes runnable. The waker
+     calls slp_gil_handoff(), which marks the woken thread state, and
+     take_gil() then requests the GIL at once instead of waiting for the
+     interval. Such a thread waits on its own condition variable
+     (gil_prio_cond), and ordinary waiters stand back from the moment it
+     is woken up until it got the GIL; otherwise a CPU-bound thread takes
+     the GIL dropped by the waker before the OS even ran the woken thread.
+     A value sent over a channel to another thread is thus received without
+     a timeslice of delay even when CPU-bound threads compete for the GIL.
+*/
+
+#if defined(_POSIX_THREADS)
+
+/* This condition variable implementation uses pthread condition
+   variables; it is the only portable choice on POSIX systems. */
+
+#include <pthread.h>
+
+#define ADD_MICROSECONDS(tv, interval) \
+do { \
+    tv.tv_usec += (long) interval; \
+    tv.tv_sec += tv.tv_usec / 1000000; \
+    tv.tv_usec %= 1000000; \
+} while (0)
+
+/* We assume all modern POSIX systems have gettimeofday() */
+#ifdef GETTIMEOFDAY_NO_TZ
+#define GETTIMEOFDAY(ptv) gettimeofday(ptv)
+#else
+#define GETTIMEOFDAY(ptv) gettimeofday(ptv, (struct timezone *)NULL)
+#endif
+
+#define MUTEX_T pthread_mutex_t
+#define MUTEX_INIT(mut) \
+    if (pthread_mutex_init(&mut, NULL)) { \
+        Py_FatalError("pthread_mutex_init(" #mut ") failed"); };
+#define MUTEX_LOCK(mut) \
+    if (pthread_mutex_lock(&mut)) { \
+        Py_FatalError("pthread_mutex_lock(" #mut ") failed"); };
+#define MUTEX_UNLOCK(mut) \
+    if (pthread_mutex_unlock(&mut)) { \
+        Py_FatalError("pthread_mutex_unlock(" #mut ") failed"); };
+
+#define COND_T pthread_cond_t
+#define COND_INIT(cond) \
+    if (pthread_cond_init(&cond, NULL)) { \
+        Py_FatalError("pthread_cond_init(" #cond ") failed"); };
+#define COND_SIGNAL(cond) \
+    if (pthread_cond_signal(&cond)) { \
+        Py_FatalError("pthread_cond_signal(" #cond ") failed"); };
+#define COND_WAIT(cond, mut) \
+    if (pthread_cond_wait(&cond, &mut)) { \
+        Py_FatalError("pthread_cond_wait(" #cond ") failed"); };
+#define COND_TIMED_WAIT(cond, mut, microseconds, timeout_result) \
+    { \
+        int r; \
+        struct timespec ts; \
+        struct timeval deadline; \
+        \
+        GETTIMEOFDAY(&deadline); \
+        ADD_MICROSECONDS(deadline, microseconds); \
+        ts.tv_sec = deadline.tv_sec; \
+        ts.tv_nsec = deadline.tv_usec * 1000; \
+        \
+        r = pthread_cond_timedwait(&cond, &mut, &ts); \
+        if (r == ETIMEDOUT) \
+            timeout_result = 1; \
+        else if (r) \
+            Py_FatalError("pthread_cond_timedwait(" #cond ") failed"); \
+        else \
+            timeout_result = 0; \
+    } \
+
+#elif defined(NT_THREADS)
+
+/*
+ * Windows (2000 and later, as well as (hopefully) CE) support
+ */
+
+#include <windows.h>
+
+#define MUTEX_T CRITICAL_SECTION
+#define MUTEX_INIT(mut) \
+    InitializeCriticalSection(&mut);
+#define MUTEX_LOCK(mut) \
+    EnterCriticalSection(&mut);
+#define MUTEX_UNLOCK(mut) \
+    LeaveCriticalSection(&mut);
+
+/* We emulate condition variables with a semaphore.  Because it is ok
+   to signal a condition variable with no one waiting, we keep track
+   of the number of waiting threads, otherwise the semaphore's count
+   could rise without bound.  A semaphore rather than an auto-reset
+   event avoids the lost wakeup when more than one thread is between
+   releasing the mutex and starting to wait. */
+
+typedef struct COND_T
+{
+    HANDLE sem;
+    int n_waiting;
+} COND_T;
+
+static void
+_cond_init(COND_T *cond)
+{
+    if (!(cond->sem = CreateSemaphore(NULL, 0, 1000, NULL)))
+        Py_FatalError("CreateSemaphore() failed");
+    cond->n_waiting = 0;
+}
+
+static void
+_cond_wait(COND_T *cond, MUTEX_T *mut)
+{
+    ++cond->n_waiting;
+    LeaveCriticalSection(mut);
+    if (WaitForSingleObject(cond->sem, INFINITE) == WAIT_FAILED)
+        Py_FatalError("WaitForSingleObject() failed");
+    EnterCriticalSection(mut);
+}
+
+static int
+_cond_timed_wait(COND_T *cond, MUTEX_T *mut, unsigned long us)
+{
+    DWORD r;
+    ++cond->n_waiting;
+    LeaveCriticalSection(mut);
+    r = WaitForSingleObject(cond->sem, us / 1000);
+    if (r == WAIT_FAILED)
+        Py_FatalError("WaitForSingleObject() failed");
+    EnterCriticalSection(mut);
+    if (r == WAIT_TIMEOUT)
+        /* A signal between the timeout and taking the mutex again
+           decrements n_waiting twice and leaves the semaphore at 1;
+           the next waiter passes right through and corrects both. */
+        --cond->n_waiting;
+    return r == WAIT_TIMEOUT;
+}
+
+static void
+_cond_signal(COND_T *cond)
+{
+    /* NOTE: This must be called with the mutex held */
+    if (cond->n_waiting > 0) {
+        if (!ReleaseSemaphore(cond->sem, 1, NULL))
+            Py_FatalError("ReleaseSemaphore() failed");
+        --cond->n_waiting;
+    }
+}
+
+#define COND_INIT(cond) \
+    _cond_init(&(cond))
+#define COND_SIGNAL(cond) \
+    _cond_signal(&(cond))
+#define COND_WAIT(cond, mut) \
+    _cond_wait(&(cond), &(mut))
+#define COND_TIMED_WAIT(cond, mut, us, timeout_result) \
+    (timeout_result) = _cond_timed_wait(&(cond), &(mut), us)
+
+#endif /* _POSIX_THREADS, NT_THREADS */
+
+
+/* Whether the GIL is already taken (-1 if uninitialized). This is volatile
+   because it can be read without any lock taken in ceval.c. */
+static volatile int gil_locked = -1;
+/* Number of GIL switches since the beginning. */
+static unsigned long gil_switch_number = 0;
+/* Last thread holding / having held the GIL. This helps us know whether
+   anyone else was scheduled after we dropped the GIL. */
+static PyThreadState *gil_last_holder = NULL;
+
+/* This condition variable allows one or several threads to wait until
+   the GIL is released. In addition, the mutex also protects the above
+   variables. */
+static COND_T gil_cond;
+static MUTEX_T gil_mutex;
+
+#ifdef FORCE_SWITCHING
+/* This condition variable helps the GIL-releasing thread wait for
+   a GIL-awaiting thread to be scheduled and take the GIL. */
+static COND_T switch_cond;
+static MUTEX_T switch_mutex;
+#endif
+
+#ifdef STACKLESS
+/* Threads handed the GIL by a Stackless scheduler wait here, and
+   ordinary waiters stand back while there are any.  They are counted
+   from the moment they are woken up. */
+static COND_T gil_prio_cond;
+static int gil_prio_waiting = 0;
+#endif
+
+/* Set by a waiting thread, checked by the main loop of the running one */
+static volatile int gil_drop_request = 0;
+
+#define SET_GIL_DROP_REQUEST() \
+    do { gil_drop_request = 1; _Py_Ticker = 0; } while (0)
+#define RESET_GIL_DROP_REQUEST() \
+    do { gil_drop_request = 0; } while (0)
+
+
+static int gil_created(void)
+{
+    return gil_locked >= 0;
+}
+
+static void create_gil(void)
+{
+    MUTEX_INIT(gil_mutex);
+#ifdef FORCE_SWITCHING
+    MUTEX_INIT(switch_mutex);
+#endif
+    COND_INIT(gil_cond);
+#ifdef STACKLESS
+    COND_INIT(gil_prio_cond);
+    gil_prio_waiting = 0;
+#endif
+#ifdef FORCE_SWITCHING
+    COND_INIT(switch_cond);
+#endif
+    gil_last_holder = NULL;
+    gil_drop_request = 0;
+    gil_locked = 0;
+}
+
+static void recreate_gil(void)
+{
+    /* Called in the child after fork(), where only the current thread
+       survives.  The old mutexes may be held, and the old condition
+       variables waited on, by threads which no longer exist; destroying
+       them is undefined behaviour then, and pthread_cond_destroy() may
+       even block on the vanished waiters.  So they are initialized
+       again in place instead.  With the default attributes, pthread
+       mutexes and condition variables hold nothing outside of their own
+       memory on the common systems, and Windows has no fork(). */
+    create_gil();
+}
+
+static void drop_gil(PyThreadState *tstate)
+{
+    /* NOTE: tstate is allowed to be NULL. */
+    if (!gil_locked)
+        Py_FatalError("drop_gil: GIL is not locked");
+    /* The holder may still be NULL if the GIL was taken with
+       PyEval_AcquireLock() before a thread state was made current;
+       otherwise it must be the releasing thread. */
+    if (tstate != NULL && gil_last_holder != NULL &&
+        tstate != gil_last_holder)
+        Py_FatalError("drop_gil: wrong thread state");
+
+    MUTEX_LOCK(gil_mutex);
+    gil_locked = 0;
+#ifdef STACKLESS
+    if (gil_prio_waiting) {
+        COND_SIGNAL(gil_prio_cond);
+    }
+    else
+#endif
+    {
+        COND_SIGNAL(gil_cond);
+    }
+    MUTEX_UNLOCK(gil_mutex);
+
+#ifdef FORCE_SWITCHING
+    if (gil_drop_request && tstate != NULL) {
+        MUTEX_LOCK(switch_mutex);
+        /* Not switched yet => wait */
+        if (gil_last_holder == tstate) {
+            RESET_GIL_DROP_REQUEST();
+            /* NOTE: if COND_WAIT does not atomically start waiting when
+               releasing the mutex, another thread can run through, take
+               the GIL and drop it again, and reset the condition
+               before we even had a chance to wait for it. */
+            COND_WAIT(switch_cond, switch_mutex);
+        }
+        MUTEX_UNLOCK(switch_mutex);
+    }
+#endif
+}
+
+static void take_gil(PyThreadState *tstate)
+{
+    int err;
+
+    /* NOTE: tstate is allowed to be NULL. */
+    err = errno;
+    MUTEX_LOCK(gil_mutex);
+
+#ifdef STACKLESS
+    if (tstate != NULL && tstate->st.thread.gil_handoff) {
+        /* woken up by the scheduler of another thread, see above */
+        tstate->st.thread.gil_handoff = 0;
+        if (gil_locked) {
+            SET_GIL_DROP_REQUEST();
+            while (gil_locked)
+                COND_WAIT(gil_prio_cond, gil_mutex);
+        }
+        --gil_prio_waiting;
+        goto _ready;
+    }
+#endif
+
+    while (gil_locked
+#ifdef STACKLESS
+           || gil_prio_waiting
+#endif
+           ) {
+        int timed_out = 0;
+        unsigned long saved_switchnum;
+
+        saved_switchnum = gil_switch_number;
+        COND_TIMED_WAIT(gil_cond, gil_mutex, INTERVAL, timed_out);
+        /* If we timed out and no switch occurred in the meantime, it is time
+           to ask the GIL-holding thread to drop it. */
+        if (timed_out && gil_switch_number == saved_switchnum) {
+            if (gil_locked)
+                SET_GIL_DROP_REQUEST();
+#ifdef STACKLESS
+            else
+                /* the woken up thread is late, stand back no longer */
+                break;
+#endif
+        }
+    }
+_ready:
+#ifdef FORCE_SWITCHING
+    /* This mutex must be taken before modifying gil_last_holder (see
+       drop_gil()). */
+    MUTEX_LOCK(switch_mutex);
+#endif
+    /* We now hold the GIL */
+    gil_locked = 1;
+
+    if (tstate != gil_last_holder) {
+        gil_last_holder = tstate;
+        ++gil_switch_number;
+    }
+
+#ifdef FORCE_SWITCHING
+    COND_SIGNAL(switch_cond);
+    MUTEX_UNLOCK(switch_mutex);
+#endif
+    if (gil_drop_request)
+        RESET_GIL_DROP_REQUEST();
+    if (tstate != NULL && tstate->async_exc != NULL)
+        /* let the main loop raise it soon */
+        _Py_Ticker = 0;
+
+    MUTEX_UNLOCK(gil_mutex);
+    errno = err;
+}
+
+#ifdef STACKLESS
+void slp_gil_handoff(PyThreadState *tstate)
+{
+    if (!gil_created())
+        return;
+    MUTEX_LOCK(gil_mutex);
+    if (!tstate->st.thread.gil_handoff) {
+        tstate->st.thread.gil_handoff = 1;
+        ++gil_prio_waiting;
+    }
+    MUTEX_UNLOCK(gil_mutex);
+}
+#endif
+
+void _PyEval_SetSwitchInterval(unsigned long microseconds)
+{
+    gil_interval = microseconds;
+}
+
+unsigned long _PyEval_GetSwitchInterval(void)
+{
+    return gil_interval;
+}
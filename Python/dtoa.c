@@ -1486,6 +1486,304 @@ bigcomp(U *rv, const char *s0, BCinfo *bc)
     return 0;
 }
 
+#ifdef ULLong
+
+/* Fast paths for _Py_dg_strtod and _Py_dg_dtoa, using a table of 128-bit
+ * significands of powers of 5 (and so of 10):
+ *
+ *  - lemire_strtod converts inputs with at most 19 significant digits
+ *    using a single 64 x 128-bit product, following D. Lemire, "Number
+ *    Parsing at a Gigabyte per Second" (Software: Practice and Experience,
+ *    2021), and the Eisel-Lemire algorithm of fast_double_parser.
+ *
+ *  - grisu_shortest finds the shortest digit string for mode 0 of
+ *    _Py_dg_dtoa with 64-bit arithmetic, following F. Loitsch, "Printing
+ *    Floating-Point Numbers Quickly and Accurately with Integers" (PLDI
+ *    2010), algorithm Grisu3, as in the double-conversion library.
+ *
+ * Both give up, and leave the work to the multiple-precision code, in the
+ * rare cases they can't decide (for about 0.5% of all doubles for Grisu3),
+ * and so their results are always identical to those of the slow paths.
+ */
+
+#include "dtoa_powers.h"
+
+/* Return the low 64 bits of the product of a and b, and store the high 64
+   bits in *hi. */
+
+static ULLong
+mul128(ULLong a, ULLong b, ULLong *hi)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a * b;
+    *hi = (ULLong)(p >> 64);
+    return (ULLong)p;
+#else
+    ULLong a1 = a >> 32, a0 = a & FFFFFFFF, b1 = b >> 32, b0 = b & FFFFFFFF;
+    ULLong p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0;
+    ULLong mid = (p00 >> 32) + (p01 & FFFFFFFF) + (p10 & FFFFFFFF);
+    *hi = a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (p00 & FFFFFFFF);
+#endif
+}
+
+/* Number of leading zero bits of the nonzero x. */
+
+static int
+hi0bits64(ULLong x)
+{
+    if (x >> 32)
+        return hi0bits((ULong)(x >> 32));
+    return 32 + hi0bits((ULong)x);
+}
+
+/* floor(log2(10**q)), for |q| <= 1000 or so */
+#define FLOOR_LOG2_POW10(q) Py_ARITHMETIC_RIGHT_SHIFT(int, 217706 * (q), 16)
+
+/* Set *rv to the double nearest to w * 10**q, for 0 < w < 10**19, and
+   return 1; or return 0 if that can't be done quickly, including when the
+   result is subnormal or overflows. */
+
+static int
+lemire_strtod(ULLong w, int q, U *rv)
+{
+    const ULLong *p;
+    ULLong hi, lo, mantissa, upperbit;
+    int lz, exponent;
+
+    if (q < POW5_MIN || q > DBL_MAX_10_EXP)
+        return 0;
+    p = pow5_128[q - POW5_MIN];
+    lz = hi0bits64(w);
+    w <<= lz;
+
+    /* The leading 55 bits of the product of w and the high half of the
+       power are exact, unless its low 9 bits are all ones and adding
+       w * (the low half) may carry into them. */
+    lo = mul128(w, p[0], &hi);
+    if ((hi & 0x1FF) == 0x1FF && lo + w < lo) {
+        ULLong lo2, mid2, mid;
+
+        lo2 = mul128(w, p[1], &mid2);
+        mid = lo + mid2;
+        if (mid < lo)
+            hi++;
+        if (mid + 1 == 0 && (hi & 0x1FF) == 0x1FF && lo2 + w < lo2)
+            return 0;
+        lo = mid;
+    }
+
+    /* 54 bits of significand, to be rounded to 53 */
+    upperbit = hi >> 63;
+    mantissa = hi >> (upperbit + 9);
+    lz += (int)(1 ^ upperbit);
+
+    /* exactly halfway between two doubles, for all we know */
+    if (lo == 0 && (hi & 0x1FF) == 0 && (mantissa & 3) == 1)
+        return 0;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (ULLong)1 << 53) {
+        /* rounding carried into a new bit */
+        mantissa = (ULLong)1 << 52;
+        lz--;
+    }
+    mantissa &= ~((ULLong)1 << 52);
+    exponent = FLOOR_LOG2_POW10(q) + 1024 + 63 - lz;
+    if (exponent < 1 || exponent > 2046)
+        return 0;
+    word0(rv) = (ULong)(mantissa >> 32) | (ULong)exponent << Exp_shift;
+    word1(rv) = (ULong)(mantissa & FFFFFFFF);
+    return 1;
+}
+
+/* A number f * 2**e with a 64-bit significand. */
+
+typedef struct {
+    ULLong f;
+    int e;
+} DiyFp;
+
+/* The product of a and b, with the significand rounded to 64 bits. */
+
+static DiyFp
+diyfp_mul(DiyFp a, DiyFp b)
+{
+    DiyFp r;
+    ULLong lo;
+
+    lo = mul128(a.f, b.f, &r.f);
+    r.f += lo >> 63;
+    r.e = a.e + b.e + 64;
+    return r;
+}
+
+/* Grisu scales numbers by a cached power of 10 so that their binary
+   exponent is in [GRISU_ALPHA, GRISU_GAMMA], which leaves at most 32 bits
+   for the integral part and at least 4 bits of each digit in the
+   fractional part. */
+#define GRISU_ALPHA (-60)
+#define GRISU_GAMMA (-32)
+
+static const ULong grisu_tens[] = {
+    0, 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+/* The last digit of buffer[0:length] is to be decremented while that makes
+   it closer to w, and the result must still be within the interval of
+   decimal numbers that round to v.  All quantities are scaled by the
+   (implicit) power of 10 that gives the digits, and known to within unit:
+
+     distance_too_high_w  distance from w to the upper end of the interval
+     unsafe_interval      the width of the interval, plus a unit either side
+     rest                 distance from the digits to the upper end
+     ten_kappa            the value of 1 in the last digit
+
+   Return 0 if the digits can't be proved to be the closest to v and
+   within the interval. */
+
+static int
+grisu_round_weed(char *buffer, int length, ULLong distance_too_high_w,
+                 ULLong unsafe_interval, ULLong rest, ULLong ten_kappa,
+                 ULLong unit)
+{
+    ULLong small_distance = distance_too_high_w - unit;
+    ULLong big_distance = distance_too_high_w + unit;
+
+    while (rest < small_distance &&
+           unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        buffer[length - 1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big_distance &&
+        unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance))
+        return 0;
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+/* Generate the shortest digits of a number in [low, high], which are scaled
+   bounds of the interval of v, closest to w (v scaled).  They are
+   digits * 10**kappa.  Return 0 if the result can't be guaranteed. */
+
+static int
+grisu_digit_gen(DiyFp low, DiyFp w, DiyFp high, char *buffer, int *length,
+                int *kappa)
+{
+    ULLong unit = 1;
+    ULLong too_low = low.f - unit, too_high = high.f + unit;
+    ULLong unsafe_interval = too_high - too_low;
+    const int shift = -w.e;
+    const ULLong one = (ULLong)1 << shift;
+    ULong integrals = (ULong)(too_high >> shift);
+    ULLong fractionals = too_high & (one - 1);
+    ULong divisor;
+    int guess;
+
+    assert(low.e == w.e && w.e == high.e);
+    assert(GRISU_ALPHA <= w.e && w.e <= GRISU_GAMMA);
+
+    /* the largest power of 10 <= integrals, which has at most 64 - shift
+       bits */
+    guess = ((64 - shift + 1) * 1233 >> 12) + 1;
+    if (integrals < grisu_tens[guess])
+        guess--;
+    divisor = grisu_tens[guess];
+    *kappa = guess;
+    *length = 0;
+
+    while (*kappa > 0) {
+        ULLong rest;
+
+        buffer[(*length)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        (*kappa)--;
+        rest = ((ULLong)integrals << shift) + fractionals;
+        if (rest < unsafe_interval)
+            return grisu_round_weed(buffer, *length, too_high - w.f,
+                                    unsafe_interval, rest,
+                                    (ULLong)divisor << shift, unit);
+        divisor /= 10;
+    }
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buffer[(*length)++] = (char)('0' + (int)(fractionals >> shift));
+        fractionals &= one - 1;
+        (*kappa)--;
+        if (fractionals < unsafe_interval)
+            return grisu_round_weed(buffer, *length,
+                                    (too_high - w.f) * unit,
+                                    unsafe_interval, fractionals, one, unit);
+        if (*length >= 17)
+            return 0;
+    }
+}
+
+/* Find the shortest digit string that rounds to the positive finite double
+   u, and of those the one closest to u:  buffer[0:*length] * 10**(*k).
+   buffer needs room for 18 digits.  Return 0 if the result can't be
+   found this way. */
+
+static int
+grisu_shortest(U *u, char *buffer, int *length, int *k)
+{
+    ULLong f;
+    int be, e, lz, mk, kappa;
+    DiyFp w, m_minus, m_plus, c;
+
+    f = (ULLong)(word0(u) & Frac_mask) << 32 | word1(u);
+    be = (int)((word0(u) & Exp_mask) >> Exp_shift);
+    if (be) {
+        f |= (ULLong)1 << (P - 1);
+        e = be - Bias - (P - 1);
+    }
+    else
+        e = Etiny;
+    assert(f != 0);
+
+    /* the boundaries of the interval rounding to u, halfway to its
+       neighbours; the lower neighbour is closer if f is a power of 2 */
+    m_plus.f = (f << 1) + 1;
+    m_plus.e = e - 1;
+    lz = hi0bits64(m_plus.f);
+    m_plus.f <<= lz;
+    m_plus.e -= lz;
+    if (f == (ULLong)1 << (P - 1) && be > 1) {
+        m_minus.f = (f << 2) - 1;
+        m_minus.e = e - 2;
+    }
+    else {
+        m_minus.f = (f << 1) - 1;
+        m_minus.e = e - 1;
+    }
+    m_minus.f <<= m_minus.e - m_plus.e;
+    m_minus.e = m_plus.e;
+    lz = hi0bits64(f);
+    w.f = f << lz;
+    w.e = e - lz;
+
+    /* Scale by c = 10**mk, with GRISU_ALPHA <= w.e + c.e + 64. */
+    mk = (int)ceil((GRISU_ALPHA - (w.e + 64) + 63) * 0.30102999566398114);
+    if (mk < POW5_MIN || mk > POW5_MAX)
+        return 0;
+    c.f = pow5_128[mk - POW5_MIN][0] + (pow5_128[mk - POW5_MIN][1] >> 63);
+    c.e = FLOOR_LOG2_POW10(mk) - 63;
+
+    if (!grisu_digit_gen(diyfp_mul(m_minus, c), diyfp_mul(w, c),
+                         diyfp_mul(m_plus, c), buffer, length, &kappa))
+        return 0;
+    *k = kappa - mk;
+    return 1;
+}
+
+#endif /* ULLong */
+
 double
 _Py_dg_strtod(const char *s00, char **se)
 {
@@ -1703,6 +2001,16 @@ _Py_dg_strtod(const char *s00, char **se)
             goto ret;
         }
     }
+#ifdef ULLong
+    /* Up to 19 digits fit in 64 bits:  try the Eisel-Lemire algorithm. */
+    if (nd <= 19 && Flt_Rounds == 1) {
+        ULLong w = 0;
+        for (i = 0; i < nd; i++)
+            w = 10*w + (s0[i < nd0 ? i : i+1] - '0');
+        if (lemire_strtod(w, e, &rv))
+            goto ret;
+    }
+#endif
     e1 += nd - k;
 
     bc.scale = 0;
@@ -2387,6 +2695,30 @@ _Py_dg_dtoa(double dd, int mode, int ndigits,
         return nrv_alloc("0", rve, 1);
     }
 
+#ifdef ULLong
+    /* Shortest digits, usually found by Grisu3 without Bigints. */
+    if (mode == 0) {
+        char buf[20];
+        int len;
+
+        if (grisu_shortest(&u, buf, &len, &k)) {
+            while (len > 1 && buf[len-1] == '0') {
+                len--;
+                k++;
+            }
+            s0 = rv_alloc(len);
+            if (s0 == NULL)
+                return NULL;
+            memcpy(s0, buf, len);
+            s0[len] = 0;
+            *decpt = k + len;
+            if (rve)
+                *rve = s0 + len;
+            return s0;
+        }
+    }
+#endif
+
     /* compute k = floor(log10(d)).  The computation may leave k
        one too large, but should never leave k too small. */
     b = d2b(&u, &be, &bbits);
@@ -0,0 +1,690 @@
+/* Generated by Python/makedtoapowers.py, do not edit. */
+
+#define POW5_MIN (-342)
+#define POW5_MAX 340
+
+static const ULLong pow5_128[POW5_MAX - POW5_MIN + 1][2] = {
+    {Py_ULL(0xeef453d6923bd65a), Py_ULL(0x113faa2906a13b3f)}, /* 5**-342 */
+    {Py_ULL(0x9558b4661b6565f8), Py_ULL(0x4ac7ca59a424c507)}, /* 5**-341 */
+    {Py_ULL(0xbaaee17fa23ebf76), Py_ULL(0x5d79bcf00d2df649)}, /* 5**-340 */
+    {Py_ULL(0xe95a99df8ace6f53), Py_ULL(0xf4d82c2c107973dc)}, /* 5**-339 */
+    {Py_ULL(0x91d8a02bb6c10594), Py_ULL(0x79071b9b8a4be869)}, /* 5**-338 */
+    {Py_ULL(0xb64ec836a47146f9), Py_ULL(0x9748e2826cdee284)}, /* 5**-337 */
+    {Py_ULL(0xe3e27a444d8d98b7), Py_ULL(0xfd1b1b2308169b25)}, /* 5**-336 */
+    {Py_ULL(0x8e6d8c6ab0787f72), Py_ULL(0xfe30f0f5e50e20f7)}, /* 5**-335 */
+    {Py_ULL(0xb208ef855c969f4f), Py_ULL(0xbdbd2d335e51a935)}, /* 5**-334 */
+    {Py_ULL(0xde8b2b66b3bc4723), Py_ULL(0xad2c788035e61382)}, /* 5**-333 */
+    {Py_ULL(0x8b16fb203055ac76), Py_ULL(0x4c3bcb5021afcc31)}, /* 5**-332 */
+    {Py_ULL(0xaddcb9e83c6b1793), Py_ULL(0xdf4abe242a1bbf3d)}, /* 5**-331 */
+    {Py_ULL(0xd953e8624b85dd78), Py_ULL(0xd71d6dad34a2af0d)}, /* 5**-330 */
+    {Py_ULL(0x87d4713d6f33aa6b), Py_ULL(0x8672648c40e5ad68)}, /* 5**-329 */
+    {Py_ULL(0xa9c98d8ccb009506), Py_ULL(0x680efdaf511f18c2)}, /* 5**-328 */
+    {Py_ULL(0xd43bf0effdc0ba48), Py_ULL(0x0212bd1b2566def2)}, /* 5**-327 */
+    {Py_ULL(0x84a57695fe98746d), Py_ULL(0x014bb630f7604b57)}, /* 5**-326 */
+    {Py_ULL(0xa5ced43b7e3e9188), Py_ULL(0x419ea3bd35385e2d)}, /* 5**-325 */
+    {Py_ULL(0xcf42894a5dce35ea), Py_ULL(0x52064cac828675b9)}, /* 5**-324 */
+    {Py_ULL(0x818995ce7aa0e1b2), Py_ULL(0x7343efebd1940993)}, /* 5**-323 */
+    {Py_ULL(0xa1ebfb4219491a1f), Py_ULL(0x1014ebe6c5f90bf8)}, /* 5**-322 */
+    {Py_ULL(0xca66fa129f9b60a6), Py_ULL(0xd41a26e077774ef6)}, /* 5**-321 */
+    {Py_ULL(0xfd00b897478238d0), Py_ULL(0x8920b098955522b4)}, /* 5**-320 */
+    {Py_ULL(0x9e20735e8cb16382), Py_ULL(0x55b46e5f5d5535b0)}, /* 5**-319 */
+    {Py_ULL(0xc5a890362fddbc62), Py_ULL(0xeb2189f734aa831d)}, /* 5**-318 */
+    {Py_ULL(0xf712b443bbd52b7b), Py_ULL(0xa5e9ec7501d523e4)}, /* 5**-317 */
+    {Py_ULL(0x9a6bb0aa55653b2d), Py_ULL(0x47b233c92125366e)}, /* 5**-316 */
+    {Py_ULL(0xc1069cd4eabe89f8), Py_ULL(0x999ec0bb696e840a)}, /* 5**-315 */
+    {Py_ULL(0xf148440a256e2c76), Py_ULL(0xc00670ea43ca250d)}, /* 5**-314 */
+    {Py_ULL(0x96cd2a865764dbca), Py_ULL(0x380406926a5e5728)}, /* 5**-313 */
+    {Py_ULL(0xbc807527ed3e12bc), Py_ULL(0xc605083704f5ecf2)}, /* 5**-312 */
+    {Py_ULL(0xeba09271e88d976b), Py_ULL(0xf7864a44c633682e)}, /* 5**-311 */
+    {Py_ULL(0x93445b8731587ea3), Py_ULL(0x7ab3ee6afbe0211d)}, /* 5**-310 */
+    {Py_ULL(0xb8157268fdae9e4c), Py_ULL(0x5960ea05bad82964)}, /* 5**-309 */
+    {Py_ULL(0xe61acf033d1a45df), Py_ULL(0x6fb92487298e33bd)}, /* 5**-308 */
+    {Py_ULL(0x8fd0c16206306bab), Py_ULL(0xa5d3b6d479f8e056)}, /* 5**-307 */
+    {Py_ULL(0xb3c4f1ba87bc8696), Py_ULL(0x8f48a4899877186c)}, /* 5**-306 */
+    {Py_ULL(0xe0b62e2929aba83c), Py_ULL(0x331acdabfe94de87)}, /* 5**-305 */
+    {Py_ULL(0x8c71dcd9ba0b4925), Py_ULL(0x9ff0c08b7f1d0b14)}, /* 5**-304 */
+    {Py_ULL(0xaf8e5410288e1b6f), Py_ULL(0x07ecf0ae5ee44dd9)}, /* 5**-303 */
+    {Py_ULL(0xdb71e91432b1a24a), Py_ULL(0xc9e82cd9f69d6150)}, /* 5**-302 */
+    {Py_ULL(0x892731ac9faf056e), Py_ULL(0xbe311c083a225cd2)}, /* 5**-301 */
+    {Py_ULL(0xab70fe17c79ac6ca), Py_ULL(0x6dbd630a48aaf406)}, /* 5**-300 */
+    {Py_ULL(0xd64d3d9db981787d), Py_ULL(0x092cbbccdad5b108)}, /* 5**-299 */
+    {Py_ULL(0x85f0468293f0eb4e), Py_ULL(0x25bbf56008c58ea5)}, /* 5**-298 */
+    {Py_ULL(0xa76c582338ed2621), Py_ULL(0xaf2af2b80af6f24e)}, /* 5**-297 */
+    {Py_ULL(0xd1476e2c07286faa), Py_ULL(0x1af5af660db4aee1)}, /* 5**-296 */
+    {Py_ULL(0x82cca4db847945ca), Py_ULL(0x50d98d9fc890ed4d)}, /* 5**-295 */
+    {Py_ULL(0xa37fce126597973c), Py_ULL(0xe50ff107bab528a0)}, /* 5**-294 */
+    {Py_ULL(0xcc5fc196fefd7d0c), Py_ULL(0x1e53ed49a96272c8)}, /* 5**-293 */
+    {Py_ULL(0xff77b1fcbebcdc4f), Py_ULL(0x25e8e89c13bb0f7a)}, /* 5**-292 */
+    {Py_ULL(0x9faacf3df73609b1), Py_ULL(0x77b191618c54e9ac)}, /* 5**-291 */
+    {Py_ULL(0xc795830d75038c1d), Py_ULL(0xd59df5b9ef6a2417)}, /* 5**-290 */
+    {Py_ULL(0xf97ae3d0d2446f25), Py_ULL(0x4b0573286b44ad1d)}, /* 5**-289 */
+    {Py_ULL(0x9becce62836ac577), Py_ULL(0x4ee367f9430aec32)}, /* 5**-288 */
+    {Py_ULL(0xc2e801fb244576d5), Py_ULL(0x229c41f793cda73f)}, /* 5**-287 */
+    {Py_ULL(0xf3a20279ed56d48a), Py_ULL(0x6b43527578c1110f)}, /* 5**-286 */
+    {Py_ULL(0x9845418c345644d6), Py_ULL(0x830a13896b78aaa9)}, /* 5**-285 */
+    {Py_ULL(0xbe5691ef416bd60c), Py_ULL(0x23cc986bc656d553)}, /* 5**-284 */
+    {Py_ULL(0xedec366b11c6cb8f), Py_ULL(0x2cbfbe86b7ec8aa8)}, /* 5**-283 */
+    {Py_ULL(0x94b3a202eb1c3f39), Py_ULL(0x7bf7d71432f3d6a9)}, /* 5**-282 */
+    {Py_ULL(0xb9e08a83a5e34f07), Py_ULL(0xdaf5ccd93fb0cc53)}, /* 5**-281 */
+    {Py_ULL(0xe858ad248f5c22c9), Py_ULL(0xd1b3400f8f9cff68)}, /* 5**-280 */
+    {Py_ULL(0x91376c36d99995be), Py_ULL(0x23100809b9c21fa1)}, /* 5**-279 */
+    {Py_ULL(0xb58547448ffffb2d), Py_ULL(0xabd40a0c2832a78a)}, /* 5**-278 */
+    {Py_ULL(0xe2e69915b3fff9f9), Py_ULL(0x16c90c8f323f516c)}, /* 5**-277 */
+    {Py_ULL(0x8dd01fad907ffc3b), Py_ULL(0xae3da7d97f6792e3)}, /* 5**-276 */
+    {Py_ULL(0xb1442798f49ffb4a), Py_ULL(0x99cd11cfdf41779c)}, /* 5**-275 */
+    {Py_ULL(0xdd95317f31c7fa1d), Py_ULL(0x40405643d711d583)}, /* 5**-274 */
+    {Py_ULL(0x8a7d3eef7f1cfc52), Py_ULL(0x482835ea666b2572)}, /* 5**-273 */
+    {Py_ULL(0xad1c8eab5ee43b66), Py_ULL(0xda3243650005eecf)}, /* 5**-272 */
+    {Py_ULL(0xd863b256369d4a40), Py_ULL(0x90bed43e40076a82)}, /* 5**-271 */
+    {Py_ULL(0x873e4f75e2224e68), Py_ULL(0x5a7744a6e804a291)}, /* 5**-270 */
+    {Py_ULL(0xa90de3535aaae202), Py_ULL(0x711515d0a205cb36)}, /* 5**-269 */
+    {Py_ULL(0xd3515c2831559a83), Py_ULL(0x0d5a5b44ca873e03)}, /* 5**-268 */
+    {Py_ULL(0x8412d9991ed58091), Py_ULL(0xe858790afe9486c2)}, /* 5**-267 */
+    {Py_ULL(0xa5178fff668ae0b6), Py_ULL(0x626e974dbe39a872)}, /* 5**-266 */
+    {Py_ULL(0xce5d73ff402d98e3), Py_ULL(0xfb0a3d212dc8128f)}, /* 5**-265 */
+    {Py_ULL(0x80fa687f881c7f8e), Py_ULL(0x7ce66634bc9d0b99)}, /* 5**-264 */
+    {Py_ULL(0xa139029f6a239f72), Py_ULL(0x1c1fffc1ebc44e80)}, /* 5**-263 */
+    {Py_ULL(0xc987434744ac874e), Py_ULL(0xa327ffb266b56220)}, /* 5**-262 */
+    {Py_ULL(0xfbe9141915d7a922), Py_ULL(0x4bf1ff9f0062baa8)}, /* 5**-261 */
+    {Py_ULL(0x9d71ac8fada6c9b5), Py_ULL(0x6f773fc3603db4a9)}, /* 5**-260 */
+    {Py_ULL(0xc4ce17b399107c22), Py_ULL(0xcb550fb4384d21d3)}, /* 5**-259 */
+    {Py_ULL(0xf6019da07f549b2b), Py_ULL(0x7e2a53a146606a48)}, /* 5**-258 */
+    {Py_ULL(0x99c102844f94e0fb), Py_ULL(0x2eda7444cbfc426d)}, /* 5**-257 */
+    {Py_ULL(0xc0314325637a1939), Py_ULL(0xfa911155fefb5308)}, /* 5**-256 */
+    {Py_ULL(0xf03d93eebc589f88), Py_ULL(0x793555ab7eba27ca)}, /* 5**-255 */
+    {Py_ULL(0x96267c7535b763b5), Py_ULL(0x4bc1558b2f3458de)}, /* 5**-254 */
+    {Py_ULL(0xbbb01b9283253ca2), Py_ULL(0x9eb1aaedfb016f16)}, /* 5**-253 */
+    {Py_ULL(0xea9c227723ee8bcb), Py_ULL(0x465e15a979c1cadc)}, /* 5**-252 */
+    {Py_ULL(0x92a1958a7675175f), Py_ULL(0x0bfacd89ec191ec9)}, /* 5**-251 */
+    {Py_ULL(0xb749faed14125d36), Py_ULL(0xcef980ec671f667b)}, /* 5**-250 */
+    {Py_ULL(0xe51c79a85916f484), Py_ULL(0x82b7e12780e7401a)}, /* 5**-249 */
+    {Py_ULL(0x8f31cc0937ae58d2), Py_ULL(0xd1b2ecb8b0908810)}, /* 5**-248 */
+    {Py_ULL(0xb2fe3f0b8599ef07), Py_ULL(0x861fa7e6dcb4aa15)}, /* 5**-247 */
+    {Py_ULL(0xdfbdcece67006ac9), Py_ULL(0x67a791e093e1d49a)}, /* 5**-246 */
+    {Py_ULL(0x8bd6a141006042bd), Py_ULL(0xe0c8bb2c5c6d24e0)}, /* 5**-245 */
+    {Py_ULL(0xaecc49914078536d), Py_ULL(0x58fae9f773886e18)}, /* 5**-244 */
+    {Py_ULL(0xda7f5bf590966848), Py_ULL(0xaf39a475506a899e)}, /* 5**-243 */
+    {Py_ULL(0x888f99797a5e012d), Py_ULL(0x6d8406c952429603)}, /* 5**-242 */
+    {Py_ULL(0xaab37fd7d8f58178), Py_ULL(0xc8e5087ba6d33b83)}, /* 5**-241 */
+    {Py_ULL(0xd5605fcdcf32e1d6), Py_ULL(0xfb1e4a9a90880a64)}, /* 5**-240 */
+    {Py_ULL(0x855c3be0a17fcd26), Py_ULL(0x5cf2eea09a55067f)}, /* 5**-239 */
+    {Py_ULL(0xa6b34ad8c9dfc06f), Py_ULL(0xf42faa48c0ea481e)}, /* 5**-238 */
+    {Py_ULL(0xd0601d8efc57b08b), Py_ULL(0xf13b94daf124da26)}, /* 5**-237 */
+    {Py_ULL(0x823c12795db6ce57), Py_ULL(0x76c53d08d6b70858)}, /* 5**-236 */
+    {Py_ULL(0xa2cb1717b52481ed), Py_ULL(0x54768c4b0c64ca6e)}, /* 5**-235 */
+    {Py_ULL(0xcb7ddcdda26da268), Py_ULL(0xa9942f5dcf7dfd09)}, /* 5**-234 */
+    {Py_ULL(0xfe5d54150b090b02), Py_ULL(0xd3f93b35435d7c4c)}, /* 5**-233 */
+    {Py_ULL(0x9efa548d26e5a6e1), Py_ULL(0xc47bc5014a1a6daf)}, /* 5**-232 */
+    {Py_ULL(0xc6b8e9b0709f109a), Py_ULL(0x359ab6419ca1091b)}, /* 5**-231 */
+    {Py_ULL(0xf867241c8cc6d4c0), Py_ULL(0xc30163d203c94b62)}, /* 5**-230 */
+    {Py_ULL(0x9b407691d7fc44f8), Py_ULL(0x79e0de63425dcf1d)}, /* 5**-229 */
+    {Py_ULL(0xc21094364dfb5636), Py_ULL(0x985915fc12f542e4)}, /* 5**-228 */
+    {Py_ULL(0xf294b943e17a2bc4), Py_ULL(0x3e6f5b7b17b2939d)}, /* 5**-227 */
+    {Py_ULL(0x979cf3ca6cec5b5a), Py_ULL(0xa705992ceecf9c42)}, /* 5**-226 */
+    {Py_ULL(0xbd8430bd08277231), Py_ULL(0x50c6ff782a838353)}, /* 5**-225 */
+    {Py_ULL(0xece53cec4a314ebd), Py_ULL(0xa4f8bf5635246428)}, /* 5**-224 */
+    {Py_ULL(0x940f4613ae5ed136), Py_ULL(0x871b7795e136be99)}, /* 5**-223 */
+    {Py_ULL(0xb913179899f68584), Py_ULL(0x28e2557b59846e3f)}, /* 5**-222 */
+    {Py_ULL(0xe757dd7ec07426e5), Py_ULL(0x331aeada2fe589cf)}, /* 5**-221 */
+    {Py_ULL(0x9096ea6f3848984f), Py_ULL(0x3ff0d2c85def7621)}, /* 5**-220 */
+    {Py_ULL(0xb4bca50b065abe63), Py_ULL(0x0fed077a756b53a9)}, /* 5**-219 */
+    {Py_ULL(0xe1ebce4dc7f16dfb), Py_ULL(0xd3e8495912c62894)}, /* 5**-218 */
+    {Py_ULL(0x8d3360f09cf6e4bd), Py_ULL(0x64712dd7abbbd95c)}, /* 5**-217 */
+    {Py_ULL(0xb080392cc4349dec), Py_ULL(0xbd8d794d96aacfb3)}, /* 5**-216 */
+    {Py_ULL(0xdca04777f541c567), Py_ULL(0xecf0d7a0fc5583a0)}, /* 5**-215 */
+    {Py_ULL(0x89e42caaf9491b60), Py_ULL(0xf41686c49db57244)}, /* 5**-214 */
+    {Py_ULL(0xac5d37d5b79b6239), Py_ULL(0x311c2875c522ced5)}, /* 5**-213 */
+    {Py_ULL(0xd77485cb25823ac7), Py_ULL(0x7d633293366b828b)}, /* 5**-212 */
+    {Py_ULL(0x86a8d39ef77164bc), Py_ULL(0xae5dff9c02033197)}, /* 5**-211 */
+    {Py_ULL(0xa8530886b54dbdeb), Py_ULL(0xd9f57f830283fdfc)}, /* 5**-210 */
+    {Py_ULL(0xd267caa862a12d66), Py_ULL(0xd072df63c324fd7b)}, /* 5**-209 */
+    {Py_ULL(0x8380dea93da4bc60), Py_ULL(0x4247cb9e59f71e6d)}, /* 5**-208 */
+    {Py_ULL(0xa46116538d0deb78), Py_ULL(0x52d9be85f074e608)}, /* 5**-207 */
+    {Py_ULL(0xcd795be870516656), Py_ULL(0x67902e276c921f8b)}, /* 5**-206 */
+    {Py_ULL(0x806bd9714632dff6), Py_ULL(0x00ba1cd8a3db53b6)}, /* 5**-205 */
+    {Py_ULL(0xa086cfcd97bf97f3), Py_ULL(0x80e8a40eccd228a4)}, /* 5**-204 */
+    {Py_ULL(0xc8a883c0fdaf7df0), Py_ULL(0x6122cd128006b2cd)}, /* 5**-203 */
+    {Py_ULL(0xfad2a4b13d1b5d6c), Py_ULL(0x796b805720085f81)}, /* 5**-202 */
+    {Py_ULL(0x9cc3a6eec6311a63), Py_ULL(0xcbe3303674053bb0)}, /* 5**-201 */
+    {Py_ULL(0xc3f490aa77bd60fc), Py_ULL(0xbedbfc4411068a9c)}, /* 5**-200 */
+    {Py_ULL(0xf4f1b4d515acb93b), Py_ULL(0xee92fb5515482d44)}, /* 5**-199 */
+    {Py_ULL(0x991711052d8bf3c5), Py_ULL(0x751bdd152d4d1c4a)}, /* 5**-198 */
+    {Py_ULL(0xbf5cd54678eef0b6), Py_ULL(0xd262d45a78a0635d)}, /* 5**-197 */
+    {Py_ULL(0xef340a98172aace4), Py_ULL(0x86fb897116c87c34)}, /* 5**-196 */
+    {Py_ULL(0x9580869f0e7aac0e), Py_ULL(0xd45d35e6ae3d4da0)}, /* 5**-195 */
+    {Py_ULL(0xbae0a846d2195712), Py_ULL(0x8974836059cca109)}, /* 5**-194 */
+    {Py_ULL(0xe998d258869facd7), Py_ULL(0x2bd1a438703fc94b)}, /* 5**-193 */
+    {Py_ULL(0x91ff83775423cc06), Py_ULL(0x7b6306a34627ddcf)}, /* 5**-192 */
+    {Py_ULL(0xb67f6455292cbf08), Py_ULL(0x1a3bc84c17b1d542)}, /* 5**-191 */
+    {Py_ULL(0xe41f3d6a7377eeca), Py_ULL(0x20caba5f1d9e4a93)}, /* 5**-190 */
+    {Py_ULL(0x8e938662882af53e), Py_ULL(0x547eb47b7282ee9c)}, /* 5**-189 */
+    {Py_ULL(0xb23867fb2a35b28d), Py_ULL(0xe99e619a4f23aa43)}, /* 5**-188 */
+    {Py_ULL(0xdec681f9f4c31f31), Py_ULL(0x6405fa00e2ec94d4)}, /* 5**-187 */
+    {Py_ULL(0x8b3c113c38f9f37e), Py_ULL(0xde83bc408dd3dd04)}, /* 5**-186 */
+    {Py_ULL(0xae0b158b4738705e), Py_ULL(0x9624ab50b148d445)}, /* 5**-185 */
+    {Py_ULL(0xd98ddaee19068c76), Py_ULL(0x3badd624dd9b0957)}, /* 5**-184 */
+    {Py_ULL(0x87f8a8d4cfa417c9), Py_ULL(0xe54ca5d70a80e5d6)}, /* 5**-183 */
+    {Py_ULL(0xa9f6d30a038d1dbc), Py_ULL(0x5e9fcf4ccd211f4c)}, /* 5**-182 */
+    {Py_ULL(0xd47487cc8470652b), Py_ULL(0x7647c3200069671f)}, /* 5**-181 */
+    {Py_ULL(0x84c8d4dfd2c63f3b), Py_ULL(0x29ecd9f40041e073)}, /* 5**-180 */
+    {Py_ULL(0xa5fb0a17c777cf09), Py_ULL(0xf468107100525890)}, /* 5**-179 */
+    {Py_ULL(0xcf79cc9db955c2cc), Py_ULL(0x7182148d4066eeb4)}, /* 5**-178 */
+    {Py_ULL(0x81ac1fe293d599bf), Py_ULL(0xc6f14cd848405530)}, /* 5**-177 */
+    {Py_ULL(0xa21727db38cb002f), Py_ULL(0xb8ada00e5a506a7c)}, /* 5**-176 */
+    {Py_ULL(0xca9cf1d206fdc03b), Py_ULL(0xa6d90811f0e4851c)}, /* 5**-175 */
+    {Py_ULL(0xfd442e4688bd304a), Py_ULL(0x908f4a166d1da663)}, /* 5**-174 */
+    {Py_ULL(0x9e4a9cec15763e2e), Py_ULL(0x9a598e4e043287fe)}, /* 5**-173 */
+    {Py_ULL(0xc5dd44271ad3cdba), Py_ULL(0x40eff1e1853f29fd)}, /* 5**-172 */
+    {Py_ULL(0xf7549530e188c128), Py_ULL(0xd12bee59e68ef47c)}, /* 5**-171 */
+    {Py_ULL(0x9a94dd3e8cf578b9), Py_ULL(0x82bb74f8301958ce)}, /* 5**-170 */
+    {Py_ULL(0xc13a148e3032d6e7), Py_ULL(0xe36a52363c1faf01)}, /* 5**-169 */
+    {Py_ULL(0xf18899b1bc3f8ca1), Py_ULL(0xdc44e6c3cb279ac1)}, /* 5**-168 */
+    {Py_ULL(0x96f5600f15a7b7e5), Py_ULL(0x29ab103a5ef8c0b9)}, /* 5**-167 */
+    {Py_ULL(0xbcb2b812db11a5de), Py_ULL(0x7415d448f6b6f0e7)}, /* 5**-166 */
+    {Py_ULL(0xebdf661791d60f56), Py_ULL(0x111b495b3464ad21)}, /* 5**-165 */
+    {Py_ULL(0x936b9fcebb25c995), Py_ULL(0xcab10dd900beec34)}, /* 5**-164 */
+    {Py_ULL(0xb84687c269ef3bfb), Py_ULL(0x3d5d514f40eea742)}, /* 5**-163 */
+    {Py_ULL(0xe65829b3046b0afa), Py_ULL(0x0cb4a5a3112a5112)}, /* 5**-162 */
+    {Py_ULL(0x8ff71a0fe2c2e6dc), Py_ULL(0x47f0e785eaba72ab)}, /* 5**-161 */
+    {Py_ULL(0xb3f4e093db73a093), Py_ULL(0x59ed216765690f56)}, /* 5**-160 */
+    {Py_ULL(0xe0f218b8d25088b8), Py_ULL(0x306869c13ec3532c)}, /* 5**-159 */
+    {Py_ULL(0x8c974f7383725573), Py_ULL(0x1e414218c73a13fb)}, /* 5**-158 */
+    {Py_ULL(0xafbd2350644eeacf), Py_ULL(0xe5d1929ef90898fa)}, /* 5**-157 */
+    {Py_ULL(0xdbac6c247d62a583), Py_ULL(0xdf45f746b74abf39)}, /* 5**-156 */
+    {Py_ULL(0x894bc396ce5da772), Py_ULL(0x6b8bba8c328eb783)}, /* 5**-155 */
+    {Py_ULL(0xab9eb47c81f5114f), Py_ULL(0x066ea92f3f326564)}, /* 5**-154 */
+    {Py_ULL(0xd686619ba27255a2), Py_ULL(0xc80a537b0efefebd)}, /* 5**-153 */
+    {Py_ULL(0x8613fd0145877585), Py_ULL(0xbd06742ce95f5f36)}, /* 5**-152 */
+    {Py_ULL(0xa798fc4196e952e7), Py_ULL(0x2c48113823b73704)}, /* 5**-151 */
+    {Py_ULL(0xd17f3b51fca3a7a0), Py_ULL(0xf75a15862ca504c5)}, /* 5**-150 */
+    {Py_ULL(0x82ef85133de648c4), Py_ULL(0x9a984d73dbe722fb)}, /* 5**-149 */
+    {Py_ULL(0xa3ab66580d5fdaf5), Py_ULL(0xc13e60d0d2e0ebba)}, /* 5**-148 */
+    {Py_ULL(0xcc963fee10b7d1b3), Py_ULL(0x318df905079926a8)}, /* 5**-147 */
+    {Py_ULL(0xffbbcfe994e5c61f), Py_ULL(0xfdf17746497f7052)}, /* 5**-146 */
+    {Py_ULL(0x9fd561f1fd0f9bd3), Py_ULL(0xfeb6ea8bedefa633)}, /* 5**-145 */
+    {Py_ULL(0xc7caba6e7c5382c8), Py_ULL(0xfe64a52ee96b8fc0)}, /* 5**-144 */
+    {Py_ULL(0xf9bd690a1b68637b), Py_ULL(0x3dfdce7aa3c673b0)}, /* 5**-143 */
+    {Py_ULL(0x9c1661a651213e2d), Py_ULL(0x06bea10ca65c084e)}, /* 5**-142 */
+    {Py_ULL(0xc31bfa0fe5698db8), Py_ULL(0x486e494fcff30a62)}, /* 5**-141 */
+    {Py_ULL(0xf3e2f893dec3f126), Py_ULL(0x5a89dba3c3efccfa)}, /* 5**-140 */
+    {Py_ULL(0x986ddb5c6b3a76b7), Py_ULL(0xf89629465a75e01c)}, /* 5**-139 */
+    {Py_ULL(0xbe89523386091465), Py_ULL(0xf6bbb397f1135823)}, /* 5**-138 */
+    {Py_ULL(0xee2ba6c0678b597f), Py_ULL(0x746aa07ded582e2c)}, /* 5**-137 */
+    {Py_ULL(0x94db483840b717ef), Py_ULL(0xa8c2a44eb4571cdc)}, /* 5**-136 */
+    {Py_ULL(0xba121a4650e4ddeb), Py_ULL(0x92f34d62616ce413)}, /* 5**-135 */
+    {Py_ULL(0xe896a0d7e51e1566), Py_ULL(0x77b020baf9c81d17)}, /* 5**-134 */
+    {Py_ULL(0x915e2486ef32cd60), Py_ULL(0x0ace1474dc1d122e)}, /* 5**-133 */
+    {Py_ULL(0xb5b5ada8aaff80b8), Py_ULL(0x0d819992132456ba)}, /* 5**-132 */
+    {Py_ULL(0xe3231912d5bf60e6), Py_ULL(0x10e1fff697ed6c69)}, /* 5**-131 */
+    {Py_ULL(0x8df5efabc5979c8f), Py_ULL(0xca8d3ffa1ef463c1)}, /* 5**-130 */
+    {Py_ULL(0xb1736b96b6fd83b3), Py_ULL(0xbd308ff8a6b17cb2)}, /* 5**-129 */
+    {Py_ULL(0xddd0467c64bce4a0), Py_ULL(0xac7cb3f6d05ddbde)}, /* 5**-128 */
+    {Py_ULL(0x8aa22c0dbef60ee4), Py_ULL(0x6bcdf07a423aa96b)}, /* 5**-127 */
+    {Py_ULL(0xad4ab7112eb3929d), Py_ULL(0x86c16c98d2c953c6)}, /* 5**-126 */
+    {Py_ULL(0xd89d64d57a607744), Py_ULL(0xe871c7bf077ba8b7)}, /* 5**-125 */
+    {Py_ULL(0x87625f056c7c4a8b), Py_ULL(0x11471cd764ad4972)}, /* 5**-124 */
+    {Py_ULL(0xa93af6c6c79b5d2d), Py_ULL(0xd598e40d3dd89bcf)}, /* 5**-123 */
+    {Py_ULL(0xd389b47879823479), Py_ULL(0x4aff1d108d4ec2c3)}, /* 5**-122 */
+    {Py_ULL(0x843610cb4bf160cb), Py_ULL(0xcedf722a585139ba)}, /* 5**-121 */
+    {Py_ULL(0xa54394fe1eedb8fe), Py_ULL(0xc2974eb4ee658828)}, /* 5**-120 */
+    {Py_ULL(0xce947a3da6a9273e), Py_ULL(0x733d226229feea32)}, /* 5**-119 */
+    {Py_ULL(0x811ccc668829b887), Py_ULL(0x0806357d5a3f525f)}, /* 5**-118 */
+    {Py_ULL(0xa163ff802a3426a8), Py_ULL(0xca07c2dcb0cf26f7)}, /* 5**-117 */
+    {Py_ULL(0xc9bcff6034c13052), Py_ULL(0xfc89b393dd02f0b5)}, /* 5**-116 */
+    {Py_ULL(0xfc2c3f3841f17c67), Py_ULL(0xbbac2078d443ace2)}, /* 5**-115 */
+    {Py_ULL(0x9d9ba7832936edc0), Py_ULL(0xd54b944b84aa4c0d)}, /* 5**-114 */
+    {Py_ULL(0xc5029163f384a931), Py_ULL(0x0a9e795e65d4df11)}, /* 5**-113 */
+    {Py_ULL(0xf64335bcf065d37d), Py_ULL(0x4d4617b5ff4a16d5)}, /* 5**-112 */
+    {Py_ULL(0x99ea0196163fa42e), Py_ULL(0x504bced1bf8e4e45)}, /* 5**-111 */
+    {Py_ULL(0xc06481fb9bcf8d39), Py_ULL(0xe45ec2862f71e1d6)}, /* 5**-110 */
+    {Py_ULL(0xf07da27a82c37088), Py_ULL(0x5d767327bb4e5a4c)}, /* 5**-109 */
+    {Py_ULL(0x964e858c91ba2655), Py_ULL(0x3a6a07f8d510f86f)}, /* 5**-108 */
+    {Py_ULL(0xbbe226efb628afea), Py_ULL(0x890489f70a55368b)}, /* 5**-107 */
+    {Py_ULL(0xeadab0aba3b2dbe5), Py_ULL(0x2b45ac74ccea842e)}, /* 5**-106 */
+    {Py_ULL(0x92c8ae6b464fc96f), Py_ULL(0x3b0b8bc90012929d)}, /* 5**-105 */
+    {Py_ULL(0xb77ada0617e3bbcb), Py_ULL(0x09ce6ebb40173744)}, /* 5**-104 */
+    {Py_ULL(0xe55990879ddcaabd), Py_ULL(0xcc420a6a101d0515)}, /* 5**-103 */
+    {Py_ULL(0x8f57fa54c2a9eab6), Py_ULL(0x9fa946824a12232d)}, /* 5**-102 */
+    {Py_ULL(0xb32df8e9f3546564), Py_ULL(0x47939822dc96abf9)}, /* 5**-101 */
+    {Py_ULL(0xdff9772470297ebd), Py_ULL(0x59787e2b93bc56f7)}, /* 5**-100 */
+    {Py_ULL(0x8bfbea76c619ef36), Py_ULL(0x57eb4edb3c55b65a)}, /* 5**-99 */
+    {Py_ULL(0xaefae51477a06b03), Py_ULL(0xede622920b6b23f1)}, /* 5**-98 */
+    {Py_ULL(0xdab99e59958885c4), Py_ULL(0xe95fab368e45eced)}, /* 5**-97 */
+    {Py_ULL(0x88b402f7fd75539b), Py_ULL(0x11dbcb0218ebb414)}, /* 5**-96 */
+    {Py_ULL(0xaae103b5fcd2a881), Py_ULL(0xd652bdc29f26a119)}, /* 5**-95 */
+    {Py_ULL(0xd59944a37c0752a2), Py_ULL(0x4be76d3346f0495f)}, /* 5**-94 */
+    {Py_ULL(0x857fcae62d8493a5), Py_ULL(0x6f70a4400c562ddb)}, /* 5**-93 */
+    {Py_ULL(0xa6dfbd9fb8e5b88e), Py_ULL(0xcb4ccd500f6bb952)}, /* 5**-92 */
+    {Py_ULL(0xd097ad07a71f26b2), Py_ULL(0x7e2000a41346a7a7)}, /* 5**-91 */
+    {Py_ULL(0x825ecc24c873782f), Py_ULL(0x8ed400668c0c28c8)}, /* 5**-90 */
+    {Py_ULL(0xa2f67f2dfa90563b), Py_ULL(0x728900802f0f32fa)}, /* 5**-89 */
+    {Py_ULL(0xcbb41ef979346bca), Py_ULL(0x4f2b40a03ad2ffb9)}, /* 5**-88 */
+    {Py_ULL(0xfea126b7d78186bc), Py_ULL(0xe2f610c84987bfa8)}, /* 5**-87 */
+    {Py_ULL(0x9f24b832e6b0f436), Py_ULL(0x0dd9ca7d2df4d7c9)}, /* 5**-86 */
+    {Py_ULL(0xc6ede63fa05d3143), Py_ULL(0x91503d1c79720dbb)}, /* 5**-85 */
+    {Py_ULL(0xf8a95fcf88747d94), Py_ULL(0x75a44c6397ce912a)}, /* 5**-84 */
+    {Py_ULL(0x9b69dbe1b548ce7c), Py_ULL(0xc986afbe3ee11aba)}, /* 5**-83 */
+    {Py_ULL(0xc24452da229b021b), Py_ULL(0xfbe85badce996168)}, /* 5**-82 */
+    {Py_ULL(0xf2d56790ab41c2a2), Py_ULL(0xfae27299423fb9c3)}, /* 5**-81 */
+    {Py_ULL(0x97c560ba6b0919a5), Py_ULL(0xdccd879fc967d41a)}, /* 5**-80 */
+    {Py_ULL(0xbdb6b8e905cb600f), Py_ULL(0x5400e987bbc1c920)}, /* 5**-79 */
+    {Py_ULL(0xed246723473e3813), Py_ULL(0x290123e9aab23b68)}, /* 5**-78 */
+    {Py_ULL(0x9436c0760c86e30b), Py_ULL(0xf9a0b6720aaf6521)}, /* 5**-77 */
+    {Py_ULL(0xb94470938fa89bce), Py_ULL(0xf808e40e8d5b3e69)}, /* 5**-76 */
+    {Py_ULL(0xe7958cb87392c2c2), Py_ULL(0xb60b1d1230b20e04)}, /* 5**-75 */
+    {Py_ULL(0x90bd77f3483bb9b9), Py_ULL(0xb1c6f22b5e6f48c2)}, /* 5**-74 */
+    {Py_ULL(0xb4ecd5f01a4aa828), Py_ULL(0x1e38aeb6360b1af3)}, /* 5**-73 */
+    {Py_ULL(0xe2280b6c20dd5232), Py_ULL(0x25c6da63c38de1b0)}, /* 5**-72 */
+    {Py_ULL(0x8d590723948a535f), Py_ULL(0x579c487e5a38ad0e)}, /* 5**-71 */
+    {Py_ULL(0xb0af48ec79ace837), Py_ULL(0x2d835a9df0c6d851)}, /* 5**-70 */
+    {Py_ULL(0xdcdb1b2798182244), Py_ULL(0xf8e431456cf88e65)}, /* 5**-69 */
+    {Py_ULL(0x8a08f0f8bf0f156b), Py_ULL(0x1b8e9ecb641b58ff)}, /* 5**-68 */
+    {Py_ULL(0xac8b2d36eed2dac5), Py_ULL(0xe272467e3d222f3f)}, /* 5**-67 */
+    {Py_ULL(0xd7adf884aa879177), Py_ULL(0x5b0ed81dcc6abb0f)}, /* 5**-66 */
+    {Py_ULL(0x86ccbb52ea94baea), Py_ULL(0x98e947129fc2b4e9)}, /* 5**-65 */
+    {Py_ULL(0xa87fea27a539e9a5), Py_ULL(0x3f2398d747b36224)}, /* 5**-64 */
+    {Py_ULL(0xd29fe4b18e88640e), Py_ULL(0x8eec7f0d19a03aad)}, /* 5**-63 */
+    {Py_ULL(0x83a3eeeef9153e89), Py_ULL(0x1953cf68300424ac)}, /* 5**-62 */
+    {Py_ULL(0xa48ceaaab75a8e2b), Py_ULL(0x5fa8c3423c052dd7)}, /* 5**-61 */
+    {Py_ULL(0xcdb02555653131b6), Py_ULL(0x3792f412cb06794d)}, /* 5**-60 */
+    {Py_ULL(0x808e17555f3ebf11), Py_ULL(0xe2bbd88bbee40bd0)}, /* 5**-59 */
+    {Py_ULL(0xa0b19d2ab70e6ed6), Py_ULL(0x5b6aceaeae9d0ec4)}, /* 5**-58 */
+    {Py_ULL(0xc8de047564d20a8b), Py_ULL(0xf245825a5a445275)}, /* 5**-57 */
+    {Py_ULL(0xfb158592be068d2e), Py_ULL(0xeed6e2f0f0d56712)}, /* 5**-56 */
+    {Py_ULL(0x9ced737bb6c4183d), Py_ULL(0x55464dd69685606b)}, /* 5**-55 */
+    {Py_ULL(0xc428d05aa4751e4c), Py_ULL(0xaa97e14c3c26b886)}, /* 5**-54 */
+    {Py_ULL(0xf53304714d9265df), Py_ULL(0xd53dd99f4b3066a8)}, /* 5**-53 */
+    {Py_ULL(0x993fe2c6d07b7fab), Py_ULL(0xe546a8038efe4029)}, /* 5**-52 */
+    {Py_ULL(0xbf8fdb78849a5f96), Py_ULL(0xde98520472bdd033)}, /* 5**-51 */
+    {Py_ULL(0xef73d256a5c0f77c), Py_ULL(0x963e66858f6d4440)}, /* 5**-50 */
+    {Py_ULL(0x95a8637627989aad), Py_ULL(0xdde7001379a44aa8)}, /* 5**-49 */
+    {Py_ULL(0xbb127c53b17ec159), Py_ULL(0x5560c018580d5d52)}, /* 5**-48 */
+    {Py_ULL(0xe9d71b689dde71af), Py_ULL(0xaab8f01e6e10b4a6)}, /* 5**-47 */
+    {Py_ULL(0x9226712162ab070d), Py_ULL(0xcab3961304ca70e8)}, /* 5**-46 */
+    {Py_ULL(0xb6b00d69bb55c8d1), Py_ULL(0x3d607b97c5fd0d22)}, /* 5**-45 */
+    {Py_ULL(0xe45c10c42a2b3b05), Py_ULL(0x8cb89a7db77c506a)}, /* 5**-44 */
+    {Py_ULL(0x8eb98a7a9a5b04e3), Py_ULL(0x77f3608e92adb242)}, /* 5**-43 */
+    {Py_ULL(0xb267ed1940f1c61c), Py_ULL(0x55f038b237591ed3)}, /* 5**-42 */
+    {Py_ULL(0xdf01e85f912e37a3), Py_ULL(0x6b6c46dec52f6688)}, /* 5**-41 */
+    {Py_ULL(0x8b61313bbabce2c6), Py_ULL(0x2323ac4b3b3da015)}, /* 5**-40 */
+    {Py_ULL(0xae397d8aa96c1b77), Py_ULL(0xabec975e0a0d081a)}, /* 5**-39 */
+    {Py_ULL(0xd9c7dced53c72255), Py_ULL(0x96e7bd358c904a21)}, /* 5**-38 */
+    {Py_ULL(0x881cea14545c7575), Py_ULL(0x7e50d64177da2e54)}, /* 5**-37 */
+    {Py_ULL(0xaa242499697392d2), Py_ULL(0xdde50bd1d5d0b9e9)}, /* 5**-36 */
+    {Py_ULL(0xd4ad2dbfc3d07787), Py_ULL(0x955e4ec64b44e864)}, /* 5**-35 */
+    {Py_ULL(0x84ec3c97da624ab4), Py_ULL(0xbd5af13bef0b113e)}, /* 5**-34 */
+    {Py_ULL(0xa6274bbdd0fadd61), Py_ULL(0xecb1ad8aeacdd58e)}, /* 5**-33 */
+    {Py_ULL(0xcfb11ead453994ba), Py_ULL(0x67de18eda5814af2)}, /* 5**-32 */
+    {Py_ULL(0x81ceb32c4b43fcf4), Py_ULL(0x80eacf948770ced7)}, /* 5**-31 */
+    {Py_ULL(0xa2425ff75e14fc31), Py_ULL(0xa1258379a94d028d)}, /* 5**-30 */
+    {Py_ULL(0xcad2f7f5359a3b3e), Py_ULL(0x096ee45813a04330)}, /* 5**-29 */
+    {Py_ULL(0xfd87b5f28300ca0d), Py_ULL(0x8bca9d6e188853fc)}, /* 5**-28 */
+    {Py_ULL(0x9e74d1b791e07e48), Py_ULL(0x775ea264cf55347e)}, /* 5**-27 */
+    {Py_ULL(0xc612062576589dda), Py_ULL(0x95364afe032a819e)}, /* 5**-26 */
+    {Py_ULL(0xf79687aed3eec551), Py_ULL(0x3a83ddbd83f52205)}, /* 5**-25 */
+    {Py_ULL(0x9abe14cd44753b52), Py_ULL(0xc4926a9672793543)}, /* 5**-24 */
+    {Py_ULL(0xc16d9a0095928a27), Py_ULL(0x75b7053c0f178294)}, /* 5**-23 */
+    {Py_ULL(0xf1c90080baf72cb1), Py_ULL(0x5324c68b12dd6339)}, /* 5**-22 */
+    {Py_ULL(0x971da05074da7bee), Py_ULL(0xd3f6fc16ebca5e04)}, /* 5**-21 */
+    {Py_ULL(0xbce5086492111aea), Py_ULL(0x88f4bb1ca6bcf585)}, /* 5**-20 */
+    {Py_ULL(0xec1e4a7db69561a5), Py_ULL(0x2b31e9e3d06c32e6)}, /* 5**-19 */
+    {Py_ULL(0x9392ee8e921d5d07), Py_ULL(0x3aff322e62439fd0)}, /* 5**-18 */
+    {Py_ULL(0xb877aa3236a4b449), Py_ULL(0x09befeb9fad487c3)}, /* 5**-17 */
+    {Py_ULL(0xe69594bec44de15b), Py_ULL(0x4c2ebe687989a9b4)}, /* 5**-16 */
+    {Py_ULL(0x901d7cf73ab0acd9), Py_ULL(0x0f9d37014bf60a11)}, /* 5**-15 */
+    {Py_ULL(0xb424dc35095cd80f), Py_ULL(0x538484c19ef38c95)}, /* 5**-14 */
+    {Py_ULL(0xe12e13424bb40e13), Py_ULL(0x2865a5f206b06fba)}, /* 5**-13 */
+    {Py_ULL(0x8cbccc096f5088cb), Py_ULL(0xf93f87b7442e45d4)}, /* 5**-12 */
+    {Py_ULL(0xafebff0bcb24aafe), Py_ULL(0xf78f69a51539d749)}, /* 5**-11 */
+    {Py_ULL(0xdbe6fecebdedd5be), Py_ULL(0xb573440e5a884d1c)}, /* 5**-10 */
+    {Py_ULL(0x89705f4136b4a597), Py_ULL(0x31680a88f8953031)}, /* 5**-9 */
+    {Py_ULL(0xabcc77118461cefc), Py_ULL(0xfdc20d2b36ba7c3e)}, /* 5**-8 */
+    {Py_ULL(0xd6bf94d5e57a42bc), Py_ULL(0x3d32907604691b4d)}, /* 5**-7 */
+    {Py_ULL(0x8637bd05af6c69b5), Py_ULL(0xa63f9a49c2c1b110)}, /* 5**-6 */
+    {Py_ULL(0xa7c5ac471b478423), Py_ULL(0x0fcf80dc33721d54)}, /* 5**-5 */
+    {Py_ULL(0xd1b71758e219652b), Py_ULL(0xd3c36113404ea4a9)}, /* 5**-4 */
+    {Py_ULL(0x83126e978d4fdf3b), Py_ULL(0x645a1cac083126ea)}, /* 5**-3 */
+    {Py_ULL(0xa3d70a3d70a3d70a), Py_ULL(0x3d70a3d70a3d70a4)}, /* 5**-2 */
+    {Py_ULL(0xcccccccccccccccc), Py_ULL(0xcccccccccccccccd)}, /* 5**-1 */
+    {Py_ULL(0x8000000000000000), Py_ULL(0x0000000000000000)}, /* 5**0 */
+    {Py_ULL(0xa000000000000000), Py_ULL(0x0000000000000000)}, /* 5**1 */
+    {Py_ULL(0xc800000000000000), Py_ULL(0x0000000000000000)}, /* 5**2 */
+    {Py_ULL(0xfa00000000000000), Py_ULL(0x0000000000000000)}, /* 5**3 */
+    {Py_ULL(0x9c40000000000000), Py_ULL(0x0000000000000000)}, /* 5**4 */
+    {Py_ULL(0xc350000000000000), Py_ULL(0x0000000000000000)}, /* 5**5 */
+    {Py_ULL(0xf424000000000000), Py_ULL(0x0000000000000000)}, /* 5**6 */
+    {Py_ULL(0x9896800000000000), Py_ULL(0x0000000000000000)}, /* 5**7 */
+    {Py_ULL(0xbebc200000000000), Py_ULL(0x0000000000000000)}, /* 5**8 */
+    {Py_ULL(0xee6b280000000000), Py_ULL(0x0000000000000000)}, /* 5**9 */
+    {Py_ULL(0x9502f90000000000), Py_ULL(0x0000000000000000)}, /* 5**10 */
+    {Py_ULL(0xba43b74000000000), Py_ULL(0x0000000000000000)}, /* 5**11 */
+    {Py_ULL(0xe8d4a51000000000), Py_ULL(0x0000000000000000)}, /* 5**12 */
+    {Py_ULL(0x9184e72a00000000), Py_ULL(0x0000000000000000)}, /* 5**13 */
+    {Py_ULL(0xb5e620f480000000), Py_ULL(0x0000000000000000)}, /* 5**14 */
+    {Py_ULL(0xe35fa931a0000000), Py_ULL(0x0000000000000000)}, /* 5**15 */
+    {Py_ULL(0x8e1bc9bf04000000), Py_ULL(0x0000000000000000)}, /* 5**16 */
+    {Py_ULL(0xb1a2bc2ec5000000), Py_ULL(0x0000000000000000)}, /* 5**17 */
+    {Py_ULL(0xde0b6b3a76400000), Py_ULL(0x0000000000000000)}, /* 5**18 */
+    {Py_ULL(0x8ac7230489e80000), Py_ULL(0x0000000000000000)}, /* 5**19 */
+    {Py_ULL(0xad78ebc5ac620000), Py_ULL(0x0000000000000000)}, /* 5**20 */
+    {Py_ULL(0xd8d726b7177a8000), Py_ULL(0x0000000000000000)}, /* 5**21 */
+    {Py_ULL(0x878678326eac9000), Py_ULL(0x0000000000000000)}, /* 5**22 */
+    {Py_ULL(0xa968163f0a57b400), Py_ULL(0x0000000000000000)}, /* 5**23 */
+    {Py_ULL(0xd3c21bcecceda100), Py_ULL(0x0000000000000000)}, /* 5**24 */
+    {Py_ULL(0x84595161401484a0), Py_ULL(0x0000000000000000)}, /* 5**25 */
+    {Py_ULL(0xa56fa5b99019a5c8), Py_ULL(0x0000000000000000)}, /* 5**26 */
+    {Py_ULL(0xcecb8f27f4200f3a), Py_ULL(0x0000000000000000)}, /* 5**27 */
+    {Py_ULL(0x813f3978f8940984), Py_ULL(0x4000000000000000)}, /* 5**28 */
+    {Py_ULL(0xa18f07d736b90be5), Py_ULL(0x5000000000000000)}, /* 5**29 */
+    {Py_ULL(0xc9f2c9cd04674ede), Py_ULL(0xa400000000000000)}, /* 5**30 */
+    {Py_ULL(0xfc6f7c4045812296), Py_ULL(0x4d00000000000000)}, /* 5**31 */
+    {Py_ULL(0x9dc5ada82b70b59d), Py_ULL(0xf020000000000000)}, /* 5**32 */
+    {Py_ULL(0xc5371912364ce305), Py_ULL(0x6c28000000000000)}, /* 5**33 */
+    {Py_ULL(0xf684df56c3e01bc6), Py_ULL(0xc732000000000000)}, /* 5**34 */
+    {Py_ULL(0x9a130b963a6c115c), Py_ULL(0x3c7f400000000000)}, /* 5**35 */
+    {Py_ULL(0xc097ce7bc90715b3), Py_ULL(0x4b9f100000000000)}, /* 5**36 */
+    {Py_ULL(0xf0bdc21abb48db20), Py_ULL(0x1e86d40000000000)}, /* 5**37 */
+    {Py_ULL(0x96769950b50d88f4), Py_ULL(0x1314448000000000)}, /* 5**38 */
+    {Py_ULL(0xbc143fa4e250eb31), Py_ULL(0x17d955a000000000)}, /* 5**39 */
+    {Py_ULL(0xeb194f8e1ae525fd), Py_ULL(0x5dcfab0800000000)}, /* 5**40 */
+    {Py_ULL(0x92efd1b8d0cf37be), Py_ULL(0x5aa1cae500000000)}, /* 5**41 */
+    {Py_ULL(0xb7abc627050305ad), Py_ULL(0xf14a3d9e40000000)}, /* 5**42 */
+    {Py_ULL(0xe596b7b0c643c719), Py_ULL(0x6d9ccd05d0000000)}, /* 5**43 */
+    {Py_ULL(0x8f7e32ce7bea5c6f), Py_ULL(0xe4820023a2000000)}, /* 5**44 */
+    {Py_ULL(0xb35dbf821ae4f38b), Py_ULL(0xdda2802c8a800000)}, /* 5**45 */
+    {Py_ULL(0xe0352f62a19e306e), Py_ULL(0xd50b2037ad200000)}, /* 5**46 */
+    {Py_ULL(0x8c213d9da502de45), Py_ULL(0x4526f422cc340000)}, /* 5**47 */
+    {Py_ULL(0xaf298d050e4395d6), Py_ULL(0x9670b12b7f410000)}, /* 5**48 */
+    {Py_ULL(0xdaf3f04651d47b4c), Py_ULL(0x3c0cdd765f114000)}, /* 5**49 */
+    {Py_ULL(0x88d8762bf324cd0f), Py_ULL(0xa5880a69fb6ac800)}, /* 5**50 */
+    {Py_ULL(0xab0e93b6efee0053), Py_ULL(0x8eea0d047a457a00)}, /* 5**51 */
+    {Py_ULL(0xd5d238a4abe98068), Py_ULL(0x72a4904598d6d880)}, /* 5**52 */
+    {Py_ULL(0x85a36366eb71f041), Py_ULL(0x47a6da2b7f864750)}, /* 5**53 */
+    {Py_ULL(0xa70c3c40a64e6c51), Py_ULL(0x999090b65f67d924)}, /* 5**54 */
+    {Py_ULL(0xd0cf4b50cfe20765), Py_ULL(0xfff4b4e3f741cf6d)}, /* 5**55 */
+    {Py_ULL(0x82818f1281ed449f), Py_ULL(0xbff8f10e7a8921a4)}, /* 5**56 */
+    {Py_ULL(0xa321f2d7226895c7), Py_ULL(0xaff72d52192b6a0d)}, /* 5**57 */
+    {Py_ULL(0xcbea6f8ceb02bb39), Py_ULL(0x9bf4f8a69f764490)}, /* 5**58 */
+    {Py_ULL(0xfee50b7025c36a08), Py_ULL(0x02f236d04753d5b4)}, /* 5**59 */
+    {Py_ULL(0x9f4f2726179a2245), Py_ULL(0x01d762422c946590)}, /* 5**60 */
+    {Py_ULL(0xc722f0ef9d80aad6), Py_ULL(0x424d3ad2b7b97ef5)}, /* 5**61 */
+    {Py_ULL(0xf8ebad2b84e0d58b), Py_ULL(0xd2e0898765a7deb2)}, /* 5**62 */
+    {Py_ULL(0x9b934c3b330c8577), Py_ULL(0x63cc55f49f88eb2f)}, /* 5**63 */
+    {Py_ULL(0xc2781f49ffcfa6d5), Py_ULL(0x3cbf6b71c76b25fb)}, /* 5**64 */
+    {Py_ULL(0xf316271c7fc3908a), Py_ULL(0x8bef464e3945ef7a)}, /* 5**65 */
+    {Py_ULL(0x97edd871cfda3a56), Py_ULL(0x97758bf0e3cbb5ac)}, /* 5**66 */
+    {Py_ULL(0xbde94e8e43d0c8ec), Py_ULL(0x3d52eeed1cbea317)}, /* 5**67 */
+    {Py_ULL(0xed63a231d4c4fb27), Py_ULL(0x4ca7aaa863ee4bdd)}, /* 5**68 */
+    {Py_ULL(0x945e455f24fb1cf8), Py_ULL(0x8fe8caa93e74ef6a)}, /* 5**69 */
+    {Py_ULL(0xb975d6b6ee39e436), Py_ULL(0xb3e2fd538e122b44)}, /* 5**70 */
+    {Py_ULL(0xe7d34c64a9c85d44), Py_ULL(0x60dbbca87196b616)}, /* 5**71 */
+    {Py_ULL(0x90e40fbeea1d3a4a), Py_ULL(0xbc8955e946fe31cd)}, /* 5**72 */
+    {Py_ULL(0xb51d13aea4a488dd), Py_ULL(0x6babab6398bdbe41)}, /* 5**73 */
+    {Py_ULL(0xe264589a4dcdab14), Py_ULL(0xc696963c7eed2dd1)}, /* 5**74 */
+    {Py_ULL(0x8d7eb76070a08aec), Py_ULL(0xfc1e1de5cf543ca2)}, /* 5**75 */
+    {Py_ULL(0xb0de65388cc8ada8), Py_ULL(0x3b25a55f43294bcb)}, /* 5**76 */
+    {Py_ULL(0xdd15fe86affad912), Py_ULL(0x49ef0eb713f39ebe)}, /* 5**77 */
+    {Py_ULL(0x8a2dbf142dfcc7ab), Py_ULL(0x6e3569326c784337)}, /* 5**78 */
+    {Py_ULL(0xacb92ed9397bf996), Py_ULL(0x49c2c37f07965404)}, /* 5**79 */
+    {Py_ULL(0xd7e77a8f87daf7fb), Py_ULL(0xdc33745ec97be906)}, /* 5**80 */
+    {Py_ULL(0x86f0ac99b4e8dafd), Py_ULL(0x69a028bb3ded71a3)}, /* 5**81 */
+    {Py_ULL(0xa8acd7c0222311bc), Py_ULL(0xc40832ea0d68ce0c)}, /* 5**82 */
+    {Py_ULL(0xd2d80db02aabd62b), Py_ULL(0xf50a3fa490c30190)}, /* 5**83 */
+    {Py_ULL(0x83c7088e1aab65db), Py_ULL(0x792667c6da79e0fa)}, /* 5**84 */
+    {Py_ULL(0xa4b8cab1a1563f52), Py_ULL(0x577001b891185938)}, /* 5**85 */
+    {Py_ULL(0xcde6fd5e09abcf26), Py_ULL(0xed4c0226b55e6f86)}, /* 5**86 */
+    {Py_ULL(0x80b05e5ac60b6178), Py_ULL(0x544f8158315b05b4)}, /* 5**87 */
+    {Py_ULL(0xa0dc75f1778e39d6), Py_ULL(0x696361ae3db1c721)}, /* 5**88 */
+    {Py_ULL(0xc913936dd571c84c), Py_ULL(0x03bc3a19cd1e38e9)}, /* 5**89 */
+    {Py_ULL(0xfb5878494ace3a5f), Py_ULL(0x04ab48a04065c723)}, /* 5**90 */
+    {Py_ULL(0x9d174b2dcec0e47b), Py_ULL(0x62eb0d64283f9c76)}, /* 5**91 */
+    {Py_ULL(0xc45d1df942711d9a), Py_ULL(0x3ba5d0bd324f8394)}, /* 5**92 */
+    {Py_ULL(0xf5746577930d6500), Py_ULL(0xca8f44ec7ee36479)}, /* 5**93 */
+    {Py_ULL(0x9968bf6abbe85f20), Py_ULL(0x7e998b13cf4e1ecb)}, /* 5**94 */
+    {Py_ULL(0xbfc2ef456ae276e8), Py_ULL(0x9e3fedd8c321a67e)}, /* 5**95 */
+    {Py_ULL(0xefb3ab16c59b14a2), Py_ULL(0xc5cfe94ef3ea101e)}, /* 5**96 */
+    {Py_ULL(0x95d04aee3b80ece5), Py_ULL(0xbba1f1d158724a12)}, /* 5**97 */
+    {Py_ULL(0xbb445da9ca61281f), Py_ULL(0x2a8a6e45ae8edc97)}, /* 5**98 */
+    {Py_ULL(0xea1575143cf97226), Py_ULL(0xf52d09d71a3293bd)}, /* 5**99 */
+    {Py_ULL(0x924d692ca61be758), Py_ULL(0x593c2626705f9c56)}, /* 5**100 */
+    {Py_ULL(0xb6e0c377cfa2e12e), Py_ULL(0x6f8b2fb00c77836c)}, /* 5**101 */
+    {Py_ULL(0xe498f455c38b997a), Py_ULL(0x0b6dfb9c0f956447)}, /* 5**102 */
+    {Py_ULL(0x8edf98b59a373fec), Py_ULL(0x4724bd4189bd5eac)}, /* 5**103 */
+    {Py_ULL(0xb2977ee300c50fe7), Py_ULL(0x58edec91ec2cb657)}, /* 5**104 */
+    {Py_ULL(0xdf3d5e9bc0f653e1), Py_ULL(0x2f2967b66737e3ed)}, /* 5**105 */
+    {Py_ULL(0x8b865b215899f46c), Py_ULL(0xbd79e0d20082ee74)}, /* 5**106 */
+    {Py_ULL(0xae67f1e9aec07187), Py_ULL(0xecd8590680a3aa11)}, /* 5**107 */
+    {Py_ULL(0xda01ee641a708de9), Py_ULL(0xe80e6f4820cc9495)}, /* 5**108 */
+    {Py_ULL(0x884134fe908658b2), Py_ULL(0x3109058d147fdcdd)}, /* 5**109 */
+    {Py_ULL(0xaa51823e34a7eede), Py_ULL(0xbd4b46f0599fd415)}, /* 5**110 */
+    {Py_ULL(0xd4e5e2cdc1d1ea96), Py_ULL(0x6c9e18ac7007c91a)}, /* 5**111 */
+    {Py_ULL(0x850fadc09923329e), Py_ULL(0x03e2cf6bc604ddb0)}, /* 5**112 */
+    {Py_ULL(0xa6539930bf6bff45), Py_ULL(0x84db8346b786151c)}, /* 5**113 */
+    {Py_ULL(0xcfe87f7cef46ff16), Py_ULL(0xe612641865679a63)}, /* 5**114 */
+    {Py_ULL(0x81f14fae158c5f6e), Py_ULL(0x4fcb7e8f3f60c07e)}, /* 5**115 */
+    {Py_ULL(0xa26da3999aef7749), Py_ULL(0xe3be5e330f38f09d)}, /* 5**116 */
+    {Py_ULL(0xcb090c8001ab551c), Py_ULL(0x5cadf5bfd3072cc5)}, /* 5**117 */
+    {Py_ULL(0xfdcb4fa002162a63), Py_ULL(0x73d9732fc7c8f7f6)}, /* 5**118 */
+    {Py_ULL(0x9e9f11c4014dda7e), Py_ULL(0x2867e7fddcdd9afa)}, /* 5**119 */
+    {Py_ULL(0xc646d63501a1511d), Py_ULL(0xb281e1fd541501b8)}, /* 5**120 */
+    {Py_ULL(0xf7d88bc24209a565), Py_ULL(0x1f225a7ca91a4226)}, /* 5**121 */
+    {Py_ULL(0x9ae757596946075f), Py_ULL(0x3375788de9b06958)}, /* 5**122 */
+    {Py_ULL(0xc1a12d2fc3978937), Py_ULL(0x0052d6b1641c83ae)}, /* 5**123 */
+    {Py_ULL(0xf209787bb47d6b84), Py_ULL(0xc0678c5dbd23a49a)}, /* 5**124 */
+    {Py_ULL(0x9745eb4d50ce6332), Py_ULL(0xf840b7ba963646e0)}, /* 5**125 */
+    {Py_ULL(0xbd176620a501fbff), Py_ULL(0xb650e5a93bc3d898)}, /* 5**126 */
+    {Py_ULL(0xec5d3fa8ce427aff), Py_ULL(0xa3e51f138ab4cebe)}, /* 5**127 */
+    {Py_ULL(0x93ba47c980e98cdf), Py_ULL(0xc66f336c36b10137)}, /* 5**128 */
+    {Py_ULL(0xb8a8d9bbe123f017), Py_ULL(0xb80b0047445d4184)}, /* 5**129 */
+    {Py_ULL(0xe6d3102ad96cec1d), Py_ULL(0xa60dc059157491e5)}, /* 5**130 */
+    {Py_ULL(0x9043ea1ac7e41392), Py_ULL(0x87c89837ad68db2f)}, /* 5**131 */
+    {Py_ULL(0xb454e4a179dd1877), Py_ULL(0x29babe4598c311fb)}, /* 5**132 */
+    {Py_ULL(0xe16a1dc9d8545e94), Py_ULL(0xf4296dd6fef3d67a)}, /* 5**133 */
+    {Py_ULL(0x8ce2529e2734bb1d), Py_ULL(0x1899e4a65f58660c)}, /* 5**134 */
+    {Py_ULL(0xb01ae745b101e9e4), Py_ULL(0x5ec05dcff72e7f8f)}, /* 5**135 */
+    {Py_ULL(0xdc21a1171d42645d), Py_ULL(0x76707543f4fa1f73)}, /* 5**136 */
+    {Py_ULL(0x899504ae72497eba), Py_ULL(0x6a06494a791c53a8)}, /* 5**137 */
+    {Py_ULL(0xabfa45da0edbde69), Py_ULL(0x0487db9d17636892)}, /* 5**138 */
+    {Py_ULL(0xd6f8d7509292d603), Py_ULL(0x45a9d2845d3c42b6)}, /* 5**139 */
+    {Py_ULL(0x865b86925b9bc5c2), Py_ULL(0x0b8a2392ba45a9b2)}, /* 5**140 */
+    {Py_ULL(0xa7f26836f282b732), Py_ULL(0x8e6cac7768d7141e)}, /* 5**141 */
+    {Py_ULL(0xd1ef0244af2364ff), Py_ULL(0x3207d795430cd926)}, /* 5**142 */
+    {Py_ULL(0x8335616aed761f1f), Py_ULL(0x7f44e6bd49e807b8)}, /* 5**143 */
+    {Py_ULL(0xa402b9c5a8d3a6e7), Py_ULL(0x5f16206c9c6209a6)}, /* 5**144 */
+    {Py_ULL(0xcd036837130890a1), Py_ULL(0x36dba887c37a8c0f)}, /* 5**145 */
+    {Py_ULL(0x802221226be55a64), Py_ULL(0xc2494954da2c9789)}, /* 5**146 */
+    {Py_ULL(0xa02aa96b06deb0fd), Py_ULL(0xf2db9baa10b7bd6c)}, /* 5**147 */
+    {Py_ULL(0xc83553c5c8965d3d), Py_ULL(0x6f92829494e5acc7)}, /* 5**148 */
+    {Py_ULL(0xfa42a8b73abbf48c), Py_ULL(0xcb772339ba1f17f9)}, /* 5**149 */
+    {Py_ULL(0x9c69a97284b578d7), Py_ULL(0xff2a760414536efb)}, /* 5**150 */
+    {Py_ULL(0xc38413cf25e2d70d), Py_ULL(0xfef5138519684aba)}, /* 5**151 */
+    {Py_ULL(0xf46518c2ef5b8cd1), Py_ULL(0x7eb258665fc25d69)}, /* 5**152 */
+    {Py_ULL(0x98bf2f79d5993802), Py_ULL(0xef2f773ffbd97a61)}, /* 5**153 */
+    {Py_ULL(0xbeeefb584aff8603), Py_ULL(0xaafb550ffacfd8fa)}, /* 5**154 */
+    {Py_ULL(0xeeaaba2e5dbf6784), Py_ULL(0x95ba2a53f983cf38)}, /* 5**155 */
+    {Py_ULL(0x952ab45cfa97a0b2), Py_ULL(0xdd945a747bf26183)}, /* 5**156 */
+    {Py_ULL(0xba756174393d88df), Py_ULL(0x94f971119aeef9e4)}, /* 5**157 */
+    {Py_ULL(0xe912b9d1478ceb17), Py_ULL(0x7a37cd5601aab85d)}, /* 5**158 */
+    {Py_ULL(0x91abb422ccb812ee), Py_ULL(0xac62e055c10ab33a)}, /* 5**159 */
+    {Py_ULL(0xb616a12b7fe617aa), Py_ULL(0x577b986b314d6009)}, /* 5**160 */
+    {Py_ULL(0xe39c49765fdf9d94), Py_ULL(0xed5a7e85fda0b80b)}, /* 5**161 */
+    {Py_ULL(0x8e41ade9fbebc27d), Py_ULL(0x14588f13be847307)}, /* 5**162 */
+    {Py_ULL(0xb1d219647ae6b31c), Py_ULL(0x596eb2d8ae258fc8)}, /* 5**163 */
+    {Py_ULL(0xde469fbd99a05fe3), Py_ULL(0x6fca5f8ed9aef3bb)}, /* 5**164 */
+    {Py_ULL(0x8aec23d680043bee), Py_ULL(0x25de7bb9480d5854)}, /* 5**165 */
+    {Py_ULL(0xada72ccc20054ae9), Py_ULL(0xaf561aa79a10ae6a)}, /* 5**166 */
+    {Py_ULL(0xd910f7ff28069da4), Py_ULL(0x1b2ba1518094da04)}, /* 5**167 */
+    {Py_ULL(0x87aa9aff79042286), Py_ULL(0x90fb44d2f05d0842)}, /* 5**168 */
+    {Py_ULL(0xa99541bf57452b28), Py_ULL(0x353a1607ac744a53)}, /* 5**169 */
+    {Py_ULL(0xd3fa922f2d1675f2), Py_ULL(0x42889b8997915ce8)}, /* 5**170 */
+    {Py_ULL(0x847c9b5d7c2e09b7), Py_ULL(0x69956135febada11)}, /* 5**171 */
+    {Py_ULL(0xa59bc234db398c25), Py_ULL(0x43fab9837e699095)}, /* 5**172 */
+    {Py_ULL(0xcf02b2c21207ef2e), Py_ULL(0x94f967e45e03f4bb)}, /* 5**173 */
+    {Py_ULL(0x8161afb94b44f57d), Py_ULL(0x1d1be0eebac278f5)}, /* 5**174 */
+    {Py_ULL(0xa1ba1ba79e1632dc), Py_ULL(0x6462d92a69731732)}, /* 5**175 */
+    {Py_ULL(0xca28a291859bbf93), Py_ULL(0x7d7b8f7503cfdcfe)}, /* 5**176 */
+    {Py_ULL(0xfcb2cb35e702af78), Py_ULL(0x5cda735244c3d43e)}, /* 5**177 */
+    {Py_ULL(0x9defbf01b061adab), Py_ULL(0x3a0888136afa64a7)}, /* 5**178 */
+    {Py_ULL(0xc56baec21c7a1916), Py_ULL(0x088aaa1845b8fdd0)}, /* 5**179 */
+    {Py_ULL(0xf6c69a72a3989f5b), Py_ULL(0x8aad549e57273d45)}, /* 5**180 */
+    {Py_ULL(0x9a3c2087a63f6399), Py_ULL(0x36ac54e2f678864b)}, /* 5**181 */
+    {Py_ULL(0xc0cb28a98fcf3c7f), Py_ULL(0x84576a1bb416a7dd)}, /* 5**182 */
+    {Py_ULL(0xf0fdf2d3f3c30b9f), Py_ULL(0x656d44a2a11c51d5)}, /* 5**183 */
+    {Py_ULL(0x969eb7c47859e743), Py_ULL(0x9f644ae5a4b1b325)}, /* 5**184 */
+    {Py_ULL(0xbc4665b596706114), Py_ULL(0x873d5d9f0dde1fee)}, /* 5**185 */
+    {Py_ULL(0xeb57ff22fc0c7959), Py_ULL(0xa90cb506d155a7ea)}, /* 5**186 */
+    {Py_ULL(0x9316ff75dd87cbd8), Py_ULL(0x09a7f12442d588f2)}, /* 5**187 */
+    {Py_ULL(0xb7dcbf5354e9bece), Py_ULL(0x0c11ed6d538aeb2f)}, /* 5**188 */
+    {Py_ULL(0xe5d3ef282a242e81), Py_ULL(0x8f1668c8a86da5fa)}, /* 5**189 */
+    {Py_ULL(0x8fa475791a569d10), Py_ULL(0xf96e017d694487bc)}, /* 5**190 */
+    {Py_ULL(0xb38d92d760ec4455), Py_ULL(0x37c981dcc395a9ac)}, /* 5**191 */
+    {Py_ULL(0xe070f78d3927556a), Py_ULL(0x85bbe253f47b1417)}, /* 5**192 */
+    {Py_ULL(0x8c469ab843b89562), Py_ULL(0x93956d7478ccec8e)}, /* 5**193 */
+    {Py_ULL(0xaf58416654a6babb), Py_ULL(0x387ac8d1970027b2)}, /* 5**194 */
+    {Py_ULL(0xdb2e51bfe9d0696a), Py_ULL(0x06997b05fcc0319e)}, /* 5**195 */
+    {Py_ULL(0x88fcf317f22241e2), Py_ULL(0x441fece3bdf81f03)}, /* 5**196 */
+    {Py_ULL(0xab3c2fddeeaad25a), Py_ULL(0xd527e81cad7626c3)}, /* 5**197 */
+    {Py_ULL(0xd60b3bd56a5586f1), Py_ULL(0x8a71e223d8d3b074)}, /* 5**198 */
+    {Py_ULL(0x85c7056562757456), Py_ULL(0xf6872d5667844e49)}, /* 5**199 */
+    {Py_ULL(0xa738c6bebb12d16c), Py_ULL(0xb428f8ac016561db)}, /* 5**200 */
+    {Py_ULL(0xd106f86e69d785c7), Py_ULL(0xe13336d701beba52)}, /* 5**201 */
+    {Py_ULL(0x82a45b450226b39c), Py_ULL(0xecc0024661173473)}, /* 5**202 */
+    {Py_ULL(0xa34d721642b06084), Py_ULL(0x27f002d7f95d0190)}, /* 5**203 */
+    {Py_ULL(0xcc20ce9bd35c78a5), Py_ULL(0x31ec038df7b441f4)}, /* 5**204 */
+    {Py_ULL(0xff290242c83396ce), Py_ULL(0x7e67047175a15271)}, /* 5**205 */
+    {Py_ULL(0x9f79a169bd203e41), Py_ULL(0x0f0062c6e984d386)}, /* 5**206 */
+    {Py_ULL(0xc75809c42c684dd1), Py_ULL(0x52c07b78a3e60868)}, /* 5**207 */
+    {Py_ULL(0xf92e0c3537826145), Py_ULL(0xa7709a56ccdf8a82)}, /* 5**208 */
+    {Py_ULL(0x9bbcc7a142b17ccb), Py_ULL(0x88a66076400bb691)}, /* 5**209 */
+    {Py_ULL(0xc2abf989935ddbfe), Py_ULL(0x6acff893d00ea435)}, /* 5**210 */
+    {Py_ULL(0xf356f7ebf83552fe), Py_ULL(0x0583f6b8c4124d43)}, /* 5**211 */
+    {Py_ULL(0x98165af37b2153de), Py_ULL(0xc3727a337a8b704a)}, /* 5**212 */
+    {Py_ULL(0xbe1bf1b059e9a8d6), Py_ULL(0x744f18c0592e4c5c)}, /* 5**213 */
+    {Py_ULL(0xeda2ee1c7064130c), Py_ULL(0x1162def06f79df73)}, /* 5**214 */
+    {Py_ULL(0x9485d4d1c63e8be7), Py_ULL(0x8addcb5645ac2ba8)}, /* 5**215 */
+    {Py_ULL(0xb9a74a0637ce2ee1), Py_ULL(0x6d953e2bd7173692)}, /* 5**216 */
+    {Py_ULL(0xe8111c87c5c1ba99), Py_ULL(0xc8fa8db6ccdd0437)}, /* 5**217 */
+    {Py_ULL(0x910ab1d4db9914a0), Py_ULL(0x1d9c9892400a22a2)}, /* 5**218 */
+    {Py_ULL(0xb54d5e4a127f59c8), Py_ULL(0x2503beb6d00cab4b)}, /* 5**219 */
+    {Py_ULL(0xe2a0b5dc971f303a), Py_ULL(0x2e44ae64840fd61d)}, /* 5**220 */
+    {Py_ULL(0x8da471a9de737e24), Py_ULL(0x5ceaecfed289e5d2)}, /* 5**221 */
+    {Py_ULL(0xb10d8e1456105dad), Py_ULL(0x7425a83e872c5f47)}, /* 5**222 */
+    {Py_ULL(0xdd50f1996b947518), Py_ULL(0xd12f124e28f77719)}, /* 5**223 */
+    {Py_ULL(0x8a5296ffe33cc92f), Py_ULL(0x82bd6b70d99aaa6f)}, /* 5**224 */
+    {Py_ULL(0xace73cbfdc0bfb7b), Py_ULL(0x636cc64d1001550b)}, /* 5**225 */
+    {Py_ULL(0xd8210befd30efa5a), Py_ULL(0x3c47f7e05401aa4e)}, /* 5**226 */
+    {Py_ULL(0x8714a775e3e95c78), Py_ULL(0x65acfaec34810a71)}, /* 5**227 */
+    {Py_ULL(0xa8d9d1535ce3b396), Py_ULL(0x7f1839a741a14d0d)}, /* 5**228 */
+    {Py_ULL(0xd31045a8341ca07c), Py_ULL(0x1ede48111209a050)}, /* 5**229 */
+    {Py_ULL(0x83ea2b892091e44d), Py_ULL(0x934aed0aab460432)}, /* 5**230 */
+    {Py_ULL(0xa4e4b66b68b65d60), Py_ULL(0xf81da84d5617853f)}, /* 5**231 */
+    {Py_ULL(0xce1de40642e3f4b9), Py_ULL(0x36251260ab9d668e)}, /* 5**232 */
+    {Py_ULL(0x80d2ae83e9ce78f3), Py_ULL(0xc1d72b7c6b426019)}, /* 5**233 */
+    {Py_ULL(0xa1075a24e4421730), Py_ULL(0xb24cf65b8612f81f)}, /* 5**234 */
+    {Py_ULL(0xc94930ae1d529cfc), Py_ULL(0xdee033f26797b627)}, /* 5**235 */
+    {Py_ULL(0xfb9b7cd9a4a7443c), Py_ULL(0x169840ef017da3b1)}, /* 5**236 */
+    {Py_ULL(0x9d412e0806e88aa5), Py_ULL(0x8e1f289560ee864e)}, /* 5**237 */
+    {Py_ULL(0xc491798a08a2ad4e), Py_ULL(0xf1a6f2bab92a27e2)}, /* 5**238 */
+    {Py_ULL(0xf5b5d7ec8acb58a2), Py_ULL(0xae10af696774b1db)}, /* 5**239 */
+    {Py_ULL(0x9991a6f3d6bf1765), Py_ULL(0xacca6da1e0a8ef29)}, /* 5**240 */
+    {Py_ULL(0xbff610b0cc6edd3f), Py_ULL(0x17fd090a58d32af3)}, /* 5**241 */
+    {Py_ULL(0xeff394dcff8a948e), Py_ULL(0xddfc4b4cef07f5b0)}, /* 5**242 */
+    {Py_ULL(0x95f83d0a1fb69cd9), Py_ULL(0x4abdaf101564f98e)}, /* 5**243 */
+    {Py_ULL(0xbb764c4ca7a4440f), Py_ULL(0x9d6d1ad41abe37f1)}, /* 5**244 */
+    {Py_ULL(0xea53df5fd18d5513), Py_ULL(0x84c86189216dc5ed)}, /* 5**245 */
+    {Py_ULL(0x92746b9be2f8552c), Py_ULL(0x32fd3cf5b4e49bb4)}, /* 5**246 */
+    {Py_ULL(0xb7118682dbb66a77), Py_ULL(0x3fbc8c33221dc2a1)}, /* 5**247 */
+    {Py_ULL(0xe4d5e82392a40515), Py_ULL(0x0fabaf3feaa5334a)}, /* 5**248 */
+    {Py_ULL(0x8f05b1163ba6832d), Py_ULL(0x29cb4d87f2a7400e)}, /* 5**249 */
+    {Py_ULL(0xb2c71d5bca9023f8), Py_ULL(0x743e20e9ef511012)}, /* 5**250 */
+    {Py_ULL(0xdf78e4b2bd342cf6), Py_ULL(0x914da9246b255416)}, /* 5**251 */
+    {Py_ULL(0x8bab8eefb6409c1a), Py_ULL(0x1ad089b6c2f7548e)}, /* 5**252 */
+    {Py_ULL(0xae9672aba3d0c320), Py_ULL(0xa184ac2473b529b1)}, /* 5**253 */
+    {Py_ULL(0xda3c0f568cc4f3e8), Py_ULL(0xc9e5d72d90a2741e)}, /* 5**254 */
+    {Py_ULL(0x8865899617fb1871), Py_ULL(0x7e2fa67c7a658892)}, /* 5**255 */
+    {Py_ULL(0xaa7eebfb9df9de8d), Py_ULL(0xddbb901b98feeab7)}, /* 5**256 */
+    {Py_ULL(0xd51ea6fa85785631), Py_ULL(0x552a74227f3ea565)}, /* 5**257 */
+    {Py_ULL(0x8533285c936b35de), Py_ULL(0xd53a88958f87275f)}, /* 5**258 */
+    {Py_ULL(0xa67ff273b8460356), Py_ULL(0x8a892abaf368f137)}, /* 5**259 */
+    {Py_ULL(0xd01fef10a657842c), Py_ULL(0x2d2b7569b0432d85)}, /* 5**260 */
+    {Py_ULL(0x8213f56a67f6b29b), Py_ULL(0x9c3b29620e29fc73)}, /* 5**261 */
+    {Py_ULL(0xa298f2c501f45f42), Py_ULL(0x8349f3ba91b47b8f)}, /* 5**262 */
+    {Py_ULL(0xcb3f2f7642717713), Py_ULL(0x241c70a936219a73)}, /* 5**263 */
+    {Py_ULL(0xfe0efb53d30dd4d7), Py_ULL(0xed238cd383aa0110)}, /* 5**264 */
+    {Py_ULL(0x9ec95d1463e8a506), Py_ULL(0xf4363804324a40aa)}, /* 5**265 */
+    {Py_ULL(0xc67bb4597ce2ce48), Py_ULL(0xb143c6053edcd0d5)}, /* 5**266 */
+    {Py_ULL(0xf81aa16fdc1b81da), Py_ULL(0xdd94b7868e94050a)}, /* 5**267 */
+    {Py_ULL(0x9b10a4e5e9913128), Py_ULL(0xca7cf2b4191c8326)}, /* 5**268 */
+    {Py_ULL(0xc1d4ce1f63f57d72), Py_ULL(0xfd1c2f611f63a3f0)}, /* 5**269 */
+    {Py_ULL(0xf24a01a73cf2dccf), Py_ULL(0xbc633b39673c8cec)}, /* 5**270 */
+    {Py_ULL(0x976e41088617ca01), Py_ULL(0xd5be0503e085d813)}, /* 5**271 */
+    {Py_ULL(0xbd49d14aa79dbc82), Py_ULL(0x4b2d8644d8a74e18)}, /* 5**272 */
+    {Py_ULL(0xec9c459d51852ba2), Py_ULL(0xddf8e7d60ed1219e)}, /* 5**273 */
+    {Py_ULL(0x93e1ab8252f33b45), Py_ULL(0xcabb90e5c942b503)}, /* 5**274 */
+    {Py_ULL(0xb8da1662e7b00a17), Py_ULL(0x3d6a751f3b936243)}, /* 5**275 */
+    {Py_ULL(0xe7109bfba19c0c9d), Py_ULL(0x0cc512670a783ad4)}, /* 5**276 */
+    {Py_ULL(0x906a617d450187e2), Py_ULL(0x27fb2b80668b24c5)}, /* 5**277 */
+    {Py_ULL(0xb484f9dc9641e9da), Py_ULL(0xb1f9f660802dedf6)}, /* 5**278 */
+    {Py_ULL(0xe1a63853bbd26451), Py_ULL(0x5e7873f8a0396973)}, /* 5**279 */
+    {Py_ULL(0x8d07e33455637eb2), Py_ULL(0xdb0b487b6423e1e8)}, /* 5**280 */
+    {Py_ULL(0xb049dc016abc5e5f), Py_ULL(0x91ce1a9a3d2cda62)}, /* 5**281 */
+    {Py_ULL(0xdc5c5301c56b75f7), Py_ULL(0x7641a140cc7810fb)}, /* 5**282 */
+    {Py_ULL(0x89b9b3e11b6329ba), Py_ULL(0xa9e904c87fcb0a9d)}, /* 5**283 */
+    {Py_ULL(0xac2820d9623bf429), Py_ULL(0x546345fa9fbdcd44)}, /* 5**284 */
+    {Py_ULL(0xd732290fbacaf133), Py_ULL(0xa97c177947ad4095)}, /* 5**285 */
+    {Py_ULL(0x867f59a9d4bed6c0), Py_ULL(0x49ed8eabcccc485d)}, /* 5**286 */
+    {Py_ULL(0xa81f301449ee8c70), Py_ULL(0x5c68f256bfff5a74)}, /* 5**287 */
+    {Py_ULL(0xd226fc195c6a2f8c), Py_ULL(0x73832eec6fff3111)}, /* 5**288 */
+    {Py_ULL(0x83585d8fd9c25db7), Py_ULL(0xc831fd53c5ff7eab)}, /* 5**289 */
+    {Py_ULL(0xa42e74f3d032f525), Py_ULL(0xba3e7ca8b77f5e55)}, /* 5**290 */
+    {Py_ULL(0xcd3a1230c43fb26f), Py_ULL(0x28ce1bd2e55f35eb)}, /* 5**291 */
+    {Py_ULL(0x80444b5e7aa7cf85), Py_ULL(0x7980d163cf5b81b3)}, /* 5**292 */
+    {Py_ULL(0xa0555e361951c366), Py_ULL(0xd7e105bcc332621f)}, /* 5**293 */
+    {Py_ULL(0xc86ab5c39fa63440), Py_ULL(0x8dd9472bf3fefaa7)}, /* 5**294 */
+    {Py_ULL(0xfa856334878fc150), Py_ULL(0xb14f98f6f0feb951)}, /* 5**295 */
+    {Py_ULL(0x9c935e00d4b9d8d2), Py_ULL(0x6ed1bf9a569f33d3)}, /* 5**296 */
+    {Py_ULL(0xc3b8358109e84f07), Py_ULL(0x0a862f80ec4700c8)}, /* 5**297 */
+    {Py_ULL(0xf4a642e14c6262c8), Py_ULL(0xcd27bb612758c0fa)}, /* 5**298 */
+    {Py_ULL(0x98e7e9cccfbd7dbd), Py_ULL(0x8038d51cb897789c)}, /* 5**299 */
+    {Py_ULL(0xbf21e44003acdd2c), Py_ULL(0xe0470a63e6bd56c3)}, /* 5**300 */
+    {Py_ULL(0xeeea5d5004981478), Py_ULL(0x1858ccfce06cac74)}, /* 5**301 */
+    {Py_ULL(0x95527a5202df0ccb), Py_ULL(0x0f37801e0c43ebc8)}, /* 5**302 */
+    {Py_ULL(0xbaa718e68396cffd), Py_ULL(0xd30560258f54e6ba)}, /* 5**303 */
+    {Py_ULL(0xe950df20247c83fd), Py_ULL(0x47c6b82ef32a2069)}, /* 5**304 */
+    {Py_ULL(0x91d28b7416cdd27e), Py_ULL(0x4cdc331d57fa5441)}, /* 5**305 */
+    {Py_ULL(0xb6472e511c81471d), Py_ULL(0xe0133fe4adf8e952)}, /* 5**306 */
+    {Py_ULL(0xe3d8f9e563a198e5), Py_ULL(0x58180fddd97723a6)}, /* 5**307 */
+    {Py_ULL(0x8e679c2f5e44ff8f), Py_ULL(0x570f09eaa7ea7648)}, /* 5**308 */
+    {Py_ULL(0xb201833b35d63f73), Py_ULL(0x2cd2cc6551e513da)}, /* 5**309 */
+    {Py_ULL(0xde81e40a034bcf4f), Py_ULL(0xf8077f7ea65e58d1)}, /* 5**310 */
+    {Py_ULL(0x8b112e86420f6191), Py_ULL(0xfb04afaf27faf782)}, /* 5**311 */
+    {Py_ULL(0xadd57a27d29339f6), Py_ULL(0x79c5db9af1f9b563)}, /* 5**312 */
+    {Py_ULL(0xd94ad8b1c7380874), Py_ULL(0x18375281ae7822bc)}, /* 5**313 */
+    {Py_ULL(0x87cec76f1c830548), Py_ULL(0x8f2293910d0b15b5)}, /* 5**314 */
+    {Py_ULL(0xa9c2794ae3a3c69a), Py_ULL(0xb2eb3875504ddb22)}, /* 5**315 */
+    {Py_ULL(0xd433179d9c8cb841), Py_ULL(0x5fa60692a46151eb)}, /* 5**316 */
+    {Py_ULL(0x849feec281d7f328), Py_ULL(0xdbc7c41ba6bcd333)}, /* 5**317 */
+    {Py_ULL(0xa5c7ea73224deff3), Py_ULL(0x12b9b522906c0800)}, /* 5**318 */
+    {Py_ULL(0xcf39e50feae16bef), Py_ULL(0xd768226b34870a00)}, /* 5**319 */
+    {Py_ULL(0x81842f29f2cce375), Py_ULL(0xe6a1158300d46640)}, /* 5**320 */
+    {Py_ULL(0xa1e53af46f801c53), Py_ULL(0x60495ae3c1097fd0)}, /* 5**321 */
+    {Py_ULL(0xca5e89b18b602368), Py_ULL(0x385bb19cb14bdfc4)}, /* 5**322 */
+    {Py_ULL(0xfcf62c1dee382c42), Py_ULL(0x46729e03dd9ed7b5)}, /* 5**323 */
+    {Py_ULL(0x9e19db92b4e31ba9), Py_ULL(0x6c07a2c26a8346d1)}, /* 5**324 */
+    {Py_ULL(0xc5a05277621be293), Py_ULL(0xc7098b7305241885)}, /* 5**325 */
+    {Py_ULL(0xf70867153aa2db38), Py_ULL(0xb8cbee4fc66d1ea7)}, /* 5**326 */
+    {Py_ULL(0x9a65406d44a5c903), Py_ULL(0x737f74f1dc043328)}, /* 5**327 */
+    {Py_ULL(0xc0fe908895cf3b44), Py_ULL(0x505f522e53053ff2)}, /* 5**328 */
+    {Py_ULL(0xf13e34aabb430a15), Py_ULL(0x647726b9e7c68fef)}, /* 5**329 */
+    {Py_ULL(0x96c6e0eab509e64d), Py_ULL(0x5eca783430dc19f5)}, /* 5**330 */
+    {Py_ULL(0xbc789925624c5fe0), Py_ULL(0xb67d16413d132072)}, /* 5**331 */
+    {Py_ULL(0xeb96bf6ebadf77d8), Py_ULL(0xe41c5bd18c57e88f)}, /* 5**332 */
+    {Py_ULL(0x933e37a534cbaae7), Py_ULL(0x8e91b962f7b6f159)}, /* 5**333 */
+    {Py_ULL(0xb80dc58e81fe95a1), Py_ULL(0x723627bbb5a4adb0)}, /* 5**334 */
+    {Py_ULL(0xe61136f2227e3b09), Py_ULL(0xcec3b1aaa30dd91c)}, /* 5**335 */
+    {Py_ULL(0x8fcac257558ee4e6), Py_ULL(0x213a4f0aa5e8a7b1)}, /* 5**336 */
+    {Py_ULL(0xb3bd72ed2af29e1f), Py_ULL(0xa988e2cd4f62d19d)}, /* 5**337 */
+    {Py_ULL(0xe0accfa875af45a7), Py_ULL(0x93eb1b80a33b8605)}, /* 5**338 */
+    {Py_ULL(0x8c6c01c9498d8b88), Py_ULL(0xbc72f130660533c3)}, /* 5**339 */
+    {Py_ULL(0xaf87023b9bf0ee6a), Py_ULL(0xeb8fad7c7f8680b4)}, /* 5**340 */
+};
@@ -28,6 +28,13 @@ PyAPI_FUNC(PyObject *) _Py_BuildValue_SizeT(const char *, ...);
 PyAPI_FUNC(int) _PyArg_VaParse_SizeT(PyObject *, char *, va_list);
 PyAPI_FUNC(int) _PyArg_VaParseTupleAndKeywords_SizeT(PyObject *, PyObject *,
                                               const char *, char **, va_list);
+PyAPI_FUNC(int) _PyArg_ParseStack_SizeT(PyObject **, Py_ssize_t,
+                                        const char *, ...);
+PyAPI_FUNC(int) _PyArg_ParseTupleAndKeywordsFast_SizeT(PyObject *, PyObject *,
+                                                       _PyArg_Parser *, ...);
+PyAPI_FUNC(int) _PyArg_ParseStackAndKeywords_SizeT(PyObject **, Py_ssize_t,
+                                                   PyObject *,
+                                                   _PyArg_Parser *, ...);
 #endif
 
 #define FLAG_COMPAT 1
@@ -36,6 +43,8 @@ PyAPI_FUNC(int) _PyArg_VaParseTupleAndKeywords_SizeT(PyObject *, PyObject *,
 
 /* Forward */
 static int vgetargs1(PyObject *, const char *, va_list *, int);
+static int vgetargs1_impl(PyObject *, PyObject **, Py_ssize_t,
+                          const char *, va_list *, int);
 static void seterror(int, const char *, int *, const char *, const char *);
 static char *convertitem(PyObject *, const char **, va_list *, int, int *,
                          char *, size_t, PyObject **);
@@ -48,6 +57,8 @@ static int getbuffer(PyObject *, Py_buffer *, char**);
 
 static int vgetargskeywords(PyObject *, PyObject *,
                             const char *, char **, va_list *, int);
+static int vgetargskeywordsfast_impl(PyObject **, Py_ssize_t, PyObject *,
+                                     _PyArg_Parser *, va_list *, int);
 static char *skipitem(const char **, va_list *, int);
 
 int
@@ -100,6 +111,34 @@ _PyArg_ParseTuple_SizeT(PyObject *args, char *format, ...)
 }
 
 
+/* Like PyArg_ParseTuple(), for the arguments of a METH_FASTCALL function */
+
+int
+_PyArg_ParseStack(PyObject **args, Py_ssize_t nargs, const char *format, ...)
+{
+    int retval;
+    va_list va;
+
+    va_start(va, format);
+    retval = vgetargs1_impl(NULL, args, nargs, format, &va, 0);
+    va_end(va);
+    return retval;
+}
+
+int
+_PyArg_ParseStack_SizeT(PyObject **args, Py_ssize_t nargs,
+                        const char *format, ...)
+{
+    int retval;
+    va_list va;
+
+    va_start(va, format);
+    retval = vgetargs1_impl(NULL, args, nargs, format, &va, FLAG_SIZE_T);
+    va_end(va);
+    return retval;
+}
+
+
 int
 PyArg_VaParse(PyObject *args, const char *format, va_list va)
 {
@@ -211,6 +250,23 @@ cleanreturn(int retval, PyObject *freelist)
 
 static int
 vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
+{
+    if (flags & FLAG_COMPAT)
+        return vgetargs1_impl(args, NULL, 0, format, p_va, flags);
+    assert(args != NULL);
+    if (!PyTuple_Check(args)) {
+        PyErr_SetString(PyExc_SystemError,
+            "new style getargs format but argument is not a tuple");
+        return 0;
+    }
+    return vgetargs1_impl(NULL, &PyTuple_GET_ITEM(args, 0),
+                          PyTuple_GET_SIZE(args), format, p_va, flags);
+}
+
+/* Parse either compat_args (FLAG_COMPAT) or the nargs items of stack */
+static int
+vgetargs1_impl(PyObject *compat_args, PyObject **stack, Py_ssize_t nargs,
+               const char *format, va_list *p_va, int flags)
 {
     char msgbuf[256];
     int levels[32];
@@ -221,12 +277,12 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
     int level = 0;
     int endfmt = 0;
     const char *formatsave = format;
-    Py_ssize_t i, len;
+    Py_ssize_t i;
     char *msg;
     PyObject *freelist = NULL;
     int compat = flags & FLAG_COMPAT;
 
-    assert(compat || (args != (PyObject*)NULL));
+    assert(nargs == 0 || stack != NULL);
     flags = flags & ~FLAG_COMPAT;
 
     while (endfmt == 0) {
@@ -281,7 +337,7 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
 
     if (compat) {
         if (max == 0) {
-            if (args == NULL)
+            if (compat_args == NULL)
                 return 1;
             PyOS_snprintf(msgbuf, sizeof(msgbuf),
                           "%.200s%s takes no arguments",
@@ -291,7 +347,7 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
             return 0;
         }
         else if (min == 1 && max == 1) {
-            if (args == NULL) {
+            if (compat_args == NULL) {
                 PyOS_snprintf(msgbuf, sizeof(msgbuf),
                       "%.200s%s takes at least one argument",
                           fname==NULL ? "function" : fname,
@@ -299,7 +355,7 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
                 PyErr_SetString(PyExc_TypeError, msgbuf);
                 return 0;
             }
-            msg = convertitem(args, &format, p_va, flags, levels,
+            msg = convertitem(compat_args, &format, p_va, flags, levels,
                               msgbuf, sizeof(msgbuf), &freelist);
             if (msg == NULL)
                 return cleanreturn(1, freelist);
@@ -313,15 +369,7 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
         }
     }
 
-    if (!PyTuple_Check(args)) {
-        PyErr_SetString(PyExc_SystemError,
-            "new style getargs format but argument is not a tuple");
-        return 0;
-    }
-
-    len = PyTuple_GET_SIZE(args);
-
-    if (len < min || max < len) {
+    if (nargs < min || max < nargs) {
         if (message == NULL) {
             PyOS_snprintf(msgbuf, sizeof(msgbuf),
                           "%.150s%s takes %s %d argument%s "
@@ -329,20 +377,20 @@ vgetargs1(PyObject *args, const char *format, va_list *p_va, int flags)
                           fname==NULL ? "function" : fname,
                           fname==NULL ? "" : "()",
                           min==max ? "exactly"
-                          : len < min ? "at least" : "at most",
-                          len < min ? min : max,
-                          (len < min ? min : max) == 1 ? "" : "s",
-                          Py_SAFE_DOWNCAST(len, Py_ssize_t, long));
+                          : nargs < min ? "at least" : "at most",
+                          nargs < min ? min : max,
+                          (nargs < min ? min : max) == 1 ? "" : "s",
+                          Py_SAFE_DOWNCAST(nargs, Py_ssize_t, long));
             message = msgbuf;
         }
         PyErr_SetString(PyExc_TypeError, message);
         return 0;
     }
 
-    for (i = 0; i < len; i++) {
+    for (i = 0; i < nargs; i++) {
         if (*format == '|')
             format++;
-        msg = convertitem(PyTuple_GET_ITEM(args, i), &format, p_va,
+        msg = convertitem(stack[i], &format, p_va,
                           flags, levels, msgbuf,
                           sizeof(msgbuf), &freelist);
         if (msg) {
@@ -1676,6 +1724,324 @@ vgetargskeywords(PyObject *args, PyObject *keywords, const char *format,
 }
 
 
+/* Precompiled keyword argument parsers.
+
+   The format and the keyword list of a _PyArg_Parser are checked against
+   each other only once, when the parser is first used.  The keyword names
+   are interned at the same time, so looking up a keyword argument is a
+   dict lookup by identity instead of creating a string for every entry
+   of the keyword list on every call. */
+
+static _PyArg_Parser *static_arg_parsers = NULL;
+
+static int
+parser_init(_PyArg_Parser *parser)
+{
+    const char * const *keywords;
+    const char *format, *msg;
+    int i, len, min;
+    PyObject *kwtuple;
+
+    assert(parser->format != NULL);
+    assert(parser->keywords != NULL);
+    if (parser->kwtuple != NULL)
+        return 1;
+
+    keywords = parser->keywords;
+    for (len = 0; keywords[len]; len++)
+        continue;
+
+    format = parser->format;
+    min = len;
+    for (i = 0; i < len; i++) {
+        if (*format == '|') {
+            if (min != len) {
+                PyErr_SetString(PyExc_RuntimeError,
+                                "Invalid format string "
+                                "(| specified twice)");
+                return 0;
+            }
+            min = i;
+            format++;
+        }
+        if (IS_END_OF_FORMAT(*format)) {
+            PyErr_Format(PyExc_RuntimeError,
+                         "More keyword list entries (%d) than "
+                         "format specifiers (%d)", len, i);
+            return 0;
+        }
+        msg = skipitem(&format, NULL, 0);
+        if (msg) {
+            PyErr_Format(PyExc_RuntimeError, "%s: '%s'", msg,
+                         format);
+            return 0;
+        }
+    }
+    if (*format == '|')
+        format++;
+    if (!IS_END_OF_FORMAT(*format)) {
+        PyErr_Format(PyExc_RuntimeError,
+            "more argument specifiers than keyword list entries "
+            "(remaining format:'%s')", format);
+        return 0;
+    }
+
+    /* grab the function name or custom error msg first (mutually exclusive) */
+    parser->fname = strchr(parser->format, ':');
+    if (parser->fname) {
+        parser->fname++;
+        parser->custom_msg = NULL;
+    }
+    else {
+        parser->custom_msg = strchr(parser->format, ';');
+        if (parser->custom_msg)
+            parser->custom_msg++;
+    }
+
+    kwtuple = PyTuple_New(len);
+    if (kwtuple == NULL)
+        return 0;
+    for (i = 0; i < len; i++) {
+        PyObject *str = PyString_InternFromString(keywords[i]);
+        if (str == NULL) {
+            Py_DECREF(kwtuple);
+            return 0;
+        }
+        PyTuple_SET_ITEM(kwtuple, i, str);
+    }
+
+    parser->min = min;
+    parser->max = len;
+    parser->kwtuple = kwtuple;
+    parser->next = static_arg_parsers;
+    static_arg_parsers = parser;
+    return 1;
+}
+
+static int
+vgetargskeywordsfast_impl(PyObject **args, Py_ssize_t nargs,
+                          PyObject *keywords, _PyArg_Parser *parser,
+                          va_list *p_va, int flags)
+{
+    char msgbuf[512];
+    int levels[32];
+    const char *format, *msg;
+    int i, len;
+    Py_ssize_t nkeywords;
+    PyObject *freelist = NULL, *current_arg, *keyword;
+
+    assert(keywords == NULL || PyDict_Check(keywords));
+    assert(parser != NULL);
+    assert(p_va != NULL);
+
+    if (!parser_init(parser))
+        return 0;
+
+    len = parser->max;
+    nkeywords = (keywords == NULL) ? 0 : PyDict_Size(keywords);
+    if (nargs + nkeywords > len) {
+        PyErr_Format(PyExc_TypeError, "%s%s takes at most %d "
+                     "argument%s (%zd given)",
+                     (parser->fname == NULL) ? "function" : parser->fname,
+                     (parser->fname == NULL) ? "" : "()",
+                     len,
+                     (len == 1) ? "" : "s",
+                     nargs + nkeywords);
+        return 0;
+    }
+
+    /* convert positional and keyword args in same loop, using the
+       keyword tuple to drive process */
+    format = parser->format;
+    for (i = 0; i < len; i++) {
+        if (*format == '|')
+            format++;
+        current_arg = NULL;
+        if (nkeywords) {
+            keyword = PyTuple_GET_ITEM(parser->kwtuple, i);
+            current_arg = PyDict_GetItem(keywords, keyword);
+        }
+        if (current_arg) {
+            --nkeywords;
+            if (i < nargs) {
+                /* arg present in tuple and in dict */
+                PyErr_Format(PyExc_TypeError,
+                             "Argument given by name ('%s') "
+                             "and position (%d)",
+                             parser->keywords[i], i+1);
+                return cleanreturn(0, freelist);
+            }
+        }
+        else if (i < nargs)
+            current_arg = args[i];
+
+        if (current_arg) {
+            msg = convertitem(current_arg, &format, p_va, flags,
+                levels, msgbuf, sizeof(msgbuf), &freelist);
+            if (msg) {
+                seterror(i+1, msg, levels, parser->fname,
+                         parser->custom_msg);
+                return cleanreturn(0, freelist);
+            }
+            continue;
+        }
+
+        if (i < parser->min) {
+            PyErr_Format(PyExc_TypeError, "Required argument "
+                         "'%s' (pos %d) not found",
+                         parser->keywords[i], i+1);
+            return cleanreturn(0, freelist);
+        }
+        if (!nkeywords)
+            return cleanreturn(1, freelist);
+
+        /* We are into optional args, skip thru to any remaining
+         * keyword args; the format was checked by parser_init() */
+        msg = skipitem(&format, p_va, flags);
+        assert(msg == NULL);
+    }
+
+    /* make sure there are no extraneous keyword arguments */
+    if (nkeywords > 0) {
+        PyObject *key, *value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(keywords, &pos, &key, &value)) {
+            int match = 0;
+            if (!PyString_Check(key)) {
+                PyErr_SetString(PyExc_TypeError,
+                                "keywords must be strings");
+                return cleanreturn(0, freelist);
+            }
+            for (i = 0; i < len; i++) {
+                keyword = PyTuple_GET_ITEM(parser->kwtuple, i);
+                if (key == keyword || _PyString_Eq(key, keyword)) {
+                    match = 1;
+                    break;
+                }
+            }
+            if (!match) {
+                PyErr_Format(PyExc_TypeError,
+                             "'%s' is an invalid keyword "
+                             "argument for this function",
+                             PyString_AS_STRING(key));
+                return cleanreturn(0, freelist);
+            }
+        }
+    }
+
+    return cleanreturn(1, freelist);
+}
+
+/* Like PyArg_ParseTupleAndKeywords(), with a precompiled parser */
+
+int
+_PyArg_ParseTupleAndKeywordsFast(PyObject *args, PyObject *keywords,
+                                 _PyArg_Parser *parser, ...)
+{
+    int retval;
+    va_list va;
+
+    if ((args == NULL || !PyTuple_Check(args)) ||
+        (keywords != NULL && !PyDict_Check(keywords)) ||
+        parser == NULL)
+    {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+
+    va_start(va, parser);
+    retval = vgetargskeywordsfast_impl(&PyTuple_GET_ITEM(args, 0),
+                                       PyTuple_GET_SIZE(args), keywords,
+                                       parser, &va, 0);
+    va_end(va);
+    return retval;
+}
+
+int
+_PyArg_ParseTupleAndKeywordsFast_SizeT(PyObject *args, PyObject *keywords,
+                                       _PyArg_Parser *parser, ...)
+{
+    int retval;
+    va_list va;
+
+    if ((args == NULL || !PyTuple_Check(args)) ||
+        (keywords != NULL && !PyDict_Check(keywords)) ||
+        parser == NULL)
+    {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+
+    va_start(va, parser);
+    retval = vgetargskeywordsfast_impl(&PyTuple_GET_ITEM(args, 0),
+                                       PyTuple_GET_SIZE(args), keywords,
+                                       parser, &va, FLAG_SIZE_T);
+    va_end(va);
+    return retval;
+}
+
+/* The same for the arguments of a METH_FASTCALL|METH_KEYWORDS function */
+
+int
+_PyArg_ParseStackAndKeywords(PyObject **args, Py_ssize_t nargs,
+                             PyObject *keywords, _PyArg_Parser *parser, ...)
+{
+    int retval;
+    va_list va;
+
+    if ((keywords != NULL && !PyDict_Check(keywords)) ||
+        parser == NULL)
+    {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+
+    va_start(va, parser);
+    retval = vgetargskeywordsfast_impl(args, nargs, keywords,
+                                       parser, &va, 0);
+    va_end(va);
+    return retval;
+}
+
+int
+_PyArg_ParseStackAndKeywords_SizeT(PyObject **args, Py_ssize_t nargs,
+                                   PyObject *keywords,
+                                   _PyArg_Parser *parser, ...)
+{
+    int retval;
+    va_list va;
+
+    if ((keywords != NULL && !PyDict_Check(keywords)) ||
+        parser == NULL)
+    {
+        PyErr_BadInternalCall();
+        return 0;
+    }
+
+    va_start(va, parser);
+    retval = vgetargskeywordsfast_impl(args, nargs, keywords,
+                                       parser, &va, FLAG_SIZE_T);
+    va_end(va);
+    return retval;
+}
+
+void
+_PyArg_Fini(void)
+{
+    _PyArg_Parser *tmp, *s = static_arg_parsers;
+    while (s) {
+        tmp = s->next;
+        s->next = NULL;
+        Py_CLEAR(s->kwtuple);
+        s = tmp;
+    }
+    static_arg_parsers = NULL;
+}
+
+
+/* Skip one format unit.  p_va may be NULL when only the format is
+   being checked, as _PyArg_Parser does the first time it is used. */
+
 static char *
 skipitem(const char **p_format, va_list *p_va, int flags)
 {
@@ -1706,13 +2072,15 @@ skipitem(const char **p_format, va_list *p_va, int flags)
 #endif
     case 'c': /* char */
         {
-            (void) va_arg(*p_va, void *);
+            if (p_va != NULL)
+                (void) va_arg(*p_va, void *);
             break;
         }
 
     case 'n': /* Py_ssize_t */
         {
-            (void) va_arg(*p_va, Py_ssize_t *);
+            if (p_va != NULL)
+                (void) va_arg(*p_va, Py_ssize_t *);
             break;
         }
 
@@ -1720,7 +2088,8 @@ skipitem(const char **p_format, va_list *p_va, int flags)
 
     case 'e': /* string with encoding */
         {
-            (void) va_arg(*p_va, const char *);
+            if (p_va != NULL)
+                (void) va_arg(*p_va, const char *);
             if (!(*format == 's' || *format == 't'))
                 /* after 'e', only 's' and 't' is allowed */
                 goto err;
@@ -1736,12 +2105,15 @@ skipitem(const char **p_format, va_list *p_va, int flags)
     case 't': /* buffer, read-only */
     case 'w': /* buffer, read-write */
         {
-            (void) va_arg(*p_va, char **);
+            if (p_va != NULL)
+                (void) va_arg(*p_va, char **);
             if (*format == '#') {
-                if (flags & FLAG_SIZE_T)
-                    (void) va_arg(*p_va, Py_ssize_t *);
-                else
-                    (void) va_arg(*p_va, int *);
+                if (p_va != NULL) {
+                    if (flags & FLAG_SIZE_T)
+                        (void) va_arg(*p_va, Py_ssize_t *);
+                    else
+                        (void) va_arg(*p_va, int *);
+                }
                 format++;
             } else if ((c == 's' || c == 'z') && *format == '*') {
                 format++;
@@ -1756,7 +2128,8 @@ skipitem(const char **p_format, va_list *p_va, int flags)
     case 'U': /* unicode string object */
 #endif
         {
-            (void) va_arg(*p_va, PyObject **);
+            if (p_va != NULL)
+                (void) va_arg(*p_va, PyObject **);
             break;
         }
 
@@ -1764,17 +2137,22 @@ skipitem(const char **p_format, va_list *p_va, int flags)
         {
             if (*format == '!') {
                 format++;
-                (void) va_arg(*p_va, PyTypeObject*);
-                (void) va_arg(*p_va, PyObject **);
+                if (p_va != NULL) {
+                    (void) va_arg(*p_va, PyTypeObject*);
+                    (void) va_arg(*p_va, PyObject **);
+                }
             }
             else if (*format == '&') {
                 typedef int (*converter)(PyObject *, void *);
-                (void) va_arg(*p_va, converter);
-                (void) va_arg(*p_va, void *);
+                if (p_va != NULL) {
+                    (void) va_arg(*p_va, converter);
+                    (void) va_arg(*p_va, void *);
+                }
                 format++;
             }
             else {
-                (void) va_arg(*p_va, PyObject **);
+                if (p_va != NULL)
+                    (void) va_arg(*p_va, PyObject **);
             }
             break;
         }
@@ -1810,27 +2188,15 @@ err:
 }
 
 
-int
-PyArg_UnpackTuple(PyObject *args, const char *name, Py_ssize_t min, Py_ssize_t max, ...)
+static int
+unpack_stack(PyObject **args, Py_ssize_t l, const char *name,
+             Py_ssize_t min, Py_ssize_t max, va_list vargs)
 {
-    Py_ssize_t i, l;
+    Py_ssize_t i;
     PyObject **o;
-    va_list vargs;
-
-#ifdef HAVE_STDARG_PROTOTYPES
-    va_start(vargs, max);
-#else
-    va_start(vargs);
-#endif
 
     assert(min >= 0);
     assert(min <= max);
-    if (!PyTuple_Check(args)) {
-        PyErr_SetString(PyExc_SystemError,
-            "PyArg_UnpackTuple() argument list is not a tuple");
-        return 0;
-    }
-    l = PyTuple_GET_SIZE(args);
     if (l < min) {
         if (name != NULL)
             PyErr_Format(
@@ -1843,7 +2209,6 @@ PyArg_UnpackTuple(PyObject *args, const char *name, Py_ssize_t min, Py_ssize_t m
                 "unpacked tuple should have %s%zd elements,"
                 " but has %zd",
                 (min == max ? "" : "at least "), min, l);
-        va_end(vargs);
         return 0;
     }
     if (l > max) {
@@ -1858,17 +2223,56 @@ PyArg_UnpackTuple(PyObject *args, const char *name, Py_ssize_t min, Py_ssize_t m
                 "unpacked tuple should have %s%zd elements,"
                 " but has %zd",
                 (min == max ? "" : "at most "), max, l);
-        va_end(vargs);
         return 0;
     }
     for (i = 0; i < l; i++) {
         o = va_arg(vargs, PyObject **);
-        *o = PyTuple_GET_ITEM(args, i);
+        *o = args[i];
     }
-    va_end(vargs);
     return 1;
 }
 
+int
+PyArg_UnpackTuple(PyObject *args, const char *name, Py_ssize_t min, Py_ssize_t max, ...)
+{
+    int retval;
+    va_list vargs;
+
+    if (!PyTuple_Check(args)) {
+        PyErr_SetString(PyExc_SystemError,
+            "PyArg_UnpackTuple() argument list is not a tuple");
+        return 0;
+    }
+#ifdef HAVE_STDARG_PROTOTYPES
+    va_start(vargs, max);
+#else
+    va_start(vargs);
+#endif
+    retval = unpack_stack(&PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args),
+                          name, min, max, vargs);
+    va_end(vargs);
+    return retval;
+}
+
+/* Like PyArg_UnpackTuple(), for the arguments of a METH_FASTCALL function */
+
+int
+_PyArg_UnpackStack(PyObject **args, Py_ssize_t nargs, const char *name,
+                   Py_ssize_t min, Py_ssize_t max, ...)
+{
+    int retval;
+    va_list vargs;
+
+#ifdef HAVE_STDARG_PROTOTYPES
+    va_start(vargs, max);
+#else
+    va_start(vargs);
+#endif
+    retval = unpack_stack(args, nargs, name, min, max, vargs);
+    va_end(vargs);
+    return retval;
+}
+
 
 /* For type constructors that don't take keyword args
  *
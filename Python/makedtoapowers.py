@@ -0,0 +1,85 @@
+#! /usr/bin/env python
+"""Generates the dtoa_powers.h file of 128-bit powers of five, used by the
+fast paths of _Py_dg_strtod and _Py_dg_dtoa in dtoa.c.  Run it after
+changing POW5_MIN or POW5_MAX, and check the result in."""
+
+import os
+import sys
+
+# _Py_dg_strtod needs 10**q for -342 <= q <= 308 (anything outside is zero
+# or infinity for inputs of up to 19 digits), and _Py_dg_dtoa needs up to
+# 10**340 to scale the smallest subnormals.
+POW5_MIN = -342
+POW5_MAX = 340
+
+
+def power(q):
+    """Return the 128-bit significand c, 2**127 <= c < 2**128, of 5**q:
+    truncated for q >= 0, and rounded up for q < 0 (as the Eisel-Lemire
+    algorithm expects)."""
+    if q >= 0:
+        c = 5 ** q
+        while c < 1 << 127:
+            c <<= 1
+        while c >= 1 << 128:
+            c >>= 1
+        return c
+    p = 5 ** -q
+    z = p.bit_length()
+    if q >= -27:
+        return 2 ** (z + 127) // p + 1
+    c = 2 ** (2 * z + 128) // p + 1
+    while c >= 1 << 128:
+        c >>= 1
+    return c
+
+
+def rounded64(q):
+    """Return the correctly rounded 64-bit significand of 5**q."""
+    if q >= 0:
+        c = 5 ** q
+        shift = c.bit_length() - 64
+        if shift <= 0:
+            return c << -shift
+        return (c + (1 << (shift - 1))) >> shift
+    p = 5 ** -q
+    b = p.bit_length() + 63
+    return (2 ** (b + 1) // p + 1) // 2
+
+
+def write_contents(f):
+    """Write C code contents to the target file object.
+    """
+    f.write("/* Generated by Python/makedtoapowers.py, do not edit. */\n\n")
+    f.write("#define POW5_MIN (%d)\n" % POW5_MIN)
+    f.write("#define POW5_MAX %d\n\n" % POW5_MAX)
+    f.write("static const ULLong pow5_128[POW5_MAX - POW5_MIN + 1][2] = {\n")
+    for q in range(POW5_MIN, POW5_MAX + 1):
+        c = power(q)
+        hi, lo = c >> 64, c & ((1 << 64) - 1)
+        # dtoa rounds the high half to get the 64-bit cached powers; the
+        # truncation above must not change that rounding.
+        assert hi + (lo >> 63) == rounded64(q), q
+        f.write("    {Py_ULL(0x%016x), Py_ULL(0x%016x)}, /* 5**%d */\n"
+                % (hi, lo, q))
+    f.write("};\n")
+
+
+def main():
+    if len(sys.argv) >= 3:
+        sys.exit("Too many arguments")
+    if len(sys.argv) == 2:
+        target = sys.argv[1]
+    else:
+        target = os.path.join(
+            os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+            "Python", "dtoa_powers.h")
+    f = open(target, "w")
+    try:
+        write_contents(f)
+    finally:
+        f.close()
+
+
+if __name__ == "__main__":
+    main()
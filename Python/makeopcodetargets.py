@@ -0,0 +1,50 @@
+#! /usr/bin/env python
+"""Generates the opcode_targets.h file for computed gotos in ceval.c.
+Run it after changing Lib/opcode.py, and check the result in."""
+
+import os
+import sys
+import imp
+
+
+def find_module(modname):
+    """Finds and returns a module in the local dist/checkout.
+    """
+    modpath = os.path.join(
+        os.path.dirname(os.path.dirname(__file__)), "Lib")
+    return imp.load_module(modname, *imp.find_module(modname, [modpath]))
+
+def write_contents(f):
+    """Write C code contents to the target file object.
+    """
+    opcode = find_module("opcode")
+    targets = ['_unknown_opcode'] * 256
+    for opname, op in opcode.opmap.items():
+        if opname == "STOP_CODE":
+            # not an instruction, ceval treats it as unknown
+            continue
+        # SLICE+1 and friends become TARGET_SLICE_1
+        targets[op] = "TARGET_%s" % opname.replace("+", "_")
+    f.write("static void *opcode_targets[256] = {\n")
+    f.write(",\n".join(["    &&%s" % s for s in targets]))
+    f.write("\n};\n")
+
+
+def main():
+    if len(sys.argv) >= 3:
+        sys.exit("Too many arguments")
+    if len(sys.argv) == 2:
+        target = sys.argv[1]
+    else:
+        target = os.path.join(
+            os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+            "Python", "opcode_targets.h")
+    f = open(target, "w")
+    try:
+        write_contents(f)
+    finally:
+        f.close()
+
+
+if __name__ == "__main__":
+    main()
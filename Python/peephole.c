@@ -273,6 +273,134 @@ markblocks(unsigned char *code, Py_ssize_t len)
     return blocks;
 }
 
+/* Replace the first instruction of some frequent pairs with a
+   superinstruction that executes both of them.  The second instruction
+   stays in place and is skipped by the eval loop, so code offsets, jump
+   targets and the line number table are unchanged.  A pair is only fused
+   when nothing jumps to its second instruction. */
+static int
+superinstruction(int opcode, int next)
+{
+    switch (opcode) {
+        case LOAD_FAST:
+            if (next == LOAD_FAST)
+                return LOAD_FAST__LOAD_FAST;
+            if (next == LOAD_ATTR)
+                return LOAD_FAST__LOAD_ATTR;
+            break;
+        case COMPARE_OP:
+            if (next == POP_JUMP_IF_FALSE)
+                return COMPARE_OP__POP_JUMP_IF_FALSE;
+            break;
+        case LOAD_CONST:
+            if (next == RETURN_VALUE)
+                return LOAD_CONST__RETURN_VALUE;
+            break;
+    }
+    return 0;
+}
+
+static void
+fuse_superinstructions(unsigned char *codestr, Py_ssize_t len,
+                       unsigned int *blocks)
+{
+    Py_ssize_t i;
+    int opcode, fused;
+
+    for (i=0 ; i+3<len ; i+=CODESIZE(opcode)) {
+        opcode = codestr[i];
+        if (!HAS_ARG(opcode) || !ISBASICBLOCK(blocks,i,4))
+            continue;
+        fused = superinstruction(opcode, codestr[i+3]);
+        if (fused) {
+            codestr[i] = fused;
+            /* the second instruction is never the start of a pair */
+            opcode = codestr[i+3];
+            i += 3;
+        }
+    }
+}
+
+/* Fuse the superinstructions of code the optimizer leaves alone */
+static PyObject *
+fuse_unoptimized(PyObject *code)
+{
+    unsigned char *codestr;
+    Py_ssize_t i, codelen;
+    unsigned int *blocks;
+    PyObject *result;
+
+    assert(PyString_Check(code));
+    codestr = (unsigned char *)PyString_AS_STRING(code);
+    codelen = PyString_GET_SIZE(code);
+    /* markblocks() does not know about extended jump targets */
+    for (i=0 ; i<codelen ; i+=CODESIZE(codestr[i]))
+        if (codestr[i] == EXTENDED_ARG) {
+            Py_INCREF(code);
+            return code;
+        }
+    result = PyString_FromStringAndSize((char *)codestr, codelen);
+    if (result == NULL)
+        return NULL;
+    codestr = (unsigned char *)PyString_AS_STRING(result);
+    blocks = markblocks(codestr, codelen);
+    if (blocks == NULL) {
+        Py_DECREF(result);
+        return NULL;
+    }
+    fuse_superinstructions(codestr, codelen, blocks);
+    PyMem_Free(blocks);
+    return result;
+}
+
+/* Return co_code with its superinstructions replaced by the opcodes of
+   their first instruction, as found before fusion.  Used for pickling,
+   so that pickled code (and the f_lasti of pickled frames) is valid for
+   any interpreter that understands the plain instruction set. */
+PyObject *
+_PyCode_UnfuseCode(PyObject *code)
+{
+    unsigned char *codestr;
+    Py_ssize_t i, len;
+    int opcode;
+    PyObject *result;
+
+    if (!PyString_Check(code)) {
+        PyErr_BadInternalCall();
+        return NULL;
+    }
+    codestr = (unsigned char *)PyString_AS_STRING(code);
+    len = PyString_GET_SIZE(code);
+    for (i=0 ; i<len ; i+=CODESIZE(codestr[i]))
+        if (codestr[i] >= LOAD_FAST__LOAD_FAST &&
+            codestr[i] <= LOAD_CONST__RETURN_VALUE)
+            break;
+    if (i >= len) {
+        Py_INCREF(code);
+        return code;
+    }
+    result = PyString_FromStringAndSize((char *)codestr, len);
+    if (result == NULL)
+        return NULL;
+    codestr = (unsigned char *)PyString_AS_STRING(result);
+    for ( ; i<len ; i+=CODESIZE(opcode)) {
+        opcode = codestr[i];
+        switch (opcode) {
+            case LOAD_FAST__LOAD_FAST:
+            case LOAD_FAST__LOAD_ATTR:
+                opcode = codestr[i] = LOAD_FAST;
+                break;
+            case COMPARE_OP__POP_JUMP_IF_FALSE:
+                opcode = codestr[i] = COMPARE_OP;
+                break;
+            case LOAD_CONST__RETURN_VALUE:
+                opcode = codestr[i] = LOAD_CONST;
+                break;
+        }
+    }
+    return result;
+}
+
 /* Perform basic peephole optimizations to components of a code object.
    The consts object should still be in list form to allow new constants
    to be appended.
@@ -280,7 +408,8 @@ markblocks(unsigned char *code, Py_ssize_t len)
    To keep the optimizer simple, it bails out (does nothing) for code
    containing extended arguments or that has a length over 32,700.  That
    allows us to avoid overflow and sign issues.  Likewise, it bails when
-   the lineno table has complex encoding for gaps >= 255.
+   the lineno table has complex encoding for gaps >= 255.  Superinstructions
+   do not move code, so they are still fused in the latter two cases.
 
    Optimizations are restricted to simple transformations occuring within a
    single basic block.  All transformations keep the code size the same or
@@ -312,13 +441,13 @@ PyCode_Optimize(PyObject *code, PyObject* consts, PyObject *names,
     lineno = (unsigned char*)PyString_AS_STRING(lineno_obj);
     tabsiz = PyString_GET_SIZE(lineno_obj);
     if (memchr(lineno, 255, tabsiz) != NULL)
-        goto exitUnchanged;
+        return fuse_unoptimized(code);
 
     /* Avoid situations where jump retargeting could overflow */
     assert(PyString_Check(code));
     codelen = PyString_GET_SIZE(code);
     if (codelen > 32700)
-        goto exitUnchanged;
+        return fuse_unoptimized(code);
 
     /* Make a modifiable copy of the code string */
     codestr = (unsigned char *)PyMem_Malloc(codelen);
@@ -641,6 +770,13 @@ PyCode_Optimize(PyObject *code, PyObject* consts, PyObject *names,
     }
     assert(h + nops == codelen);
 
+    /* Jump targets moved with the NOPs, fuse against the new blocks */
+    PyMem_Free(blocks);
+    blocks = markblocks(codestr, h);
+    if (blocks == NULL)
+        goto exitError;
+    fuse_superinstructions(codestr, h, blocks);
+
     code = PyString_FromStringAndSize((char *)codestr, h);
     PyMem_Free(addrmap);
     PyMem_Free(codestr);
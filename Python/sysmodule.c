@@ -474,7 +474,7 @@ PyDoc_STRVAR(setcheckinterval_doc,
 "setcheckinterval(n)\n\
 \n\
 Tell the Python interpreter to check for asynchronous events every\n\
-n instructions.  This also affects how often thread switches occur."
+n instructions.  Thread switches are governed by setswitchinterval()."
 );
 
 static PyObject *
@@ -487,6 +487,314 @@ PyDoc_STRVAR(getcheckinterval_doc,
 "getcheckinterval() -> current check interval; see setcheckinterval()."
 );
 
+#ifdef WITH_THREAD
+static PyObject *
+sys_setswitchinterval(PyObject *self, PyObject *args)
+{
+    double d;
+    if (!PyArg_ParseTuple(args, "d:setswitchinterval", &d))
+        return NULL;
+    if (d <= 0.0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "switch interval must be strictly positive");
+        return NULL;
+    }
+    _PyEval_SetSwitchInterval((unsigned long) (1e6 * d));
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(setswitchinterval_doc,
+"setswitchinterval(n)\n\
+\n\
+Set the ideal thread switching delay inside the Python interpreter.\n\
+The actual frequency of switching threads can be lower if the\n\
+interpreter executes long sequences of uninterruptible code\n\
+(this is implementation-specific and workload-dependent).\n\
+\n\
+The parameter must represent the desired switching delay in seconds.\n\
+A typical value is 0.005 (5 milliseconds)."
+);
+
+static PyObject *
+sys_getswitchinterval(PyObject *self, PyObject *args)
+{
+    return PyFloat_FromDouble(1e-6 * _PyEval_GetSwitchInterval());
+}
+
+PyDoc_STRVAR(getswitchinterval_doc,
+"getswitchinterval() -> current thread switch interval; see setswitchinterval()."
+);
+#endif /* WITH_THREAD */
+
+static PyObject *
+sys_setopcodeprofile(PyObject *self, PyObject *args)
+{
+    int flags;
+
+    if (!PyArg_ParseTuple(args, "i:setopcodeprofile", &flags))
+        return NULL;
+    if (flags & ~(PyEval_PROFILE_OPCODES | PyEval_PROFILE_LINES |
+                  PyEval_PROFILE_PAIRS)) {
+        PyErr_SetString(PyExc_ValueError, "invalid opcode profile flags");
+        return NULL;
+    }
+    if (_PyEval_SetOpcodeProfile(flags) < 0)
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(setopcodeprofile_doc,
+"setopcodeprofile(flags)\n\
+\n\
+Count the executed opcodes of every code object.  flags is 0 to stop\n\
+counting, or a sum of 1 (opcodes), 2 (also line hits) and 4 (also\n\
+opcode pairs over all code).  Counting slows the interpreter down, the\n\
+counts are kept until clearopcodestats() is called."
+);
+
+static PyObject *
+sys_getopcodeprofile(PyObject *self)
+{
+    return PyInt_FromLong(_PyEval_GetOpcodeProfile());
+}
+
+PyDoc_STRVAR(getopcodeprofile_doc,
+"getopcodeprofile() -> current opcode profile flags; see setopcodeprofile()."
+);
+
+static PyObject *
+sys_getopcodestats(PyObject *self)
+{
+    return _PyEval_GetOpcodeStats();
+}
+
+PyDoc_STRVAR(getopcodestats_doc,
+"getopcodestats() -> (codes, pairs)\n\
+\n\
+Return the counts of setopcodeprofile().  codes is a list of\n\
+(code, opcodes, lines) tuples for every code object that ran, opcodes\n\
+a list of 256 counts indexed by opcode and lines a dict mapping line\n\
+numbers to hits, or None.  pairs is a list of 256 lists of counts\n\
+indexed by the previous and the current opcode, or None."
+);
+
+static PyObject *
+sys_clearopcodestats(PyObject *self)
+{
+    _PyEval_ClearOpcodeStats();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(clearopcodestats_doc,
+"clearopcodestats()\n\
+\n\
+Discard the counts of setopcodeprofile()."
+);
+
+static PyObject *
+sys_getframestats(PyObject *self)
+{
+    return _PyFrame_GetStats();
+}
+
+PyDoc_STRVAR(getframestats_doc,
+"getframestats() -> dict\n\
+\n\
+Return the statistics of the frame allocator: the number of frames\n\
+allocated and deallocated, how many of them were served by or went to\n\
+a code object's zombie frame and the size-classed free lists, and for\n\
+every size class in use a (slots, cached, limit) tuple."
+);
+
+#ifdef WITH_PYMALLOC
+/* Set d[key] to the integer value, and return -1 on error. */
+static int
+set_size_item(PyObject *d, const char *key, size_t value)
+{
+    PyObject *v = PyInt_FromSize_t(value);
+    int err;
+
+    if (v == NULL)
+        return -1;
+    err = PyDict_SetItemString(d, key, v);
+    Py_DECREF(v);
+    return err;
+}
+
+static PyObject *
+sys_getmallocstats(PyObject *self)
+{
+    _PyMallocStats stats;
+    size_t pools = 0, blocks = 0, allocated_bytes = 0;
+    PyObject *d, *classes = NULL, *v;
+    int i;
+
+    /* Count first: building the result allocates blocks. */
+    _PyObject_GetMallocStats(&stats);
+    for (i = 0; i < stats.nclasses; i++) {
+        pools += stats.classes[i].pools;
+        blocks += stats.classes[i].blocks;
+        allocated_bytes += stats.classes[i].blocks * stats.classes[i].size;
+    }
+
+    d = PyDict_New();
+    if (d == NULL)
+        return NULL;
+    classes = PyList_New(stats.nclasses);
+    if (classes == NULL)
+        goto error;
+    for (i = 0; i < stats.nclasses; i++) {
+        _PyMallocClassStats *c = &stats.classes[i];
+        v = Py_BuildValue("(nnnn)", (Py_ssize_t)c->size,
+                          (Py_ssize_t)c->pools, (Py_ssize_t)c->blocks,
+                          (Py_ssize_t)c->free_blocks);
+        if (v == NULL)
+            goto error;
+        PyList_SET_ITEM(classes, i, v);
+    }
+    if (PyDict_SetItemString(d, "classes", classes) < 0)
+        goto error;
+    Py_CLEAR(classes);
+    v = PyFloat_FromDouble(stats.arenas == 0 ? 0.0 :
+                           1.0 - (double)allocated_bytes /
+                           ((double)stats.arenas * stats.arena_size));
+    if (v == NULL)
+        goto error;
+    i = PyDict_SetItemString(d, "fragmentation", v);
+    Py_DECREF(v);
+    if (i < 0 ||
+        PyDict_SetItemString(d, "hugepages",
+                             stats.hugepages ? Py_True : Py_False) < 0 ||
+        set_size_item(d, "arena_size", stats.arena_size) < 0 ||
+        set_size_item(d, "pool_size", stats.pool_size) < 0 ||
+        set_size_item(d, "arenas", stats.arenas) < 0 ||
+        set_size_item(d, "arenas_allocated", stats.arenas_allocated) < 0 ||
+        set_size_item(d, "arenas_freed",
+                      stats.arenas_allocated - stats.arenas) < 0 ||
+        set_size_item(d, "arenas_highwater", stats.arenas_highwater) < 0 ||
+        set_size_item(d, "pools", pools) < 0 ||
+        set_size_item(d, "free_pools", stats.free_pools) < 0 ||
+        set_size_item(d, "blocks", blocks) < 0 ||
+        set_size_item(d, "allocated_bytes", allocated_bytes) < 0 ||
+        set_size_item(d, "sample_rate", stats.sample_rate) < 0 ||
+        set_size_item(d, "samples_lost", stats.samples_lost) < 0)
+        goto error;
+    return d;
+
+  error:
+    Py_XDECREF(classes);
+    Py_DECREF(d);
+    return NULL;
+}
+
+PyDoc_STRVAR(getmallocstats_doc,
+"getmallocstats() -> dict\n\
+\n\
+Return the statistics of the object allocator: the arena and pool size,\n\
+the number of arenas, pools and blocks in use, the free pools, and the\n\
+fraction of the arenas not taken by allocated blocks.  classes has a\n\
+(size, pools, blocks, free blocks) tuple for every size class."
+);
+
+/* The site of a sampled allocation: the code object and line of the
+   innermost Python frame. */
+static void *
+malloc_sample_where(int *lineno)
+{
+    PyThreadState *tstate = _PyThreadState_Current;
+    PyFrameObject *f = tstate != NULL ? tstate->frame : NULL;
+
+#ifdef STACKLESS
+    while (f != NULL && !PyFrame_Check(f))
+        f = f->f_back;
+#endif
+    if (f == NULL)
+        return NULL;
+    *lineno = PyFrame_GetLineNumber(f);
+    return f->f_code;
+}
+
+static void
+malloc_sample_hold(void *key, int incr)
+{
+    if (incr > 0)
+        Py_INCREF((PyObject *)key);
+    else
+        Py_DECREF((PyObject *)key);
+}
+
+static const _PyMallocSampler malloc_sampler = {
+    malloc_sample_where,
+    malloc_sample_hold
+};
+
+static PyObject *
+sys_setmallocsampling(PyObject *self, PyObject *args)
+{
+    Py_ssize_t rate;
+
+    if (!PyArg_ParseTuple(args, "n:setmallocsampling", &rate))
+        return NULL;
+    if (rate < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "sampling rate must not be negative");
+        return NULL;
+    }
+    if (_PyObject_SetMallocSampling(rate, &malloc_sampler) < 0)
+        return PyErr_NoMemory();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyDoc_STRVAR(setmallocsampling_doc,
+"setmallocsampling(rate)\n\
+\n\
+Record the size class and the Python code and line of every rate'th\n\
+allocation of the object allocator, and whether the block is freed.\n\
+A rate of 0 stops sampling and discards the samples."
+);
+
+static int
+malloc_sample_visit(size_t size, void *key, int lineno,
+                    size_t allocated, size_t live, void *list)
+{
+    PyObject *v;
+    int err;
+
+    v = Py_BuildValue("(nOinn)", (Py_ssize_t)size,
+                      key != NULL ? (PyObject *)key : Py_None, lineno,
+                      (Py_ssize_t)allocated, (Py_ssize_t)live);
+    if (v == NULL)
+        return -1;
+    err = PyList_Append((PyObject *)list, v);
+    Py_DECREF(v);
+    return err;
+}
+
+static PyObject *
+sys_getmallocsamples(PyObject *self)
+{
+    PyObject *list = PyList_New(0);
+
+    if (list != NULL &&
+        _PyObject_VisitMallocSamples(malloc_sample_visit, list) < 0)
+        Py_CLEAR(list);
+    return list;
+}
+
+PyDoc_STRVAR(getmallocsamples_doc,
+"getmallocsamples() -> list\n\
+\n\
+Return the samples of setmallocsampling() as a list of\n\
+(size, code, line, allocated, live) tuples, one for every size class\n\
+and line that allocated sampled blocks.  code is None for allocations\n\
+outside of Python code, live counts the blocks not freed yet."
+);
+#endif /* WITH_PYMALLOC */
+
 #ifdef WITH_TSC
 static PyObject *
 sys_settscdump(PyObject *self, PyObject *args)
@@ -908,6 +1216,8 @@ static PyMethodDef sys_methods[] = {
      callstats_doc},
     {"_clear_type_cache",       sys_clear_type_cache,     METH_NOARGS,
      sys_clear_type_cache__doc__},
+    {"clearopcodestats", (PyCFunction)sys_clearopcodestats, METH_NOARGS,
+     clearopcodestats_doc},
     {"_current_frames", sys_current_frames, METH_NOARGS,
      current_frames_doc},
     {"displayhook",     sys_displayhook, METH_O, displayhook_doc},
@@ -932,6 +1242,14 @@ static PyMethodDef sys_methods[] = {
 #ifdef Py_USING_UNICODE
     {"getfilesystemencoding", (PyCFunction)sys_getfilesystemencoding,
      METH_NOARGS, getfilesystemencoding_doc},
+#endif
+    {"getframestats", (PyCFunction)sys_getframestats, METH_NOARGS,
+     getframestats_doc},
+#ifdef WITH_PYMALLOC
+    {"getmallocsamples", (PyCFunction)sys_getmallocsamples, METH_NOARGS,
+     getmallocsamples_doc},
+    {"getmallocstats", (PyCFunction)sys_getmallocstats, METH_NOARGS,
+     getmallocstats_doc},
 #endif
 #ifdef Py_TRACE_REFS
     {"getobjects",      _Py_GetObjects, METH_VARARGS},
@@ -960,10 +1278,26 @@ static PyMethodDef sys_methods[] = {
      setcheckinterval_doc},
     {"getcheckinterval",        sys_getcheckinterval, METH_NOARGS,
      getcheckinterval_doc},
+#ifdef WITH_THREAD
+    {"setswitchinterval",       sys_setswitchinterval, METH_VARARGS,
+     setswitchinterval_doc},
+    {"getswitchinterval",       sys_getswitchinterval, METH_NOARGS,
+     getswitchinterval_doc},
+#endif
 #ifdef HAVE_DLOPEN
     {"setdlopenflags", sys_setdlopenflags, METH_VARARGS,
      setdlopenflags_doc},
 #endif
+#ifdef WITH_PYMALLOC
+    {"setmallocsampling", sys_setmallocsampling, METH_VARARGS,
+     setmallocsampling_doc},
+#endif
+    {"setopcodeprofile", sys_setopcodeprofile, METH_VARARGS,
+     setopcodeprofile_doc},
+    {"getopcodeprofile", (PyCFunction)sys_getopcodeprofile, METH_NOARGS,
+     getopcodeprofile_doc},
+    {"getopcodestats", (PyCFunction)sys_getopcodestats, METH_NOARGS,
+     getopcodestats_doc},
     {"setprofile",      sys_setprofile, METH_O, setprofile_doc},
     {"getprofile",      sys_getprofile, METH_NOARGS, getprofile_doc},
     {"setrecursionlimit", sys_setrecursionlimit, METH_VARARGS,
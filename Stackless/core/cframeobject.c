@@ -142,9 +142,10 @@ err_exit:
 static PyObject *
 cframe_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    static char *kwlist[] = {NULL};
+    static const char * const kwlist[] = {NULL};
+    static _PyArg_Parser parser = {":cframe", kwlist};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, ":cframe", kwlist))
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
         return NULL;
     return (PyObject *) slp_cframe_new(NULL, 0);
 }
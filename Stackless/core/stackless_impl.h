@@ -36,11 +36,12 @@ extern "C" {
 PyAPI_DATA(int) slp_enable_softswitch;
 PyAPI_DATA(int) slp_in_psyco;
 PyAPI_DATA(int) slp_try_stackless;
-PyAPI_DATA(PyCStackObject *) slp_cstack_chain;
 
 PyAPI_FUNC(PyCStackObject *) slp_cstack_new(PyCStackObject **cst,
                                             intptr_t *stackref,
                                             PyTaskletObject *task);
+PyAPI_FUNC(void) slp_cstack_set_tstate(PyCStackObject *cst,
+                                       PyThreadState *ts);
 PyAPI_FUNC(size_t) slp_cstack_save(PyCStackObject *cstprev);
 PyAPI_FUNC(void) slp_cstack_restore(PyCStackObject *cst);
 
@@ -360,6 +361,10 @@ PyAPI_FUNC(PyTaskletObject *) slp_channel_remove_specific(
                                     PyChannelObject *channel,
                                     int dir, PyTaskletObject *task);
 PyAPI_FUNC(PyTaskletObject *) slp_channel_remove_slow(PyTaskletObject *task);
+PyAPI_FUNC(PyObject *) slp_channel_wait(PyChannelObject *channel,
+                                        int stackless);
+PyAPI_FUNC(PyTaskletObject *) slp_channel_wake(PyChannelObject *channel,
+                                               PyObject *value);
 
 /* recording the main thread state */
 
@@ -381,6 +386,14 @@ PyAPI_FUNC(PyObject *) slp_schedule_task(PyTaskletObject *prev,
 
 PyAPI_FUNC(void) slp_thread_unblock(PyThreadState *ts);
 
+/* let a woken up thread take the GIL soon, see Python/ceval_gil.h */
+
+PyAPI_FUNC(void) slp_gil_handoff(PyThreadState *ts);
+
+/* leaving the tasklet group at the end of a tasklet */
+
+PyAPI_FUNC(void) slp_taskletgroup_discard(PyTaskletObject *task);
+
 PyAPI_FUNC(int) initialize_main_and_current(void);
 
 /* setting the tasklet's tempval, optimized for no change */
@@ -463,6 +476,7 @@ PyAPI_FUNC(PyCFrameObject *) slp_cframe_newfunc(PyObject *func,
 
 PyAPI_FUNC(PyFrameObject *) slp_get_frame(PyTaskletObject *task);
 PyAPI_FUNC(void) slp_check_pending_irq(void);
+PyAPI_FUNC(double) slp_clock(void);
 PyAPI_FUNC(int) slp_return_wrapper(PyObject *retval);
 PyAPI_FUNC(int) slp_int_wrapper(PyObject *retval);
 PyAPI_FUNC(int) slp_current_wrapper(int(*func)(PyTaskletObject*),
@@ -88,6 +88,10 @@ typedef struct _tasklet {
     struct _cstack *cstate;
     PyObject *def_globals;
     PyObject *tsk_weakreflist;
+    /* tasklet group membership, maintained by the group */
+    struct _taskletgroup *group;
+    struct _tasklet *group_next;
+    struct _tasklet *group_prev;
 } PyTaskletObject;
 
 
@@ -164,6 +168,33 @@ typedef struct _channel {
 } PyChannelObject;
 
 
+/*** important structures: tasklet group ***/
+
+typedef struct _taskletgroup {
+    PyObject_HEAD
+    /* the members, chained through group_next/group_prev */
+    struct _tasklet *members;
+    Py_ssize_t count;
+    /* tasklets waiting in join() */
+    struct _channel *waiters;
+    PyObject *grp_weakreflist;
+} PyTaskletGroupObject;
+
+
+/*** important structures: future ***/
+
+typedef struct _future {
+    PyObject_HEAD
+    /* the value or a bomb, NULL while pending */
+    PyObject *result;
+    /* tasklets waiting for this future alone */
+    struct _channel *waiters;
+    /* the wait_all/wait_any sets watching this future, or NULL */
+    PyObject *watchers;
+    PyObject *fut_weakreflist;
+} PyFutureObject;
+
+
 /*** important stuctures: cframe ***/
 
 typedef struct _cframe {
@@ -210,6 +241,12 @@ PyAPI_DATA(PyTypeObject) PyCStack_Type;
 PyAPI_DATA(PyTypeObject) PyBomb_Type;
 #define PyBomb_Check(op) ((op)->ob_type == &PyBomb_Type)
 
+PyAPI_DATA(PyTypeObject) PyTaskletGroup_Type;
+#define PyTaskletGroup_Check(op) PyObject_TypeCheck(op, &PyTaskletGroup_Type)
+
+PyAPI_DATA(PyTypeObject) PyFuture_Type;
+#define PyFuture_Check(op) PyObject_TypeCheck(op, &PyFuture_Type)
+
 PyAPI_DATA(PyTypeObject*) PyTasklet_TypePtr;
 #define PyTasklet_Type (*PyTasklet_TypePtr)
 #define PyTasklet_Check(op) PyObject_TypeCheck(op, PyTasklet_TypePtr)
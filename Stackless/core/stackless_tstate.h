@@ -20,6 +20,8 @@ typedef struct _sts {
     intptr_t *cstack_base;
     /* stack overflow check and init flag */
     intptr_t *cstack_root;
+    /* the chain of all stacks created by this thread */
+    struct _cstack *cstack_chain;
     /* main tasklet */
     struct _tasklet *main;
     /* runnable tasklets */
@@ -33,10 +35,13 @@ typedef struct _sts {
     /* trap recursive scheduling via callbacks */
     int schedlock;
     int runflags;                               /* flags for stackless.run() behaviour */
+    double host_deadline;                       /* end of the run_host() budget */
+    PyObject *sleepers;                         /* sorted (deadline, tasklet) list */
 #ifdef WITH_THREAD
     struct {
         PyObject *block_lock;                   /* to block the thread */
         int is_blocked;
+        int gil_handoff;                        /* woken up, take the GIL soon */
     } thread;
 #endif
     /* number of nested interpreters (1.0/2.0 merge) */
@@ -54,6 +59,7 @@ typedef struct _sts {
     tstate->st.serial_last_jump = 0; \
     tstate->st.cstack_base = NULL; \
     tstate->st.cstack_root = NULL; \
+    tstate->st.cstack_chain = NULL; \
     tstate->st.ticker = 0; \
     tstate->st.interval = 0; \
     tstate->st.interrupt = NULL; \
@@ -63,6 +69,8 @@ typedef struct _sts {
     tstate->st.runcount = 0; \
     tstate->st.nesting_level = 0; \
     tstate->st.runflags = 0; \
+    tstate->st.host_deadline = 0.0; \
+    tstate->st.sleepers = NULL; \
     tstate->st.del_post_switch = NULL;
 
 /* note that the scheduler knows how to zap. It checks if it is in charge
@@ -73,23 +81,28 @@ typedef struct _sts {
 struct _ts; /* Forward */
 
 void slp_kill_tasks_with_stacks(struct _ts *tstate);
+void slp_cstack_chain_release(struct _ts *tstate);
 
 #define __STACKLESS_PYSTATE_CLEAR \
     slp_kill_tasks_with_stacks(tstate); \
-    Py_CLEAR(tstate->st.initial_stub);
+    Py_CLEAR(tstate->st.initial_stub); \
+    Py_CLEAR(tstate->st.sleepers); \
+    slp_cstack_chain_release(tstate);
 
 #ifdef WITH_THREAD
 
 #define STACKLESS_PYSTATE_NEW \
     __STACKLESS_PYSTATE_NEW \
     tstate->st.thread.block_lock = NULL; \
-    tstate->st.thread.is_blocked = 0;
+    tstate->st.thread.is_blocked = 0; \
+    tstate->st.thread.gil_handoff = 0;
 
 
 #define STACKLESS_PYSTATE_CLEAR \
     __STACKLESS_PYSTATE_CLEAR \
     Py_CLEAR(tstate->st.thread.block_lock); \
-    tstate->st.thread.is_blocked = 0;
+    tstate->st.thread.is_blocked = 0; \
+    tstate->st.thread.gil_handoff = 0;
 
 #else
 
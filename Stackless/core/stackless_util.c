@@ -3,6 +3,10 @@
 #ifdef STACKLESS
 #include "stackless_impl.h"
 
+#ifdef MS_WINDOWS
+#include <windows.h>
+#endif
+
 /* backward compatibility */
 #ifndef Py_TYPE
 #define Py_TYPE(ob)     (ob->ob_type)
@@ -50,6 +54,35 @@ slp_get_frame(PyTaskletObject *task)
     return ts->st.current == task ? ts->frame : task->f.frame;
 }
 
+/* a monotonic clock in seconds, for the host loop and sleep() */
+double
+slp_clock(void)
+{
+#ifdef MS_WINDOWS
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double) now.QuadPart / (double) freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + t.tv_nsec * 1e-9;
+#else
+    struct timeval t;
+
+#ifdef GETTIMEOFDAY_NO_TZ
+    gettimeofday(&t);
+#else
+    gettimeofday(&t, (struct timezone *) NULL);
+#endif
+    return (double) t.tv_sec + t.tv_usec * 1e-6;
+#endif
+}
+
 void slp_check_pending_irq()
 {
     PyThreadState *ts = PyThreadState_GET();
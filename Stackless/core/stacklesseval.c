@@ -37,9 +37,6 @@ int slp_in_psyco = 0;
  */
 int slp_try_stackless = 0;
 
-/* the list of all stacks of all threads */
-struct _cstack *slp_cstack_chain = NULL;
-
 
 /******************************************************
 
@@ -66,12 +63,59 @@ static void slp_cstack_cacheclear(void)
     cstack_cachecount = 0;
 }
 
+/*
+ * every stack is linked into the chain of the thread state that
+ * it belongs to. This keeps thread teardown proportional to the
+ * number of stacks of that thread.
+ */
+
+static void
+cstack_chain_remove(PyCStackObject *cst)
+{
+    PyCStackObject **chain;
+
+    if (cst->tstate == NULL)
+        return;
+    chain = &cst->tstate->st.cstack_chain;
+    *chain = cst;
+    SLP_CHAIN_REMOVE(PyCStackObject, chain, cst, next, prev);
+}
+
+void
+slp_cstack_set_tstate(PyCStackObject *cst, PyThreadState *ts)
+{
+    PyCStackObject **chain = &ts->st.cstack_chain;
+
+    if (cst->tstate == ts)
+        return;
+    cstack_chain_remove(cst);
+    cst->tstate = ts;
+    SLP_CHAIN_INSERT(PyCStackObject, chain, cst, next, prev);
+}
+
+/* hand the stacks which outlive their thread over to the main thread.
+   the stacks which outlive the main thread belong to no thread at all. */
+
+void
+slp_cstack_chain_release(PyThreadState *ts)
+{
+    PyCStackObject *cst;
+
+    if (slp_initial_tstate != NULL && ts != slp_initial_tstate) {
+        while (ts->st.cstack_chain != NULL)
+            slp_cstack_set_tstate(ts->st.cstack_chain, slp_initial_tstate);
+        return;
+    }
+    while ((cst = ts->st.cstack_chain) != NULL) {
+        cstack_chain_remove(cst);
+        cst->tstate = NULL;
+    }
+}
+
 static void
 cstack_dealloc(PyCStackObject *cst)
 {
-    slp_cstack_chain = cst;
-    SLP_CHAIN_REMOVE(PyCStackObject, &slp_cstack_chain, cst, next,
-                     prev);
+    cstack_chain_remove(cst);
     if (cst->ob_size >= CSTACK_SLOTS) {
         PyObject_Del(cst);
     }
@@ -111,7 +155,7 @@ slp_cstack_new(PyCStackObject **cst, intptr_t *stackref, PyTaskletObject *task)
 
     (*cst)->startaddr = stackbase;
     (*cst)->next = (*cst)->prev = NULL;
-    SLP_CHAIN_INSERT(PyCStackObject, &slp_cstack_chain, *cst, next, prev);
+    SLP_CHAIN_INSERT(PyCStackObject, &ts->st.cstack_chain, *cst, next, prev);
     (*cst)->serial = ts->st.serial_last_jump;
     (*cst)->task = task;
     (*cst)->tstate = ts;
@@ -307,12 +351,13 @@ slp_eval_frame(PyFrameObject *f)
     return slp_frame_dispatch(f, fprev, 0, Py_None);
 }
 
-void slp_kill_tasks_with_stacks(PyThreadState *ts)
+static void
+kill_tasks_with_stacks(PyThreadState *ts)
 {
     int count = 0;
 
     while (1) {
-        PyCStackObject *csfirst = slp_cstack_chain, *cs;
+        PyCStackObject *csfirst = ts->st.cstack_chain, *cs;
         PyTaskletObject *t, *task;
         PyTaskletObject **chain;
 
@@ -326,8 +371,6 @@ void slp_kill_tasks_with_stacks(PyThreadState *ts)
             ++count;
             if (cs->task == NULL)
                 continue;
-            if (ts != NULL && cs->tstate != ts)
-                continue;
             break;
         }
         count = 0;
@@ -361,12 +404,30 @@ void slp_kill_tasks_with_stacks(PyThreadState *ts)
 
         if (t->cstate != NULL) {
             /* ensure a valid tstate */
-            t->cstate->tstate = slp_initial_tstate;
+            slp_cstack_set_tstate(t->cstate, slp_initial_tstate);
         }
         Py_DECREF(t);
     }
 }
 
+void slp_kill_tasks_with_stacks(PyThreadState *ts)
+{
+    PyInterpreterState *interp;
+    PyThreadState *other;
+
+    if (ts != NULL) {
+        kill_tasks_with_stacks(ts);
+        return;
+    }
+    /* all threads: visit the stack chain of every thread state */
+    for (interp = PyInterpreterState_Head(); interp != NULL;
+         interp = PyInterpreterState_Next(interp)) {
+        for (other = PyInterpreterState_ThreadHead(interp); other != NULL;
+             other = PyThreadState_Next(other))
+            kill_tasks_with_stacks(other);
+    }
+}
+
 void PyStackless_kill_tasks_with_stacks(int allthreads)
 {
     PyThreadState *ts = PyThreadState_Get();
@@ -539,6 +600,9 @@ slp_gen_send_ex(PyGenObject *ob, PyObject *arg, int exc)
         (f->f_back = (PyFrameObject *)
                  slp_cframe_new(gen_iternext_callback, 0)) == NULL)
         return NULL;
+    /* A hard switched tp_iternext returns to C code that expects
+       the end of the iteration without StopIteration. */
+    ((PyCFrameObject *) f->f_back)->i = !stackless && arg == NULL;
 
     if (f->f_lasti == -1) {
         if (arg && arg != Py_None) {
@@ -615,7 +679,8 @@ gen_iternext_callback(PyFrameObject *f, int exc, PyObject *result)
             PyErr_SetNone(PyExc_StopIteration);
         /* Stackless extra handling */
         /* are we awaited by a for_iter or called by next() ? */
-        else if (ts->frame->f_execute != PyEval_EvalFrame_iter) {
+        else if (!cf->i &&
+                 ts->frame->f_execute != PyEval_EvalFrame_iter) {
             /* do the missing part of the next call */
             if (!PyErr_Occurred())
                 PyErr_SetNone(PyExc_StopIteration);
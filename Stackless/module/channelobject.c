@@ -125,6 +125,57 @@ slp_channel_remove_slow(PyTaskletObject *task)
     return slp_channel_remove_specific(channel, dir, task);;
 }
 
+/*
+ * Channels as plain wait queues, for the synchronization objects.
+ * Waiting blocks the current tasklet as a receiver. Waking moves the
+ * first receiver to the runnables of its thread with the given value,
+ * without switching to it.
+ */
+
+PyObject *
+slp_channel_wait(PyChannelObject *channel, int stackless)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    PyTaskletObject *source = ts->st.current;
+
+    if (source->flags.block_trap)
+        RUNTIME_ERROR("this tasklet does not like to be"
+                      " blocked.", NULL);
+    TASKLET_SETVAL(source, Py_None);
+    slp_current_remove();
+    slp_channel_insert(channel, source, -1);
+    /* keep a temporary channel alive past a soft switch */
+    if (channel->ob_refcnt == 1) {
+        assert(ts->st.del_post_switch == NULL);
+        ts->st.del_post_switch = (PyObject *) channel;
+        Py_INCREF(channel);
+    }
+    return slp_schedule_task(source, ts->st.current, stackless, 0);
+}
+
+PyTaskletObject *
+slp_channel_wake(PyChannelObject *channel, PyObject *value)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    PyTaskletObject *task;
+
+    for (;;) {
+        if (channel->balance >= 0)
+            return NULL;
+        task = slp_channel_remove(channel, -1);
+        if (task->cstate->tstate != NULL)
+            break;
+        /* it outlived the main thread, and so it is dead */
+        Py_DECREF(task);
+    }
+    /* the channel's reference moves to the runnables */
+    TASKLET_SETVAL(task, value);
+    slp_current_insert(task);
+    if (task->cstate->tstate != ts)
+        slp_thread_unblock(task->cstate->tstate);
+    return task;
+}
+
 
 PyChannelObject *
 PyChannel_New(PyTypeObject *type)
@@ -149,9 +200,10 @@ PyChannel_New(PyTypeObject *type)
 static PyObject *
 channel_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    static char *argnames[] = {NULL};
+    static const char * const argnames[] = {NULL};
+    static _PyArg_Parser parser = {":channel", argnames};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, ":channel", argnames))
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
         return NULL;
     return (PyObject *)PyChannel_New(type);
 }
@@ -570,21 +622,26 @@ static CHANNEL_SEND_EXCEPTION_HEAD(wrap_channel_send_exception)
 }
 
 static PyObject *
-channel_send_exception(PyObject *myself, PyObject *args)
+channel_send_exception(PyObject *myself, PyObject **args, Py_ssize_t nargs)
 {
     STACKLESS_GETARG();
     PyObject *retval = NULL;
-    PyObject *klass = PySequence_GetItem(args, 0);
+    PyObject *klass, *exc_args;
+    Py_ssize_t i;
 
-    if (klass == NULL)
+    if (nargs < 1)
         VALUE_ERROR("channel.send_exception(e, v...)", NULL);
-    args = PySequence_GetSlice(args, 1, PySequence_Size(args));
-    if (!args) {
-        goto err_exit;
+    klass = args[0];
+    exc_args = PyTuple_New(nargs - 1);
+    if (exc_args == NULL)
+        return NULL;
+    for (i = 1; i < nargs; i++) {
+        Py_INCREF(args[i]);
+        PyTuple_SET_ITEM(exc_args, i - 1, args[i]);
     }
     STACKLESS_PROMOTE_ALL();
     retval = impl_channel_send_exception((PyChannelObject*)myself,
-                                            klass, args);
+                                            klass, exc_args);
     STACKLESS_ASSERT();
     if (retval == NULL || STACKLESS_UNWINDING(retval)) {
         goto err_exit;
@@ -592,8 +649,7 @@ channel_send_exception(PyObject *myself, PyObject *args)
     Py_INCREF(Py_None);
     retval = Py_None;
 err_exit:
-    Py_DECREF(klass);
-    Py_XDECREF(args);
+    Py_DECREF(exc_args);
     return retval;
 }
 
@@ -708,8 +764,9 @@ channel_iternext(PyChannelObject *self)
 {
     STACKLESS_GETARG();
 
-    if (self->flags.closing && self->balance == 0) {
-        /* signal the end of the iteration */
+    if (self->flags.closing && self->balance <= 0) {
+        /* signal the end of the iteration without the StopIteration
+           that receive() would raise, as there is no sender left */
         return NULL;
     }
     STACKLESS_PROMOTE_ALL();
@@ -1008,7 +1065,7 @@ channel_cmethods[] = {
 
 #define PCF PyCFunction
 #define METH_KS METH_KEYWORDS | METH_STACKLESS
-#define METH_VS METH_VARARGS | METH_STACKLESS
+#define METH_FS METH_FASTCALL | METH_STACKLESS
 #define METH_NS METH_NOARGS | METH_STACKLESS
 #define METH_OS METH_O | METH_STACKLESS
 
@@ -1016,7 +1073,7 @@ static PyMethodDef
 channel_methods[] = {
     {"send",                (PCF)channel_send,              METH_OS,
      channel_send__doc__},
-    {"send_exception",  (PCF)channel_send_exception,    METH_VS,
+    {"send_exception",  (PCF)channel_send_exception,    METH_FS,
      channel_send_exception__doc__},
     {"receive",             (PCF)channel_receive,           METH_NS,
      channel_receive__doc__},
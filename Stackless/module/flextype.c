@@ -115,15 +115,16 @@ static PyObject *
 flextype_new(PyTypeObject *meta, PyObject *args, PyObject *kwds)
 {
     PyObject *name, *bases, *dict;
-    static char *kwlist[] = {"name", "bases", "dict", 0};
+    static const char * const kwlist[] = {"name", "bases", "dict", 0};
+    static _PyArg_Parser parser = {"SO!O!:type", kwlist};
     PyFlexTypeObject *type;
     Py_ssize_t basicsize = meta->tp_basicsize;
     Py_ssize_t type_size = basicsize;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "SO!O!:type", kwlist,
-                                     &name,
-                                     &PyTuple_Type, &bases,
-                                     &PyDict_Type, &dict))
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser,
+                                          &name,
+                                          &PyTuple_Type, &bases,
+                                          &PyDict_Type, &dict))
         return NULL;
     assert(PyType_IsSubtype(meta, &PyFlexType_Type));
     type_size = find_size(bases, type_size);
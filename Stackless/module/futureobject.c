@@ -0,0 +1,567 @@
+/******************************************************
+
+  The Future
+
+ ******************************************************/
+
+#include "Python.h"
+
+#ifdef STACKLESS
+#include "core/stackless_impl.h"
+#include "futureobject.h"
+
+/*
+ * A future is resolved once, with a value or with a bomb. Resolving
+ * it moves all waiting tasklets to the runnables, with the result as
+ * their tempval, so a bomb explodes in each of them like an exception
+ * sent over a channel. No channel action and no value swapping is
+ * involved, and the resolving tasklet continues to run.
+ *
+ * wait_all() and wait_any() block on a waitset, which is registered
+ * with every pending future and counts down as they are resolved.
+ */
+
+typedef struct _waitset {
+    PyObject_HEAD
+    PyChannelObject *waiters;
+    /* the number of resolutions still to wait for */
+    Py_ssize_t remaining;
+    /* wait_any returns the future that fired, wait_all returns None */
+    int any;
+    /* the futures we are registered with, NULL when fired */
+    PyObject *futures;
+} PyWaitSetObject;
+
+static PyTypeObject PyWaitSet_Type;
+
+
+/*******************************************************************
+
+  waitset
+
+ ******************************************************************/
+
+static PyWaitSetObject *
+waitset_new(Py_ssize_t remaining, int any)
+{
+    PyWaitSetObject *ws = PyObject_GC_New(PyWaitSetObject, &PyWaitSet_Type);
+
+    if (ws == NULL)
+        return NULL;
+    ws->remaining = remaining;
+    ws->any = any;
+    ws->waiters = NULL;
+    ws->futures = PyList_New(0);
+    if (ws->futures != NULL)
+        ws->waiters = PyChannel_New(NULL);
+    PyObject_GC_Track(ws);
+    if (ws->waiters == NULL) {
+        Py_DECREF(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+static int
+waitset_traverse(PyWaitSetObject *ws, visitproc visit, void *arg)
+{
+    Py_VISIT(ws->waiters);
+    Py_VISIT(ws->futures);
+    return 0;
+}
+
+static int
+waitset_clear(PyWaitSetObject *ws)
+{
+    Py_CLEAR(ws->waiters);
+    Py_CLEAR(ws->futures);
+    return 0;
+}
+
+static void
+waitset_dealloc(PyWaitSetObject *ws)
+{
+    PyObject_GC_UnTrack(ws);
+    waitset_clear(ws);
+    PyObject_GC_Del(ws);
+}
+
+/* remove ws from the watchers of the futures it still waits for */
+
+static void
+waitset_detach(PyWaitSetObject *ws)
+{
+    PyObject *futures = ws->futures;
+    Py_ssize_t i, j;
+
+    ws->futures = NULL;
+    if (futures == NULL)
+        return;
+    for (i = 0; i < PyList_GET_SIZE(futures); ++i) {
+        PyFutureObject *f = (PyFutureObject *) PyList_GET_ITEM(futures, i);
+        PyObject *watchers = f->watchers;
+
+        if (watchers == NULL)
+            continue;
+        for (j = PyList_GET_SIZE(watchers) - 1; j >= 0; --j)
+            if (PyList_GET_ITEM(watchers, j) == (PyObject *) ws)
+                PyList_SetSlice(watchers, j, j + 1, NULL);
+    }
+    Py_DECREF(futures);
+}
+
+static void
+waitset_notify(PyWaitSetObject *ws, PyFutureObject *f)
+{
+    if (ws->futures == NULL || --ws->remaining > 0)
+        return;
+    if (ws->waiters != NULL)
+        slp_channel_wake(ws->waiters, ws->any ? (PyObject *) f : Py_None);
+    waitset_detach(ws);
+}
+
+static PyTypeObject PyWaitSet_Type = {
+    PyObject_HEAD_INIT(&PyType_Type)
+    0,
+    "stackless._waitset",
+    sizeof(PyWaitSetObject),
+    0,
+    (destructor)waitset_dealloc,                /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    0,                                          /* tp_doc */
+    (traverseproc)waitset_traverse,             /* tp_traverse */
+    (inquiry)waitset_clear,                     /* tp_clear */
+};
+
+
+/*******************************************************************
+
+  future
+
+ ******************************************************************/
+
+PyFutureObject *
+PyFuture_New(PyTypeObject *type)
+{
+    PyFutureObject *f;
+
+    if (type == NULL)
+        type = &PyFuture_Type;
+    assert(PyType_IsSubtype(type, &PyFuture_Type));
+    f = (PyFutureObject *) type->tp_alloc(type, 0);
+    if (f == NULL)
+        return NULL;
+    f->result = NULL;
+    f->watchers = NULL;
+    f->fut_weakreflist = NULL;
+    /* the waiters channel is created by the first blocking result() */
+    f->waiters = NULL;
+    return f;
+}
+
+static PyObject *
+future_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {NULL};
+    static _PyArg_Parser parser = {":future", argnames};
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
+        return NULL;
+    return (PyObject *) PyFuture_New(type);
+}
+
+static int
+future_traverse(PyFutureObject *f, visitproc visit, void *arg)
+{
+    Py_VISIT(f->result);
+    Py_VISIT(f->waiters);
+    Py_VISIT(f->watchers);
+    return 0;
+}
+
+static int
+future_clear(PyFutureObject *f)
+{
+    Py_CLEAR(f->result);
+    Py_CLEAR(f->waiters);
+    Py_CLEAR(f->watchers);
+    return 0;
+}
+
+static void
+future_dealloc(PyFutureObject *f)
+{
+    PyObject_GC_UnTrack(f);
+    if (f->fut_weakreflist != NULL)
+        PyObject_ClearWeakRefs((PyObject *) f);
+    future_clear(f);
+    Py_TYPE(f)->tp_free((PyObject *) f);
+}
+
+/* hand a result to the caller, exploding a bomb */
+
+static PyObject *
+future_deliver(PyObject *result)
+{
+    Py_INCREF(result);
+    if (PyBomb_Check(result))
+        return slp_bomb_explode(result);
+    return result;
+}
+
+/* resolve the future with a value or a bomb, stealing the reference */
+
+static int
+future_resolve(PyFutureObject *self, PyObject *result)
+{
+    PyObject *watchers;
+    Py_ssize_t i;
+
+    if (self->result != NULL) {
+        Py_DECREF(result);
+        RUNTIME_ERROR("future is already resolved", -1);
+    }
+    self->result = result;
+    if (self->waiters != NULL)
+        while (slp_channel_wake(self->waiters, result) != NULL)
+            ;
+    /* detach the list, the waitsets remove themselves from others */
+    watchers = self->watchers;
+    self->watchers = NULL;
+    if (watchers != NULL) {
+        for (i = 0; i < PyList_GET_SIZE(watchers); ++i)
+            waitset_notify((PyWaitSetObject *) PyList_GET_ITEM(watchers, i),
+                           self);
+        Py_DECREF(watchers);
+    }
+    return 0;
+}
+
+int
+PyFuture_SetResult(PyFutureObject *self, PyObject *value)
+{
+    Py_INCREF(value);
+    return future_resolve(self, value);
+}
+
+PyDoc_STRVAR(future_set_result__doc__,
+"future.set_result(value) -- resolve the future with value.\n\
+All waiting tasklets are scheduled, but the caller continues to run.\n\
+A future can be resolved only once.");
+
+static PyObject *
+future_set_result(PyFutureObject *self, PyObject *value)
+{
+    if (PyFuture_SetResult(self, value))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+int
+PyFuture_SetException(PyFutureObject *self, PyObject *klass, PyObject *args)
+{
+    PyObject *bomb;
+
+    if (self->result != NULL)
+        RUNTIME_ERROR("future is already resolved", -1);
+    bomb = slp_make_bomb(klass, args, "future.set_exception");
+    if (bomb == NULL)
+        return -1;
+    return future_resolve(self, bomb);
+}
+
+PyDoc_STRVAR(future_set_exception__doc__,
+"future.set_exception(exc, value) -- resolve the future with an exception.\n\
+exc must be a subclass of Exception. The exception is raised in every\n\
+tasklet which waits for the result.");
+
+static PyObject *
+future_set_exception(PyFutureObject *self, PyObject *args)
+{
+    PyObject *klass = PySequence_GetItem(args, 0);
+    int ret;
+
+    if (klass == NULL)
+        VALUE_ERROR("future.set_exception(e, v...)", NULL);
+    args = PySequence_GetSlice(args, 1, PySequence_Size(args));
+    if (args == NULL) {
+        Py_DECREF(klass);
+        return NULL;
+    }
+    ret = PyFuture_SetException(self, klass, args);
+    Py_DECREF(klass);
+    Py_DECREF(args);
+    if (ret)
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(future_result__doc__,
+"future.result() -- return the value of the future, or raise its\n\
+exception. Blocks the current tasklet while the future is pending.");
+
+static PyObject *
+PyFuture_Result_M(PyFutureObject *self)
+{
+    return PyStackless_CallMethod_Main((PyObject *) self, "result", NULL);
+}
+
+static PyObject *
+impl_future_result(PyFutureObject *self)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+
+    if (self->result != NULL)
+        return future_deliver(self->result);
+    if (ts->st.main == NULL) return PyFuture_Result_M(self);
+    if (self->waiters == NULL &&
+        (self->waiters = PyChannel_New(NULL)) == NULL)
+        return NULL;
+    return slp_channel_wait(self->waiters, stackless);
+}
+
+PyObject *
+PyFuture_Result(PyFutureObject *self)
+{
+    return impl_future_result(self);
+}
+
+static PyObject *
+future_result(PyObject *self)
+{
+    return impl_future_result((PyFutureObject *) self);
+}
+
+PyDoc_STRVAR(future_done__doc__,
+"future.done() -- return True if the future has been resolved.");
+
+static PyObject *
+future_done(PyFutureObject *self)
+{
+    return PyBool_FromLong(self->result != NULL);
+}
+
+static PyObject *
+future_get_waiting(PyFutureObject *self)
+{
+    PyChannelObject *waiters = self->waiters;
+
+    return PyInt_FromLong(waiters != NULL && waiters->balance < 0 ?
+                          -waiters->balance : 0);
+}
+
+
+/*******************************************************************
+
+  wait_all and wait_any
+
+ ******************************************************************/
+
+/*
+ * Collect the futures of seq. Returns a new list, and sets *pending to
+ * the number of unresolved entries and *done to the first resolved one.
+ */
+
+static PyObject *
+future_collect(PyObject *seq, Py_ssize_t *pending, PyFutureObject **done)
+{
+    PyObject *futures = PySequence_List(seq);
+    Py_ssize_t i;
+
+    if (futures == NULL)
+        return NULL;
+    *pending = 0;
+    *done = NULL;
+    for (i = 0; i < PyList_GET_SIZE(futures); ++i) {
+        PyObject *f = PyList_GET_ITEM(futures, i);
+
+        if (!PyFuture_Check(f)) {
+            Py_DECREF(futures);
+            TYPE_ERROR("can only wait for futures", NULL);
+        }
+        if (((PyFutureObject *) f)->result == NULL)
+            ++*pending;
+        else if (*done == NULL)
+            *done = (PyFutureObject *) f;
+    }
+    return futures;
+}
+
+static PyObject *
+future_wait_set(PyObject *futures, Py_ssize_t remaining, int any,
+                int stackless)
+{
+    PyWaitSetObject *ws = waitset_new(remaining, any);
+    PyObject *retval;
+    Py_ssize_t i;
+
+    if (ws == NULL)
+        return NULL;
+    for (i = 0; i < PyList_GET_SIZE(futures); ++i) {
+        PyFutureObject *f = (PyFutureObject *) PyList_GET_ITEM(futures, i);
+
+        if (f->result != NULL)
+            continue;
+        if (f->watchers == NULL && (f->watchers = PyList_New(0)) == NULL)
+            goto error;
+        if (PyList_Append(f->watchers, (PyObject *) ws) ||
+            PyList_Append(ws->futures, (PyObject *) f))
+            goto error;
+    }
+    retval = slp_channel_wait(ws->waiters, stackless);
+    Py_DECREF(ws);
+    return retval;
+error:
+    waitset_detach(ws);
+    Py_DECREF(ws);
+    return NULL;
+}
+
+PyObject *
+PyFuture_WaitAll(PyObject *seq)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PyObject *futures, *retval;
+    PyFutureObject *done;
+    Py_ssize_t pending;
+
+    futures = future_collect(seq, &pending, &done);
+    if (futures == NULL)
+        return NULL;
+    if (pending == 0) {
+        Py_DECREF(futures);
+        Py_RETURN_NONE;
+    }
+    if (ts->st.main == NULL) {
+        retval = PyStackless_CallMethod_Main(slp_module, "wait_all", "(O)",
+                                             futures);
+        Py_DECREF(futures);
+        return retval;
+    }
+    retval = future_wait_set(futures, pending, 0, stackless);
+    Py_DECREF(futures);
+    return retval;
+}
+
+PyObject *
+PyFuture_WaitAny(PyObject *seq)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PyObject *futures, *retval;
+    PyFutureObject *done;
+    Py_ssize_t pending;
+
+    futures = future_collect(seq, &pending, &done);
+    if (futures == NULL)
+        return NULL;
+    if (done != NULL || pending == 0) {
+        Py_DECREF(futures);
+        if (done == NULL)
+            VALUE_ERROR("wait_any needs at least one future", NULL);
+        Py_INCREF(done);
+        return (PyObject *) done;
+    }
+    if (ts->st.main == NULL) {
+        retval = PyStackless_CallMethod_Main(slp_module, "wait_any", "(O)",
+                                             futures);
+        Py_DECREF(futures);
+        return retval;
+    }
+    retval = future_wait_set(futures, 1, 1, stackless);
+    Py_DECREF(futures);
+    return retval;
+}
+
+
+#define PCF PyCFunction
+#define METH_NS METH_NOARGS | METH_STACKLESS
+
+static PyMethodDef future_methods[] = {
+    {"set_result",      (PCF)future_set_result,     METH_O,
+     future_set_result__doc__},
+    {"set_exception",   (PCF)future_set_exception,  METH_VARARGS,
+     future_set_exception__doc__},
+    {"result",          (PCF)future_result,         METH_NS,
+     future_result__doc__},
+    {"done",            (PCF)future_done,           METH_NOARGS,
+     future_done__doc__},
+    {NULL,              NULL}           /* sentinel */
+};
+
+static PyGetSetDef future_getsetlist[] = {
+    {"waiting",         (getter)future_get_waiting, NULL,
+     "the number of tasklets blocked in result()."},
+    {0},
+};
+
+PyDoc_STRVAR(future__doc__,
+"future() -- a placeholder for a result which is not available yet.\n\
+Any number of tasklets can wait for it with result(), or together with\n\
+other futures with stackless.wait_all() and stackless.wait_any().");
+
+PyTypeObject PyFuture_Type = {
+    PyObject_HEAD_INIT(&PyType_Type)
+    0,
+    "stackless.future",
+    sizeof(PyFutureObject),
+    0,
+    (destructor)future_dealloc,                 /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    PyObject_GenericSetAttr,                    /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC |
+        Py_TPFLAGS_BASETYPE,                    /* tp_flags */
+    future__doc__,                              /* tp_doc */
+    (traverseproc)future_traverse,              /* tp_traverse */
+    (inquiry)future_clear,                      /* tp_clear */
+    0,                                          /* tp_richcompare */
+    offsetof(PyFutureObject, fut_weakreflist),  /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    future_methods,                             /* tp_methods */
+    0,                                          /* tp_members */
+    future_getsetlist,                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    PyType_GenericAlloc,                        /* tp_alloc */
+    future_new,                                 /* tp_new */
+    PyObject_GC_Del,                            /* tp_free */
+};
+
+int init_futuretype(void)
+{
+    return PyType_Ready(&PyWaitSet_Type) || PyType_Ready(&PyFuture_Type);
+}
+#endif
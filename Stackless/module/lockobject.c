@@ -0,0 +1,992 @@
+/******************************************************
+
+  Tasklet Synchronization Objects
+
+ ******************************************************/
+
+#include "Python.h"
+
+#ifdef STACKLESS
+#include "core/stackless_impl.h"
+#include "lockobject.h"
+
+/*
+ * lock, rlock, semaphore, condition and event block tasklets instead of
+ * threads. Each object owns a private channel which serves as its wait
+ * queue, so blocked tasklets are visible to the channel machinery and
+ * can be killed like any other blocked tasklet.
+ * An uncontended acquire neither switches nor calls Python code.
+ *
+ * Locks and events are handed over: release() makes the first waiter
+ * the new owner before waking it up. A semaphore wakes up one waiter,
+ * which competes for the released unit again.
+ * A waiter which is woken up and then killed before it runs gives up
+ * what it was handed, so the other waiters are not stuck.
+ */
+
+typedef struct _waitable_ops {
+    /* take the object for task, 1 on success, 0 if task must wait */
+    int (*acquire)(PyObject *self, PyTaskletObject *task);
+    /* task was woken up, 1 if it got the object, 0 to wait again */
+    int (*woken)(PyObject *self, PyTaskletObject *task);
+    /* task was woken up by an exception, give back what it holds */
+    void (*abandon)(PyObject *self, PyTaskletObject *task);
+} waitable_ops;
+
+#define SLP_WAITABLE_HEAD \
+    PyObject_HEAD \
+    waitable_ops *ops; \
+    PyChannelObject *waiters; \
+    PyObject *weakreflist;
+
+typedef struct _slp_waitable {
+    SLP_WAITABLE_HEAD
+} PySlpWaitableObject;
+
+typedef struct _slp_lock {
+    SLP_WAITABLE_HEAD
+    PyTaskletObject *owner;
+    long count;
+    int recursive;
+} PySlpLockObject;
+
+typedef struct _slp_semaphore {
+    SLP_WAITABLE_HEAD
+    long value;
+} PySlpSemaphoreObject;
+
+typedef struct _slp_event {
+    SLP_WAITABLE_HEAD
+    int flag;
+} PySlpEventObject;
+
+typedef struct _slp_condition {
+    SLP_WAITABLE_HEAD
+    PySlpLockObject *lock;
+} PySlpConditionObject;
+
+#define WAITABLE(ob) ((PySlpWaitableObject *) (ob))
+
+/* wake up the first waiter, if the object has not been cleared */
+
+static PyTaskletObject *
+waitable_wake(PyObject *self, PyObject *value)
+{
+    PyChannelObject *waiters = WAITABLE(self)->waiters;
+
+    return waiters != NULL ? slp_channel_wake(waiters, value) : NULL;
+}
+
+
+/*******************************************************************
+
+  The wait loop.
+
+  A blocking wait keeps its state in a cframe, so that it can be
+  continued after a soft switch:
+
+  ob1   the waitable to acquire
+  ob2   a pending exception, as a bomb, to be raised after acquiring
+  ob3   the result of the call
+  i     the recursion count to restore for condition.wait, or 0
+  n     the stage, see below
+
+ ******************************************************************/
+
+#define WAIT_START      0   /* try to acquire */
+#define WAIT_BLOCKED    1   /* back from the wait queue of ob1 */
+#define WAIT_NOTIFIED   2   /* back from the wait queue of a condition */
+
+static PyObject *
+waitable_run(PyCFrameObject *f, PyObject *retval, int stackless)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    PyObject *self = f->ob1;
+    waitable_ops *ops = WAITABLE(self)->ops;
+
+    if (f->n == WAIT_NOTIFIED) {
+        /* re-acquire the lock in any case, and raise afterwards */
+        if (retval == NULL) {
+            f->ob2 = slp_curexc_to_bomb();
+            if (f->ob2 == NULL)
+                goto exit_frame;
+        }
+        else
+            Py_DECREF(retval);
+    }
+    else if (f->n == WAIT_BLOCKED) {
+        if (retval == NULL) {
+            ops->abandon(self, ts->st.current);
+            goto exit_frame;
+        }
+        Py_DECREF(retval);
+        if (ops->woken(self, ts->st.current))
+            goto acquired;
+    }
+
+    while (!ops->acquire(self, ts->st.current)) {
+        f->n = WAIT_BLOCKED;
+        if (WAITABLE(self)->waiters == NULL) {
+            retval = slp_runtime_error("the object has been cleared");
+            goto exit_frame;
+        }
+        retval = slp_channel_wait(WAITABLE(self)->waiters, stackless);
+        if (retval == NULL) {
+            ops->abandon(self, ts->st.current);
+            goto exit_frame;
+        }
+        if (STACKLESS_UNWINDING(retval))
+            return retval;
+        /* was a hard switch */
+        Py_DECREF(retval);
+        if (ops->woken(self, ts->st.current))
+            break;
+    }
+acquired:
+    if (f->i)
+        ((PySlpLockObject *) self)->count = f->i;
+    if (f->ob2 != NULL) {
+        retval = slp_bomb_explode(f->ob2);
+        f->ob2 = NULL;
+    }
+    else {
+        retval = f->ob3;
+        Py_INCREF(retval);
+    }
+exit_frame:
+    /* epilog to return from the frame */
+    ts->frame = f->f_back;
+    Py_DECREF(f);
+    return retval;
+}
+
+PyObject *
+slp_waitable_callback(PyFrameObject *f, int exc, PyObject *retval)
+{
+    return waitable_run((PyCFrameObject *) f, retval, STACKLESS_POSSIBLE());
+}
+
+/*
+ * Push the wait state for self onto the current tasklet.
+ * Returns a borrowed reference.
+ */
+
+static PyCFrameObject *
+waitable_push(PyObject *self, PyObject *result)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    PyCFrameObject *f = slp_cframe_new(slp_waitable_callback, 1);
+
+    if (f == NULL)
+        return NULL;
+    Py_INCREF(self);
+    f->ob1 = self;
+    Py_INCREF(result);
+    f->ob3 = result;
+    f->n = WAIT_START;
+    f->i = 0;
+    ts->frame = (PyFrameObject *) f;
+    return f;
+}
+
+static PyObject *
+waitable_acquire(PyObject *self, int blocking, PyObject *result,
+                 int stackless, char *name)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    PyCFrameObject *f;
+
+    if (ts->st.main == NULL)
+        return PyStackless_CallMethod_Main(self, name, "(i)", blocking);
+    if (WAITABLE(self)->ops->acquire(self, ts->st.current)) {
+        Py_INCREF(result);
+        return result;
+    }
+    if (!blocking)
+        Py_RETURN_FALSE;
+    f = waitable_push(self, result);
+    if (f == NULL)
+        return NULL;
+    return waitable_run(f, NULL, stackless);
+}
+
+static int
+waitable_traverse(PySlpWaitableObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->waiters);
+    return 0;
+}
+
+static int
+waitable_clear(PySlpWaitableObject *self)
+{
+    Py_CLEAR(self->waiters);
+    return 0;
+}
+
+static void
+waitable_dealloc(PySlpWaitableObject *self)
+{
+    PyTypeObject *type = Py_TYPE(self);
+
+    PyObject_GC_UnTrack(self);
+    if (self->weakreflist != NULL)
+        PyObject_ClearWeakRefs((PyObject *) self);
+    /* use the clear function of our own static type */
+    while (type->tp_flags & Py_TPFLAGS_HEAPTYPE)
+        type = type->tp_base;
+    type->tp_clear((PyObject *) self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+waitable_alloc(PyTypeObject *type, waitable_ops *ops)
+{
+    PySlpWaitableObject *self;
+
+    self = (PySlpWaitableObject *) type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+    self->ops = ops;
+    self->weakreflist = NULL;
+    self->waiters = PyChannel_New(NULL);
+    if (self->waiters == NULL) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *) self;
+}
+
+static PyObject *
+waitable_get_waiting(PySlpWaitableObject *self)
+{
+    PyChannelObject *waiters = self->waiters;
+
+    return PyInt_FromLong(waiters != NULL && waiters->balance < 0 ?
+                          -waiters->balance : 0);
+}
+
+
+/*******************************************************************
+
+  lock and rlock
+
+ ******************************************************************/
+
+static int
+lock_acquire_op(PyObject *ob, PyTaskletObject *task)
+{
+    PySlpLockObject *self = (PySlpLockObject *) ob;
+
+    if (self->owner == NULL) {
+        Py_INCREF(task);
+        self->owner = task;
+        self->count = 1;
+        return 1;
+    }
+    if (self->recursive && self->owner == task) {
+        ++self->count;
+        return 1;
+    }
+    return 0;
+}
+
+static int
+lock_woken_op(PyObject *ob, PyTaskletObject *task)
+{
+    return ((PySlpLockObject *) ob)->owner == task;
+}
+
+/* pass the lock on to the first waiter, or unlock it */
+
+static void
+lock_handoff(PySlpLockObject *self)
+{
+    PyTaskletObject *owner = self->owner;
+    PyTaskletObject *next = waitable_wake((PyObject *) self, Py_True);
+
+    Py_XINCREF(next);
+    self->owner = next;
+    self->count = next != NULL;
+    Py_DECREF(owner);
+}
+
+static void
+lock_abandon_op(PyObject *ob, PyTaskletObject *task)
+{
+    PySlpLockObject *self = (PySlpLockObject *) ob;
+
+    if (self->owner == task)
+        lock_handoff(self);
+}
+
+static waitable_ops lock_ops = {
+    lock_acquire_op, lock_woken_op, lock_abandon_op
+};
+
+static PyObject *
+lock_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {NULL};
+    static _PyArg_Parser parser = {":lock", argnames};
+    PySlpLockObject *self;
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
+        return NULL;
+    self = (PySlpLockObject *) waitable_alloc(type, &lock_ops);
+    if (self != NULL) {
+        self->owner = NULL;
+        self->count = 0;
+        self->recursive = PyType_IsSubtype(type, &PySlpRLock_Type);
+    }
+    return (PyObject *) self;
+}
+
+static int
+lock_traverse(PySlpLockObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->owner);
+    return waitable_traverse(WAITABLE(self), visit, arg);
+}
+
+static int
+lock_clear(PySlpLockObject *self)
+{
+    Py_CLEAR(self->owner);
+    self->count = 0;
+    return waitable_clear(WAITABLE(self));
+}
+
+PyDoc_STRVAR(lock_acquire__doc__,
+"acquire([blocking]) -- acquire the lock, blocking the current tasklet\n\
+if necessary. Without blocking, return False if the lock cannot be\n\
+acquired immediately. Returns True when the lock has been acquired.");
+
+static PyObject *
+lock_acquire(PyObject *self, PyObject **args, Py_ssize_t nargs,
+             PyObject *kwds)
+{
+    STACKLESS_GETARG();
+    static const char * const argnames[] = {"blocking", NULL};
+    static _PyArg_Parser parser = {"|i:acquire", argnames};
+    int blocking = 1;
+
+    if ((nargs > 0 || kwds != NULL) &&
+        !_PyArg_ParseStackAndKeywords(args, nargs, kwds, &parser,
+                                      &blocking))
+        return NULL;
+    return waitable_acquire(self, blocking, Py_True, stackless, "acquire");
+}
+
+static PyObject *
+lock_enter(PyObject *self)
+{
+    STACKLESS_GETARG();
+
+    return waitable_acquire(self, 1, Py_True, stackless, "acquire");
+}
+
+static int
+lock_release_impl(PySlpLockObject *self)
+{
+    PyTaskletObject *current = PyThreadState_GET()->st.current;
+
+    if (self->owner == NULL ||
+        (self->recursive && self->owner != current))
+        RUNTIME_ERROR("cannot release un-acquired lock", -1);
+    if (--self->count == 0)
+        lock_handoff(self);
+    return 0;
+}
+
+PyDoc_STRVAR(lock_release__doc__,
+"release() -- release the lock. The first waiting tasklet becomes the\n\
+owner and is scheduled, but the current tasklet continues to run.");
+
+static PyObject *
+lock_release(PySlpLockObject *self)
+{
+    if (lock_release_impl(self))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+lock_exit(PySlpLockObject *self, PyObject *args)
+{
+    return lock_release(self);
+}
+
+PyDoc_STRVAR(lock_locked__doc__,
+"locked() -- return True if the lock is held.");
+
+static PyObject *
+lock_locked(PySlpLockObject *self)
+{
+    return PyBool_FromLong(self->owner != NULL);
+}
+
+static PyObject *
+lock_is_owned(PySlpLockObject *self)
+{
+    return PyBool_FromLong(self->owner != NULL &&
+                           self->owner == PyThreadState_GET()->st.current);
+}
+
+static PyObject *
+lock_get_owner(PySlpLockObject *self)
+{
+    PyObject *ret = self->owner != NULL ? (PyObject *) self->owner : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+#define PCF PyCFunction
+#define METH_FKS METH_FASTCALL | METH_KEYWORDS | METH_STACKLESS
+#define METH_NS METH_NOARGS | METH_STACKLESS
+
+static PyMethodDef lock_methods[] = {
+    {"acquire",         (PCF)lock_acquire,      METH_FKS,
+     lock_acquire__doc__},
+    {"release",         (PCF)lock_release,      METH_NOARGS,
+     lock_release__doc__},
+    {"locked",          (PCF)lock_locked,       METH_NOARGS,
+     lock_locked__doc__},
+    {"_is_owned",       (PCF)lock_is_owned,     METH_NOARGS, NULL},
+    {"__enter__",       (PCF)lock_enter,        METH_NS, NULL},
+    {"__exit__",        (PCF)lock_exit,         METH_VARARGS, NULL},
+    {NULL,              NULL}           /* sentinel */
+};
+
+static PyGetSetDef lock_getsetlist[] = {
+    {"owner",           (getter)lock_get_owner, NULL,
+     "the tasklet which holds the lock, or None."},
+    {"waiting",         (getter)waitable_get_waiting, NULL,
+     "the number of tasklets waiting for the lock."},
+    {0},
+};
+
+PyDoc_STRVAR(lock__doc__,
+"lock() -- a lock which blocks tasklets instead of threads.\n\
+Waiting tasklets acquire the lock in the order they arrived.");
+
+PyDoc_STRVAR(rlock__doc__,
+"rlock() -- a reentrant lock which blocks tasklets instead of threads.\n\
+The tasklet which holds it may acquire it again and must release it\n\
+as often as it acquired it.");
+
+#define WAITABLE_TYPE(typename, name, structname, doc) \
+PyTypeObject typename = { \
+    PyObject_HEAD_INIT(&PyType_Type) \
+    0, \
+    "stackless." name, \
+    sizeof(structname), \
+    0, \
+    (destructor)waitable_dealloc,               /* tp_dealloc */ \
+    0,                                          /* tp_print */ \
+    0,                                          /* tp_getattr */ \
+    0,                                          /* tp_setattr */ \
+    0,                                          /* tp_compare */ \
+    0,                                          /* tp_repr */ \
+    0,                                          /* tp_as_number */ \
+    0,                                          /* tp_as_sequence */ \
+    0,                                          /* tp_as_mapping */ \
+    0,                                          /* tp_hash */ \
+    0,                                          /* tp_call */ \
+    0,                                          /* tp_str */ \
+    PyObject_GenericGetAttr,                    /* tp_getattro */ \
+    PyObject_GenericSetAttr,                    /* tp_setattro */ \
+    0,                                          /* tp_as_buffer */ \
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | \
+        Py_TPFLAGS_BASETYPE,                    /* tp_flags */ \
+    doc,                                        /* tp_doc */ \
+
+
+#define WAITABLE_TYPE_END(typename, prefix) \
+    0,                                          /* tp_richcompare */ \
+    offsetof(PySlpWaitableObject, weakreflist), /* tp_weaklistoffset */ \
+    0,                                          /* tp_iter */ \
+    0,                                          /* tp_iternext */ \
+    prefix##_methods,                           /* tp_methods */ \
+    0,                                          /* tp_members */ \
+    prefix##_getsetlist,                        /* tp_getset */ \
+    0,                                          /* tp_base */ \
+    0,                                          /* tp_dict */ \
+    0,                                          /* tp_descr_get */ \
+    0,                                          /* tp_descr_set */ \
+    0,                                          /* tp_dictoffset */ \
+    0,                                          /* tp_init */ \
+    PyType_GenericAlloc,                        /* tp_alloc */ \
+    prefix##_new,                               /* tp_new */ \
+    PyObject_GC_Del,                            /* tp_free */ \
+};
+
+WAITABLE_TYPE(PySlpLock_Type, "lock", PySlpLockObject, lock__doc__)
+    (traverseproc)lock_traverse,                /* tp_traverse */
+    (inquiry)lock_clear,                        /* tp_clear */
+WAITABLE_TYPE_END(PySlpLock_Type, lock)
+
+WAITABLE_TYPE(PySlpRLock_Type, "rlock", PySlpLockObject, rlock__doc__)
+    (traverseproc)lock_traverse,                /* tp_traverse */
+    (inquiry)lock_clear,                        /* tp_clear */
+WAITABLE_TYPE_END(PySlpRLock_Type, lock)
+
+
+/*******************************************************************
+
+  semaphore
+
+ ******************************************************************/
+
+static int
+semaphore_acquire_op(PyObject *ob, PyTaskletObject *task)
+{
+    PySlpSemaphoreObject *self = (PySlpSemaphoreObject *) ob;
+
+    if (self->value > 0) {
+        --self->value;
+        return 1;
+    }
+    return 0;
+}
+
+static void
+semaphore_abandon_op(PyObject *ob, PyTaskletObject *task)
+{
+    PySlpSemaphoreObject *self = (PySlpSemaphoreObject *) ob;
+
+    /* our wakeup may have been for a unit which is still there */
+    if (self->value > 0)
+        waitable_wake((PyObject *) self, Py_None);
+}
+
+static waitable_ops semaphore_ops = {
+    semaphore_acquire_op, semaphore_acquire_op, semaphore_abandon_op
+};
+
+static PyObject *
+semaphore_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {"value", NULL};
+    static _PyArg_Parser parser = {"|l:semaphore", argnames};
+    PySlpSemaphoreObject *self;
+    long value = 1;
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser, &value))
+        return NULL;
+    if (value < 0)
+        VALUE_ERROR("semaphore initial value must be >= 0", NULL);
+    self = (PySlpSemaphoreObject *) waitable_alloc(type, &semaphore_ops);
+    if (self != NULL)
+        self->value = value;
+    return (PyObject *) self;
+}
+
+PyDoc_STRVAR(semaphore_acquire__doc__,
+"acquire([blocking]) -- decrement the counter, blocking the current\n\
+tasklet while it is zero. Without blocking, return False instead of\n\
+blocking. Returns True when the counter has been decremented.");
+
+#define semaphore_acquire lock_acquire
+#define semaphore_enter lock_enter
+
+PyDoc_STRVAR(semaphore_release__doc__,
+"release() -- increment the counter, and wake up a waiting tasklet.");
+
+static PyObject *
+semaphore_release(PySlpSemaphoreObject *self)
+{
+    ++self->value;
+    waitable_wake((PyObject *) self, Py_None);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+semaphore_exit(PySlpSemaphoreObject *self, PyObject *args)
+{
+    return semaphore_release(self);
+}
+
+static PyObject *
+semaphore_get_value(PySlpSemaphoreObject *self)
+{
+    return PyInt_FromLong(self->value);
+}
+
+static PyMethodDef semaphore_methods[] = {
+    {"acquire",         (PCF)semaphore_acquire, METH_FKS,
+     semaphore_acquire__doc__},
+    {"release",         (PCF)semaphore_release, METH_NOARGS,
+     semaphore_release__doc__},
+    {"__enter__",       (PCF)semaphore_enter,   METH_NS, NULL},
+    {"__exit__",        (PCF)semaphore_exit,    METH_VARARGS, NULL},
+    {NULL,              NULL}           /* sentinel */
+};
+
+static PyGetSetDef semaphore_getsetlist[] = {
+    {"value",           (getter)semaphore_get_value, NULL,
+     "the current value of the counter."},
+    {"waiting",         (getter)waitable_get_waiting, NULL,
+     "the number of tasklets waiting for the semaphore."},
+    {0},
+};
+
+PyDoc_STRVAR(semaphore__doc__,
+"semaphore([value]) -- a counting semaphore for tasklets.\n\
+The counter starts at value, which defaults to 1.");
+
+WAITABLE_TYPE(PySlpSemaphore_Type, "semaphore", PySlpSemaphoreObject,
+              semaphore__doc__)
+    (traverseproc)waitable_traverse,            /* tp_traverse */
+    (inquiry)waitable_clear,                    /* tp_clear */
+WAITABLE_TYPE_END(PySlpSemaphore_Type, semaphore)
+
+
+/*******************************************************************
+
+  event
+
+ ******************************************************************/
+
+static int
+event_acquire_op(PyObject *ob, PyTaskletObject *task)
+{
+    return ((PySlpEventObject *) ob)->flag;
+}
+
+static int
+event_woken_op(PyObject *ob, PyTaskletObject *task)
+{
+    /* set() wakes everybody, even if the flag is cleared again */
+    return 1;
+}
+
+static void
+event_abandon_op(PyObject *ob, PyTaskletObject *task)
+{
+}
+
+static waitable_ops event_ops = {
+    event_acquire_op, event_woken_op, event_abandon_op
+};
+
+static PyObject *
+event_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {NULL};
+    static _PyArg_Parser parser = {":event", argnames};
+    PySlpEventObject *self;
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
+        return NULL;
+    self = (PySlpEventObject *) waitable_alloc(type, &event_ops);
+    if (self != NULL)
+        self->flag = 0;
+    return (PyObject *) self;
+}
+
+PyDoc_STRVAR(event_wait__doc__,
+"wait() -- block the current tasklet until the flag is set.\n\
+Returns True.");
+
+static PyObject *
+event_wait(PyObject *self)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+
+    if (ts->st.main == NULL)
+        return PyStackless_CallMethod_Main(self, "wait", NULL);
+    return waitable_acquire(self, 1, Py_True, stackless, "wait");
+}
+
+PyDoc_STRVAR(event_set__doc__,
+"set() -- set the flag and wake up all waiting tasklets.");
+
+static PyObject *
+event_set(PySlpEventObject *self)
+{
+    self->flag = 1;
+    while (waitable_wake((PyObject *) self, Py_True) != NULL)
+        ;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(event_clear__doc__,
+"clear() -- reset the flag.");
+
+static PyObject *
+event_clear(PySlpEventObject *self)
+{
+    self->flag = 0;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(event_is_set__doc__,
+"is_set() -- return the flag.");
+
+static PyObject *
+event_is_set(PySlpEventObject *self)
+{
+    return PyBool_FromLong(self->flag);
+}
+
+static PyMethodDef event_methods[] = {
+    {"wait",            (PCF)event_wait,        METH_NS,
+     event_wait__doc__},
+    {"set",             (PCF)event_set,         METH_NOARGS,
+     event_set__doc__},
+    {"clear",           (PCF)event_clear,       METH_NOARGS,
+     event_clear__doc__},
+    {"is_set",          (PCF)event_is_set,      METH_NOARGS,
+     event_is_set__doc__},
+    {"isSet",           (PCF)event_is_set,      METH_NOARGS,
+     event_is_set__doc__},
+    {NULL,              NULL}           /* sentinel */
+};
+
+static PyGetSetDef event_getsetlist[] = {
+    {"waiting",         (getter)waitable_get_waiting, NULL,
+     "the number of tasklets waiting for the flag."},
+    {0},
+};
+
+PyDoc_STRVAR(event__doc__,
+"event() -- a flag which tasklets can wait for.");
+
+WAITABLE_TYPE(PySlpEvent_Type, "event", PySlpEventObject, event__doc__)
+    (traverseproc)waitable_traverse,            /* tp_traverse */
+    (inquiry)waitable_clear,                    /* tp_clear */
+WAITABLE_TYPE_END(PySlpEvent_Type, event)
+
+
+/*******************************************************************
+
+  condition
+
+  wait() releases the lock completely, blocks in the wait queue of the
+  condition and then acquires the lock again through the wait loop,
+  restoring the recursion count of an rlock.
+
+ ******************************************************************/
+
+static int
+condition_acquire_op(PyObject *ob, PyTaskletObject *task)
+{
+    /* nobody waits for the condition itself without notify() */
+    return 0;
+}
+
+static waitable_ops condition_ops = {
+    condition_acquire_op, event_woken_op, event_abandon_op
+};
+
+static PyObject *
+condition_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {"lock", NULL};
+    static _PyArg_Parser parser = {"|O:condition", argnames};
+    PySlpConditionObject *self;
+    PyObject *lock = NULL;
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser, &lock))
+        return NULL;
+    if (lock == NULL || lock == Py_None) {
+        lock = PyObject_CallObject((PyObject *) &PySlpRLock_Type, NULL);
+        if (lock == NULL)
+            return NULL;
+    }
+    else if (PyObject_TypeCheck(lock, &PySlpLock_Type) ||
+             PyObject_TypeCheck(lock, &PySlpRLock_Type))
+        Py_INCREF(lock);
+    else
+        TYPE_ERROR("condition needs a stackless lock or rlock", NULL);
+    self = (PySlpConditionObject *) waitable_alloc(type, &condition_ops);
+    if (self == NULL) {
+        Py_DECREF(lock);
+        return NULL;
+    }
+    self->lock = (PySlpLockObject *) lock;
+    return (PyObject *) self;
+}
+
+static int
+condition_traverse(PySlpConditionObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->lock);
+    return waitable_traverse(WAITABLE(self), visit, arg);
+}
+
+static int
+condition_clear(PySlpConditionObject *self)
+{
+    Py_CLEAR(self->lock);
+    return waitable_clear(WAITABLE(self));
+}
+
+static PyObject *
+condition_acquire(PySlpConditionObject *self, PyObject **args,
+                  Py_ssize_t nargs, PyObject *kwds)
+{
+    STACKLESS_GETARG();
+    PyObject *ret;
+
+    STACKLESS_PROMOTE_ALL();
+    ret = lock_acquire((PyObject *) self->lock, args, nargs, kwds);
+    STACKLESS_ASSERT();
+    return ret;
+}
+
+static PyObject *
+condition_enter(PySlpConditionObject *self)
+{
+    STACKLESS_GETARG();
+
+    return waitable_acquire((PyObject *) self->lock, 1, Py_True, stackless,
+                            "acquire");
+}
+
+static PyObject *
+condition_release(PySlpConditionObject *self)
+{
+    return lock_release(self->lock);
+}
+
+static PyObject *
+condition_exit(PySlpConditionObject *self, PyObject *args)
+{
+    return lock_exit(self->lock, args);
+}
+
+PyDoc_STRVAR(condition_wait__doc__,
+"wait() -- release the lock, block the current tasklet until it is\n\
+notified, and acquire the lock again. The lock must be held.");
+
+static PyObject *
+condition_wait(PySlpConditionObject *self)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PySlpLockObject *lock = self->lock;
+    PyCFrameObject *f;
+    PyObject *retval;
+
+    if (ts->st.main == NULL)
+        return PyStackless_CallMethod_Main((PyObject *) self, "wait", NULL);
+    if (lock == NULL || lock->owner != ts->st.current)
+        RUNTIME_ERROR("cannot wait on un-acquired lock", NULL);
+    f = waitable_push((PyObject *) lock, Py_None);
+    if (f == NULL)
+        return NULL;
+    f->n = WAIT_NOTIFIED;
+    f->i = lock->recursive ? lock->count : 0;
+    lock_handoff(lock);
+    if (self->waiters == NULL)
+        retval = slp_runtime_error("the object has been cleared");
+    else
+        retval = slp_channel_wait(self->waiters, stackless);
+    if (STACKLESS_UNWINDING(retval))
+        return retval;
+    /* was a hard switch, or we could not block */
+    return waitable_run(f, retval, stackless);
+}
+
+PyDoc_STRVAR(condition_notify__doc__,
+"notify([n]) -- wake up at most n tasklets waiting for the condition.\n\
+n defaults to 1. The lock must be held.");
+
+static PyObject *
+condition_notify(PySlpConditionObject *self, PyObject *args)
+{
+    PyTaskletObject *current = PyThreadState_GET()->st.current;
+    Py_ssize_t n = 1;
+
+    if (!PyArg_ParseTuple(args, "|n:notify", &n))
+        return NULL;
+    if (self->lock == NULL || self->lock->owner != current)
+        RUNTIME_ERROR("cannot notify on un-acquired lock", NULL);
+    while (n-- > 0 && waitable_wake((PyObject *) self, Py_None) != NULL)
+        ;
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(condition_notify_all__doc__,
+"notify_all() -- wake up all tasklets waiting for the condition.\n\
+The lock must be held.");
+
+static PyObject *
+condition_notify_all(PySlpConditionObject *self)
+{
+    PyTaskletObject *current = PyThreadState_GET()->st.current;
+
+    if (self->lock == NULL || self->lock->owner != current)
+        RUNTIME_ERROR("cannot notify on un-acquired lock", NULL);
+    while (waitable_wake((PyObject *) self, Py_None) != NULL)
+        ;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+condition_get_lock(PySlpConditionObject *self)
+{
+    PyObject *ret = self->lock != NULL ? (PyObject *) self->lock : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyMethodDef condition_methods[] = {
+    {"acquire",         (PCF)condition_acquire, METH_FKS,
+     lock_acquire__doc__},
+    {"release",         (PCF)condition_release, METH_NOARGS,
+     lock_release__doc__},
+    {"wait",            (PCF)condition_wait,    METH_NS,
+     condition_wait__doc__},
+    {"notify",          (PCF)condition_notify,  METH_VARARGS,
+     condition_notify__doc__},
+    {"notify_all",      (PCF)condition_notify_all, METH_NOARGS,
+     condition_notify_all__doc__},
+    {"notifyAll",       (PCF)condition_notify_all, METH_NOARGS,
+     condition_notify_all__doc__},
+    {"__enter__",       (PCF)condition_enter,   METH_NS, NULL},
+    {"__exit__",        (PCF)condition_exit,    METH_VARARGS, NULL},
+    {NULL,              NULL}           /* sentinel */
+};
+
+static PyGetSetDef condition_getsetlist[] = {
+    {"lock",            (getter)condition_get_lock, NULL,
+     "the underlying lock."},
+    {"waiting",         (getter)waitable_get_waiting, NULL,
+     "the number of tasklets waiting to be notified."},
+    {0},
+};
+
+PyDoc_STRVAR(condition__doc__,
+"condition([lock]) -- a condition variable for tasklets.\n\
+lock must be a stackless lock or rlock. A new rlock is used by default.");
+
+WAITABLE_TYPE(PySlpCondition_Type, "condition", PySlpConditionObject,
+              condition__doc__)
+    (traverseproc)condition_traverse,           /* tp_traverse */
+    (inquiry)condition_clear,                   /* tp_clear */
+WAITABLE_TYPE_END(PySlpCondition_Type, condition)
+
+
+DEF_INVALID_EXEC(slp_waitable_callback)
+
+int init_locktypes(void)
+{
+    if (0
+        || PyType_Ready(&PySlpLock_Type)
+        || PyType_Ready(&PySlpRLock_Type)
+        || PyType_Ready(&PySlpSemaphore_Type)
+        || PyType_Ready(&PySlpEvent_Type)
+        || PyType_Ready(&PySlpCondition_Type)
+        )
+        return -1;
+    return slp_register_execute(&PyCFrame_Type, "slp_waitable_callback",
+                                slp_waitable_callback,
+                                REF_INVALID_EXEC(slp_waitable_callback));
+}
+#endif
@@ -0,0 +1,10 @@
+PyAPI_DATA(PyTypeObject) PySlpLock_Type;
+PyAPI_DATA(PyTypeObject) PySlpRLock_Type;
+PyAPI_DATA(PyTypeObject) PySlpSemaphore_Type;
+PyAPI_DATA(PyTypeObject) PySlpEvent_Type;
+PyAPI_DATA(PyTypeObject) PySlpCondition_Type;
+
+int init_locktypes(void);
+
+PyObject * slp_waitable_callback(struct _frame *f, int throwflag,
+                                 PyObject *retval);
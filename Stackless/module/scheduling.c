@@ -77,7 +77,8 @@ new_bomb(void)
 static PyObject *
 bomb_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    static char *kwlist[] = {"type", "value", "traceback", NULL};
+    static const char * const kwlist[] = {"type", "value", "traceback", NULL};
+    static _PyArg_Parser parser = {"|OOO:bomb", kwlist};
     PyBombObject *bomb = new_bomb();
 
     if (bomb == NULL)
@@ -86,10 +87,10 @@ bomb_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     if (PyTuple_GET_SIZE(args) == 1 &&
         PyTuple_Check(PyTuple_GET_ITEM(args, 0)))
         args = PyTuple_GET_ITEM(args, 0);
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOO:bomb", kwlist,
-                                     &bomb->curexc_type,
-                                     &bomb->curexc_value,
-                                     &bomb->curexc_traceback)) {
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser,
+                                          &bomb->curexc_type,
+                                          &bomb->curexc_value,
+                                          &bomb->curexc_traceback)) {
         Py_DECREF(bomb);
         return NULL;
     }
@@ -583,6 +584,9 @@ static int schedule_thread_unblock(PyThreadState *nts)
 {
     if (nts->st.thread.is_blocked) {
         nts->st.thread.is_blocked = 0;
+        /* let the woken thread ask for the GIL without waiting for
+           the switch interval, see Python/ceval_gil.h */
+        slp_gil_handoff(nts);
         release_lock(nts->st.thread.block_lock);
     }
     return 0;
@@ -1058,6 +1062,10 @@ tasklet_end(PyObject *retval)
             slp_transfer_return(ts->st.initial_stub);
     }
 
+    /* leave the tasklet group, waking up its joiners if we were the last */
+    if (task->group != NULL)
+        slp_taskletgroup_discard(task);
+
     /* remove from runnables */
     slp_current_remove();
 
@@ -10,6 +10,9 @@
 #include "core/cframeobject.h"
 #include "taskletobject.h"
 #include "channelobject.h"
+#include "taskletgroupobject.h"
+#include "futureobject.h"
+#include "lockobject.h"
 #include "pickling/prickelpit.h"
 #include "core/stackless_methods.h"
 #include "pythread.h"
@@ -85,15 +88,17 @@ PyStackless_Schedule_nr(PyObject *retval, int remove)
 }
 
 static PyObject *
-schedule_generic(PyObject *self, PyObject *args, PyObject *kwds, int remove)
+schedule_generic(PyObject **args, Py_ssize_t nargs, PyObject *kwds,
+                 int remove)
 {
     STACKLESS_GETARG();
     PyObject *retval = (PyObject *) PyThreadState_GET()->st.current;
-    static char *argnames[] = {"retval", NULL};
+    static const char * const argnames[] = {"retval", NULL};
+    static _PyArg_Parser parser = {"|O:schedule", argnames};
 
-    if (PyTuple_GET_SIZE(args) > 0) {
-        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O:schedule",
-                                         argnames, &retval))
+    if (nargs > 0 || kwds != NULL) {
+        if (!_PyArg_ParseStackAndKeywords(args, nargs, kwds, &parser,
+                                          &retval))
             return NULL;
     }
     STACKLESS_PROMOTE_ALL();
@@ -101,15 +106,16 @@ schedule_generic(PyObject *self, PyObject *args, PyObject *kwds, int remove)
 }
 
 static PyObject *
-schedule(PyObject *self, PyObject *args, PyObject *kwds)
+schedule(PyObject *self, PyObject **args, Py_ssize_t nargs, PyObject *kwds)
 {
-    return schedule_generic(self, args, kwds, 0);
+    return schedule_generic(args, nargs, kwds, 0);
 }
 
 static PyObject *
-schedule_remove(PyObject *self, PyObject *args, PyObject *kwds)
+schedule_remove(PyObject *self, PyObject **args, Py_ssize_t nargs,
+                PyObject *kwds)
 {
-    return schedule_generic(self, args, kwds, 1);
+    return schedule_generic(args, nargs, kwds, 1);
 }
 
 
@@ -291,15 +297,13 @@ PyStackless_RunWatchdog(long timeout)
 }
 
 
-PyObject *
-PyStackless_RunWatchdogEx(long timeout, int flags)
+static PyObject *
+watchdog_run(long timeout, int flags, PyObject * (*interrupt)(void))
 {
     PyThreadState *ts = PyThreadState_GET();
     PyTaskletObject *victim;
     PyObject *retval;
 
-    if (ts->st.main == NULL)
-        return PyStackless_RunWatchdog_M(timeout, flags);
     if (ts->st.current != ts->st.main)
         RUNTIME_ERROR(
             "run() must be run from the main tasklet.",
@@ -308,7 +312,7 @@ PyStackless_RunWatchdogEx(long timeout, int flags)
     if (timeout <= 0)
         ts->st.interrupt = NULL;
     else
-        ts->st.interrupt = interrupt_timeout_return;
+        ts->st.interrupt = interrupt;
 
     ts->st.ticker = ts->st.interval = timeout;
 
@@ -349,12 +353,23 @@ PyStackless_RunWatchdogEx(long timeout, int flags)
         Py_RETURN_NONE;
 }
 
+PyObject *
+PyStackless_RunWatchdogEx(long timeout, int flags)
+{
+    PyThreadState *ts = PyThreadState_GET();
+
+    if (ts->st.main == NULL)
+        return PyStackless_RunWatchdog_M(timeout, flags);
+    return watchdog_run(timeout, flags, interrupt_timeout_return);
+}
+
 static PyObject *
-run_watchdog(PyObject *self, PyObject *args, PyObject *kwds)
+run_watchdog(PyObject *self, PyObject **args, Py_ssize_t nargs, PyObject *kwds)
 {
-    static char *argnames[] = {"timeout", "threadblock", "soft",
-                                                            "ignore_nesting", "totaltimeout",
-                                                            NULL};
+    static const char * const argnames[] = {"timeout", "threadblock", "soft",
+                                            "ignore_nesting", "totaltimeout",
+                                            NULL};
+    static _PyArg_Parser parser = {"|liiii:run_watchdog", argnames};
     long timeout = 0;
     int threadblock = 0;
     int soft = 0;
@@ -362,9 +377,9 @@ run_watchdog(PyObject *self, PyObject *args, PyObject *kwds)
     int totaltimeout = 0;
     int flags;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|liiii:run_watchdog",
-                                     argnames, &timeout, &threadblock, &soft,
-                                     &ignore_nesting, &totaltimeout))
+    if (!_PyArg_ParseStackAndKeywords(args, nargs, kwds, &parser,
+                                      &timeout, &threadblock, &soft,
+                                      &ignore_nesting, &totaltimeout))
         return NULL;
     flags = threadblock ? Py_WATCHDOG_THREADBLOCK : 0;
     flags |= soft ? PY_WATCHDOG_SOFT : 0;
@@ -373,6 +388,330 @@ run_watchdog(PyObject *self, PyObject *args, PyObject *kwds)
     return PyStackless_RunWatchdogEx(timeout, flags);
 }
 
+/******************************************************
+
+  host loop support
+
+ ******************************************************/
+
+/*
+ * run_host() lets an embedding application drive the scheduler from
+ * its own event loop. The time budget is checked softly, every
+ * HOST_CHECK_TICKS opcodes, so no tasklet is interrupted: main is
+ * revived at the next switch, and the others stay runnable for the
+ * next call. That switch happens anyway, so it may go to main at any
+ * nesting level; otherwise hard switched tasklets, which always run
+ * nested, would pass the interrupt on forever. The sleepers of a
+ * thread are kept in ts->st.sleepers, sorted by deadline. Each entry
+ * is a (deadline, tasklet) tuple, and the deadline object is also the
+ * sleeping tasklet's tempval, which tells a due sleeper from a tasklet
+ * that has been woken otherwise.
+ */
+
+#define HOST_CHECK_TICKS 1000
+
+static PyObject *
+interrupt_host_deadline(void)
+{
+    PyThreadState *ts = PyThreadState_GET();
+
+    if (slp_clock() < ts->st.host_deadline) {
+        ts->st.ticker = ts->st.interval;
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return interrupt_timeout_return();
+}
+
+static int
+sleeper_waiting(PyObject *entry)
+{
+    PyTaskletObject *task = (PyTaskletObject *) PyTuple_GET_ITEM(entry, 1);
+
+    return task->tempval == PyTuple_GET_ITEM(entry, 0) &&
+           task->next == NULL && !task->flags.blocked &&
+           task->f.frame != NULL;
+}
+
+#define SLEEPER_DEADLINE(entry) PyFloat_AS_DOUBLE(PyTuple_GET_ITEM(entry, 0))
+
+/* wake the sleepers which are due, and drop stale entries in front */
+
+static int
+host_wake_sleepers(PyThreadState *ts, double now)
+{
+    PyObject *sleepers = ts->st.sleepers;
+    Py_ssize_t i, n;
+
+    if (sleepers == NULL)
+        return 0;
+    n = PyList_GET_SIZE(sleepers);
+    for (i = 0; i < n; ++i) {
+        PyObject *entry = PyList_GET_ITEM(sleepers, i);
+
+        if (!sleeper_waiting(entry))
+            continue;
+        if (SLEEPER_DEADLINE(entry) > now)
+            break;
+        if (PyStackless_Wakeup(
+            (PyTaskletObject *) PyTuple_GET_ITEM(entry, 1), Py_None))
+            return -1;
+    }
+    return PyList_SetSlice(sleepers, 0, i, NULL);
+}
+
+/* the deadline of the first sleeper, or -1.0 */
+
+static double
+host_next_deadline(PyThreadState *ts)
+{
+    PyObject *sleepers = ts->st.sleepers;
+
+    if (sleepers == NULL || PyList_GET_SIZE(sleepers) == 0)
+        return -1.0;
+    return SLEEPER_DEADLINE(PyList_GET_ITEM(sleepers, 0));
+}
+
+int
+PyStackless_Wakeup(PyTaskletObject *task, PyObject *value)
+{
+    PyThreadState *ts;
+
+    if (value == NULL)
+        value = Py_None;
+    if (task->next != NULL || task->flags.blocked || task->cstate == NULL ||
+        task->cstate->tstate == NULL || task->f.frame == NULL)
+        RUNTIME_ERROR("tasklet is not waiting for a wake-up", -1);
+    ts = task->cstate->tstate;
+    if (task == ts->st.main)
+        RUNTIME_ERROR("the main tasklet cannot be woken up", -1);
+    TASKLET_SETVAL(task, value);
+    Py_INCREF(task);
+    slp_current_insert(task);
+    if (ts != PyThreadState_GET())
+        slp_thread_unblock(ts);
+    return 0;
+}
+
+PyDoc_STRVAR(wakeup__doc__,
+"wakeup(task, value=None) -- make a tasklet runnable which has removed\n\
+itself with schedule_remove() or sleeps in sleep(). That call returns\n\
+value when the tasklet continues.");
+
+static PyObject *
+wakeup(PyObject *self, PyObject *args)
+{
+    PyObject *task, *value = Py_None;
+
+    if (!PyArg_ParseTuple(args, "O!|O:wakeup", &PyTasklet_Type, &task,
+                          &value))
+        return NULL;
+    if (PyStackless_Wakeup((PyTaskletObject *) task, value))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+PyStackless_Sleep_M(double seconds)
+{
+    return PyStackless_CallMethod_Main(slp_module, "sleep", "(d)", seconds);
+}
+
+PyObject *
+PyStackless_Sleep(double seconds)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PyObject *deadline, *entry, *ret;
+    Py_ssize_t lo, hi, mid;
+    double d;
+
+    if (ts->st.main == NULL) return PyStackless_Sleep_M(seconds);
+    if (ts->st.current == ts->st.main)
+        RUNTIME_ERROR("the main tasklet cannot sleep", NULL);
+    if (ts->st.sleepers == NULL &&
+        (ts->st.sleepers = PyList_New(0)) == NULL)
+        return NULL;
+    d = slp_clock() + (seconds > 0.0 ? seconds : 0.0);
+    if ((deadline = PyFloat_FromDouble(d)) == NULL)
+        return NULL;
+    entry = PyTuple_Pack(2, deadline, ts->st.current);
+    if (entry == NULL) {
+        Py_DECREF(deadline);
+        return NULL;
+    }
+    /* equal deadlines are woken in the order they were set */
+    lo = 0;
+    hi = PyList_GET_SIZE(ts->st.sleepers);
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (SLEEPER_DEADLINE(PyList_GET_ITEM(ts->st.sleepers, mid)) <= d)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (PyList_Insert(ts->st.sleepers, lo, entry)) {
+        Py_DECREF(entry);
+        Py_DECREF(deadline);
+        return NULL;
+    }
+    Py_DECREF(entry);
+    if (d < ts->st.host_deadline)
+        ts->st.host_deadline = d;
+    STACKLESS_PROMOTE_ALL();
+    ret = PyStackless_Schedule(deadline, 1);
+    STACKLESS_ASSERT();
+    Py_DECREF(deadline);
+    return ret;
+}
+
+PyDoc_STRVAR(sleep__doc__,
+"sleep(seconds) -- remove the current tasklet from the runnables until\n\
+run_host() finds that seconds have passed, or until it is woken with\n\
+wakeup(), whose value is returned.");
+
+static PyObject *
+stackless_sleep(PyObject *self, PyObject *seconds)
+{
+    STACKLESS_GETARG();
+    double d = PyFloat_AsDouble(seconds);
+    PyObject *ret;
+
+    if (d == -1.0 && PyErr_Occurred())
+        return NULL;
+    STACKLESS_PROMOTE_ALL();
+    ret = PyStackless_Sleep(d);
+    STACKLESS_ASSERT();
+    return ret;
+}
+
+static int
+host_parse_timer(PyObject *o, void *p)
+{
+    double *d = (double *) p;
+
+    if (o == Py_None) {
+        *d = -1.0;
+        return 1;
+    }
+    *d = PyFloat_AsDouble(o);
+    return !(*d == -1.0 && PyErr_Occurred());
+}
+
+static int
+PyStackless_RunHost_M(double budget, double *next_timer)
+{
+    PyObject *ret;
+    int status;
+    double d = -1.0;
+
+    ret = PyStackless_CallMethod_Main(slp_module, "run_host", "(d)", budget);
+    if (ret == NULL)
+        return -1;
+    if (!PyArg_ParseTuple(ret, "iO&", &status, host_parse_timer, &d))
+        status = -1;
+    else if (next_timer != NULL)
+        *next_timer = d;
+    Py_DECREF(ret);
+    return status;
+}
+
+int
+PyStackless_RunHost(double budget, double *next_timer)
+{
+    PyThreadState *ts = PyThreadState_GET();
+    double now = slp_clock();
+    double end = budget > 0.0 ? now + budget : -1.0;
+    double next;
+    PyObject *retval;
+    int status;
+
+    if (ts->st.main == NULL)
+        return PyStackless_RunHost_M(budget, next_timer);
+    if (ts->st.current != ts->st.main)
+        RUNTIME_ERROR("run_host() must be run from the main tasklet.", -1);
+
+    for (;;) {
+        if (host_wake_sleepers(ts, now))
+            return -1;
+        if (ts->st.runcount == 1) {
+            status = PY_HOSTRUN_IDLE;
+            break;
+        }
+        if (end >= 0.0 && now >= end) {
+            status = PY_HOSTRUN_BUDGET;
+            break;
+        }
+        /*
+         * come back when the budget expires or the next sleeper is due.
+         * PyStackless_Sleep moves the deadline up for new sleepers.
+         */
+        next = host_next_deadline(ts);
+        if (next < 0.0 || (end >= 0.0 && end < next))
+            next = end;
+        ts->st.host_deadline = next >= 0.0 ? next : Py_HUGE_VAL;
+        retval = watchdog_run(HOST_CHECK_TICKS,
+                              PY_WATCHDOG_SOFT | PY_WATCHDOG_TOTALTIMEOUT |
+                              PY_WATCHDOG_IGNORE_NESTING,
+                              interrupt_host_deadline);
+        if (retval == NULL)
+            return -1;
+        Py_DECREF(retval);
+        now = slp_clock();
+    }
+    if (next_timer != NULL) {
+        next = host_next_deadline(ts);
+        *next_timer = next < 0.0 ? -1.0 : next > now ? next - now : 0.0;
+    }
+    return status;
+}
+
+PyDoc_STRVAR(run_host__doc__,
+"run_host(budget=0.0) -- run tasklets until none is runnable, or until\n\
+budget seconds have passed, if budget is not 0. Sleepers are woken when\n\
+they are due. Tasklets are not interrupted: when the budget expires,\n\
+run_host() returns at the next tasklet switch.\n\
+Returns a tuple (status, next_timer), where status is 0 if the\n\
+scheduler went idle and 1 if the budget expired, and next_timer is the\n\
+time in seconds until the next sleeper is due, or None.\n\
+This function must be called from the main tasklet only.");
+
+static PyObject *
+run_host(PyObject *self, PyObject *args)
+{
+    double budget = 0.0, next_timer;
+    int status;
+
+    if (!PyArg_ParseTuple(args, "|d:run_host", &budget))
+        return NULL;
+    status = PyStackless_RunHost(budget, &next_timer);
+    if (status < 0)
+        return NULL;
+    if (next_timer < 0.0)
+        return Py_BuildValue("(iO)", status, Py_None);
+    return Py_BuildValue("(id)", status, next_timer);
+}
+
+PyDoc_STRVAR(wait_all__doc__,
+"wait_all(futures) -- block the current tasklet until all futures of\n\
+the sequence are resolved. The results are fetched with result().");
+
+static PyObject *
+wait_all(PyObject *self, PyObject *futures)
+{
+    return PyFuture_WaitAll(futures);
+}
+
+PyDoc_STRVAR(wait_any__doc__,
+"wait_any(futures) -- block the current tasklet until any future of\n\
+the sequence is resolved, and return that future.");
+
+static PyObject *
+wait_any(PyObject *self, PyObject *futures)
+{
+    return PyFuture_WaitAny(futures);
+}
+
 PyDoc_STRVAR(get_thread_info__doc__,
 "get_thread_info(thread_id) -- return a 3-tuple of the thread's\n\
 main tasklet, current tasklet and runcount.\n\
@@ -437,16 +776,17 @@ This can be used to measure the execution time of 1.000.000 switches.");
 
 static
 PyObject *
-test_cframe(PyObject *self, PyObject *args, PyObject *kwds)
+test_cframe(PyObject *self, PyObject **args, Py_ssize_t nargs, PyObject *kwds)
 {
-    static char *argnames[] = {"switches", "words", NULL};
+    static const char * const argnames[] = {"switches", "words", NULL};
+    static _PyArg_Parser parser = {"l|l:test_cframe", argnames};
     long switches, extra = 0;
     long i;
     PyObject *ret = Py_None;
 
     Py_INCREF(ret);
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "l|l:test_cframe",
-                                     argnames, &switches, &extra))
+    if (!_PyArg_ParseStackAndKeywords(args, nargs, kwds, &parser,
+                                      &switches, &extra))
         return NULL;
         if (extra < 0 || extra > STACK_MAX_USEFUL)
             VALUE_ERROR(
@@ -549,15 +889,17 @@ exit_test_cframe_nr_loop:
 
 static
 PyObject *
-test_cframe_nr(PyObject *self, PyObject *args, PyObject *kwds)
+test_cframe_nr(PyObject *self, PyObject **args, Py_ssize_t nargs,
+               PyObject *kwds)
 {
-    static char *argnames[] = {"switches", NULL};
+    static const char * const argnames[] = {"switches", NULL};
+    static _PyArg_Parser parser = {"l:test_cframe_nr", argnames};
     PyThreadState *ts = PyThreadState_GET();
     PyCFrameObject *cf;
     long switches;
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "l:test_cframe_nr",
-                                     argnames, &switches))
+    if (!_PyArg_ParseStackAndKeywords(args, nargs, kwds, &parser,
+                                      &switches))
         return NULL;
     cf = slp_cframe_new(test_cframe_nr_loop, 1);
     if (cf == NULL)
@@ -869,14 +1211,16 @@ PyDoc_STRVAR(_gc_untrack__doc__,
 /* List of functions defined in the module */
 
 #define PCF PyCFunction
-#define METH_KS METH_KEYWORDS | METH_STACKLESS
+#define METH_OS METH_O | METH_STACKLESS
+#define METH_FK METH_FASTCALL | METH_KEYWORDS
+#define METH_FKS METH_FASTCALL | METH_KEYWORDS | METH_STACKLESS
 
 static PyMethodDef stackless_methods[] = {
-    {"schedule",                    (PCF)schedule,              METH_KS,
+    {"schedule",                    (PCF)schedule,              METH_FKS,
      schedule__doc__},
-    {"schedule_remove",             (PCF)schedule_remove,       METH_KS,
+    {"schedule_remove",             (PCF)schedule_remove,       METH_FKS,
      schedule__doc__},
-    {"run",                         (PCF)run_watchdog,          METH_KEYWORDS,
+    {"run",                         (PCF)run_watchdog,          METH_FK,
      run_watchdog__doc__},
     {"getruncount",                 (PCF)getruncount,           METH_NOARGS,
      getruncount__doc__},
@@ -888,9 +1232,9 @@ static PyMethodDef stackless_methods[] = {
      getmain__doc__},
     {"enable_softswitch",           (PCF)enable_softswitch,     METH_O,
      enable_soft__doc__},
-    {"test_cframe",                 (PCF)test_cframe,           METH_KEYWORDS,
+    {"test_cframe",                 (PCF)test_cframe,           METH_FK,
      test_cframe__doc__},
-    {"test_cframe_nr",              (PCF)test_cframe_nr,        METH_KEYWORDS,
+    {"test_cframe_nr",              (PCF)test_cframe_nr,        METH_FK,
     test_cframe_nr__doc__},
     {"test_outside",                (PCF)test_outside,          METH_NOARGS,
     test_outside__doc__},
@@ -904,6 +1248,16 @@ static PyMethodDef stackless_methods[] = {
      slp_pickle_moduledict__doc__},
     {"get_thread_info",             (PCF)get_thread_info,       METH_VARARGS,
      get_thread_info__doc__},
+    {"run_host",                    (PCF)run_host,              METH_VARARGS,
+     run_host__doc__},
+    {"sleep",                       (PCF)stackless_sleep,       METH_OS,
+     sleep__doc__},
+    {"wakeup",                      (PCF)wakeup,                METH_VARARGS,
+     wakeup__doc__},
+    {"wait_all",                    (PCF)wait_all,              METH_OS,
+     wait_all__doc__},
+    {"wait_any",                    (PCF)wait_any,              METH_OS,
+     wait_any__doc__},
     {"_gc_untrack",                 (PCF)_gc_untrack,           METH_O,
     _gc_untrack__doc__},
     {"_gc_track",                   (PCF)_gc_track,             METH_O,
@@ -1034,19 +1388,30 @@ static PyObject *
 slpmodule_getuncollectables(PySlpModuleObject *mod, void *context)
 {
     PyObject *lis = PyList_New(0);
-    PyCStackObject *cst = slp_cstack_chain;
+    PyInterpreterState *interp;
+    PyThreadState *ts;
+    PyCStackObject *cst;
 
     if (lis == NULL)
         return NULL;
-    do {
-        if (cst->task != NULL) {
-            if (PyList_Append(lis, (PyObject *) cst->task)) {
-                Py_DECREF(lis);
-                return NULL;
-            }
+    for (interp = PyInterpreterState_Head(); interp != NULL;
+         interp = PyInterpreterState_Next(interp)) {
+        for (ts = PyInterpreterState_ThreadHead(interp); ts != NULL;
+             ts = PyThreadState_Next(ts)) {
+            cst = ts->st.cstack_chain;
+            if (cst == NULL)
+                continue;
+            do {
+                if (cst->task != NULL) {
+                    if (PyList_Append(lis, (PyObject *) cst->task)) {
+                        Py_DECREF(lis);
+                        return NULL;
+                    }
+                }
+                cst = cst->next;
+            } while (cst != ts->st.cstack_chain);
         }
-        cst = cst->next;
-    } while (cst != slp_cstack_chain);
+    }
     return lis;
 }
 
@@ -1191,6 +1556,9 @@ _PyStackless_InitTypes(void)
         || init_flextype()
         || init_tasklettype()
         || init_channeltype()
+        || init_taskletgrouptype()
+        || init_locktypes()
+        || init_futuretype()
         )
         return 0;
     return -1;
@@ -1244,6 +1612,13 @@ _PyStackless_Init(void)
     INSERT("bomb",          &PyBomb_Type);
     INSERT("tasklet",   &PyTasklet_Type);
     INSERT("channel",   &PyChannel_Type);
+    INSERT("taskletgroup", &PyTaskletGroup_Type);
+    INSERT("lock",      &PySlpLock_Type);
+    INSERT("rlock",     &PySlpRLock_Type);
+    INSERT("semaphore", &PySlpSemaphore_Type);
+    INSERT("condition", &PySlpCondition_Type);
+    INSERT("event",     &PySlpEvent_Type);
+    INSERT("future",    &PyFuture_Type);
     INSERT("stackless", slp_module);
 
     m = (PySlpModuleObject *) slp_module;
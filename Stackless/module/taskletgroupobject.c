@@ -0,0 +1,478 @@
+/******************************************************
+
+  The Tasklet Group
+
+ ******************************************************/
+
+#include "Python.h"
+
+#ifdef STACKLESS
+#include "core/stackless_impl.h"
+#include "taskletgroupobject.h"
+
+/*
+ * A tasklet group keeps a reference to each of its members.
+ * The members are chained through their group_next/group_prev
+ * fields, so that joining and leaving a group costs no allocation.
+ * A tasklet leaves its group when it ends (see tasklet_end), and
+ * the tasklets blocked in join() are woken up when the last member
+ * has left.
+ */
+
+static void
+taskletgroup_unlink(PyTaskletGroupObject *group, PyTaskletObject *task)
+{
+    PyTaskletObject **chain = &group->members;
+    PyTaskletObject *hold = group->members, *ret;
+
+    assert(task->group == group);
+    *chain = task;
+    SLP_CHAIN_REMOVE(PyTaskletObject, chain, ret, group_next, group_prev);
+    if (hold != task)
+        *chain = hold;
+    task->group = NULL;
+    --group->count;
+}
+
+/* called by tasklet_end. Must not run any Python code. */
+
+void
+slp_taskletgroup_discard(PyTaskletObject *task)
+{
+    PyTaskletGroupObject *group = task->group;
+
+    taskletgroup_unlink(group, task);
+    if (group->count == 0 && group->waiters != NULL)
+        while (slp_channel_wake(group->waiters, Py_None) != NULL)
+            ;
+    Py_DECREF(task);
+}
+
+/*
+ * Drop the members which died without passing tasklet_end, for instance
+ * tasklets of a thread which has gone away.
+ */
+
+static int
+taskletgroup_member_alive(PyTaskletObject *task)
+{
+    PyThreadState *ts = task->cstate->tstate;
+
+    /* a tasklet which outlived the main thread is dead */
+    if (ts == NULL)
+        return 0;
+    /* like slp_get_frame, but also valid for other threads */
+    if (ts->st.current == task)
+        return ts == PyThreadState_GET() ? ts->frame != NULL : 1;
+    return task->f.frame != NULL;
+}
+
+static void
+taskletgroup_prune(PyTaskletGroupObject *group)
+{
+    Py_ssize_t i, n = group->count;
+
+    for (i = 0; i < n; ++i) {
+        PyTaskletObject *t = group->members;
+
+        group->members = t->group_next;
+        if (!taskletgroup_member_alive(t))
+            slp_taskletgroup_discard(t);
+    }
+}
+
+PyTaskletGroupObject *
+PyTaskletGroup_New(PyTypeObject *type)
+{
+    PyTaskletGroupObject *group;
+
+    if (type == NULL)
+        type = &PyTaskletGroup_Type;
+    assert(PyType_IsSubtype(type, &PyTaskletGroup_Type));
+    group = (PyTaskletGroupObject *) type->tp_alloc(type, 0);
+    if (group == NULL)
+        return NULL;
+    group->members = NULL;
+    group->count = 0;
+    group->grp_weakreflist = NULL;
+    group->waiters = PyChannel_New(NULL);
+    if (group->waiters == NULL) {
+        Py_DECREF(group);
+        return NULL;
+    }
+    return group;
+}
+
+static PyObject *
+taskletgroup_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static const char * const argnames[] = {NULL};
+    static _PyArg_Parser parser = {":taskletgroup", argnames};
+
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser))
+        return NULL;
+    return (PyObject *) PyTaskletGroup_New(type);
+}
+
+static int
+taskletgroup_traverse(PyTaskletGroupObject *group, visitproc visit, void *arg)
+{
+    PyTaskletObject *t = group->members;
+
+    if (t != NULL) {
+        do {
+            Py_VISIT(t);
+            t = t->group_next;
+        } while (t != group->members);
+    }
+    Py_VISIT(group->waiters);
+    return 0;
+}
+
+static int
+taskletgroup_clear(PyTaskletGroupObject *group)
+{
+    while (group->members != NULL) {
+        PyTaskletObject *t = group->members;
+
+        taskletgroup_unlink(group, t);
+        Py_DECREF(t);
+    }
+    Py_CLEAR(group->waiters);
+    return 0;
+}
+
+static void
+taskletgroup_dealloc(PyTaskletGroupObject *group)
+{
+    PyObject_GC_UnTrack(group);
+    if (group->grp_weakreflist != NULL)
+        PyObject_ClearWeakRefs((PyObject *)group);
+    taskletgroup_clear(group);
+    Py_TYPE(group)->tp_free((PyObject *)group);
+}
+
+
+int
+PyTaskletGroup_Add(PyTaskletGroupObject *group, PyTaskletObject *task)
+{
+    PyTaskletObject **chain = &group->members;
+
+    if (task->group == group)
+        return 0;
+    if (task->group != NULL)
+        RUNTIME_ERROR("tasklet already belongs to another group", -1);
+    if (slp_get_frame(task) == NULL)
+        RUNTIME_ERROR("cannot add a dead or unbound tasklet to a group", -1);
+    Py_INCREF(task);
+    SLP_CHAIN_INSERT(PyTaskletObject, chain, task, group_next, group_prev);
+    task->group = group;
+    ++group->count;
+    return 0;
+}
+
+PyDoc_STRVAR(taskletgroup_add__doc__,
+"taskletgroup.add(t) -- make the alive tasklet t a member of the group.\n\
+A tasklet can belong to one group at a time. It leaves the group\n\
+when it ends.");
+
+static PyObject *
+taskletgroup_add(PyTaskletGroupObject *self, PyObject *task)
+{
+    if (!PyTasklet_Check(task))
+        TYPE_ERROR("taskletgroup.add needs a tasklet", NULL);
+    if (PyTaskletGroup_Add(self, (PyTaskletObject *)task))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+int
+PyTaskletGroup_Remove(PyTaskletGroupObject *group, PyTaskletObject *task)
+{
+    if (task->group != group)
+        VALUE_ERROR("tasklet is not a member of this group", -1);
+    Py_INCREF(task);
+    slp_taskletgroup_discard(task);
+    Py_DECREF(task);
+    return 0;
+}
+
+PyDoc_STRVAR(taskletgroup_remove__doc__,
+"taskletgroup.remove(t) -- take tasklet t out of the group.\n\
+The tasklet keeps running.");
+
+static PyObject *
+taskletgroup_remove(PyTaskletGroupObject *self, PyObject *task)
+{
+    if (!PyTasklet_Check(task))
+        TYPE_ERROR("taskletgroup.remove needs a tasklet", NULL);
+    if (PyTaskletGroup_Remove(self, (PyTaskletObject *)task))
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+
+/*
+ * join: block until all members have ended.
+ */
+
+PyDoc_STRVAR(taskletgroup_join__doc__,
+"taskletgroup.join() -- block until every member tasklet has ended.\n\
+Returns at once if the group is empty. The current tasklet must not\n\
+be a member itself.");
+
+static PyObject *
+PyTaskletGroup_Join_M(PyTaskletGroupObject *self)
+{
+    return PyStackless_CallMethod_Main((PyObject *) self, "join", NULL);
+}
+
+static PyObject *
+impl_taskletgroup_join(PyTaskletGroupObject *self)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PyObject *ret;
+
+    if (ts->st.main == NULL) return PyTaskletGroup_Join_M(self);
+    taskletgroup_prune(self);
+    if (self->count == 0)
+        Py_RETURN_NONE;
+    if (ts->st.current->group == self)
+        RUNTIME_ERROR("a member cannot join its own group", NULL);
+    if (self->waiters == NULL)
+        RUNTIME_ERROR("tasklet group has been cleared", NULL);
+    STACKLESS_PROMOTE_ALL();
+    ret = PyChannel_Receive(self->waiters);
+    STACKLESS_ASSERT();
+    return ret;
+}
+
+int
+PyTaskletGroup_Join(PyTaskletGroupObject *group)
+{
+    return slp_return_wrapper(impl_taskletgroup_join(group));
+}
+
+static PyObject *
+taskletgroup_join(PyObject *self)
+{
+    return impl_taskletgroup_join((PyTaskletGroupObject *)self);
+}
+
+
+/*
+ * kill: raise TaskletExit in all members.
+ *
+ * Unlike calling tasklet.kill in a loop, this does not switch back
+ * and forth between the caller and each victim. All victims of this
+ * thread are queued in a row in front of the caller, each carrying
+ * the same TaskletExit bomb, and a single switch starts the chain.
+ * The victims unwind one after the other and the caller runs again
+ * when the last of them has ended.
+ * Members of other threads are queued in their own thread, which is
+ * woken up.
+ */
+
+PyDoc_STRVAR(taskletgroup_kill__doc__,
+"taskletgroup.kill() -- raise TaskletExit in every member tasklet.\n\
+The members of the current thread are run right away and have ended\n\
+when kill() returns, unless they catch the exception.\n\
+A member which is the current tasklet is left alone.");
+
+static PyObject *
+PyTaskletGroup_Kill_M(PyTaskletGroupObject *self)
+{
+    return PyStackless_CallMethod_Main((PyObject *) self, "kill", NULL);
+}
+
+static PyObject *
+impl_taskletgroup_kill(PyTaskletGroupObject *self)
+{
+    STACKLESS_GETARG();
+    PyThreadState *ts = PyThreadState_GET();
+    PyTaskletObject *current, *first = NULL;
+    PyObject *noargs, *bomb;
+    Py_ssize_t i, n;
+
+    if (ts->st.main == NULL) return PyTaskletGroup_Kill_M(self);
+    taskletgroup_prune(self);
+    if (self->count == 0)
+        Py_RETURN_NONE;
+    noargs = PyTuple_New(0);
+    if (noargs == NULL)
+        return NULL;
+    bomb = slp_make_bomb(PyExc_TaskletExit, noargs, "taskletgroup.kill");
+    Py_DECREF(noargs);
+    if (bomb == NULL)
+        return NULL;
+
+    current = ts->st.current;
+    n = self->count;
+    for (i = 0; i < n; ++i) {
+        PyTaskletObject *t = self->members;
+
+        /* rotate, so that every member is visited once */
+        self->members = t->group_next;
+        if (t == current)
+            continue;
+        TASKLET_SETVAL(t, bomb);
+        /* take the tasklet from where it is, with a reference */
+        if (t->flags.blocked)
+            slp_channel_remove_slow(t);
+        else if (t->next == NULL)
+            Py_INCREF(t);
+        else if (t->cstate->tstate == ts) {
+            PyTaskletObject *hold = ts->st.current;
+
+            ts->st.current = t;
+            slp_current_remove();
+            ts->st.current = hold;
+        }
+        else
+            /* runnable in another thread, it will meet the bomb there */
+            continue;
+        /* queue it in front of the caller */
+        slp_current_insert(t);
+        if (t->cstate->tstate != ts)
+            slp_thread_unblock(t->cstate->tstate);
+        else if (first == NULL)
+            first = t;
+    }
+    Py_DECREF(bomb);
+    if (first == NULL)
+        Py_RETURN_NONE;
+    return slp_schedule_task(current, first, stackless, 0);
+}
+
+int
+PyTaskletGroup_Kill(PyTaskletGroupObject *group)
+{
+    return slp_return_wrapper(impl_taskletgroup_kill(group));
+}
+
+static PyObject *
+taskletgroup_kill(PyObject *self)
+{
+    return impl_taskletgroup_kill((PyTaskletGroupObject *)self);
+}
+
+
+static PyObject *
+taskletgroup_get_members(PyTaskletGroupObject *self)
+{
+    PyObject *list = PyList_New(self->count);
+    PyTaskletObject *t = self->members;
+    Py_ssize_t i;
+
+    if (list == NULL)
+        return NULL;
+    for (i = 0; i < self->count; ++i) {
+        Py_INCREF(t);
+        PyList_SET_ITEM(list, i, (PyObject *) t);
+        t = t->group_next;
+    }
+    return list;
+}
+
+static Py_ssize_t
+taskletgroup_length(PyTaskletGroupObject *self)
+{
+    return self->count;
+}
+
+static int
+taskletgroup_contains(PyTaskletGroupObject *self, PyObject *task)
+{
+    return PyTasklet_Check(task) &&
+           ((PyTaskletObject *) task)->group == self;
+}
+
+static PyGetSetDef taskletgroup_getsetlist[] = {
+    {"members",         (getter)taskletgroup_get_members, NULL,
+     "a list of the member tasklets, in the order they were added."},
+    {0},
+};
+
+static PySequenceMethods taskletgroup_as_sequence = {
+    (lenfunc)taskletgroup_length,               /* sq_length */
+    0,                                          /* sq_concat */
+    0,                                          /* sq_repeat */
+    0,                                          /* sq_item */
+    0,                                          /* sq_slice */
+    0,                                          /* sq_ass_item */
+    0,                                          /* sq_ass_slice */
+    (objobjproc)taskletgroup_contains,          /* sq_contains */
+};
+
+#define PCF PyCFunction
+#define METH_NS METH_NOARGS | METH_STACKLESS
+
+static PyMethodDef
+taskletgroup_methods[] = {
+    {"add",                 (PCF)taskletgroup_add,          METH_O,
+     taskletgroup_add__doc__},
+    {"remove",              (PCF)taskletgroup_remove,       METH_O,
+     taskletgroup_remove__doc__},
+    {"join",                (PCF)taskletgroup_join,         METH_NS,
+     taskletgroup_join__doc__},
+    {"kill",                (PCF)taskletgroup_kill,         METH_NS,
+     taskletgroup_kill__doc__},
+    {NULL,                  NULL}            /* sentinel */
+};
+
+PyDoc_STRVAR(taskletgroup__doc__,
+"A taskletgroup collects tasklets which belong together, so that they\n\
+can be waited for with join() and cancelled with kill() at once.\n\
+A member leaves the group when it ends.");
+
+PyTypeObject PyTaskletGroup_Type = {
+    PyObject_HEAD_INIT(&PyType_Type)
+    0,
+    "stackless.taskletgroup",
+    sizeof(PyTaskletGroupObject),
+    0,
+    (destructor)taskletgroup_dealloc,           /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    &taskletgroup_as_sequence,                  /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    PyObject_GenericSetAttr,                    /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC |
+        Py_TPFLAGS_BASETYPE,                    /* tp_flags */
+    taskletgroup__doc__,                        /* tp_doc */
+    (traverseproc)taskletgroup_traverse,        /* tp_traverse */
+    (inquiry)taskletgroup_clear,                /* tp_clear */
+    0,                                          /* tp_richcompare */
+    offsetof(PyTaskletGroupObject, grp_weakreflist),
+                                                /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    taskletgroup_methods,                       /* tp_methods */
+    0,                                          /* tp_members */
+    taskletgroup_getsetlist,                    /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    PyType_GenericAlloc,                        /* tp_alloc */
+    taskletgroup_new,                           /* tp_new */
+    PyObject_GC_Del,                            /* tp_free */
+};
+
+int init_taskletgrouptype(void)
+{
+    return PyType_Ready(&PyTaskletGroup_Type);
+}
+#endif
@@ -0,0 +1 @@
+int init_taskletgrouptype(void);
@@ -203,6 +203,9 @@ PyTasklet_New(PyTypeObject *type, PyObject *func)
         Py_INCREF(func);
         t->tempval = func;
         t->tsk_weakreflist = NULL;
+        t->group = NULL;
+        t->group_next = NULL;
+        t->group_prev = NULL;
         Py_INCREF(ts->st.initial_stub);
         t->cstate = ts->st.initial_stub;
         t->def_globals = PyEval_GetGlobals();
@@ -251,10 +254,10 @@ static PyObject *
 tasklet_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
     PyFunctionObject *func = NULL;
-    static char *kwlist[] = {"func", NULL};
+    static const char * const kwlist[] = {"func", NULL};
+    static _PyArg_Parser parser = {"|O:tasklet", kwlist};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O:tasklet",
-                                     kwlist, &func))
+    if (!_PyArg_ParseTupleAndKeywordsFast(args, kwds, &parser, &func))
         return NULL;
     return (PyObject*) PyTasklet_New(type, (PyObject*)func);
 }
@@ -493,6 +496,8 @@ static TASKLET_INSERT_HEAD(impl_tasklet_insert)
         RUNTIME_ERROR("You cannot run a blocked tasklet", -1);
     if (task->f.frame == NULL && task != ts->st.current)
         RUNTIME_ERROR("You cannot run an unbound(dead) tasklet", -1);
+    if (task->cstate->tstate == NULL)
+        RUNTIME_ERROR("You cannot run a tasklet which outlived the main thread", -1);
     if (task->next == NULL) {
         Py_INCREF(task);
         slp_current_insert(task);
@@ -523,17 +523,29 @@ slp_from_tuple_with_nulls(PyObject **start, PyObject *tup)
 
 static struct _typeobject wrap_PyCode_Type;
 
+/* The inline caches of the eval loop (co_opcache and friends) are not
+ * part of the state: the unpickled code object starts without them and
+ * builds its own once it is hot.
+ * Superinstructions are pickled as the plain instructions they stand
+ * for. Instruction offsets do not change, so f_lasti of pickled frames
+ * stays valid either way.
+ */
+
 static PyObject *
 code_reduce(PyCodeObject * co)
 {
-    PyObject *tup = Py_BuildValue(
+    PyObject *tup, *code = _PyCode_UnfuseCode(co->co_code);
+
+    if (code == NULL)
+        return NULL;
+    tup = Py_BuildValue(
         "(O(" codetuplefmt ")())",
         &wrap_PyCode_Type,
         co->co_argcount,
         co->co_nlocals,
         co->co_stacksize,
         co->co_flags,
-        co->co_code,
+        code,
         co->co_consts,
         co->co_names,
         co->co_varnames,
@@ -544,7 +556,7 @@ code_reduce(PyCodeObject * co)
         co->co_freevars,
         co->co_cellvars
     );
-
+    Py_DECREF(code);
     return tup;
 }
 
@@ -243,6 +243,84 @@ PyAPI_FUNC(void) PyChannel_SetScheduleAll(PyChannelObject *self, int val);
  */
 PyAPI_FUNC(int) PyChannel_GetBalance(PyChannelObject *self);
 
+/******************************************************
+
+  tasklet group related functions
+
+ ******************************************************/
+
+/*
+ * create a new tasklet group.
+ * type must be derived from PyTaskletGroup_Type or NULL.
+ */
+PyAPI_FUNC(PyTaskletGroupObject *) PyTaskletGroup_New(PyTypeObject *type);
+
+/*
+ * add an alive tasklet to the group. A tasklet can be member of
+ * one group at a time and leaves it when it ends.
+ */
+PyAPI_FUNC(int) PyTaskletGroup_Add(PyTaskletGroupObject *group,
+				   PyTaskletObject *task);
+/* 0 = success	-1 = failure */
+
+/* take a tasklet out of the group */
+PyAPI_FUNC(int) PyTaskletGroup_Remove(PyTaskletGroupObject *group,
+				      PyTaskletObject *task);
+/* 0 = success	-1 = failure */
+
+/*
+ * block until all members have ended.
+ */
+PyAPI_FUNC(int) PyTaskletGroup_Join(PyTaskletGroupObject *group);
+/* 0 = success	-1 = failure */
+
+/*
+ * raise TaskletExit in all members. The members of the current
+ * thread are run in a row, before the caller continues.
+ */
+PyAPI_FUNC(int) PyTaskletGroup_Kill(PyTaskletGroupObject *group);
+/* 0 = success	-1 = failure */
+
+/******************************************************
+
+  future related functions
+
+ ******************************************************/
+
+/*
+ * create a new, pending future.
+ * type must be derived from PyFuture_Type or NULL.
+ */
+PyAPI_FUNC(PyFutureObject *) PyFuture_New(PyTypeObject *type);
+
+/*
+ * resolve the future with a value, or with an exception.
+ * Waiting tasklets are scheduled, the caller is not blocked.
+ */
+PyAPI_FUNC(int) PyFuture_SetResult(PyFutureObject *self, PyObject *value);
+/* 0 = success	-1 = failure */
+
+PyAPI_FUNC(int) PyFuture_SetException(PyFutureObject *self,
+				      PyObject *klass, PyObject *args);
+/* 0 = success	-1 = failure */
+
+/*
+ * get the value, blocking while the future is pending.
+ */
+PyAPI_FUNC(PyObject *) PyFuture_Result(PyFutureObject *self);
+/* result = success  NULL = failure */
+
+/*
+ * block until all futures of the sequence are resolved,
+ * or until any of them is resolved, which is returned.
+ * The results are fetched with PyFuture_Result.
+ */
+PyAPI_FUNC(PyObject *) PyFuture_WaitAll(PyObject *futures);
+/* Py_None = success  NULL = failure */
+
+PyAPI_FUNC(PyObject *) PyFuture_WaitAny(PyObject *futures);
+/* future = success  NULL = failure */
+
 /******************************************************
 
   stacklessmodule functions
@@ -325,6 +403,39 @@ PyAPI_FUNC(PyObject *) PyStackless_RunWatchdog(long timeout);
 PyAPI_FUNC(PyObject *) PyStackless_RunWatchdogEx(long timeout,
 											   int flags);
 
+/*
+ * run the tasklets of the current thread from the event loop of an
+ * embedding application, until none is runnable, or until budget
+ * seconds of wall-clock time have passed, if budget is > 0.
+ * Tasklets are never interrupted. When the budget expires, the
+ * function returns at the next tasklet switch and the remaining
+ * tasklets stay runnable for the next call.
+ * Sleepers whose deadline has passed are woken before and during
+ * the run. If next_timer is not NULL, it receives the time in
+ * seconds until the next sleeper is due, or -1.0 if none sleeps.
+ * This function can only be called from the main tasklet.
+ */
+#define PY_HOSTRUN_IDLE			0
+#define PY_HOSTRUN_BUDGET		1
+PyAPI_FUNC(int) PyStackless_RunHost(double budget, double *next_timer);
+/* status = success  -1 = failure */
+
+/*
+ * remove the current tasklet from the runnables for the given
+ * number of seconds. It is woken by PyStackless_RunHost.
+ */
+PyAPI_FUNC(PyObject *) PyStackless_Sleep(double seconds);
+/* value = success  NULL = failure */
+
+/*
+ * post a wake-up for a tasklet which has removed itself from the
+ * runnables, e.g. with PyStackless_Schedule(retval, 1), or which
+ * sleeps. It becomes runnable in its thread, and the call it waits
+ * in returns value (NULL means Py_None). The GIL must be held.
+ */
+PyAPI_FUNC(int) PyStackless_Wakeup(PyTaskletObject *task, PyObject *value);
+/* 0 = success	-1 = failure */
+
 /******************************************************
 
   debugging and monitoring functions
@@ -0,0 +1,62 @@
+# object allocator arena benchmark
+#
+# Builds a heap of small objects and reads them in random order, which
+# makes the cost of address translation visible, then frees most of them.
+# Runs itself in a child process for each arena setting (PYTHONARENASIZE,
+# PYTHONHUGEPAGES) and prints the time to build the heap, the time to
+# walk it, and the resident size before and after freeing:
+#
+#     python arenas.py [objects]
+
+import sys, os, time, random, subprocess
+
+settings = [
+    ("256k arenas", {}),
+    ("2m arenas", {"PYTHONARENASIZE": "2m"}),
+    ("2m huge pages", {"PYTHONHUGEPAGES": "1"}),
+    ("16m huge pages", {"PYTHONHUGEPAGES": "1", "PYTHONARENASIZE": "16m"}),
+]
+
+def rss():
+    for line in open("/proc/self/status"):
+        if line.startswith("VmRSS:"):
+            return int(line.split()[1]) // 1024
+    return 0
+
+def child(n):
+    start = time.time()
+    objs = [(i, str(i)) for i in xrange(n)]
+    order = range(n)
+    random.seed(0)
+    random.shuffle(order)
+    build = time.time() - start
+    best = None
+    for i in xrange(3):
+        start = time.time()
+        for j in order:
+            objs[j][1]
+        diff = time.time() - start
+        if best is None or diff < best:
+            best = diff
+    before = rss()
+    del objs[n // 10:]
+    print "build %.2f s, walk %.2f s, %d MB, %d MB after freeing 90%%" % (
+        build, best, before, rss())
+
+def main(n=5000000):
+    print sys.version
+    for name, env in settings:
+        environ = dict(os.environ)
+        environ.pop("PYTHONARENASIZE", None)
+        environ.pop("PYTHONHUGEPAGES", None)
+        environ.update(env)
+        sys.stdout.write("%-15s " % name)
+        sys.stdout.flush()
+        subprocess.call([sys.executable, __file__, "--child", str(n)],
+                        env=environ)
+
+if __name__ == '__main__':
+    if sys.argv[1:2] == ["--child"]:
+        child(int(sys.argv[2]))
+    else:
+        main(*map(int, sys.argv[1:]))
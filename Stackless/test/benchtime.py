@@ -0,0 +1,8 @@
+# timing helper shared by the benchmarks in this directory
+
+import timeit
+
+def best(func, number=1, repeat=5):
+    """Return the best time of one call of func, over repeat runs of
+    number calls each."""
+    return min(timeit.repeat(func, number=number, repeat=repeat)) / number
@@ -0,0 +1,47 @@
+# codec benchmark
+#
+# Times str.decode() and unicode.encode() with the utf-8, ascii and
+# latin-1 codecs on a few megabytes of English, French and Russian text,
+# and prints the best throughput of a few runs in megabytes per second:
+#
+#     python codecbench.py [megabytes]
+
+import sys, random
+from benchtime import best
+
+WORDS = {
+    "english": u"the quick brown fox jumps over a lazy dog while "
+               u"servers log every request they handle".split(),
+    "french": u"le c\xe9l\xe8bre gar\xe7on na\xefve a mang\xe9 une "
+              u"cr\xeape \xe0 la cr\xe8me br\xfbl\xe9e".split(),
+    "russian": u"\u0441\u044a\u0435\u0448\u044c \u0436\u0435 \u0435\u0449"
+               u"\u0451 \u044d\u0442\u0438\u0445 \u043c\u044f\u0433\u043a"
+               u"\u0438\u0445 \u0431\u0443\u043b\u043e\u043a".split(),
+}
+
+def text(words, size):
+    random.seed(0)
+    result = []
+    total = 0
+    while total < size:
+        word = random.choice(words)
+        result.append(word)
+        total += len(word) + 1
+    return u" ".join(result)
+
+def main(megabytes=4):
+    print sys.version
+    for name in ["english", "french", "russian"]:
+        u = text(WORDS[name], megabytes << 20)
+        for codec in ["utf-8", "ascii", "latin-1"]:
+            try:
+                b = u.encode(codec)
+            except UnicodeError:
+                continue
+            mb = len(b) / float(1 << 20)
+            print "%-8s %-8s decode %7.0f MB/s, encode %7.0f MB/s" % (
+                name, codec, mb / best(lambda: b.decode(codec)),
+                mb / best(lambda: u.encode(codec)))
+
+if __name__ == '__main__':
+    main(*map(int, sys.argv[1:]))
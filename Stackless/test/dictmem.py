@@ -0,0 +1,56 @@
+# instance __dict__ memory benchmark
+#
+# Creates many instances of new-style and classic classes, each with a
+# handful of attributes set in __init__, and reports how much memory an
+# instance __dict__ takes (sys.getsizeof, which counts the values array
+# of a dict that shares the key table of its class) and how long the
+# instances take to create and to read.
+
+import sys
+from benchtime import best
+
+class New(object):
+    def __init__(self, i):
+        self.a = i
+        self.b = i
+        self.c = i
+        self.d = i
+        self.e = i
+
+class Classic:
+    def __init__(self, i):
+        self.a = i
+        self.b = i
+        self.c = i
+        self.d = i
+        self.e = i
+
+class Wide(object):
+    def __init__(self, i):
+        for name in 'abcdefghijkl':
+            setattr(self, name, i)
+
+def create(cls, n):
+    return [cls(i) for i in xrange(n)]
+
+def read(objs):
+    for o in objs:
+        o.a; o.b; o.c; o.d; o.e
+
+def main(n=100000):
+    print sys.version
+    for cls in New, Classic, Wide:
+        t_create = best(lambda: create(cls, n))
+        objs = create(cls, n)
+        t_read = best(lambda: read(objs))
+        shared = sys.getsizeof(objs[0].__dict__)
+        plain = sys.getsizeof(dict(objs[0].__dict__))
+        print "%-8s %7d instances: dict %4d bytes (%4d unshared), " \
+              "create %6.3f s, read %6.3f s" % (
+            cls.__name__, n, shared, plain, t_create, t_read)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(int(sys.argv[1]))
+    else:
+        main()
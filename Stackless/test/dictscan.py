@@ -0,0 +1,51 @@
+# dict iteration and size benchmark
+#
+# Iterates over dicts of various sizes, fresh ones and ones that had
+# two thirds of their keys deleted, with keys(), iteritems() and a for
+# loop, and reports the size of each dict (sys.getsizeof).  Iteration
+# walks the dense array of entries, so its cost follows the number of
+# items rather than the size of the hash table.
+
+import sys
+from benchtime import best
+
+def make(n, holes):
+    d = dict.fromkeys(xrange(3 * n if holes else n), 0)
+    if holes:
+        for i in xrange(0, 3 * n):
+            if i % 3:
+                del d[i]
+    return d
+
+def keys(d, loops):
+    for i in xrange(loops):
+        d.keys()
+
+def iteritems(d, loops):
+    for i in xrange(loops):
+        for item in d.iteritems():
+            pass
+
+def forloop(d, loops):
+    for i in xrange(loops):
+        for k in d:
+            pass
+
+def main(total=2000000):
+    print sys.version
+    for n in (5, 50, 500, 50000):
+        for holes in (False, True):
+            d = make(n, holes)
+            loops = max(1, total // n)
+            times = [best(lambda: func(d, loops)) * 1e9 / (loops * n)
+                     for func in (keys, iteritems, forloop)]
+            print "%6d items%s %8d bytes: keys %5.1f, iteritems %5.1f, " \
+                  "for %5.1f ns/item" % (
+                n, holes and " (holes)" or "        ", sys.getsizeof(d),
+                times[0], times[1], times[2])
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(int(sys.argv[1]))
+    else:
+        main()
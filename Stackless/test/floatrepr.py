@@ -0,0 +1,35 @@
+# float repr() and float() benchmark
+#
+# Times repr() of floats and float() of the resulting strings for a few
+# kinds of values, and prints the best time per item of a few runs:
+#
+#     python floatrepr.py [count]
+
+import sys, random, struct
+from benchtime import best
+
+def any_double():
+    bits = random.getrandbits(64)
+    return struct.unpack("<d", struct.pack("<Q", bits))[0]
+
+def main(n=200000):
+    print sys.version
+    random.seed(0)
+    sets = [
+        ("random()", random.random),
+        ("2 decimals", lambda: round(random.uniform(0, 1000), 2)),
+        ("any double", any_double),
+    ]
+    for name, gen in sets:
+        xs = []
+        while len(xs) < n:
+            x = gen()
+            if x - x == 0:
+                xs.append(x)
+        ss = map(repr, xs)
+        print "%-11s repr %7.1f ns, float %7.1f ns" % (
+            name, best(lambda: map(repr, xs)) * 1e9 / n,
+            best(lambda: map(float, ss)) * 1e9 / n)
+
+if __name__ == '__main__':
+    main(*map(int, sys.argv[1:]))
@@ -0,0 +1,59 @@
+# frame allocation benchmark
+#
+# Many tasklets, each holding a few live frames of the same functions,
+# switch round robin while calling further functions.  The zombie frame
+# of a code object cannot serve them, so this measures the free lists.
+
+import sys, time
+import stackless
+
+def leaf(x):
+    return x + 1
+
+def middle(x, rounds):
+    for i in xrange(rounds):
+        x = leaf(x)
+        stackless.schedule()
+    return x
+
+def outer(rounds):
+    return middle(0, rounds)
+
+def run(ntasklets, rounds):
+    start = time.clock()
+    for i in xrange(ntasklets):
+        stackless.tasklet(outer)(rounds)
+    stackless.run()
+    return time.clock() - start
+
+def churn(ntasklets):
+    # create and tear down the frames of whole tasklets
+    start = time.clock()
+    for i in xrange(ntasklets):
+        stackless.tasklet(outer)(1)
+    stackless.run()
+    return time.clock() - start
+
+def main(ntasklets=50000, rounds=10):
+    print sys.version
+    diff = run(ntasklets, rounds)
+    n = ntasklets * rounds
+    print "%6d tasklets, %8d switches took %8.5f seconds, %6.3f us/switch" % (
+        ntasklets, n, diff, diff * 1e6 / n)
+    diff = churn(ntasklets)
+    print "%6d short tasklets took %8.5f seconds, %6.3f us/tasklet" % (
+        ntasklets, diff, diff * 1e6 / ntasklets)
+    if hasattr(sys, "getframestats"):
+        stats = sys.getframestats()
+        for key in sorted(stats):
+            if key != "classes":
+                print "%-16s %10d" % (key, stats[key])
+        for slots, cached, limit in stats["classes"]:
+            print "class %4d slots %6d cached, limit %6d" % (
+                slots, cached, limit)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(*map(int, sys.argv[1:]))
+    else:
+        main()
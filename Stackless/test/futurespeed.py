@@ -0,0 +1,66 @@
+# request/response benchmark
+#
+# A client tasklet waits for a result computed by a server tasklet,
+# once with a channel created per request and once with a future.
+# The fan-out variants issue a batch of requests and gather all results.
+
+import sys, time
+import stackless
+
+def via_channel(n):
+    def server(chan, i):
+        chan.send(i)
+    start = time.clock()
+    for i in xrange(n):
+        chan = stackless.channel()
+        stackless.tasklet(server)(chan, i)
+        chan.receive()
+    return time.clock() - start
+
+def via_future(n):
+    def server(f, i):
+        f.set_result(i)
+    start = time.clock()
+    for i in xrange(n):
+        f = stackless.future()
+        stackless.tasklet(server)(f, i)
+        f.result()
+    return time.clock() - start
+
+def fanout_channel(n, k=10):
+    def server(chan, i):
+        chan.send(i)
+    start = time.clock()
+    for i in xrange(n // k):
+        chans = [stackless.channel() for j in xrange(k)]
+        for chan in chans:
+            stackless.tasklet(server)(chan, i)
+        for chan in chans:
+            chan.receive()
+    return time.clock() - start
+
+def fanout_future(n, k=10):
+    def server(f, i):
+        f.set_result(i)
+    start = time.clock()
+    for i in xrange(n // k):
+        futures = [stackless.future() for j in xrange(k)]
+        for f in futures:
+            stackless.tasklet(server)(f, i)
+        stackless.wait_all(futures)
+        for f in futures:
+            f.result()
+    return time.clock() - start
+
+def main(n=100000):
+    print sys.version
+    for func in via_channel, via_future, fanout_channel, fanout_future:
+        diff = func(n)
+        print "%-14s %6d requests took %8.5f seconds, %6.2f us/request" % (
+            func.__name__, n, diff, diff * 1e6 / n)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(int(sys.argv[1]))
+    else:
+        main()
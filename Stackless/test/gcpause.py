@@ -0,0 +1,47 @@
+# garbage collection pause benchmark
+#
+# Keeps a large number of trees with parent links alive and replaces
+# them one by one, so the old trees become cyclic garbage in the oldest
+# generation.  Prints the pause histograms of gc.get_pause_histogram(),
+# with full collections of the oldest generation, or with incremental
+# collection when a step size is given:
+#
+#     python gcpause.py [step [trees]]
+
+import sys, time, gc
+
+class Node(object):
+    def __init__(self, parent):
+        self.parent = parent
+        self.children = []
+        if parent is not None:
+            parent.children.append(self)
+
+def tree(n):
+    root = Node(None)
+    nodes = [root]
+    for i in xrange(n):
+        nodes.append(Node(nodes[i // 4]))
+    return root
+
+def main(step=0, trees=1000, size=1000):
+    print sys.version
+    gc.set_incremental(step)
+    live = [tree(size) for i in xrange(trees)]
+    gc.get_pause_histogram(True)
+    start = time.clock()
+    for i in xrange(3 * trees):
+        live[i % trees] = tree(size)
+    diff = time.clock() - start
+    print "step %d: %d trees, %.2f seconds, %d objects tracked" % (
+        step, trees, diff, len(gc.get_objects()))
+    names = ("generation 0", "generation 1", "generation 2", "steps")
+    for name, hist in zip(names, gc.get_pause_histogram()):
+        if not sum(hist):
+            continue
+        longest = max(i for i, count in enumerate(hist) if count)
+        print "%-13s %6d pauses, longest < %8d us" % (
+            name, sum(hist), 2 ** longest)
+
+if __name__ == '__main__':
+    main(*map(int, sys.argv[1:]))
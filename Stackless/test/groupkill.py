@@ -0,0 +1,46 @@
+# bulk cancellation benchmark
+#
+# Blocks a number of tasklets on a channel and compares killing them
+# one by one with tasklet.kill() to killing them with a taskletgroup.
+
+import sys, time
+import stackless
+
+def blocker(chan):
+    chan.receive()
+
+def spawn(n, group=None):
+    chan = stackless.channel()
+    tasks = [stackless.tasklet(blocker)(chan) for i in xrange(n)]
+    if group is not None:
+        for t in tasks:
+            group.add(t)
+    stackless.run()
+    return tasks
+
+def kill_each(n):
+    tasks = spawn(n)
+    start = time.clock()
+    for t in tasks:
+        t.kill()
+    return time.clock() - start
+
+def kill_group(n):
+    group = stackless.taskletgroup()
+    spawn(n, group)
+    start = time.clock()
+    group.kill()
+    return time.clock() - start
+
+def main(n=20000):
+    print sys.version
+    for func in kill_each, kill_group:
+        diff = func(n)
+        print "%-10s %6d tasklets took %8.5f seconds, %6.2f us/tasklet" % (
+            func.__name__, n, diff, diff * 1e6 / n)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(int(sys.argv[1]))
+    else:
+        main()
@@ -0,0 +1,80 @@
+# end-of-iteration benchmark
+#
+# Runs many short iterations, so the cost of ending each loop shows:
+# generators drained by for loops and by C consumers such as list()
+# and sum(), itertools over generators, container iterators and
+# channel iteration from another tasklet.
+
+import sys, itertools
+import stackless
+from benchtime import best
+
+def gen(n):
+    for i in xrange(n):
+        yield i
+
+def gen_raise(n):
+    for i in xrange(n):
+        yield i
+    raise StopIteration
+
+def for_gen(loops, n):
+    for j in xrange(loops):
+        for i in gen(n):
+            pass
+
+def list_gen(loops, n):
+    for j in xrange(loops):
+        list(gen(n))
+
+def sum_gen(loops, n):
+    for j in xrange(loops):
+        sum(gen(n))
+
+def for_gen_raise(loops, n):
+    for j in xrange(loops):
+        for i in gen_raise(n):
+            pass
+
+def chain_gen(loops, n):
+    chain = itertools.chain
+    for j in xrange(loops):
+        for i in chain(gen(n), gen(n)):
+            pass
+
+def containers(loops, n):
+    l = range(n)
+    d = dict.fromkeys(l)
+    s = set(l)
+    for j in xrange(loops):
+        for i in l:
+            pass
+        for i in d:
+            pass
+        for i in s:
+            pass
+
+def channel_iter(loops, n):
+    for j in xrange(loops):
+        c = stackless.channel()
+        def sender():
+            c.send_sequence(xrange(n))
+            c.close()
+        stackless.tasklet(sender)()
+        for i in c:
+            pass
+
+def main(loops=100000, n=3):
+    print sys.version
+    for func in (for_gen, list_gen, sum_gen, for_gen_raise, chain_gen,
+                 containers, channel_iter):
+        func(10, n)
+        diff = best(lambda: func(loops, n))
+        print "%-14s %7d loops of %d, best %8.5f seconds, %6.3f us/loop" % (
+            func.__name__, loops, n, diff, diff * 1e6 / loops)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(*map(int, sys.argv[1:]))
+    else:
+        main()
@@ -0,0 +1,33 @@
+# long integer conversion and arithmetic benchmark
+#
+# Times str() and long() of numbers with a given number of decimal
+# digits, and multiplication and division of such numbers, with the best
+# of a few runs:
+#
+#     python longconv.py [digits ...]
+
+import sys, random
+from benchtime import best
+
+def main(sizes=(1000, 10000, 100000, 1000000)):
+    print sys.version
+    random.seed(0)
+    for n in sizes:
+        s = "".join([random.choice("0123456789") for i in xrange(n)])
+        s = "9" + s[1:]
+        x = long(s)
+        y = long(s[::-1])
+        z = x * y
+        number = max(1, 100000 // n)
+        times = tuple([best(f, number)
+                       for f in (lambda: str(x), lambda: long(s),
+                                 lambda: x * y, lambda: x * x,
+                                 lambda: divmod(z, y))])
+        print "%8d digits: str %9.5f, long %9.5f, mul %9.5f, " \
+              "square %9.5f, divmod %9.5f s" % ((n,) + times)
+
+if __name__ == '__main__':
+    if sys.argv[1:]:
+        main(map(int, sys.argv[1:]))
+    else:
+        main()
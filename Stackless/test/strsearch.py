@@ -0,0 +1,50 @@
+# string search benchmark
+#
+# Times find, count, split and replace on a few megabytes of log-like
+# text, as str, unicode and bytearray, with the best of a few runs:
+#
+#     python strsearch.py [megabytes]
+
+import sys, random
+from benchtime import best
+
+def logtext(size):
+    random.seed(0)
+    levels = ["INFO", "INFO", "INFO", "DEBUG", "WARNING"]
+    words = ["request", "served", "user", "session", "cache", "miss",
+             "GET", "/api/v1/items", "200", "in", "ms", "from", "backend"]
+    lines = []
+    total = 0
+    while total < size:
+        line = "2011-03-%02d 12:%02d:%02d,%03d %s [worker-%d] %s" % (
+            random.randrange(1, 29), random.randrange(60),
+            random.randrange(60), random.randrange(1000),
+            random.choice(levels), random.randrange(16),
+            " ".join(random.choice(words) for i in xrange(12)))
+        lines.append(line)
+        total += len(line) + 1
+    return "\n".join(lines)
+
+def main(megabytes=4):
+    print sys.version
+    text = logtext(megabytes << 20)
+    for name, s in [("str", text), ("unicode", text.decode("ascii")),
+                    ("bytearray", bytearray(text))]:
+        t = type(s)
+        nl, ex, err, srv = t("\n"), t("!"), t("ERROR"), t("served")
+        results = [
+            ("find char", lambda: s.find(ex)),
+            ("rfind char", lambda: s.rfind(ex)),
+            ("count char", lambda: s.count(nl)),
+            ("find word", lambda: s.find(err)),
+            ("count word", lambda: s.count(srv)),
+            ("split()", lambda: s.split()),
+            ("split(nl)", lambda: s.split(nl)),
+            ("rsplit()", lambda: s.rsplit()),
+            ("replace", lambda: s.replace(srv, t("SERVED"))),
+            ]
+        print "%-10s" % name + ", ".join(
+            ["%s %.2f ms" % (what, best(f) * 1e3) for what, f in results])
+
+if __name__ == '__main__':
+    main(*map(int, sys.argv[1:]))
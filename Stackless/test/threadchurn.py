@@ -0,0 +1,57 @@
+# thread churn benchmark
+#
+# Keeps a large number of hard switched tasklets blocked in the main
+# thread and measures how long it takes to start and exit threads which
+# create a few hard switched tasklets of their own.
+# Thread teardown has to kill the tasklets with stacks of the exiting
+# thread only, so the time per thread should not depend on the number
+# of stacks alive in the main thread.
+
+import sys, time, thread
+import stackless
+
+def blocker(chan):
+    chan.receive()
+
+def make_stacks(n, chan):
+    hold = stackless.enable_softswitch(False)
+    try:
+        for i in xrange(n):
+            stackless.tasklet(blocker)(chan)
+        stackless.run()
+    finally:
+        stackless.enable_softswitch(hold)
+
+def worker(n, done):
+    make_stacks(n, stackless.channel())
+    done.release()
+
+def churn(nthreads, per_thread):
+    clock = time.time
+    start = clock()
+    for i in xrange(nthreads):
+        done = thread.allocate_lock()
+        done.acquire()
+        thread.start_new_thread(worker, (per_thread, done))
+        done.acquire()
+    return clock() - start
+
+def main(live_counts=(0, 1000, 10000), nthreads=200, per_thread=10):
+    print sys.version
+    chan = stackless.channel()
+    alive = 0
+    for live in live_counts:
+        make_stacks(live - alive, chan)
+        alive = live
+        diff = churn(nthreads, per_thread)
+        print "%6d live stacks: %4d threads took %8.5f seconds, %8.1f us/thread" % (
+            len(stackless.uncollectables), nthreads, diff, diff * 1e6 / nthreads)
+    while chan.balance < 0:
+        chan.send(None)
+
+if __name__ == '__main__':
+    args = [int(arg) for arg in sys.argv[1:]]
+    if args:
+        main(args)
+    else:
+        main()
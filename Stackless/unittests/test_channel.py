@@ -134,6 +134,72 @@ class TestChannels(unittest.TestCase):
 
         scheduler_run(slave_func)
 
+    def testInterthreadHandoff(self):
+        ''' Test that a thread woken up over a channel gets the GIL from a busy sender without waiting for the switch interval. '''
+        import sys, time
+        channel = stackless.channel()
+        events = []
+        def receiver():
+            while True:
+                i = channel.receive()
+                if i is None:
+                    break
+                events.append(("received", i))
+        thread = threading.Thread(target=receiver)
+        thread.start()
+        interval = sys.getswitchinterval()
+        # an ordinary waiter would not get the GIL from the loop below
+        sys.setswitchinterval(1000.0)
+        try:
+            for i in range(5):
+                while channel.balance >= 0:
+                    time.sleep(0.001)
+                channel.send(i)
+                # keep the GIL busy until the receiver got the value
+                for n in xrange(10 ** 8):
+                    if len(events) > 2 * i:
+                        break
+                events.append(("busy", i))
+        finally:
+            sys.setswitchinterval(interval)
+            while channel.balance >= 0:
+                time.sleep(0.001)
+            channel.send(None)
+            thread.join()
+        # without the hand-off the busy loop runs to its end first
+        self.assertEqual(events, [(what, i) for i in range(5)
+                                  for what in ("received", "busy")])
+
+    def testIterateClosing(self):
+        ''' Test that iterating a closing channel with waiting receivers ends at once. '''
+        channel = stackless.channel()
+        t = stackless.tasklet(channel.receive)()
+        stackless.run()
+        self.assertEqual(channel.balance, -1)
+        channel.close()
+        self.assertEqual(list(channel), [])
+        self.assertRaises(StopIteration, channel.receive)
+        t.kill()
+
+    def testSendException(self):
+        ''' Test that send_exception delivers the class and all further arguments, also through the method descriptor. '''
+        channel = stackless.channel()
+        errors = []
+        def receiver():
+            for i in range(3):
+                try:
+                    channel.receive()
+                except ValueError, e:
+                    errors.append(e.args)
+        stackless.tasklet(receiver)()
+        stackless.run()
+        channel.send_exception(ValueError, 1, 2)
+        channel.send_exception(ValueError)
+        stackless.channel.send_exception(channel, ValueError, "x")
+        self.assertEqual(errors, [(1, 2), (), ("x",)])
+        self.assertRaises(ValueError, channel.send_exception)
+        self.assertRaises(TypeError, channel.send_exception, ValueError, x=1)
+
 
 if __name__ == '__main__':
     import sys
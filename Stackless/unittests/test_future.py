@@ -0,0 +1,167 @@
+import unittest
+import stackless
+import threading
+
+class TestFuture(unittest.TestCase):
+    def setUp(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from other tests, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def tearDown(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from this test, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def testResolved(self):
+        f = stackless.future()
+        self.assertFalse(f.done())
+        f.set_result(42)
+        self.assertTrue(f.done())
+        self.assertEqual(f.result(), 42)
+        self.assertEqual(f.result(), 42)
+        self.assertRaises(RuntimeError, f.set_result, 43)
+        self.assertRaises(RuntimeError, f.set_exception, ValueError)
+
+    def testWaiters(self):
+        f = stackless.future()
+        got = []
+        def waiter(i):
+            got.append((i, f.result()))
+        for i in range(3):
+            stackless.tasklet(waiter)(i)
+        stackless.run()
+        self.assertEqual(f.waiting, 3)
+        # resolving does not block the caller
+        f.set_result("x")
+        self.assertEqual(got, [])
+        self.assertEqual(f.waiting, 0)
+        stackless.run()
+        self.assertEqual(got, [(0, "x"), (1, "x"), (2, "x")])
+
+    def testException(self):
+        f = stackless.future()
+        errors = []
+        def waiter():
+            try:
+                f.result()
+            except ValueError, e:
+                errors.append(e.args)
+        for i in range(2):
+            stackless.tasklet(waiter)()
+        stackless.run()
+        f.set_exception(ValueError, "bad")
+        stackless.run()
+        self.assertEqual(errors, [("bad",), ("bad",)])
+        self.assertRaises(ValueError, f.result)
+
+    def testResultFromMain(self):
+        f = stackless.future()
+        def resolver():
+            f.set_result(7)
+        stackless.tasklet(resolver)()
+        self.assertEqual(f.result(), 7)
+
+    def testHardSwitching(self):
+        f = stackless.future()
+        got = []
+        def waiter():
+            got.append(stackless.test_cstate(f.result))
+        stackless.tasklet(waiter)()
+        stackless.run()
+        f.set_result(1)
+        stackless.run()
+        self.assertEqual(got, [1])
+
+    def testKillWaiter(self):
+        f = stackless.future()
+        t = stackless.tasklet(f.result)()
+        stackless.run()
+        t.kill()
+        self.assertEqual(f.waiting, 0)
+        f.set_result(None)
+
+    def testWaitAll(self):
+        futures = [stackless.future() for i in range(3)]
+        futures[1].set_result(1)
+        done = []
+        def waiter():
+            self.assertEqual(stackless.wait_all(futures), None)
+            done.append([f.result() for f in futures])
+        stackless.tasklet(waiter)()
+        stackless.run()
+        futures[2].set_result(2)
+        stackless.run()
+        self.assertEqual(done, [])
+        futures[0].set_result(0)
+        stackless.run()
+        self.assertEqual(done, [[0, 1, 2]])
+        # nothing pending returns at once
+        self.assertEqual(stackless.wait_all(futures), None)
+        self.assertEqual(stackless.wait_all([]), None)
+
+    def testWaitAny(self):
+        futures = [stackless.future() for i in range(3)]
+        done = []
+        def waiter():
+            done.append(stackless.wait_any(futures))
+        stackless.tasklet(waiter)()
+        stackless.run()
+        futures[2].set_result(2)
+        stackless.run()
+        self.assertTrue(done[0] is futures[2])
+        # the fired wait set has left the other futures
+        futures[0].set_result(0)
+        stackless.run()
+        self.assertEqual(len(done), 1)
+        self.assertTrue(stackless.wait_any(futures) is futures[0])
+        self.assertRaises(ValueError, stackless.wait_any, [])
+        self.assertRaises(TypeError, stackless.wait_any, [1])
+
+    def testWaitAnyException(self):
+        futures = [stackless.future() for i in range(2)]
+        errors = []
+        def waiter():
+            f = stackless.wait_any(futures)
+            try:
+                f.result()
+            except KeyError:
+                errors.append(f)
+        stackless.tasklet(waiter)()
+        stackless.run()
+        futures[1].set_exception(KeyError)
+        stackless.run()
+        self.assertEqual(errors, [futures[1]])
+
+    def testThreads(self):
+        f = stackless.future()
+        got = []
+        def other():
+            got.append(f.result())
+        t = threading.Thread(target=other)
+        t.start()
+        while not f.waiting:
+            stackless.schedule()
+            import time; time.sleep(0.001)
+        f.set_result("done")
+        t.join()
+        self.assertEqual(got, ["done"])
+
+    def testSubclass(self):
+        class MyFuture(stackless.future):
+            pass
+        f = MyFuture()
+        f.set_result(1)
+        self.assertEqual(stackless.wait_any([f]), f)
+
+    def testCycle(self):
+        import gc, weakref
+        f = stackless.future()
+        f.set_result(f)
+        ref = weakref.ref(f)
+        del f
+        gc.collect()
+        self.assertEqual(ref(), None)
+
+
+if __name__ == '__main__':
+    import sys
+    if not sys.argv[1:]:
+        sys.argv.append('-v')
+    unittest.main()
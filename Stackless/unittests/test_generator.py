@@ -28,5 +28,55 @@ class TestGarbageCollection(unittest.TestCase):
         if relevant and len(leakage):
             self.assertTrue(len(leakage) == 0, "Leaked %s" % repr(leakage))
 
+class TestExhaustion(unittest.TestCase):
+    def gen(self, n):
+        for i in range(n):
+            yield i
+
+    def testConsumers(self):
+        # C consumers see the end without a pending StopIteration
+        import itertools, sys
+        self.assertEqual(list(self.gen(3)), [0, 1, 2])
+        self.assertEqual(sum(self.gen(4)), 6)
+        self.assertEqual(list(itertools.chain(self.gen(2), self.gen(1))),
+                         [0, 1, 0])
+        self.assertEqual(sys.exc_info(), (None, None, None))
+
+    def testNext(self):
+        g = self.gen(1)
+        self.assertEqual(g.next(), 0)
+        self.assertRaises(StopIteration, g.next)
+        self.assertRaises(StopIteration, g.next)
+        g = self.gen(1)
+        self.assertEqual(next(g), 0)
+        self.assertRaises(StopIteration, next, g)
+        self.assertEqual(next(g, "default"), "default")
+
+    def testSend(self):
+        g = self.gen(1)
+        self.assertEqual(g.send(None), 0)
+        self.assertRaises(StopIteration, g.send, None)
+
+    def testForLoop(self):
+        result = []
+        for i in self.gen(3):
+            for j in self.gen(i):
+                result.append(j)
+        self.assertEqual(result, [0, 0, 1])
+
+    def testTasklet(self):
+        import stackless
+        result = []
+        def consumer():
+            result.append(list(self.gen(2)))
+            g = self.gen(0)
+            try:
+                g.next()
+            except StopIteration:
+                result.append("stop")
+        stackless.tasklet(consumer)()
+        stackless.run()
+        self.assertEqual(result, [[0, 1], "stop"])
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,221 @@
+import unittest
+import stackless
+import thread, threading
+
+def is_soft():
+    softswitch = stackless.enable_softswitch(0)
+    stackless.enable_softswitch(softswitch)
+    return softswitch
+
+class TestTaskletGroup(unittest.TestCase):
+    def setUp(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from other tests, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def tearDown(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from this test, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def spawn(self, group, func, *args):
+        t = stackless.tasklet(func)(*args)
+        group.add(t)
+        return t
+
+    def testMembership(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        tasks = [self.spawn(group, chan.receive) for i in range(3)]
+        self.assertEqual(len(group), 3)
+        self.assertEqual(group.members, tasks)
+        self.assertTrue(tasks[1] in group)
+        group.remove(tasks[1])
+        self.assertFalse(tasks[1] in group)
+        self.assertEqual(group.members, [tasks[0], tasks[2]])
+        self.assertRaises(ValueError, group.remove, tasks[1])
+        other = stackless.taskletgroup()
+        self.assertRaises(RuntimeError, other.add, tasks[0])
+        self.assertRaises(RuntimeError, group.add, stackless.tasklet(chan.receive))
+        group.add(tasks[0]) # no-op
+        self.assertEqual(len(group), 2)
+        tasks[1].kill()
+        group.kill()
+        self.assertEqual(len(group), 0)
+
+    def testMembersLeaveWhenDone(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        t1 = self.spawn(group, chan.receive)
+        t2 = self.spawn(group, lambda: None)
+        stackless.run()
+        self.assertEqual(group.members, [t1])
+        chan.send(None)
+        self.assertEqual(len(group), 0)
+
+    def testJoin(self):
+        group = stackless.taskletgroup()
+        done = []
+        def worker(n):
+            for i in range(n):
+                stackless.schedule()
+            done.append(n)
+        for n in (3, 1, 2):
+            self.spawn(group, worker, n)
+        group.join()
+        self.assertEqual(sorted(done), [1, 2, 3])
+        self.assertEqual(len(group), 0)
+        # joining an empty group returns at once
+        group.join()
+
+    def testJoinFromTasklets(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        self.spawn(group, chan.receive)
+        joined = []
+        def joiner(i):
+            group.join()
+            joined.append(i)
+        for i in range(3):
+            stackless.tasklet(joiner)(i)
+        stackless.run()
+        self.assertEqual(joined, [])
+        chan.send(None)
+        stackless.run()
+        self.assertEqual(joined, [0, 1, 2])
+
+    def testJoinSelf(self):
+        group = stackless.taskletgroup()
+        errors = []
+        def member():
+            try:
+                group.join()
+            except RuntimeError:
+                errors.append(True)
+        self.spawn(group, member)
+        stackless.run()
+        self.assertEqual(errors, [True])
+
+    def testKill(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        exits = []
+        def victim(i):
+            try:
+                chan.receive()
+            except TaskletExit:
+                exits.append(i)
+                raise
+        def runner(i):
+            try:
+                while True:
+                    stackless.schedule()
+            except TaskletExit:
+                exits.append(i)
+                raise
+        tasks = [self.spawn(group, victim, i) for i in range(3)]
+        stackless.run()
+        self.assertEqual(chan.balance, -3)
+        tasks += [self.spawn(group, runner, i) for i in range(3, 5)]
+        stackless.schedule()
+        paused = self.spawn(group, victim, 5)
+        paused.remove()
+        group.kill()
+        # all victims have unwound before kill() returns, in member order.
+        # the paused tasklet never started, so it had no handler yet.
+        self.assertEqual(exits, range(5))
+        self.assertEqual(chan.balance, 0)
+        self.assertEqual(len(group), 0)
+        for t in tasks:
+            self.assertFalse(t.alive)
+        self.assertFalse(paused.alive)
+
+    def testKillSurvivor(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        def stubborn():
+            try:
+                chan.receive()
+            except TaskletExit:
+                chan.receive()
+        t = self.spawn(group, stubborn)
+        stackless.run()
+        group.kill()
+        self.assertTrue(t.alive)
+        self.assertEqual(len(group), 1)
+        chan.send(None)
+        self.assertEqual(len(group), 0)
+
+    def testKillFromMember(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        def leader():
+            group.kill()
+        others = [self.spawn(group, chan.receive) for i in range(2)]
+        lead = self.spawn(group, leader)
+        stackless.run()
+        self.assertEqual(group.members, [])
+        self.assertFalse(lead.alive)
+        for t in others:
+            self.assertFalse(t.alive)
+
+    def testKillOtherThread(self):
+        group = stackless.taskletgroup()
+        ready = thread.allocate_lock()
+        ready.acquire()
+        exits = []
+        def victim(chan):
+            try:
+                chan.receive()
+            except TaskletExit:
+                exits.append(thread.get_ident())
+        def other():
+            chan = stackless.channel()
+            for i in range(2):
+                group.add(stackless.tasklet(victim)(chan))
+            stackless.run()
+            ready.release()
+            group.join()
+        t = threading.Thread(target=other)
+        t.start()
+        ready.acquire()
+        self.assertEqual(len(group), 2)
+        group.kill()
+        t.join()
+        self.assertEqual(len(exits), 2)
+        self.assertEqual(len(group), 0)
+
+    def testJoinOtherThread(self):
+        group = stackless.taskletgroup()
+        chan = stackless.channel()
+        self.spawn(group, chan.receive)
+        stackless.run()
+        result = []
+        def other():
+            group.join()
+            result.append(len(group))
+        t = threading.Thread(target=other)
+        t.start()
+        chan.send(None)
+        t.join()
+        self.assertEqual(result, [0])
+
+    def testCycle(self):
+        import gc, weakref
+        group = stackless.taskletgroup()
+        def f(g):
+            stackless.schedule_remove()
+        t = self.spawn(group, f, group)
+        stackless.run()
+        if not is_soft():
+            # the C stack of a hard switched tasklet keeps its frames
+            # alive, so there is no garbage to collect
+            t.kill()
+            return
+        ref = weakref.ref(group)
+        del group, t
+        gc.collect()
+        self.assertEqual(ref(), None)
+
+
+if __name__ == '__main__':
+    import sys
+    if not sys.argv[1:]:
+        sys.argv.append('-v')
+    unittest.main()
@@ -0,0 +1,144 @@
+import unittest
+import stackless
+import time
+
+class TestHostLoop(unittest.TestCase):
+    def setUp(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from other tests, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def tearDown(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from this test, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def testIdle(self):
+        done = []
+        def worker(i):
+            stackless.schedule()
+            done.append(i)
+        for i in range(3):
+            stackless.tasklet(worker)(i)
+        self.assertEqual(stackless.run_host(), (0, None))
+        self.assertEqual(done, [0, 1, 2])
+        self.assertEqual(stackless.run_host(1.0), (0, None))
+
+    def testBudget(self):
+        count = [0]
+        def spinner():
+            while True:
+                count[0] += 1
+                stackless.schedule()
+        t = stackless.tasklet(spinner)()
+        start = time.time()
+        status, next_timer = stackless.run_host(0.05)
+        elapsed = time.time() - start
+        self.assertEqual(status, 1)
+        self.assertEqual(next_timer, None)
+        self.assertTrue(0.04 < elapsed < 1.0, elapsed)
+        # the tasklet was not interrupted, it is still runnable
+        self.assertTrue(t.alive and t.scheduled)
+        n = count[0]
+        self.assertEqual(stackless.run_host(0.01)[0], 1)
+        self.assertTrue(count[0] > n)
+        t.kill()
+
+    def testBudgetNoSwitches(self):
+        # the clock is also checked while a tasklet runs
+        def busy():
+            end = time.time() + 0.05
+            while time.time() < end:
+                pass
+            stackless.schedule()
+            stackless.schedule_remove()
+        t = stackless.tasklet(busy)()
+        self.assertEqual(stackless.run_host(0.01)[0], 1)
+        self.assertTrue(t.alive)
+        stackless.run_host()
+        stackless.wakeup(t)
+        stackless.run_host()
+        self.assertFalse(t.alive)
+
+    def testSleep(self):
+        woken = []
+        def sleeper(i, delay):
+            stackless.sleep(delay)
+            woken.append(i)
+        stackless.tasklet(sleeper)(1, 0.05)
+        stackless.tasklet(sleeper)(0, 0.01)
+        status, next_timer = stackless.run_host()
+        self.assertEqual(status, 0)
+        self.assertEqual(woken, [])
+        self.assertTrue(0.0 <= next_timer <= 0.01, next_timer)
+        deadline = time.time() + 2.0
+        while len(woken) < 2 and time.time() < deadline:
+            status, next_timer = stackless.run_host()
+            if next_timer is not None:
+                time.sleep(next_timer)
+        self.assertEqual(woken, [0, 1])
+        self.assertEqual(stackless.run_host(), (0, None))
+
+    def testSleepDuringBudget(self):
+        woken = []
+        def sleeper():
+            stackless.sleep(0.01)
+            woken.append(True)
+        def spinner():
+            while not woken:
+                stackless.schedule()
+        stackless.tasklet(sleeper)()
+        stackless.tasklet(spinner)()
+        self.assertEqual(stackless.run_host(1.0), (0, None))
+        self.assertEqual(woken, [True])
+
+    def testWakeup(self):
+        got = []
+        def waiter():
+            got.append(stackless.schedule_remove())
+        t = stackless.tasklet(waiter)()
+        stackless.run_host()
+        self.assertEqual(got, [])
+        stackless.wakeup(t, "event")
+        self.assertRaises(RuntimeError, stackless.wakeup, t)
+        stackless.run_host()
+        self.assertEqual(got, ["event"])
+        self.assertRaises(RuntimeError, stackless.wakeup, t)
+
+    def testWakeupSleeper(self):
+        got = []
+        def sleeper():
+            got.append(stackless.sleep(60))
+        t = stackless.tasklet(sleeper)()
+        self.assertTrue(stackless.run_host()[1] > 50)
+        stackless.wakeup(t, 42)
+        # the stale timer entry is gone
+        self.assertEqual(stackless.run_host(), (0, None))
+        self.assertEqual(got, [42])
+
+    def testWakeupBlocked(self):
+        chan = stackless.channel()
+        t = stackless.tasklet(chan.receive)()
+        stackless.run_host()
+        self.assertRaises(RuntimeError, stackless.wakeup, t)
+        self.assertRaises(RuntimeError, stackless.wakeup, stackless.getmain())
+        chan.send(None)
+
+    def testKillSleeper(self):
+        t = stackless.tasklet(stackless.sleep)(0)
+        stackless.run()
+        t.kill()
+        self.assertEqual(stackless.run_host(), (0, None))
+
+    def testMainCannotSleep(self):
+        self.assertRaises(RuntimeError, stackless.sleep, 0)
+
+    def testException(self):
+        def bad():
+            stackless.schedule()
+            1 // 0
+        stackless.tasklet(bad)()
+        self.assertRaises(ZeroDivisionError, stackless.run_host, 1.0)
+
+
+if __name__ == '__main__':
+    import sys
+    if not sys.argv[1:]:
+        sys.argv.append('-v')
+    unittest.main()
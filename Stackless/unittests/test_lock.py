@@ -0,0 +1,313 @@
+import unittest
+import stackless
+import thread, threading
+import time
+
+class LockTestCase(unittest.TestCase):
+    def setUp(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from other tests, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+    def tearDown(self):
+        self.assertEqual(stackless.getruncount(), 1, "Leakage from this test, with %d tasklets still in the scheduler" % (stackless.getruncount() - 1))
+
+
+class TestLock(LockTestCase):
+    locktype = stackless.lock
+
+    def testUncontended(self):
+        lock = self.locktype()
+        self.assertFalse(lock.locked())
+        self.assertTrue(lock.acquire())
+        self.assertTrue(lock.locked())
+        self.assertEqual(lock.owner, stackless.getcurrent())
+        lock.release()
+        self.assertFalse(lock.locked())
+        self.assertEqual(lock.owner, None)
+        self.assertRaises(RuntimeError, lock.release)
+        with lock:
+            self.assertTrue(lock.locked())
+        self.assertFalse(lock.locked())
+
+    def testNonBlocking(self):
+        lock = self.locktype()
+        result = []
+        def other():
+            result.append(lock.acquire(False))
+            result.append(lock.acquire(blocking=False))
+        lock.acquire()
+        stackless.tasklet(other)()
+        stackless.run()
+        self.assertEqual(result, [False, False])
+        self.assertRaises(TypeError, lock.acquire, 0, blocking=0)
+        lock.release()
+
+    def testFifoHandoff(self):
+        lock = self.locktype()
+        order = []
+        def worker(i):
+            lock.acquire()
+            order.append(i)
+            stackless.schedule()
+            lock.release()
+        lock.acquire()
+        for i in range(4):
+            stackless.tasklet(worker)(i)
+        stackless.run()
+        self.assertEqual(lock.waiting, 4)
+        lock.release()
+        # the first waiter owns the lock before it runs, so the
+        # releasing tasklet cannot barge in again
+        self.assertFalse(lock.acquire(False))
+        stackless.run()
+        self.assertEqual(order, range(4))
+        self.assertFalse(lock.locked())
+
+    def testWith(self):
+        lock = self.locktype()
+        inside = []
+        def worker(i):
+            with lock:
+                inside.append(i)
+                stackless.schedule()
+                self.assertEqual(inside, [i])
+                inside.remove(i)
+        for i in range(3):
+            stackless.tasklet(worker)(i)
+        stackless.run()
+        self.assertFalse(lock.locked())
+
+    def testKillWaiter(self):
+        lock = self.locktype()
+        lock.acquire()
+        t = stackless.tasklet(lock.acquire)()
+        stackless.run()
+        self.assertTrue(t.blocked)
+        t.kill()
+        self.assertEqual(lock.waiting, 0)
+        lock.release()
+        self.assertFalse(lock.locked())
+
+    def testKillAfterHandoff(self):
+        lock = self.locktype()
+        got = []
+        def waiter(i):
+            lock.acquire()
+            got.append(i)
+            lock.release()
+        lock.acquire()
+        t1 = stackless.tasklet(waiter)(1)
+        t2 = stackless.tasklet(waiter)(2)
+        stackless.run()
+        lock.release()
+        self.assertEqual(lock.owner, t1)
+        # t1 dies before it can use the lock, it must pass it on
+        t1.kill()
+        self.assertEqual(lock.owner, t2)
+        stackless.run()
+        self.assertEqual(got, [2])
+        self.assertFalse(lock.locked())
+
+    def testHardSwitching(self):
+        lock = self.locktype()
+        order = []
+        def worker(i):
+            stackless.test_cstate(lock.acquire)
+            order.append(i)
+            stackless.schedule()
+            lock.release()
+        lock.acquire()
+        for i in range(3):
+            stackless.tasklet(worker)(i)
+        stackless.run()
+        lock.release()
+        stackless.run()
+        self.assertEqual(order, range(3))
+
+    def testThreads(self):
+        lock = self.locktype()
+        count = [0]
+        def worker():
+            for i in range(100):
+                with lock:
+                    n = count[0]
+                    stackless.schedule()
+                    count[0] = n + 1
+        def threadfunc():
+            tasklets = [stackless.tasklet(worker)() for i in range(3)]
+            # run() returns early when all workers wait for a lock held
+            # in another thread, they are woken up into our run queue
+            while [t for t in tasklets if t.alive]:
+                stackless.run()
+                time.sleep(0.001)
+        threads = [threading.Thread(target=threadfunc) for i in range(3)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(count[0], 900)
+
+
+class TestRLock(TestLock):
+    locktype = stackless.rlock
+
+    def testRecursion(self):
+        lock = self.locktype()
+        lock.acquire()
+        lock.acquire()
+        self.assertTrue(lock._is_owned())
+        lock.release()
+        self.assertTrue(lock.locked())
+        lock.release()
+        self.assertFalse(lock.locked())
+
+    def testReleaseByOther(self):
+        lock = self.locktype()
+        errors = []
+        def other():
+            try:
+                lock.release()
+            except RuntimeError:
+                errors.append(True)
+        lock.acquire()
+        stackless.tasklet(other)()
+        stackless.run()
+        self.assertEqual(errors, [True])
+        lock.release()
+
+
+class TestSemaphore(LockTestCase):
+    def testCounting(self):
+        sem = stackless.semaphore(2)
+        self.assertTrue(sem.acquire())
+        self.assertTrue(sem.acquire())
+        self.assertFalse(sem.acquire(False))
+        self.assertEqual(sem.value, 0)
+        sem.release()
+        sem.release()
+        self.assertEqual(sem.value, 2)
+        self.assertRaises(ValueError, stackless.semaphore, -1)
+
+    def testBlocking(self):
+        sem = stackless.semaphore(0)
+        got = []
+        def worker(i):
+            with sem:
+                got.append(i)
+        for i in range(3):
+            stackless.tasklet(worker)(i)
+        stackless.run()
+        self.assertEqual(sem.waiting, 3)
+        sem.release()
+        stackless.run()
+        self.assertEqual(got, [0, 1, 2])
+        self.assertEqual(sem.value, 1)
+
+    def testKillAfterWakeup(self):
+        sem = stackless.semaphore(0)
+        got = []
+        def worker(i):
+            sem.acquire()
+            got.append(i)
+        t1 = stackless.tasklet(worker)(1)
+        t2 = stackless.tasklet(worker)(2)
+        stackless.run()
+        sem.release()
+        t1.kill()
+        stackless.run()
+        self.assertEqual(got, [2])
+        self.assertEqual(sem.value, 0)
+
+
+class TestEvent(LockTestCase):
+    def testWait(self):
+        event = stackless.event()
+        self.assertFalse(event.is_set())
+        woken = []
+        def waiter(i):
+            woken.append((i, event.wait()))
+        for i in range(3):
+            stackless.tasklet(waiter)(i)
+        stackless.run()
+        self.assertEqual(event.waiting, 3)
+        event.set()
+        self.assertTrue(event.isSet())
+        # waiters return even if the flag is cleared before they run
+        event.clear()
+        stackless.run()
+        self.assertEqual(woken, [(0, True), (1, True), (2, True)])
+        event.set()
+        self.assertTrue(event.wait())
+
+
+class TestCondition(LockTestCase):
+    def testProducerConsumer(self):
+        cond = stackless.condition()
+        items = []
+        got = []
+        def consumer():
+            with cond:
+                while not items:
+                    cond.wait()
+                got.append(items.pop(0))
+        def producer(i):
+            with cond:
+                items.append(i)
+                cond.notify()
+        for i in range(3):
+            stackless.tasklet(consumer)()
+        stackless.run()
+        self.assertEqual(cond.waiting, 3)
+        for i in range(3):
+            stackless.tasklet(producer)(i)
+        stackless.run()
+        self.assertEqual(got, [0, 1, 2])
+        self.assertFalse(cond.lock.locked())
+
+    def testRecursionRestored(self):
+        cond = stackless.condition(stackless.rlock())
+        counts = []
+        def waiter():
+            cond.acquire()
+            cond.acquire()
+            cond.wait()
+            counts.append(cond.lock._is_owned())
+            cond.release()
+            counts.append(cond.lock._is_owned())
+            cond.release()
+            counts.append(cond.lock.locked())
+        stackless.tasklet(waiter)()
+        stackless.run()
+        self.assertFalse(cond.lock.locked())
+        with cond:
+            cond.notify_all()
+        stackless.run()
+        self.assertEqual(counts, [True, True, False])
+
+    def testNotOwned(self):
+        cond = stackless.condition(stackless.lock())
+        self.assertRaises(RuntimeError, cond.wait)
+        self.assertRaises(RuntimeError, cond.notify)
+        self.assertRaises(TypeError, stackless.condition, thread.allocate_lock())
+
+    def testKillWaiterReacquires(self):
+        cond = stackless.condition()
+        state = []
+        def waiter():
+            with cond:
+                try:
+                    cond.wait()
+                except TaskletExit:
+                    state.append(cond.lock._is_owned())
+                    raise
+        t = stackless.tasklet(waiter)()
+        stackless.run()
+        t.kill()
+        self.assertEqual(state, [True])
+        self.assertFalse(cond.lock.locked())
+
+
+if __name__ == '__main__':
+    import sys
+    if not sys.argv[1:]:
+        sys.argv.append('-v')
+    unittest.main()
@@ -115,6 +115,133 @@ class TestWatchdog(unittest.TestCase):
         self.assertFalse(t.scheduled)
         self.assertEqual(t.recursion_depth, 0)
     
+class TestThreadStacks(unittest.TestCase):
+
+    def test_thread_exit_kills_own_stacks(self):
+        """ Thread exit only kills the tasklets with stacks of that thread. """
+        import thread
+        chan = stackless.channel()
+        killed = []
+
+        def blocker(tag):
+            try:
+                chan.receive()
+            except TaskletExit:
+                killed.append(tag)
+                raise
+
+        def worker(done):
+            hold = stackless.enable_softswitch(False)
+            try:
+                for i in range(3):
+                    stackless.tasklet(blocker)("thread")
+                stackless.run()
+            finally:
+                stackless.enable_softswitch(hold)
+            done.release()
+
+        hold = stackless.enable_softswitch(False)
+        try:
+            mine = stackless.tasklet(blocker)("main")
+            stackless.run()
+        finally:
+            stackless.enable_softswitch(hold)
+        self.assertTrue(mine in stackless.uncollectables)
+
+        done = thread.allocate_lock()
+        done.acquire()
+        thread.start_new_thread(worker, (done,))
+        done.acquire()
+        # give the thread a chance to clear its thread state
+        import time
+        for i in range(100):
+            if len(killed) == 3:
+                break
+            time.sleep(0.01)
+        self.assertEqual(killed, ["thread"] * 3)
+        self.assertTrue(mine.alive)
+        self.assertTrue(mine in stackless.uncollectables)
+        mine.kill()
+        self.assertEqual(killed[-1], "main")
+
+    def test_outliving_main_thread(self):
+        """ Tasklets which outlive the main thread state count as dead. """
+        import subprocess, sys
+        script = """if 1:
+            import os, sys, stackless
+            lock = stackless.lock()
+            lock.acquire()
+            group = stackless.taskletgroup()
+            group.add(stackless.tasklet(lock.acquire)())
+            removed = stackless.tasklet(stackless.schedule_remove)()
+            group.add(removed)
+            stackless.run()
+
+            class Late(object):
+                # a profile function is released after the Stackless
+                # part of the main thread state, when the globals are gone
+                def __init__(self):
+                    self.__dict__.update(write=os.write, error=RuntimeError,
+                                         wakeup=stackless.wakeup, lock=lock,
+                                         group=group, removed=removed)
+                def __call__(self, *args):
+                    pass
+                def __del__(self):
+                    for func, args in ((self.wakeup, (self.removed,)),
+                                       (self.removed.insert, ())):
+                        try:
+                            func(*args)
+                        except self.error:
+                            self.write(1, "error ")
+                    self.lock.release()
+                    self.group.kill()
+                    self.write(1, "%r" % (self.group.members,))
+            sys.setprofile(Late())
+            """
+        p = subprocess.Popen([sys.executable, "-c", script],
+                             stdout=subprocess.PIPE)
+        out = p.communicate()[0]
+        self.assertEqual((p.returncode, out), (0, "error error []"))
+
+class TestArguments(unittest.TestCase):
+
+    def test_schedule_retval(self):
+        self.assertEqual(stackless.schedule(), stackless.getcurrent())
+        self.assertEqual(stackless.schedule(1), 1)
+        self.assertEqual(stackless.schedule(retval=2), 2)
+        got = []
+        def worker():
+            got.append(stackless.schedule_remove(retval=3))
+        t = stackless.tasklet(worker)()
+        stackless.run()
+        t.insert()
+        stackless.run()
+        self.assertEqual(got, [3])
+
+    def test_errors(self):
+        self.assertRaises(TypeError, stackless.schedule, 1, 2)
+        self.assertRaises(TypeError, stackless.schedule, 1, retval=1)
+        self.assertRaises(TypeError, stackless.schedule, value=1)
+        self.assertRaises(TypeError, stackless.run, timeout="x")
+        self.assertRaises(TypeError, stackless.test_cframe)
+        self.assertRaises(TypeError, stackless.channel, 1)
+        self.assertRaises(TypeError, stackless.tasklet, runtask, 1)
+        try:
+            stackless.run(spam=1)
+        except TypeError, e:
+            self.assertEqual(str(e), "'spam' is an invalid keyword "
+                             "argument for this function")
+        else:
+            self.fail("no TypeError")
+
+    def test_keywords(self):
+        t = stackless.tasklet(func=runtask)()
+        self.assertEqual(stackless.run(timeout=0, threadblock=False), None)
+        self.assertFalse(t.alive)
+        t = stackless.tasklet(stackless.test_cframe)(switches=2, words=1)
+        stackless.run()
+        self.assertFalse(t.alive)
+
 #///////////////////////////////////////////////////////////////////////////////
 
 if __name__ == '__main__':
@@ -90,6 +90,15 @@ def dicttestiteritems(n, when):
             schedule()
     return n
 
+def dicttestholes(n, when):
+    d = dict([ (i, i) for i in range(n) ])
+    for i in range(0, n, 3):
+        del d[i]
+    for i in d.iterkeys():
+        if i == when:
+            schedule()
+    return n
+
 def settest(n, when):
     for i in set(range(n)):
         if i == when:
@@ -123,6 +132,24 @@ def genoutertest(n, when):
             schedule()
     return i
 
+def hotcode(n, when):
+    # warm enough to get the inline caches of the eval loop
+    total = 0
+    for i in range(n):
+        total += len(glist) + abs(i)
+        if i == when:
+            schedule()
+    return total
+
+def fusedtest(n, when):
+    # superinstructions around the point where the tasklet is pickled
+    total = 0
+    for i in range(n):
+        if i == when:
+            schedule()
+        total = total + i
+    return total
+
 def cellpickling():
     """defect:  Initializing a function object with a partially constructed
        cell object
@@ -252,6 +279,10 @@ class TestConcretePickledTasklets(TestPickledTasklets):
     def testDictIteritems(self):
         self.run_pickled(dicttestiteritems, 20, 13)
 
+    # Test pickling of an iterator over a dict with deleted entries.
+    def testDictHoles(self):
+        self.run_pickled(dicttestholes, 20, 13)
+
     # Test pickling of iteration over the set type.
     def testSet(self):
         self.run_pickled(settest, 20, 13)
@@ -263,6 +294,32 @@ class TestConcretePickledTasklets(TestPickledTasklets):
     def testTuple(self):
         self.run_pickled(tupletest, 20, 13)
 
+    def testHotCode(self):
+        before = pickle.dumps(hotcode.func_code)
+        for i in range(2000):
+            hotcode(3, -1)
+        self.assertEqual(pickle.dumps(hotcode.func_code), before)
+        self.run_pickled(hotcode, 20, 13)
+
+    def testSuperinstructions(self):
+        import opcode
+        def opnames(code):
+            co_code, i, names = code.co_code, 0, []
+            while i < len(co_code):
+                op = ord(co_code[i])
+                names.append(opcode.opname[op])
+                i += 3 if op >= opcode.HAVE_ARGUMENT else 1
+            return names
+        names = opnames(fusedtest.func_code)
+        self.assertIn('COMPARE_OP__POP_JUMP_IF_FALSE', names)
+        # pickled as plain instructions at the same offsets
+        code = pickle.loads(pickle.dumps(fusedtest.func_code))
+        unfused = opnames(code)
+        self.assertEqual(len(unfused), len(names))
+        self.assertEqual([name for name in unfused if '__' in name], [])
+        self.assertEqual(code.co_lnotab, fusedtest.func_code.co_lnotab)
+        self.run_pickled(fusedtest, 20, 13)
+
     def testGeneratorScheduling(self):
         self.run_pickled(genschedoutertest, 20, 13)
 
@@ -19,6 +19,11 @@ import socket
 from optparse import OptionParser, SUPPRESS_HELP
 import platform
 
+try:
+    import stackless
+except ImportError:
+    stackless = None
+
 # Compatibility
 try:
     xrange
@@ -39,6 +44,9 @@ LATENCY_DURATION = 2.0
 BANDWIDTH_PACKET_SIZE = 1024
 BANDWIDTH_DURATION = 2.0
 
+TASKLET_PING_INTERVAL = 0.01
+TASKLET_DURATION = 2.0
+
 
 def task_pidigits():
     """Pi calculation (Python)"""
@@ -153,6 +161,7 @@ else:
 
 latency_tasks = throughput_tasks
 bandwidth_tasks = [task_pidigits]
+tasklet_tasks = throughput_tasks
 
 
 class TimedLoop:
@@ -525,6 +534,82 @@ def run_bandwidth_tests(max_threads):
         print()
 
 
+# Tasklet switching latency: a tasklet in one thread sends a ping over a
+# channel to a tasklet waiting in another thread and waits for the pong.
+# Both schedulers block their thread while waiting, so every round trip
+# wakes up a blocked thread twice while the CPU threads hold the GIL.
+
+def run_tasklet_test(func, args, nthreads):
+    assert nthreads >= 0
+
+    ping = stackless.channel()
+    pong = stackless.channel()
+
+    def server():
+        while True:
+            x = ping.receive()
+            if x is None:
+                break
+            pong.send(x)
+
+    end_event = []
+    loop = TimedLoop(func, args)
+    start_cond = threading.Condition()
+    ready = []
+
+    def cpu():
+        with start_cond:
+            ready.append(None)
+            start_cond.notify()
+        loop(time.time(), TASKLET_DURATION * 3, end_event, do_yield=False)
+
+    server_thread = threading.Thread(target=server)
+    server_thread.start()
+    threads = []
+    for i in range(nthreads):
+        threads.append(threading.Thread(target=cpu))
+    for t in threads:
+        t.setDaemon(True)
+        t.start()
+    with start_cond:
+        while len(ready) < nthreads:
+            start_cond.wait()
+
+    results = []
+    _time = time.time
+    end_time = _time() + TASKLET_DURATION
+    while _time() < end_time:
+        t1 = _time()
+        ping.send(t1)
+        assert pong.receive() == t1
+        results.append((t1, _time()))
+        time.sleep(TASKLET_PING_INTERVAL)
+    end_event.append(None)
+    ping.send(None)
+    server_thread.join()
+    for t in threads:
+        t.join()
+    return results
+
+def run_tasklet_tests(max_threads):
+    for task in tasklet_tasks:
+        print("Background CPU task:", task.__doc__)
+        print()
+        func, args = task()
+        nthreads = 0
+        while nthreads <= max_threads:
+            results = run_tasklet_test(func, args, nthreads)
+            n = len(results)
+            # We print out milliseconds
+            lats = [1000 * (t2 - t1) for (t1, t2) in results]
+            avg = sum(lats) / n
+            dev = (sum((x - avg) ** 2 for x in lats) / n) ** 0.5
+            print("CPU threads=%d: %.2f ms. (std dev: %.2f ms.)" % (nthreads, avg, dev), end="")
+            print()
+            nthreads += 1
+        print()
+
+
 def main():
     usage = "usage: %prog [-h|--help] [options]"
     parser = OptionParser(usage=usage)
@@ -537,6 +622,9 @@ def main():
     parser.add_option("-b", "--bandwidth",
                       action="store_true", dest="bandwidth", default=False,
                       help="run I/O bandwidth tests")
+    parser.add_option("-T", "--tasklets",
+                      action="store_true", dest="tasklets", default=False,
+                      help="run cross-thread tasklet latency tests (Stackless)")
     parser.add_option("-i", "--interval",
                       action="store", type="int", dest="check_interval", default=None,
                       help="sys.setcheckinterval() value")
@@ -569,8 +657,12 @@ def main():
         bandwidth_client(**kwargs)
         return
 
-    if not options.throughput and not options.latency and not options.bandwidth:
+    if (not options.throughput and not options.latency and
+        not options.bandwidth and not options.tasklets):
         options.throughput = options.latency = options.bandwidth = True
+        options.tasklets = stackless is not None
+    if options.tasklets and stackless is None:
+        parser.error("the tasklet tests need Stackless Python")
     if options.check_interval:
         sys.setcheckinterval(options.check_interval)
     if options.switch_interval:
@@ -605,5 +697,10 @@ def main():
         print()
         run_bandwidth_tests(options.nthreads)
 
+    if options.tasklets:
+        print("--- Tasklet latency ---")
+        print()
+        run_tasklet_tests(options.nthreads)
+
 if __name__ == "__main__":
     main()